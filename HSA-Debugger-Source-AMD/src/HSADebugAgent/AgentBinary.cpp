@@ -15,8 +15,14 @@
 #include <cstring>
 #include <sstream>
 #include <iostream>
+#include <mutex>
+#include <unordered_map>
 #include <unistd.h>
 
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
 #include <hsa_ext_amd.h>
 #include <amd_hsa_kernel_code.h>
 
@@ -52,17 +58,18 @@ static uint32_t* ExtractIsaBinaryFromAQLPacket(const hsa_kernel_dispatch_packet_
     return reinterpret_cast<uint32_t*>(pAqlPacket->kernel_object + pKernelCode->kernel_code_entry_byte_offset);
 }
 
-static uint32_t* ExtractIsaBinaryFromElfBinary(uint64_t    isaOffset,
-                                               const void* pBinary,
-                                               size_t      binarySize)
+/// Find the .hsatext section of the code object, which holds the isa of all kernels
+/// This parses the ELF, so it is done once per code object rather than once per kernel symbol
+static bool ExtractIsaSectionFromElfBinary(const void*     pBinary,
+                                           size_t          binarySize,
+                                           const uint8_t** ppSectionOut,
+                                           size_t*         pSectionSizeOut)
 {
-    if (nullptr == pBinary || 0 == binarySize)
+    if (nullptr == pBinary || 0 == binarySize || nullptr == ppSectionOut || nullptr == pSectionSizeOut)
     {
-        return nullptr;
+        return false;
     }
 
-    // get isa binary from .hsatext section with a relative byte offset (isaOffset)
-
     // Determine the ELF type:
     bool isELF = false;
     bool isELF32 = false;
@@ -84,13 +91,13 @@ static uint32_t* ExtractIsaBinaryFromElfBinary(uint64_t    isaOffset,
     // Validate:
     if (!isELF)
     {
-        return nullptr;
+        return false;
     }
 
     if (!isELF32 && !isELF64)
     {
         assert(!"Unsupported ELF sub-format!");
-        return nullptr;
+        return false;
     }
 
     // Set the version of elf:
@@ -101,7 +108,7 @@ static uint32_t* ExtractIsaBinaryFromElfBinary(uint64_t    isaOffset,
 
     if (nullptr == pContainerElf)
     {
-        return nullptr;
+        return false;
     }
 
     // First get the .hsatext section:
@@ -113,7 +120,7 @@ static uint32_t* ExtractIsaBinaryFromElfBinary(uint64_t    isaOffset,
 
     if ((0 != rcShrstr) || (0 == sectionHeaderStringSectionIndex))
     {
-        return nullptr;
+        return false;
     }
 
     // Iterate the sections to find the isa section
@@ -159,9 +166,9 @@ static uint32_t* ExtractIsaBinaryFromElfBinary(uint64_t    isaOffset,
                 if (nullptr != pSectionData)
                 {
                     // Found the section, no need to continue:
-                    // the isa binary is prefixed with an amd_kernel_code_t structure
-                    uint64_t buffer = reinterpret_cast<uint64_t>(pSectionData->d_buf) + isaOffset + sizeof(amd_kernel_code_t);
-                    return reinterpret_cast<uint32_t*>(buffer);
+                    *ppSectionOut = reinterpret_cast<const uint8_t*>(pSectionData->d_buf);
+                    *pSectionSizeOut = pSectionData->d_size;
+                    return true;
                 }
             }
         }
@@ -170,7 +177,26 @@ static uint32_t* ExtractIsaBinaryFromElfBinary(uint64_t    isaOffset,
         pCurrentSection = elf_nextscn(pContainerElf, pCurrentSection);
     }
 
-    return nullptr;
+    return false;
+}
+
+/// Get the isa of the kernel at isaOffset in the .hsatext section
+/// \param[out] pIsaWordsOut The number of isa words up to the end of the section
+static const uint32_t* ExtractIsaBinaryFromIsaSection(uint64_t       isaOffset,
+                                                      const uint8_t* pSection,
+                                                      size_t         sectionSize,
+                                                      size_t*        pIsaWordsOut)
+{
+    // the isa binary is prefixed with an amd_kernel_code_t structure
+    const uint64_t isaStart = isaOffset + sizeof(amd_kernel_code_t);
+
+    if (nullptr == pSection || isaStart >= sectionSize)
+    {
+        return nullptr;
+    }
+
+    *pIsaWordsOut = (sectionSize - isaStart) / sizeof(uint32_t);
+    return reinterpret_cast<const uint32_t*>(pSection + isaStart);
 }
 
 static bool CanSkipInstructionCompare(const uint32_t firstInstruction, const uint32_t secondInstruction)
@@ -194,29 +220,94 @@ static bool CanSkipInstructionCompare(const uint32_t firstInstruction, const uin
     return false;
 }
 
-static bool FindKernelNameUsingIsaComparison(const hsa_kernel_dispatch_packet_t* pAqlPacket,
-                                             uint64_t                            isaOffset,
-                                             const void*                         pBinary,
-                                             size_t                              binarySize)
+/// End of program instruction, both isa binaries end with it
+static const uint32_t gs_S_END_PGM_INSTRUCTION = 0xbf810000;
+
+/// Number of isa words at the kernel entry that are hashed
+static const size_t gs_PROLOGUE_HASH_WORDS = 8;
+
+/// Map the instructions that CanSkipInstructionCompare treats as equal to the same word
+static uint32_t NormalizeInstructionForHash(const uint32_t instruction)
 {
-    const uint32_t* pIsaInAql = ExtractIsaBinaryFromAQLPacket(pAqlPacket);
-    const uint32_t* pIsaInCodeObject = ExtractIsaBinaryFromElfBinary(isaOffset, pBinary, binarySize);
+    const uint32_t S_NOP = 0xbf800000;
+    const uint32_t S_TRAP_BASE = 0xbf920000;
+    const uint32_t S_TRAP_MASK = 0xffff0000;
 
-    if (nullptr == pIsaInAql || nullptr == pIsaInCodeObject)
+    if ((instruction & S_TRAP_MASK) == S_TRAP_BASE)
     {
-        AGENT_ERROR("FindKernelNameUsingIsaComparison: Invalid input parameters");
+        return S_NOP;
+    }
 
-        return false;
+    return instruction;
+}
+
+/// Hash the first few instructions of a kernel, stopping at S_END_PGM.
+/// Two kernels that FindKernelNameUsingIsaComparison would match always have the same hash,
+/// so kernels with a different hash do not need the full comparison
+static uint64_t HashIsaPrologue(const uint32_t* pIsa, const size_t maxWords)
+{
+    // 64-bit FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < gs_PROLOGUE_HASH_WORDS && i < maxWords; ++i)
+    {
+        const uint32_t instruction = NormalizeInstructionForHash(pIsa[i]);
+
+        for (size_t byte = 0; byte < sizeof(uint32_t); ++byte)
+        {
+            hash ^= (instruction >> (8 * byte)) & 0xff;
+            hash *= 0x100000001b3ULL;
+        }
+
+        if (instruction == gs_S_END_PGM_INSTRUCTION)
+        {
+            break;
+        }
     }
 
-    /// \todo: the following is not efficient for a large isa
-    // loop through the isa binary to check whether they are the same
-    const uint32_t S_END_PGM_INSTRUCTION = 0xbf810000;
-    uint64_t i = 0;
+    return hash;
+}
+
+/// Compare the isa of the dispatched kernel with a kernel in the code object, up to S_END_PGM
+static bool CompareIsaUntilEndPgm(const uint32_t* pIsaInAql,
+                                  const uint32_t* pIsaInCodeObject,
+                                  const size_t    codeObjectWords)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i endPgm = _mm_set1_epi32((int)gs_S_END_PGM_INSTRUCTION);
+#endif
 
-    while (pIsaInAql[i] == pIsaInCodeObject[i] || CanSkipInstructionCompare(pIsaInAql[i], pIsaInCodeObject[i]))
+    while (i < codeObjectWords)
     {
-        if (pIsaInAql[i] == S_END_PGM_INSTRUCTION)
+#if defined(__SSE2__)
+        // Compare four words at a time while they are all equal and none of them is S_END_PGM.
+        // Loads from the AQL isa are aligned so they never cross into a page past S_END_PGM
+        if ((0 == (reinterpret_cast<uintptr_t>(pIsaInAql + i) & 15)) && (i + 4 <= codeObjectWords))
+        {
+            const __m128i aqlWords = _mm_load_si128(reinterpret_cast<const __m128i*>(pIsaInAql + i));
+            const __m128i codeObjectWordsVec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pIsaInCodeObject + i));
+
+            const int equalMask = _mm_movemask_epi8(_mm_cmpeq_epi32(aqlWords, codeObjectWordsVec));
+            const int endPgmMask = _mm_movemask_epi8(_mm_cmpeq_epi32(aqlWords, endPgm));
+
+            if (0xffff == equalMask && 0 == endPgmMask)
+            {
+                i += 4;
+                continue;
+            }
+        }
+#endif
+
+        // A difference, the end of the program or an unaligned word: check one word,
+        // the debugger may have patched it
+        if (pIsaInAql[i] != pIsaInCodeObject[i] && !CanSkipInstructionCompare(pIsaInAql[i], pIsaInCodeObject[i]))
+        {
+            return false;
+        }
+
+        if (pIsaInAql[i] == gs_S_END_PGM_INSTRUCTION)
         {
             // both isa binaries are exactly the same until the end of the program
             return true;
@@ -225,11 +316,55 @@ static bool FindKernelNameUsingIsaComparison(const hsa_kernel_dispatch_packet_t*
         ++i;
     }
 
-    AGENT_LOG("FindKernelNameUsingIsaComparison: Returned false");
-    // the two isa binaries are different
+    // Ran off the end of the code object without finding S_END_PGM
     return false;
 }
 
+static bool FindKernelNameUsingIsaComparison(const uint32_t* pIsaInAql,
+                                             const uint64_t  aqlPrologueHash,
+                                             uint64_t        isaOffset,
+                                             const uint8_t*  pIsaSection,
+                                             size_t          isaSectionSize)
+{
+    size_t codeObjectWords = 0;
+    const uint32_t* pIsaInCodeObject = ExtractIsaBinaryFromIsaSection(isaOffset, pIsaSection, isaSectionSize, &codeObjectWords);
+
+    if (nullptr == pIsaInAql || nullptr == pIsaInCodeObject)
+    {
+        AGENT_ERROR("FindKernelNameUsingIsaComparison: Invalid input parameters");
+
+        return false;
+    }
+
+    // Most candidates differ within the first few instructions
+    if (HashIsaPrologue(pIsaInCodeObject, codeObjectWords) != aqlPrologueHash)
+    {
+        return false;
+    }
+
+    if (!CompareIsaUntilEndPgm(pIsaInAql, pIsaInCodeObject, codeObjectWords))
+    {
+        AGENT_LOG("FindKernelNameUsingIsaComparison: Returned false");
+        // the two isa binaries are different
+        return false;
+    }
+
+    return true;
+}
+
+/// A kernel name found for a kernel object by an earlier dispatch
+typedef struct
+{
+    size_t m_binarySize;        ///< Size of the code object the name was found in
+    uint64_t m_prologueHash;    ///< Prologue hash of the kernel object's isa
+    std::string m_kernelName;   ///< The kernel name
+} KernelNameCacheEntry;
+
+/// Kernel names by kernel object. Dispatching a kernel that was dispatched before is the
+/// common case, and only needs a lookup instead of comparing against every kernel
+static std::unordered_map<uint64_t, KernelNameCacheEntry> gs_kernelNameCache;
+static std::mutex gs_kernelNameCacheMutex;
+
 // \todo move stuff from agentutils to here
 // The code to get the kernel name seems to get the debug symbol too, so stuff could be shared here
 bool AgentBinary::PopulateKernelNameFromBinary(const hsa_kernel_dispatch_packet_t* pAqlPacket)
@@ -239,6 +374,41 @@ bool AgentBinary::PopulateKernelNameFromBinary(const hsa_kernel_dispatch_packet_
         return false;
     }
 
+    const uint32_t* pIsaInAql = ExtractIsaBinaryFromAQLPacket(pAqlPacket);
+
+    if (nullptr == pIsaInAql)
+    {
+        AGENT_ERROR("PopulateKernelNameFromBinary: Could not get the isa from the AQL packet");
+        return false;
+    }
+
+    // The AQL isa is only read up to its S_END_PGM
+    const uint64_t aqlPrologueHash = HashIsaPrologue(pIsaInAql, gs_PROLOGUE_HASH_WORDS);
+
+    {
+        std::lock_guard<std::mutex> lock(gs_kernelNameCacheMutex);
+        std::unordered_map<uint64_t, KernelNameCacheEntry>::const_iterator it = gs_kernelNameCache.find(pAqlPacket->kernel_object);
+
+        // A different executable may have been loaded at the same address since
+        if (it != gs_kernelNameCache.end() &&
+            it->second.m_binarySize == m_binarySize &&
+            it->second.m_prologueHash == aqlPrologueHash)
+        {
+            m_kernelName = it->second.m_kernelName;
+            AGENT_LOG("PopulateKernelNameFromBinary: Kernel Name found in cache " << m_kernelName);
+            return true;
+        }
+    }
+
+    const uint8_t* pIsaSection = nullptr;
+    size_t isaSectionSize = 0;
+
+    if (!ExtractIsaSectionFromElfBinary(m_pBinary, m_binarySize, &pIsaSection, &isaSectionSize))
+    {
+        AGENT_ERROR("PopulateKernelNameFromBinary: Could not find the isa section in DBE binary");
+        return false;
+    }
+
     std::string outputKernelName;
 
     // Get the symbol list (of pair of symbol string name and symbol value representing byte offset)
@@ -272,7 +442,7 @@ bool AgentBinary::PopulateKernelNameFromBinary(const hsa_kernel_dispatch_packet_
                 ('&' == curSym[kernelNamePrefix1Length])
             )
         {
-            if (FindKernelNameUsingIsaComparison(pAqlPacket, elfSymbols[i].second, m_pBinary, m_binarySize))
+            if (FindKernelNameUsingIsaComparison(pIsaInAql, aqlPrologueHash, elfSymbols[i].second, pIsaSection, isaSectionSize))
             {
                 // Found a level 1 match (the first one). It overrides any other matches, so return it!
                 outputKernelName = curSym.substr(kernelNamePrefix1Length);
@@ -283,7 +453,7 @@ bool AgentBinary::PopulateKernelNameFromBinary(const hsa_kernel_dispatch_packet_
         else if (!foundMatch2) // Only take the first level 2 match - and keep looking for level 1 matches
         {
             if ((curSym.length() > 1) && ('&' == curSym[0]) &&
-                FindKernelNameUsingIsaComparison(pAqlPacket, elfSymbols[i].second, m_pBinary, m_binarySize))
+                FindKernelNameUsingIsaComparison(pIsaInAql, aqlPrologueHash, elfSymbols[i].second, pIsaSection, isaSectionSize))
             {
                 outputKernelName = curSym;
                 foundMatch2 = true;
@@ -304,6 +474,38 @@ bool AgentBinary::PopulateKernelNameFromBinary(const hsa_kernel_dispatch_packet_
 
     m_kernelName = outputKernelName;
 
+    {
+        std::lock_guard<std::mutex> lock(gs_kernelNameCacheMutex);
+        KernelNameCacheEntry& entry = gs_kernelNameCache[pAqlPacket->kernel_object];
+        entry.m_binarySize = m_binarySize;
+        entry.m_prologueHash = aqlPrologueHash;
+        entry.m_kernelName = outputKernelName;
+    }
+
+    return true;
+}
+
+bool AgentBinary::FindCachedKernelName(const hsa_kernel_dispatch_packet_t* pAqlPacket, std::string& kernelNameOut)
+{
+    const uint32_t* pIsaInAql = ExtractIsaBinaryFromAQLPacket(pAqlPacket);
+
+    if (nullptr == pIsaInAql)
+    {
+        return false;
+    }
+
+    // Without the binary its size cannot be checked, the prologue hash has to do
+    const uint64_t aqlPrologueHash = HashIsaPrologue(pIsaInAql, gs_PROLOGUE_HASH_WORDS);
+
+    std::lock_guard<std::mutex> lock(gs_kernelNameCacheMutex);
+    std::unordered_map<uint64_t, KernelNameCacheEntry>::const_iterator it = gs_kernelNameCache.find(pAqlPacket->kernel_object);
+
+    if (it == gs_kernelNameCache.end() || it->second.m_prologueHash != aqlPrologueHash)
+    {
+        return false;
+    }
+
+    kernelNameOut = it->second.m_kernelName;
     return true;
 }
 
@@ -501,7 +703,7 @@ HsailAgentStatus AgentBinary::WriteIsaToSharedMem() const
 
     // Maximum size of the shared memory buffer (1MB) used during initialization
     // The max size is half since it is shared
-    static const size_t s_MAX_SIZE = g_BINARY_BUFFER_MAXSIZE;
+    static const size_t s_MAX_SIZE = g_BINARY_BUFFER_INITIALSIZE;
 
     if (m_binarySize <= 0)
     {
@@ -550,33 +752,48 @@ HsailAgentStatus AgentBinary::WriteBinaryToSharedMem(const key_t shmKey) const
         return status;
     }
 
-    // Maximum size of the shared memory buffer (1MB) used during initialization
-    // The max size is half since it is shared
-    static const size_t s_MAX_SIZE = g_BINARY_BUFFER_MAXSIZE;
-
     if (m_binarySize <= 0)
     {
         AGENT_ERROR("WriteBinaryToShmem: Error Binary size is 0");
         return status;
     }
 
-    if (m_binarySize > s_MAX_SIZE)
-    {
-        AGENT_ERROR("WriteBinaryToShmem: Error Binary is larger than the shared mem allocated");
-        return status;
-    }
-
     // The shared mem segment needs place for a size_t value and the binary
-    if ((m_binarySize + sizeof(size_t)) > s_MAX_SIZE)
+    // Large code objects do not fit in the initial buffer, so grow it.
+    // gdb attaches the buffer again for every new binary and picks up the new size
+    const size_t requiredSize = m_binarySize + sizeof(size_t);
+    size_t shmSize = AgentGetSharedMemBufferSize(shmKey);
+
+    if (shmSize < requiredSize)
     {
-        AGENT_ERROR("WriteBinaryToShmem: Binary size is too big");
-        return status;
+        size_t newSize = (shmSize > 0) ? shmSize : g_BINARY_BUFFER_INITIALSIZE;
+
+        while (newSize < requiredSize)
+        {
+            newSize *= 2;
+        }
+
+        AGENT_LOG("WriteBinaryToShmem: Grow the binary buffer from " << shmSize << " to " << newSize << " bytes");
+
+        if (shmSize > 0 && AgentFreeSharedMemBuffer(shmKey, shmSize) != HSAIL_AGENT_STATUS_SUCCESS)
+        {
+            AGENT_ERROR("WriteBinaryToShmem: Could not free the binary buffer");
+            return status;
+        }
+
+        if (AgentAllocSharedMemBuffer(shmKey, newSize) != HSAIL_AGENT_STATUS_SUCCESS)
+        {
+            AGENT_ERROR("WriteBinaryToShmem: Could not grow the binary buffer");
+            return status;
+        }
+
+        shmSize = newSize;
     }
 
     // Get the pointer to the shmem segment
-    void* pShm = AgentMapSharedMemBuffer(shmKey, g_BINARY_BUFFER_MAXSIZE);
+    void* pShm = AgentMapSharedMemBuffer(shmKey, shmSize);
 
-    if (pShm == (int*) - 1)
+    if (pShm == nullptr)
     {
         AGENT_ERROR("WriteBinaryToShmem: Error with AgentMapSharedMemBuffer");
         return status;
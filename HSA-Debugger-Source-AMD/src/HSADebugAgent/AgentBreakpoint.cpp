@@ -5,6 +5,8 @@
 /// \file  AgentBreakpoint.cpp
 /// \brief The breakpoint class
 //==============================================================================
+#include <string.h>
+
 // Use some stl vectors for maintaining breakpoint handles
 #include <vector>
 
@@ -314,11 +316,16 @@ HsailAgentStatus AgentBreakpoint::DeleteBreakpointKernelName(const GdbBkptId gdb
 }
 
 HsailAgentStatus AgentBreakpointCondition::CheckCondition(const HwDbgWavefrontInfo* pWaveInfo,
+                                                          const HwDbgDim3&          workGroupSize,
+                                                          const uint64_t            hitCount,
                                                           bool&               conditionCodeOut,
-                                                          HsailConditionCode& conditionTypeOut) const
+                                                          HsailConditionCode& conditionTypeOut,
+                                                          int&                matchingLaneOut) const
 {
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
 
+    matchingLaneOut = -1;
+
     if (pWaveInfo == nullptr)
     {
         AGENT_ERROR("CheckCondition: WaveInfo is nullptr");
@@ -331,6 +338,13 @@ HsailAgentStatus AgentBreakpointCondition::CheckCondition(const HwDbgWavefrontIn
 
     switch (m_conditionCode)
     {
+        case HSAIL_BREAKPOINT_CONDITION_PROGRAM:
+        {
+            outputCode = m_program.Evaluate(*pWaveInfo, workGroupSize, hitCount, &matchingLaneOut);
+            status = HSAIL_AGENT_STATUS_SUCCESS;
+            break;
+        }
+
         case HSAIL_BREAKPOINT_CONDITION_EQUAL:
         {
             outputCode = AgentIsWorkItemPresentInWave(m_workgroupID, m_workitemID, pWaveInfo);
@@ -418,6 +432,12 @@ void AgentBreakpointCondition::PrintCondition() const
             break;
         }
 
+        case HSAIL_BREAKPOINT_CONDITION_PROGRAM:
+        {
+            AGENT_OP("Condition: breakpoint condition program");
+            break;
+        }
+
         case HSAIL_BREAKPOINT_CONDITION_ANY:
         {
             break;
@@ -457,4 +477,71 @@ HsailAgentStatus AgentBreakpointCondition::SetCondition(const HsailConditionPack
     return status;
 }
 
+HsailAgentStatus AgentBreakpointCondition::SetProgram(const HsailConditionOp* pOps, const size_t numOps)
+{
+    HsailAgentStatus status = m_program.SetProgram(pOps, numOps);
+
+    if (status == HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        m_conditionCode = m_program.IsEmpty() ? HSAIL_BREAKPOINT_CONDITION_ANY : HSAIL_BREAKPOINT_CONDITION_PROGRAM;
+    }
+
+    return status;
+}
+
+void AgentBreakpointStats::AddWave(const HwDbgWavefrontInfo& waveInfo)
+{
+    uint64_t activeLanes = 0;
+
+    for (uint64_t execMask = waveInfo.executionMask; execMask != 0; execMask &= execMask - 1)
+    {
+        const int lane = __builtin_ctzll(execMask);
+
+        if (lane < HSAIL_WAVEFRONT_SIZE)
+        {
+            m_laneHits[lane]++;
+            activeLanes++;
+        }
+    }
+
+    m_waveHits++;
+
+    const std::tuple<uint32_t, uint32_t, uint32_t> key(waveInfo.workGroupId.x,
+                                                       waveInfo.workGroupId.y,
+                                                       waveInfo.workGroupId.z);
+
+    std::map<std::tuple<uint32_t, uint32_t, uint32_t>, size_t>::const_iterator it = m_workGroupIndex.find(key);
+
+    if (it == m_workGroupIndex.end())
+    {
+        HsailWorkGroupHits workGroupHits;
+        memset(&workGroupHits, 0, sizeof(HsailWorkGroupHits));
+        workGroupHits.m_workGroup.x = waveInfo.workGroupId.x;
+        workGroupHits.m_workGroup.y = waveInfo.workGroupId.y;
+        workGroupHits.m_workGroup.z = waveInfo.workGroupId.z;
+
+        it = m_workGroupIndex.insert(std::make_pair(key, m_workGroups.size())).first;
+        m_workGroups.push_back(workGroupHits);
+    }
+
+    m_workGroups.at(it->second).m_waveHits++;
+    m_workGroups.at(it->second).m_laneHits += activeLanes;
+    m_isChanged = true;
+}
+
+void AgentBreakpointStats::Clear()
+{
+    m_waveHits = 0;
+    memset(m_laneHits, 0, sizeof(m_laneHits));
+    m_workGroups.clear();
+    m_workGroupIndex.clear();
+    m_isChanged = true;
+}
+
+void AgentBreakpointStats::GetCounters(HsailBreakpointStats& statsOut) const
+{
+    statsOut.m_waveHits = m_waveHits;
+    memcpy(statsOut.m_laneHits, m_laneHits, sizeof(m_laneHits));
+}
+
 }
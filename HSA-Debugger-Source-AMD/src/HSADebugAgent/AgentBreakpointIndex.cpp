@@ -0,0 +1,58 @@
+//==============================================================================
+// Copyright (c) 2015 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Hash indexes over the breakpoint manager's breakpoint vectors
+//==============================================================================
+#include "AgentBreakpointIndex.h"
+
+namespace HwDbgAgent
+{
+
+void AgentBreakpointIndex::Clear()
+{
+    m_pcPositions.clear();
+    m_gdbIdPositions.clear();
+}
+
+void AgentBreakpointIndex::AddPC(const HwDbgCodeAddress pc, const int position)
+{
+    m_pcPositions[pc].push_back(position);
+}
+
+void AgentBreakpointIndex::AddGdbId(const GdbBkptId gdbId, const int position)
+{
+    m_gdbIdPositions.insert(std::make_pair(gdbId, position));
+}
+
+void AgentBreakpointIndex::RemoveGdbId(const GdbBkptId gdbId)
+{
+    m_gdbIdPositions.erase(gdbId);
+}
+
+const std::vector<int>* AgentBreakpointIndex::FindPC(const HwDbgCodeAddress pc) const
+{
+    std::unordered_map<HwDbgCodeAddress, std::vector<int> >::const_iterator it = m_pcPositions.find(pc);
+
+    if (it == m_pcPositions.end())
+    {
+        return nullptr;
+    }
+
+    return &it->second;
+}
+
+int AgentBreakpointIndex::FindGdbId(const GdbBkptId gdbId) const
+{
+    std::unordered_map<GdbBkptId, int>::const_iterator it = m_gdbIdPositions.find(gdbId);
+
+    if (it == m_gdbIdPositions.end())
+    {
+        return -1;
+    }
+
+    return it->second;
+}
+
+} // End Namespace HwDbgAgent
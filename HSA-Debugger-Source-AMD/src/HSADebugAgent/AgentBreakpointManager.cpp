@@ -16,17 +16,21 @@
 #include <errno.h>
 
 // Use some stl vectors for maintaining breakpoint handles
+#include <algorithm>
+#include <unordered_map>
 #include <vector>
 
 // Include the DBE
 #include "AMDGPUDebug.h"
 
 // Agent includes
+#include "AgentBinary.h"
 #include "AgentBreakpoint.h"
 #include "AgentBreakpointManager.h"
 #include "AgentFocusWaveControl.h"
 
 #include "AgentLogging.h"
+#include "AgentTrace.h"
 #include "AgentNotifyGdb.h"
 #include "AgentUtils.h"
 #include "CommunicationControl.h"
@@ -53,26 +57,12 @@ bool AgentBreakpointManager::GetBreakpointFromGDBId(const GdbBkptId ipId,
 
     AGENT_LOG("GetBreakpointFromGDBId: Look For Breakpoint GDB ID: " << ipId);
 
-    for (unsigned int i = 0; i < m_pBreakpoints.size(); i++)
+    int breakpointPos = m_breakpointIndex.FindGdbId(ipId);
+
+    if (breakpointPos != -1 && m_pBreakpoints.at(breakpointPos) != nullptr)
     {
-        AgentBreakpoint* pCurrentBP = m_pBreakpoints.at(i);
-        if(pCurrentBP != nullptr)
-        {
-            for (unsigned int j = 0; j < pCurrentBP->m_GdbId.size(); j++)
-            {
-                AGENT_LOG("For Breakpoint: " << i << "\t GDB ID: " <<  pCurrentBP->m_GdbId.at(j) );
-                if (pCurrentBP->m_GdbId.at(j) == ipId)
-                {
-                    *pBreakpointPosOut = i;
-                    retVal = true;
-                    break;
-                }
-            }
-            if (retVal == true)
-            {
-                break;
-            }
-        }
+        *pBreakpointPosOut = breakpointPos;
+        retVal = true;
     }
 
     if (retVal == false)
@@ -103,44 +93,33 @@ bool AgentBreakpointManager::GetBreakpointFromPC(const HwDbgCodeAddress pc,
     }
 
     bool pcbpFound = false;
-    unsigned int bpCount = (unsigned int)m_pBreakpoints.size();
 
-    for (unsigned int i = 0; i < bpCount; i++)
+    // It should be enabled, otherwise something is very wrong
+    bpIndex = m_breakpointIndex.FindFirstPC(pc, [this](const int position)
     {
-        AgentBreakpoint* pCurrentBP = m_pBreakpoints.at(i);
+        const AgentBreakpoint* pCurrentBP = m_pBreakpoints.at(position);
+        return (pCurrentBP->m_bpState == HSAIL_BREAKPOINT_STATE_ENABLED ||
+                pCurrentBP->m_bpState == HSAIL_BREAKPOINT_STATE_PENDING);
+    });
 
-        if (pCurrentBP->m_pc == pc)
-        {
-            // It should be enabled, otherwise something is very wrong
-            if (pCurrentBP->m_bpState == HSAIL_BREAKPOINT_STATE_ENABLED ||
-                pCurrentBP->m_bpState == HSAIL_BREAKPOINT_STATE_PENDING)
-            {
-                bpIndex = i;
-                retVal = true;
-                pcbpFound = true;
-                break;
-            }
-        }
+    if (bpIndex != -1)
+    {
+        retVal = true;
+        pcbpFound = true;
     }
 
     bool bpMomentary = false;
 
     if (!retVal)
     {
-        unsigned int momentaryBPCount = (unsigned int)m_pMomentaryBreakpoints.size();
+        const std::vector<int>* pMomentaryPositions = m_momentaryBreakpointIndex.FindPC(pc);
 
-        for (unsigned int i = 0; i < momentaryBPCount; i++)
+        if (pMomentaryPositions != nullptr && !pMomentaryPositions->empty())
         {
-            AgentBreakpoint* pCurrentBP = m_pMomentaryBreakpoints.at(i);
-
-            if (pCurrentBP->m_pc == pc)
-            {
-                // Found the breakpoint:
-                bpMomentary = true;
-                bpIndex = i;
-                retVal = true;
-                break;
-            }
+            // Found the breakpoint:
+            bpMomentary = true;
+            bpIndex = pMomentaryPositions->front();
+            retVal = true;
         }
     }
 
@@ -161,26 +140,30 @@ bool AgentBreakpointManager::IsPCDuplicate(const HwDbgCodeAddress inputPC,
 {
     bool retCode = false;
 
-    for (unsigned int i = 0; i < m_pBreakpoints.size(); i++)
+    const std::vector<int>* pPositions = m_breakpointIndex.FindPC(inputPC);
+
+    if (pPositions == nullptr)
     {
-        AgentBreakpoint* bp = m_pBreakpoints.at(i);
+        return retCode;
+    }
+
+    for (size_t i = 0; i < pPositions->size(); i++)
+    {
+        AgentBreakpoint* bp = m_pBreakpoints.at(pPositions->at(i));
 
         if (bp != nullptr)
         {
             if (bp->m_type == HSAIL_BREAKPOINT_TYPE_PC_BP)
             {
-                if (bp->m_pc == inputPC)
-                {
-                    AGENT_OP("HSAIL-GDB detected a duplicate breakpoint\n"
-                            "Breakpoint " << bp->m_GdbId.at(0) << " already exists at PC 0x" << std::hex << inputPC << std::dec << "\n"
-                            "Use breakpoint index " << bp->m_GdbId.at(0) << " "
-                            "to enable/disable/delete breakpoints at PC 0x" << std::hex << inputPC << std::dec);
+                AGENT_OP("HSAIL-GDB detected a duplicate breakpoint\n"
+                        "Breakpoint " << bp->m_GdbId.at(0) << " already exists at PC 0x" << std::hex << inputPC << std::dec << "\n"
+                        "Use breakpoint index " << bp->m_GdbId.at(0) << " "
+                        "to enable/disable/delete breakpoints at PC 0x" << std::hex << inputPC << std::dec);
 
-                    duplicatePosition = i;
+                duplicatePosition = pPositions->at(i);
 
-                    retCode = true;
-                    break;
-                }
+                retCode = true;
+                break;
             }
         }
         else
@@ -201,34 +184,67 @@ bool AgentBreakpointManager::IsPCBreakpoint(const HwDbgCodeAddress pc) const
 
     if (HSAIL_ISA_PC_UNKOWN != pc)
     {
-        unsigned int bpCount = (unsigned int)m_pBreakpoints.size();
+        const std::vector<int>* pPositions = m_breakpointIndex.FindPC(pc);
 
-        for (unsigned int i = 0; i < bpCount; i++)
+        // This logic assumes that each PC will be unique to a breakpoint
+        // That means that once a breakpoint is disabled, the PC should not be hit by the DBE
+        // so only the first breakpoint at this PC is considered
+        if (pPositions != nullptr && !pPositions->empty())
         {
-            AgentBreakpoint* pCurrentBP = m_pBreakpoints.at(i);
+            AgentBreakpoint* pCurrentBP = m_pBreakpoints.at(pPositions->front());
 
-            if (pCurrentBP->m_pc == pc)
-            {
-                // It should be enabled, otherwise something is very wrong
-                if (pCurrentBP->m_bpState == HSAIL_BREAKPOINT_STATE_ENABLED)
-                {
-                    retVal = true;
-                    break;
-                }
-                else
-                {
-                    // This logic assumes that each PC will be unique to a breakpoint
-                    // That means that once a breakpoint is disabled, the PC should not be hit by the DBE
-                    // We exit this loop if this happens since something is logically wrong here
-                    break;
-                }
-            }
+            // It should be enabled, otherwise something is very wrong
+            retVal = (pCurrentBP->m_bpState == HSAIL_BREAKPOINT_STATE_ENABLED);
         }
     }
 
     return retVal;
 }
 
+/// Add the PC and GDB IDs of one breakpoint to the index
+void AgentBreakpointManager::IndexBreakpoint(const int breakpointPos)
+{
+    const AgentBreakpoint* pBkpt = m_pBreakpoints.at(breakpointPos);
+
+    if (pBkpt == nullptr)
+    {
+        AGENT_ERROR("IndexBreakpoint: nullptr element in breakpoint vector");
+        return;
+    }
+
+    if (HSAIL_ISA_PC_UNKOWN != pBkpt->m_pc)
+    {
+        m_breakpointIndex.AddPC(pBkpt->m_pc, breakpointPos);
+    }
+
+    for (size_t i = 0; i < pBkpt->m_GdbId.size(); i++)
+    {
+        m_breakpointIndex.AddGdbId(pBkpt->m_GdbId.at(i), breakpointPos);
+    }
+}
+
+/// The delete functions of AgentBreakpoint can drop a GDB ID and still fail,
+/// so the index follows what the breakpoint holds rather than the returned status
+void AgentBreakpointManager::UnindexGdbId(const AgentBreakpoint* pBkpt, const GdbBkptId gdbId)
+{
+    if (std::find(pBkpt->m_GdbId.begin(), pBkpt->m_GdbId.end(), gdbId) == pBkpt->m_GdbId.end())
+    {
+        m_breakpointIndex.RemoveGdbId(gdbId);
+    }
+}
+
+/// Deleting a breakpoint shifts the positions of the ones after it.
+/// This only happens on a user command, so rebuilding the whole index is fine
+void AgentBreakpointManager::RebuildBreakpointIndex()
+{
+    m_breakpointIndex.Clear();
+
+    for (unsigned int i = 0; i < m_pBreakpoints.size(); i++)
+    {
+        IndexBreakpoint(i);
+    }
+}
+
 
 /// The CreateBreakpoint does not check for duplicate breakpoint creation, since it is too
 /// late to tell the user when it reaches the agent.  That will be the job of HwDbgFacilities
@@ -256,6 +272,7 @@ HsailAgentStatus AgentBreakpointManager::CreateBreakpoint(const HwDbgContextHand
                        "Append GDB ID " << ipPacket.m_gdbBreakpointID << " to m_GdbId vector");
 
             m_pBreakpoints.at(duplicatePosition)->m_GdbId.push_back(ipPacket.m_gdbBreakpointID);
+            m_breakpointIndex.AddGdbId(ipPacket.m_gdbBreakpointID, duplicatePosition);
             return HSAIL_AGENT_STATUS_SUCCESS;
         }
     }
@@ -272,6 +289,7 @@ HsailAgentStatus AgentBreakpointManager::CreateBreakpoint(const HwDbgContextHand
             AGENT_OP("HSAIL-GDB detected a duplicate function breakpoint") ;
 
             m_pBreakpoints.at(duplicatePosition)->m_GdbId.push_back(ipPacket.m_gdbBreakpointID);
+            m_breakpointIndex.AddGdbId(ipPacket.m_gdbBreakpointID, duplicatePosition);
             return HSAIL_AGENT_STATUS_SUCCESS;
         }
     }
@@ -336,6 +354,7 @@ HsailAgentStatus AgentBreakpointManager::CreateBreakpoint(const HwDbgContextHand
     if (status == HSAIL_AGENT_STATUS_SUCCESS)
     {
         m_pBreakpoints.push_back(pBkpt);
+        IndexBreakpoint((int)m_pBreakpoints.size() - 1);
     }
     else
     {
@@ -368,6 +387,7 @@ HsailAgentStatus AgentBreakpointManager::ClearBreakpointVectors()
     }
 
     m_pBreakpoints.clear();
+    m_breakpointIndex.Clear();
 
     for (unsigned int i = 0; i < m_pMomentaryBreakpoints.size(); i++)
     {
@@ -384,6 +404,7 @@ HsailAgentStatus AgentBreakpointManager::ClearBreakpointVectors()
     }
 
     m_pMomentaryBreakpoints.clear();
+    m_momentaryBreakpointIndex.Clear();
     return status;
 }
 
@@ -417,6 +438,15 @@ HsailAgentStatus AgentBreakpointManager::DeleteBreakpoint(const HwDbgContextHand
         return status;
     }
 
+    return DeleteBreakpointAt(DbeContextHandle, breakpointpos, static_cast<GdbBkptId>(ipPacket.m_gdbBreakpointID));
+}
+
+HsailAgentStatus AgentBreakpointManager::DeleteBreakpointAt(const HwDbgContextHandle DbeContextHandle,
+                                                            const int                breakpointpos,
+                                                            const GdbBkptId          gdbId)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
     AgentBreakpoint* pBkpt =  m_pBreakpoints.at(breakpointpos);
 
     if (pBkpt == nullptr)
@@ -425,13 +455,13 @@ HsailAgentStatus AgentBreakpointManager::DeleteBreakpoint(const HwDbgContextHand
         return status;
     }
 
-
     if (pBkpt->m_type == HSAIL_BREAKPOINT_TYPE_PC_BP)
     {
         // We do need to do the real delete only if there is no GDB ID left over
         // The DeleteBreakpointDBE handles this by looking in the GDB ID vector
         // and then calling the DBE accordingly
-        status = pBkpt->DeleteBreakpointDBE(DbeContextHandle, ipPacket.m_gdbBreakpointID);
+        status = pBkpt->DeleteBreakpointDBE(DbeContextHandle, gdbId);
+        UnindexGdbId(pBkpt, gdbId);
 
         if (status == HSAIL_AGENT_STATUS_FAILURE)
         {
@@ -443,7 +473,8 @@ HsailAgentStatus AgentBreakpointManager::DeleteBreakpoint(const HwDbgContextHand
     if (pBkpt->m_type == HSAIL_BREAKPOINT_TYPE_KERNEL_NAME_BP)
     {
         // We do need to do the real delete only if there is no GDB ID left over
-        status = pBkpt->DeleteBreakpointKernelName(ipPacket.m_gdbBreakpointID);
+        status = pBkpt->DeleteBreakpointKernelName(gdbId);
+        UnindexGdbId(pBkpt, gdbId);
 
         if (status == HSAIL_AGENT_STATUS_FAILURE)
         {
@@ -459,6 +490,7 @@ HsailAgentStatus AgentBreakpointManager::DeleteBreakpoint(const HwDbgContextHand
     {
         delete m_pBreakpoints.at(breakpointpos);
         m_pBreakpoints.erase(m_pBreakpoints.begin() + breakpointpos);
+        RebuildBreakpointIndex();
     }
     else
     {
@@ -569,6 +601,15 @@ HsailAgentStatus AgentBreakpointManager::DisablePCBreakpoint(HwDbgContextHandle
         return status;
     }
 
+    return DisablePCBreakpointAt(DbeContextHandle, breakpointpos, static_cast<GdbBkptId>(ipPacket.m_gdbBreakpointID));
+}
+
+HsailAgentStatus AgentBreakpointManager::DisablePCBreakpointAt(const HwDbgContextHandle DbeContextHandle,
+                                                               const int                breakpointpos,
+                                                               const GdbBkptId          gdbId)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
     if (m_pBreakpoints.at(breakpointpos)->m_bpState != HSAIL_BREAKPOINT_STATE_ENABLED)
     {
         AGENT_ERROR("DisablePCBreakpoint: Disabling a breakpoint in DISABLED already or INVALID");
@@ -587,7 +628,8 @@ HsailAgentStatus AgentBreakpointManager::DisablePCBreakpoint(HwDbgContextHandle
 
     if (pBkpt->m_type == HSAIL_BREAKPOINT_TYPE_PC_BP)
     {
-        status = pBkpt->DeleteBreakpointDBE(DbeContextHandle, ipPacket.m_gdbBreakpointID);
+        status = pBkpt->DeleteBreakpointDBE(DbeContextHandle, gdbId);
+        UnindexGdbId(pBkpt, gdbId);
     }
 
     // Breakpoint deleted in DBE, it shouldn't hit now when we call HwDbgContinue
@@ -737,6 +779,13 @@ HsailAgentStatus AgentBreakpointManager::EnablePCBreakpoint(const HwDbgContextHa
         return HSAIL_AGENT_STATUS_FAILURE;
     }
 
+    return EnablePCBreakpointAt(DbeContextHandle, breakpointpos, static_cast<GdbBkptId>(ipPacket.m_gdbBreakpointID));
+}
+
+HsailAgentStatus AgentBreakpointManager::EnablePCBreakpointAt(const HwDbgContextHandle DbeContextHandle,
+                                                              const int                breakpointpos,
+                                                              const GdbBkptId          gdbId)
+{
     // Added for readability
     AgentBreakpoint* pBkpt = m_pBreakpoints.at(breakpointpos);
 
@@ -773,7 +822,13 @@ HsailAgentStatus AgentBreakpointManager::EnablePCBreakpoint(const HwDbgContextHa
     }
     else
     {
-        status = pBkpt->CreateBreakpointDBE(DbeContextHandle, ipPacket.m_gdbBreakpointID);
+        status = pBkpt->CreateBreakpointDBE(DbeContextHandle, gdbId);
+
+        // The GDB ID was dropped from the breakpoint when it was disabled
+        if (g_UNKOWN_GDB_BKPT_ID != gdbId)
+        {
+            m_breakpointIndex.AddGdbId(gdbId, breakpointpos);
+        }
     }
 
     // Breakpoint created in DBE and state is enabled
@@ -792,6 +847,245 @@ HsailAgentStatus AgentBreakpointManager::AllocateMomentaryBPBuffer() const
     return status;
 }
 
+/// Allocate the shared mem for breakpoint batches
+HsailAgentStatus AgentBreakpointManager::AllocateBreakpointBatchBuffer() const
+{
+    return AgentAllocSharedMemBuffer(g_BREAKPOINT_BATCH_SHMKEY, g_BREAKPOINT_BATCH_MAXSIZE);
+}
+
+/// Free the shared mem for breakpoint batches
+HsailAgentStatus AgentBreakpointManager::FreeBreakpointBatchBuffer() const
+{
+    return AgentFreeSharedMemBuffer(g_BREAKPOINT_BATCH_SHMKEY, g_BREAKPOINT_BATCH_MAXSIZE);
+}
+
+/// Allocate the shared mem for the breakpoint statistics
+HsailAgentStatus AgentBreakpointManager::AllocateBreakpointStatsBuffer()
+{
+    HsailAgentStatus status = AgentAllocSharedMemBuffer(g_BREAKPOINT_STATS_SHMKEY, g_BREAKPOINT_STATS_MAXSIZE);
+
+    // Start out with no breakpoints, rather than whatever a previous session left
+    if (status == HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        m_isStatsLayoutStale = true;
+        status = PublishBreakpointStats();
+    }
+
+    return status;
+}
+
+/// Free the shared mem for the breakpoint statistics
+HsailAgentStatus AgentBreakpointManager::FreeBreakpointStatsBuffer() const
+{
+    return AgentFreeSharedMemBuffer(g_BREAKPOINT_STATS_SHMKEY, g_BREAKPOINT_STATS_MAXSIZE);
+}
+
+/// The most breakpoints whose statistics fit the shared mem
+static const size_t gs_MAX_STATS_BREAKPOINTS = (g_BREAKPOINT_STATS_MAXSIZE - sizeof(HsailBreakpointStatsHeader)) /
+                                               sizeof(HsailBreakpointStats);
+
+/// Work-group slots set aside after a breakpoint's work-groups at least, while there is room
+static const size_t gs_MIN_SPARE_WORKGROUPS = 16;
+
+/// Update the statistics of PC breakpoints in shared mem, gdb can read them at any time so
+/// the write is bracketed by an odd sequence number.
+/// Trace breakpoints are hit over and over, so a hit only rewrites the breakpoint it was at
+HsailAgentStatus AgentBreakpointManager::PublishBreakpointStats()
+{
+    bool isChanged = false;
+    const bool isLayoutCurrent = !m_isStatsLayoutStale && IsStatsLayoutCurrent(&isChanged);
+
+    if (isLayoutCurrent && !isChanged)
+    {
+        return HSAIL_AGENT_STATUS_SUCCESS;
+    }
+
+    HsailBreakpointStatsHeader* pHeader = nullptr;
+    pHeader = (HsailBreakpointStatsHeader*)AgentMapSharedMemBuffer(g_BREAKPOINT_STATS_SHMKEY, g_BREAKPOINT_STATS_MAXSIZE);
+
+    if (pHeader == nullptr)
+    {
+        AGENT_ERROR("PublishBreakpointStats: Could not get the shared mem");
+        return HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    // Only the agent writes the sequence number
+    const uint32_t sequence = pHeader->m_sequence & ~1u;
+    __atomic_store_n(&pHeader->m_sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    if (isLayoutCurrent)
+    {
+        WriteChangedBreakpointStats(pHeader);
+    }
+    else
+    {
+        WriteAllBreakpointStats(pHeader);
+    }
+
+    // Pairs with the acquire load gdb does after copying the statistics
+    __atomic_store_n(&pHeader->m_sequence, sequence + 2, __ATOMIC_RELEASE);
+
+    return AgentUnMapSharedMemBuffer((void*)pHeader);
+}
+
+bool AgentBreakpointManager::IsStatsLayoutCurrent(bool* pIsChangedOut) const
+{
+    *pIsChangedOut = false;
+    size_t statsPos = 0;
+
+    for (size_t i = 0; i < m_pBreakpoints.size(); i++)
+    {
+        const AgentBreakpoint* pBkpt = m_pBreakpoints[i];
+
+        if (pBkpt == nullptr || pBkpt->m_type != HSAIL_BREAKPOINT_TYPE_PC_BP)
+        {
+            continue;
+        }
+
+        // Breakpoints past the last that fit were never published
+        if (statsPos == m_publishedStats.size())
+        {
+            return statsPos == gs_MAX_STATS_BREAKPOINTS;
+        }
+
+        const PublishedStats& published = m_publishedStats[statsPos++];
+
+        if (published.m_pBkpt != pBkpt || published.m_pc != pBkpt->m_pc || published.m_mode != pBkpt->m_mode)
+        {
+            return false;
+        }
+
+        if (pBkpt->m_stats.IsChanged())
+        {
+            // New work-groups beyond the spare slots need a new layout
+            if (!published.m_isTruncated && pBkpt->m_stats.GetWorkGroups().size() > published.m_maxWorkGroups)
+            {
+                return false;
+            }
+
+            *pIsChangedOut = true;
+        }
+    }
+
+    return statsPos == m_publishedStats.size();
+}
+
+void AgentBreakpointManager::WriteAllBreakpointStats(HsailBreakpointStatsHeader* pHeader)
+{
+    m_publishedStats.clear();
+
+    size_t numBreakpoints = 0;
+    size_t numHitWorkGroups = 0;
+
+    for (size_t i = 0; i < m_pBreakpoints.size() && numBreakpoints < gs_MAX_STATS_BREAKPOINTS; i++)
+    {
+        if (m_pBreakpoints[i] != nullptr && m_pBreakpoints[i]->m_type == HSAIL_BREAKPOINT_TYPE_PC_BP)
+        {
+            numBreakpoints++;
+            numHitWorkGroups += m_pBreakpoints[i]->m_stats.GetWorkGroups().size();
+        }
+    }
+
+    // The work-groups go after all breakpoints, as many as fit. Each breakpoint gets
+    // spare slots from what is left over, so its new work-groups can be written in place
+    HsailBreakpointStats* pStats = reinterpret_cast<HsailBreakpointStats*>(pHeader + 1);
+    HsailWorkGroupHits* pWorkGroups = reinterpret_cast<HsailWorkGroupHits*>(pStats + numBreakpoints);
+    const size_t maxWorkGroups = (g_BREAKPOINT_STATS_MAXSIZE - sizeof(HsailBreakpointStatsHeader) -
+                                  numBreakpoints * sizeof(HsailBreakpointStats)) / sizeof(HsailWorkGroupHits);
+    size_t numSpareWorkGroups = maxWorkGroups > numHitWorkGroups ? maxWorkGroups - numHitWorkGroups : 0;
+
+    size_t numWorkGroups = 0;
+    bool isTruncated = false;
+
+    for (size_t i = 0; i < m_pBreakpoints.size() && m_publishedStats.size() < numBreakpoints; i++)
+    {
+        AgentBreakpoint* pBkpt = m_pBreakpoints[i];
+
+        if (pBkpt == nullptr || pBkpt->m_type != HSAIL_BREAKPOINT_TYPE_PC_BP)
+        {
+            continue;
+        }
+
+        const std::vector<HsailWorkGroupHits>& workGroups = pBkpt->m_stats.GetWorkGroups();
+        const size_t numBkptWorkGroups = std::min(workGroups.size(), maxWorkGroups - numWorkGroups);
+        const size_t numSpare = std::min(numSpareWorkGroups, std::max(workGroups.size(), gs_MIN_SPARE_WORKGROUPS));
+
+        PublishedStats published;
+        published.m_pBkpt = pBkpt;
+        published.m_pc = pBkpt->m_pc;
+        published.m_mode = pBkpt->m_mode;
+        published.m_firstWorkGroup = numWorkGroups;
+        published.m_isTruncated = numBkptWorkGroups != workGroups.size();
+        published.m_maxWorkGroups = numBkptWorkGroups + (published.m_isTruncated ? 0 : numSpare);
+
+        if (!published.m_isTruncated)
+        {
+            numSpareWorkGroups -= numSpare;
+        }
+
+        HsailBreakpointStats& stats = pStats[m_publishedStats.size()];
+        memset(&stats, 0, sizeof(HsailBreakpointStats));
+        stats.m_pc = pBkpt->m_pc;
+        stats.m_mode = pBkpt->m_mode;
+        stats.m_firstWorkGroup = numWorkGroups;
+        stats.m_numWorkGroups = (uint32_t)numBkptWorkGroups;
+        pBkpt->m_stats.GetCounters(stats);
+
+        if (numBkptWorkGroups != 0)
+        {
+            memcpy(pWorkGroups + numWorkGroups, workGroups.data(), numBkptWorkGroups * sizeof(HsailWorkGroupHits));
+        }
+
+        numWorkGroups += published.m_maxWorkGroups;
+        isTruncated = isTruncated || published.m_isTruncated;
+        pBkpt->m_stats.MarkPublished();
+        m_publishedStats.push_back(published);
+    }
+
+    pHeader->m_numBreakpoints = (uint32_t)numBreakpoints;
+    pHeader->m_numWorkGroups = (uint32_t)numWorkGroups;
+    pHeader->m_isTruncated = isTruncated ? 1 : 0;
+    m_isStatsLayoutStale = false;
+}
+
+void AgentBreakpointManager::WriteChangedBreakpointStats(HsailBreakpointStatsHeader* pHeader)
+{
+    HsailBreakpointStats* pStats = reinterpret_cast<HsailBreakpointStats*>(pHeader + 1);
+    HsailWorkGroupHits* pWorkGroups = reinterpret_cast<HsailWorkGroupHits*>(pStats + m_publishedStats.size());
+
+    for (size_t i = 0; i < m_publishedStats.size(); i++)
+    {
+        const PublishedStats& published = m_publishedStats[i];
+        AgentBreakpointStats& bkptStats = published.m_pBkpt->m_stats;
+
+        if (!bkptStats.IsChanged())
+        {
+            continue;
+        }
+
+        const std::vector<HsailWorkGroupHits>& workGroups = bkptStats.GetWorkGroups();
+        const size_t numBkptWorkGroups = std::min(workGroups.size(), published.m_maxWorkGroups);
+
+        HsailBreakpointStats& stats = pStats[i];
+        stats.m_numWorkGroups = (uint32_t)numBkptWorkGroups;
+        bkptStats.GetCounters(stats);
+
+        if (numBkptWorkGroups != 0)
+        {
+            memcpy(pWorkGroups + published.m_firstWorkGroup, workGroups.data(),
+                   numBkptWorkGroups * sizeof(HsailWorkGroupHits));
+        }
+
+        if (numBkptWorkGroups != workGroups.size())
+        {
+            pHeader->m_isTruncated = 1;
+        }
+
+        bkptStats.MarkPublished();
+    }
+}
+
 /// Free the shared mem for the momentary breakpoints
 HsailAgentStatus AgentBreakpointManager::FreeMomentaryBPBuffer() const
 {
@@ -827,53 +1121,276 @@ HsailAgentStatus AgentBreakpointManager::CreateMomentaryBreakpoints(const HwDbgC
 
     AGENT_LOG("MomentaryBreakpoint: Create " << numMomentaryBp << " momentary breakpoints");
 
+    // These go away with the next stop, step breakpoints of an earlier line included
+    m_keepMomentaryBreakpoints = false;
+
     for (int i = 0; i < numMomentaryBp; i++)
     {
-        // Bind this breakpoint's PC:
-        // We need a valid DBE context for this call
-        // This enforces our step in logic which says that we cannot create a kernel pc
-        // breakpoint before we create a function breakpoint
-        AgentBreakpoint* pBkpt = new(std::nothrow) AgentBreakpoint;
+        status = AddMomentaryBreakpoint(DbeContextHandle, (HwDbgCodeAddress)pMomentaryBP[i].m_pc, pMomentaryBP[i].m_lineNum);
+    }
+
+    // Clear memory after we are done
+    memset(pMomentaryBP, 0, sizeof(HsailMomentaryBP)*numMomentaryBp);
+
+    status = AgentUnMapSharedMemBuffer((void*)pMomentaryBP);
+    return status;
+}
+
+/// Create one momentary breakpoint
+HsailAgentStatus AgentBreakpointManager::AddMomentaryBreakpoint(const HwDbgContextHandle DbeContextHandle,
+                                                                const HwDbgCodeAddress   pc,
+                                                                const int                lineNum)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    // Bind this breakpoint's PC:
+    // We need a valid DBE context for this call
+    // This enforces our step in logic which says that we cannot create a kernel pc
+    // breakpoint before we create a function breakpoint
+    AgentBreakpoint* pBkpt = new(std::nothrow) AgentBreakpoint;
+
+    if (pBkpt == nullptr)
+    {
+        AGENT_ERROR("MomentaryBreakpoint: Error in allocating AgentBreakpoint");
+        return status;
+    }
+
+    if (HSAIL_ISA_PC_UNKOWN != pc && nullptr != DbeContextHandle)
+    {
+        pBkpt->m_pc = pc;
+        pBkpt->m_type = HwDbgAgent::HSAIL_BREAKPOINT_TYPE_PC_BP;
+        pBkpt->m_lineNum = lineNum;
+        status = pBkpt->CreateBreakpointDBE(DbeContextHandle);
+    }
+
+    // We don't have source line information for temporary breakpoints
+    // and kernel function breakpoints for now
+    // We print line information for other types
+
+    if (status == HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        pBkpt->m_bpState = HSAIL_BREAKPOINT_STATE_ENABLED;
+        m_pMomentaryBreakpoints.push_back(pBkpt);
+        m_momentaryBreakpointIndex.AddPC(pBkpt->m_pc, (int)m_pMomentaryBreakpoints.size() - 1);
+    }
+    else
+    {
+        delete pBkpt;
+    }
+
+    return status;
+}
+
+/// The position of the PC breakpoint at this PC, -1 if there is none
+int AgentBreakpointManager::GetPCBreakpointPosition(const HwDbgCodeAddress pc) const
+{
+    return m_breakpointIndex.FindFirstPC(pc, [this](const int position)
+    {
+        const AgentBreakpoint* pBkpt = m_pBreakpoints.at(position);
+        return (pBkpt != nullptr && pBkpt->m_type == HSAIL_BREAKPOINT_TYPE_PC_BP);
+    });
+}
 
-        if (pBkpt == nullptr)
+/// Set the condition program of a breakpoint, the program follows the batch's operations
+HsailAgentStatus AgentBreakpointManager::SetBreakpointProgramAt(const int                breakpointPos,
+                                                                const HsailBreakpointOp& op,
+                                                                const uint8_t*           pBatch,
+                                                                const size_t             batchSize)
+{
+    const HsailConditionOp* pProgram = nullptr;
+
+    if (op.m_numConditionOps != 0)
+    {
+        const size_t programSize = op.m_numConditionOps * sizeof(HsailConditionOp);
+
+        if (op.m_numConditionOps > HSAIL_MAX_CONDITION_OPS ||
+            op.m_conditionOffset > batchSize || programSize > batchSize - op.m_conditionOffset ||
+            op.m_conditionOffset % sizeof(uint64_t) != 0)
         {
-            AGENT_ERROR("MomentaryBreakpoint: Error in allocating AgentBreakpoint");
-            return status;
+            AGENT_ERROR("SetBreakpointProgramAt: Condition program of " << op.m_numConditionOps <<
+                        " operations at " << op.m_conditionOffset << " is outside the batch");
+            return HSAIL_AGENT_STATUS_FAILURE;
         }
 
-        HwDbgCodeAddress pc = pMomentaryBP[i].m_pc ;
+        pProgram = reinterpret_cast<const HsailConditionOp*>(pBatch + op.m_conditionOffset);
+    }
+
+    return m_pBreakpoints.at(breakpointPos)->m_condition.SetProgram(pProgram, op.m_numConditionOps);
+}
+
+HsailAgentStatus AgentBreakpointManager::SetBreakpointModeAt(const int breakpointPos, const uint32_t mode)
+{
+    if (mode != HSAIL_BREAKPOINT_MODE_STOP && mode != HSAIL_BREAKPOINT_MODE_TRACE)
+    {
+        AGENT_ERROR("SetBreakpointModeAt: Unknown breakpoint mode " << mode);
+        return HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    AgentBreakpoint* pBkpt = m_pBreakpoints.at(breakpointPos);
+
+    if (mode == HSAIL_BREAKPOINT_MODE_TRACE && pBkpt->m_mode != HSAIL_BREAKPOINT_MODE_TRACE)
+    {
+        pBkpt->m_stats.Clear();
+    }
+
+    pBkpt->m_mode = (HsailBreakpointMode)mode;
 
-        if (HSAIL_ISA_PC_UNKOWN != pc && nullptr != DbeContextHandle)
+    AGENT_LOG("SetBreakpointModeAt: Breakpoint at PC 0x" << std::hex << pBkpt->m_pc << std::dec <<
+              (mode == HSAIL_BREAKPOINT_MODE_TRACE ? " traces" : " stops"));
+
+    return HSAIL_AGENT_STATUS_SUCCESS;
+}
+
+/// Apply a single operation of a breakpoint batch
+HsailAgentStatus AgentBreakpointManager::ApplyBreakpointOp(const HwDbgContextHandle DbeContextHandle,
+                                                           const HsailBreakpointOp& op,
+                                                           const uint8_t*           pBatch,
+                                                           const size_t             batchSize)
+{
+    if (op.m_op == HSAIL_BREAKPOINT_OP_CREATE)
+    {
+        // Go through CreateBreakpoint so duplicates are handled the same way as for single packets
+        HsailCommandPacket createPacket;
+        memset(&createPacket, 0, sizeof(HsailCommandPacket));
+        createPacket.m_command = HSAIL_COMMAND_CREATE_BREAKPOINT;
+        createPacket.m_gdbBreakpointID = op.m_gdbBreakpointID;
+        createPacket.m_pc = op.m_pc;
+        createPacket.m_lineNum = op.m_lineNum;
+        createPacket.m_conditionPacket.m_conditionCode = HSAIL_BREAKPOINT_CONDITION_ANY;
+
+        HsailAgentStatus status = CreateBreakpoint(DbeContextHandle, createPacket, HSAIL_BREAKPOINT_TYPE_PC_BP);
+
+        // Breakpoints at the same PC share their condition and mode, the last one set wins
+        if (status == HSAIL_AGENT_STATUS_SUCCESS && op.m_numConditionOps != 0)
         {
-            pBkpt->m_pc = (HwDbgCodeAddress)pc;
-            pBkpt->m_type = HwDbgAgent::HSAIL_BREAKPOINT_TYPE_PC_BP;
-            pBkpt->m_lineNum = pMomentaryBP[i].m_lineNum;
-            status = pBkpt->CreateBreakpointDBE(DbeContextHandle);
+            status = SetBreakpointProgramAt(GetPCBreakpointPosition(op.m_pc), op, pBatch, batchSize);
         }
 
-        if (status == HSAIL_AGENT_STATUS_SUCCESS)
+        if (status == HSAIL_AGENT_STATUS_SUCCESS && op.m_mode != HSAIL_BREAKPOINT_MODE_STOP)
         {
-            pBkpt->m_bpState = HSAIL_BREAKPOINT_STATE_ENABLED;
+            status = SetBreakpointModeAt(GetPCBreakpointPosition(op.m_pc), op.m_mode);
         }
 
-        // We don't have source line information for temporary breakpoints
-        // and kernel function breakpoints for now
-        // We print line information for other types
+        return status;
+    }
+
+    // Step breakpoints are momentary breakpoints, they never go through the PC breakpoints
+    if (op.m_op == HSAIL_BREAKPOINT_OP_STEP_CLEAR)
+    {
+        m_keepMomentaryBreakpoints = false;
+        return ClearMomentaryBreakpoints(DbeContextHandle);
+    }
+
+    if (op.m_op == HSAIL_BREAKPOINT_OP_STEP)
+    {
+        m_keepMomentaryBreakpoints = true;
+        return AddMomentaryBreakpoint(DbeContextHandle, op.m_pc, op.m_lineNum);
+    }
+
+    int breakpointPos = GetPCBreakpointPosition(op.m_pc);
 
-        if (status == HSAIL_AGENT_STATUS_SUCCESS)
+    if (breakpointPos == -1)
+    {
+        AGENT_ERROR("ApplyBreakpointOp: No breakpoint at PC 0x" << std::hex << op.m_pc << std::dec);
+        return HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    switch (op.m_op)
+    {
+        case HSAIL_BREAKPOINT_OP_DELETE:
+            return DeleteBreakpointAt(DbeContextHandle, breakpointPos, op.m_gdbBreakpointID);
+
+        case HSAIL_BREAKPOINT_OP_ENABLE:
+            return EnablePCBreakpointAt(DbeContextHandle, breakpointPos, op.m_gdbBreakpointID);
+
+        case HSAIL_BREAKPOINT_OP_DISABLE:
+            return DisablePCBreakpointAt(DbeContextHandle, breakpointPos, op.m_gdbBreakpointID);
+
+        case HSAIL_BREAKPOINT_OP_CONDITION:
+            return SetBreakpointProgramAt(breakpointPos, op, pBatch, batchSize);
+
+        case HSAIL_BREAKPOINT_OP_MODE:
+            return SetBreakpointModeAt(breakpointPos, op.m_mode);
+
+        default:
+            AGENT_ERROR("ApplyBreakpointOp: Unknown breakpoint operation " << op.m_op);
+            return HSAIL_AGENT_STATUS_FAILURE;
+    }
+}
+
+/// Apply all operations of a breakpoint batch in one pass over the shared mem
+HsailAgentStatus AgentBreakpointManager::ApplyBreakpointBatch(const HwDbgContextHandle DbeContextHandle,
+                                                              const HsailCommandPacket ipPacket)
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+
+    if (ipPacket.m_command != HSAIL_COMMAND_BREAKPOINT_BATCH)
+    {
+        AGENT_ERROR("ApplyBreakpointBatch: Function called for wrong packet type");
+        return status;
+    }
+
+    HsailBreakpointBatchHeader* pHeader = nullptr;
+    pHeader = (HsailBreakpointBatchHeader*)AgentMapSharedMemBuffer(g_BREAKPOINT_BATCH_SHMKEY, g_BREAKPOINT_BATCH_MAXSIZE);
+
+    if (pHeader == nullptr)
+    {
+        AGENT_ERROR("ApplyBreakpointBatch: Could not get the shared mem");
+        return status;
+    }
+
+    // Pairs with the release store gdb does after writing the operations
+    uint32_t sequence = __atomic_load_n(&pHeader->m_sequence, __ATOMIC_ACQUIRE);
+
+    const size_t maxOps = (g_BREAKPOINT_BATCH_MAXSIZE - sizeof(HsailBreakpointBatchHeader)) / sizeof(HsailBreakpointOp);
+    size_t numOps = pHeader->m_numOps;
+
+    if (numOps > maxOps)
+    {
+        AGENT_ERROR("ApplyBreakpointBatch: Batch of " << numOps << " operations does not fit, truncating");
+        numOps = maxOps;
+    }
+
+    HsailBreakpointOp* pOps = reinterpret_cast<HsailBreakpointOp*>(pHeader + 1);
+    unsigned int failureCount = 0;
+
+    AGENT_LOG("ApplyBreakpointBatch: Apply " << numOps << " breakpoint operations");
+
+    // gdb reads back which operations failed once the batch is consumed
+    for (size_t i = 0; i < numOps; i++)
+    {
+        if (ApplyBreakpointOp(DbeContextHandle, pOps[i],
+                              reinterpret_cast<const uint8_t*>(pHeader),
+                              g_BREAKPOINT_BATCH_MAXSIZE) != HSAIL_AGENT_STATUS_SUCCESS)
         {
-            m_pMomentaryBreakpoints.push_back(pBkpt);
+            pOps[i].m_status = HSAIL_BREAKPOINT_OP_STATUS_FAILURE;
+            failureCount++;
         }
         else
         {
-            delete pBkpt;
+            pOps[i].m_status = HSAIL_BREAKPOINT_OP_STATUS_SUCCESS;
         }
     }
 
-    // Clear memory after we are done
-    memset(pMomentaryBP, 0, sizeof(HsailMomentaryBP)*numMomentaryBp);
+    // Let gdb know it can write the next batch, and read the status
+    __atomic_store_n(&pHeader->m_consumed, sequence, __ATOMIC_RELEASE);
+
+    AgentTrace(AGENT_TRACE_EVENT_BREAKPOINT_BATCH, sequence, numOps);
+
+    status = AgentUnMapSharedMemBuffer((void*)pHeader);
+
+    // Deleted breakpoints and mode changes show up in the statistics straight away
+    if (PublishBreakpointStats() != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("ApplyBreakpointBatch: Could not publish the breakpoint statistics");
+    }
+
+    if (failureCount != 0)
+    {
+        AGENT_ERROR("ApplyBreakpointBatch: " << failureCount << " of " << numOps << " operations failed");
+        status = HSAIL_AGENT_STATUS_FAILURE;
+    }
 
-    status = AgentUnMapSharedMemBuffer((void*)pMomentaryBP);
     return status;
 }
 
@@ -893,8 +1410,10 @@ HsailAgentStatus AgentBreakpointManager::ClearMomentaryBreakpoints(const HwDbgCo
         HwDbgCodeAddress currentPC = pCurrentBP->m_pc;
 
         // If there's a non-momentary breakpoint set at the same PC, don't clear the BP from the hardware
+        // Step breakpoints kept past the end of a dispatch are pending, the DBE deleted them already
 
-        if (currentPC != HSAIL_ISA_PC_UNKOWN  &&  !IsPCBreakpoint(currentPC))
+        if (currentPC != HSAIL_ISA_PC_UNKOWN  &&  !IsPCBreakpoint(currentPC) &&
+            pCurrentBP->m_bpState == HSAIL_BREAKPOINT_STATE_ENABLED)
         {
             status = pCurrentBP->DeleteBreakpointDBE(DbeContextHandle);
 
@@ -909,10 +1428,16 @@ HsailAgentStatus AgentBreakpointManager::ClearMomentaryBreakpoints(const HwDbgCo
     }
 
     m_pMomentaryBreakpoints.clear();
+    m_momentaryBreakpointIndex.Clear();
 
     return (0 == failureCount) ? HSAIL_AGENT_STATUS_SUCCESS : HSAIL_AGENT_STATUS_FAILURE;
 }
 
+bool AgentBreakpointManager::IsKeepingMomentaryBreakpoints() const
+{
+    return m_keepMomentaryBreakpoints;
+}
+
 // Count the number of  momentary breakpoints in a particular state,
 // The default HsailBkptType parameter assumes all momentary breakpoints are PC breakpoints
 int AgentBreakpointManager::GetNumMomentaryBreakpointsInState(const HsailBkptState ipState, const HsailBkptType type) const
@@ -1051,6 +1576,7 @@ void AgentBreakpointManager::PrintWaveInfo(const HwDbgWavefrontInfo* pWaveInfo,
 /// for now
 HsailAgentStatus AgentBreakpointManager::PrintStoppedReason(const HwDbgEventType         DbeEventType,
                                                             const HwDbgContextHandle     DbeContextHandle,
+                                                            const HwDbgDim3&             workGroupSize,
                                                                   AgentFocusWaveControl* pFocusWaveControl,
                                                                   bool*                  pIsStopNeeded)
 {
@@ -1091,6 +1617,10 @@ HsailAgentStatus AgentBreakpointManager::PrintStoppedReason(const HwDbgEventType
     // A logic check, we should have atleast one valid breakpoint set
     bool checkSingleValidBreakpoint = false;
 
+    // Hits of each breakpoint by the waves of this stop so far, the hit counts
+    // themselves are only updated by UpdateBreakpointStatistics
+    std::unordered_map<const AgentBreakpoint*, int> stopHitCounts;
+
     // For all active waves, that we get from the DBE
     for (size_t i = 0; i < nWaves; i++)
     {
@@ -1116,17 +1646,42 @@ HsailAgentStatus AgentBreakpointManager::PrintStoppedReason(const HwDbgEventType
 
             checkSingleValidBreakpoint = true;
 
+            // Trace breakpoints are only counted, unless a step ends at the same PC
+            if (!isMomentary && pHitBP->m_mode == HSAIL_BREAKPOINT_MODE_TRACE)
+            {
+                const std::vector<int>* pMomentaryPositions = m_momentaryBreakpointIndex.FindPC(pWaveInfo[i].codeAddress);
+
+                if (pMomentaryPositions == nullptr || pMomentaryPositions->empty())
+                {
+                    continue;
+                }
+
+                *pIsStopNeeded = true;
+                break;
+            }
+
+            const uint64_t hitCount = (uint64_t)pHitBP->m_hitcount + (++stopHitCounts[pHitBP]);
+
             // If the focus doesnt match, check that the breakpoint is conditional or not
             bool checkCondition = false;
             HsailConditionCode condCode;
-            pHitBP->m_condition.CheckCondition(&pWaveInfo[i], checkCondition, condCode);
+            int matchingLane = -1;
+            pHitBP->m_condition.CheckCondition(&pWaveInfo[i], workGroupSize, hitCount,
+                                               checkCondition, condCode, matchingLane);
 
             if (checkCondition)
             {
 
+                // A condition program focuses on the first lane it matched
+                if (condCode == HSAIL_BREAKPOINT_CONDITION_PROGRAM && matchingLane != -1)
+                {
+                    HwDbgDim3 focusWg = pWaveInfo[i].workGroupId;
+                    HwDbgDim3 focusWi = pWaveInfo[i].workItemId[matchingLane];
+                    pFocusWaveControl->SetFocusWave(nullptr, &focusWg, &focusWi);
+                }
                 // We need to change the focus only if it is a real conditional
-                if (condCode != HSAIL_BREAKPOINT_CONDITION_ANY &&
-                    condCode != HSAIL_BREAKPOINT_CONDITION_UNKNOWN)
+                else if (condCode != HSAIL_BREAKPOINT_CONDITION_ANY &&
+                         condCode != HSAIL_BREAKPOINT_CONDITION_UNKNOWN)
                 {
                     HwDbgDim3 focusWg = pHitBP->m_condition.GetWG();
                     HwDbgDim3 focusWi = pHitBP->m_condition.GetWI();
@@ -1153,7 +1708,8 @@ HsailAgentStatus AgentBreakpointManager::PrintStoppedReason(const HwDbgEventType
 
 // We update each breakpoint's hit count by one if one wave is at the breakpoint
 HsailAgentStatus AgentBreakpointManager::UpdateBreakpointStatistics(const HwDbgEventType DbeEventType,
-                                                                    const HwDbgContextHandle DbeContextHandle)
+                                                                    const HwDbgContextHandle DbeContextHandle,
+                                                                    const bool isStopNeeded)
 {
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
     HwDbgStatus dbeStatus;
@@ -1222,6 +1778,8 @@ HsailAgentStatus AgentBreakpointManager::UpdateBreakpointStatistics(const HwDbgE
             // Momentary breakpoints are not GDB breakpoints:
             if (!isMomentary)
             {
+                pHitBP->m_stats.AddWave(pWaveInfo[i]);
+
                 // Save it to the payload
                 status = pHitBP->UpdateNotificationPayload(&notifyPayload);
 
@@ -1242,10 +1800,71 @@ HsailAgentStatus AgentBreakpointManager::UpdateBreakpointStatistics(const HwDbgE
         return status;
     }
 
+    if (PublishBreakpointStats() != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("UpdateBreakpointStatistics: Could not publish the breakpoint statistics");
+    }
+
+    // No breakpoint condition matched, the dispatch resumes without gdb hearing about it
+    if (!isStopNeeded)
+    {
+        AGENT_LOG("UpdateBreakpointStatistics: No condition matched, do not notify gdb");
+        return HSAIL_AGENT_STATUS_SUCCESS;
+    }
+
     status = AgentNotifyBreakpointHit(notifyPayload);
     return status;
 }
 
+AgentDispatchFilter& AgentBreakpointManager::GetDispatchFilter()
+{
+    return m_dispatchFilter;
+}
+
+bool AgentBreakpointManager::CanSkipDispatch(const hsa_kernel_dispatch_packet_t* pAqlPacket) const
+{
+    // gdb selects all kernels while it has breakpoints the agent does not know of yet,
+    // such as source breakpoints waiting for the code object of a kernel to resolve
+    if (m_dispatchFilter.IsAllKernels())
+    {
+        return false;
+    }
+
+    // PC breakpoints are isa offsets in whichever kernel is dispatched, any of them could hit
+    int numPCBreakpoints =
+        GetNumBreakpointsInState(HSAIL_BREAKPOINT_STATE_ENABLED, HSAIL_BREAKPOINT_TYPE_PC_BP) +
+        GetNumBreakpointsInState(HSAIL_BREAKPOINT_STATE_PENDING, HSAIL_BREAKPOINT_TYPE_PC_BP) +
+        GetNumMomentaryBreakpointsInState(HSAIL_BREAKPOINT_STATE_ENABLED) +
+        GetNumMomentaryBreakpointsInState(HSAIL_BREAKPOINT_STATE_PENDING);
+
+    if (0 < numPCBreakpoints)
+    {
+        return false;
+    }
+
+    int numFunctionBreakpoints =
+        GetNumBreakpointsInState(HSAIL_BREAKPOINT_STATE_ENABLED, HSAIL_BREAKPOINT_TYPE_KERNEL_NAME_BP) +
+        GetNumBreakpointsInState(HSAIL_BREAKPOINT_STATE_PENDING, HSAIL_BREAKPOINT_TYPE_KERNEL_NAME_BP);
+
+    if (0 == numFunctionBreakpoints && !m_dispatchFilter.HasKernelNames())
+    {
+        return true;
+    }
+
+    // The kernel name comes from the binary, which needs the DBE, unless the
+    // kernel object was dispatched before
+    std::string kernelName;
+
+    if (!AgentBinary::FindCachedKernelName(pAqlPacket, kernelName))
+    {
+        return false;
+    }
+
+    int funcBPPosition = -1;
+    return !m_dispatchFilter.IsKernelSelected(kernelName) &&
+           !CheckAgainstKernelNameBreakpoints(kernelName, &funcBPPosition);
+}
+
 HsailAgentStatus AgentBreakpointManager::ReportFunctionBreakpoint(const std::string& kernelFunctionName)
 {
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
@@ -1325,6 +1944,20 @@ AgentBreakpointManager::~AgentBreakpointManager()
         AGENT_ERROR("~AgentBreakpointManager: Could not free the shared mem buffer for momentary BP");
     }
 
+    status = FreeBreakpointBatchBuffer();
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("~AgentBreakpointManager: Could not free the shared mem buffer for breakpoint batches");
+    }
+
+    status = FreeBreakpointStatsBuffer();
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("~AgentBreakpointManager: Could not free the shared mem buffer for breakpoint statistics");
+    }
+
     AGENT_LOG("~AgentBreakpointManager: Free Breakpoint Manager");
     // What other cleanup is needed ?
 }
@@ -0,0 +1,279 @@
+//==============================================================================
+// Copyright (c) 2015 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Breakpoint condition programs evaluated inside the agent
+//==============================================================================
+#include "AgentConditionProgram.h"
+#include "AgentLogging.h"
+
+namespace HwDbgAgent
+{
+
+/// \return the number of values an operation pops and pushes, false for an unknown operation
+static bool GetStackEffect(const uint32_t op, int& popCount, int& pushCount, bool& isLaneDependent)
+{
+    popCount = 0;
+    pushCount = 1;
+    isLaneDependent = false;
+
+    switch (op)
+    {
+        case HSAIL_CONDITION_OP_WORKITEM_ID:
+        case HSAIL_CONDITION_OP_GLOBAL_ID:
+        case HSAIL_CONDITION_OP_LANE:
+            isLaneDependent = true;
+            return true;
+
+        case HSAIL_CONDITION_OP_CONST:
+        case HSAIL_CONDITION_OP_WORKGROUP_ID:
+        case HSAIL_CONDITION_OP_EXEC_MASK:
+        case HSAIL_CONDITION_OP_ACTIVE_LANES:
+        case HSAIL_CONDITION_OP_HIT_COUNT:
+            return true;
+
+        case HSAIL_CONDITION_OP_MOD:
+        case HSAIL_CONDITION_OP_BIT_AND:
+        case HSAIL_CONDITION_OP_EQ:
+        case HSAIL_CONDITION_OP_NE:
+        case HSAIL_CONDITION_OP_LT:
+        case HSAIL_CONDITION_OP_LE:
+        case HSAIL_CONDITION_OP_GT:
+        case HSAIL_CONDITION_OP_GE:
+        case HSAIL_CONDITION_OP_AND:
+        case HSAIL_CONDITION_OP_OR:
+            popCount = 2;
+            return true;
+
+        case HSAIL_CONDITION_OP_IN_RANGE:
+            popCount = 3;
+            return true;
+
+        case HSAIL_CONDITION_OP_NOT:
+            popCount = 1;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+static uint32_t GetDim3Component(const HwDbgDim3& dim, const uint64_t component)
+{
+    return (component == 0) ? dim.x : ((component == 1) ? dim.y : dim.z);
+}
+
+HsailAgentStatus AgentConditionProgram::SetProgram(const HsailConditionOp* pOps, const size_t numOps)
+{
+    if (numOps == 0)
+    {
+        Clear();
+        return HSAIL_AGENT_STATUS_SUCCESS;
+    }
+
+    if (pOps == nullptr)
+    {
+        AGENT_ERROR("SetProgram: Condition program is nullptr");
+        return HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    std::vector<HsailConditionOp> ops;
+    bool isLaneDependent = false;
+    int depth = 0;
+
+    for (size_t i = 0; i < numOps && pOps[i].m_op != HSAIL_CONDITION_OP_END; i++)
+    {
+        int popCount = 0;
+        int pushCount = 0;
+        bool isOpLaneDependent = false;
+
+        if (!GetStackEffect(pOps[i].m_op, popCount, pushCount, isOpLaneDependent))
+        {
+            AGENT_ERROR("SetProgram: Unknown condition operation " << pOps[i].m_op << " at " << i);
+            return HSAIL_AGENT_STATUS_FAILURE;
+        }
+
+        if ((pOps[i].m_op == HSAIL_CONDITION_OP_WORKGROUP_ID ||
+             pOps[i].m_op == HSAIL_CONDITION_OP_WORKITEM_ID ||
+             pOps[i].m_op == HSAIL_CONDITION_OP_GLOBAL_ID) && pOps[i].m_operand > 2)
+        {
+            AGENT_ERROR("SetProgram: Invalid dimension " << pOps[i].m_operand << " at " << i);
+            return HSAIL_AGENT_STATUS_FAILURE;
+        }
+
+        depth -= popCount;
+
+        if (depth < 0)
+        {
+            AGENT_ERROR("SetProgram: Condition stack underflow at " << i);
+            return HSAIL_AGENT_STATUS_FAILURE;
+        }
+
+        depth += pushCount;
+
+        if (depth > HSAIL_MAX_CONDITION_STACK)
+        {
+            AGENT_ERROR("SetProgram: Condition stack overflow at " << i);
+            return HSAIL_AGENT_STATUS_FAILURE;
+        }
+
+        isLaneDependent = isLaneDependent || isOpLaneDependent;
+        ops.push_back(pOps[i]);
+    }
+
+    if (depth != 1 || ops.size() > HSAIL_MAX_CONDITION_OPS)
+    {
+        AGENT_ERROR("SetProgram: Condition program of " << ops.size() << " operations leaves " << depth << " values");
+        return HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    m_ops.swap(ops);
+    m_isLaneDependent = isLaneDependent;
+
+    AGENT_LOG("SetProgram: Condition program of " << m_ops.size() << " operations" <<
+              (m_isLaneDependent ? ", evaluated per lane" : ""));
+
+    return HSAIL_AGENT_STATUS_SUCCESS;
+}
+
+void AgentConditionProgram::Clear()
+{
+    m_ops.clear();
+    m_isLaneDependent = false;
+}
+
+bool AgentConditionProgram::IsEmpty() const
+{
+    return m_ops.empty();
+}
+
+uint64_t AgentConditionProgram::Run(const HwDbgWavefrontInfo& waveInfo,
+                                    const HwDbgDim3&          workGroupSize,
+                                    const uint64_t            hitCount,
+                                    const int                 lane) const
+{
+    // The program was validated, the stack cannot under or overflow
+    uint64_t stack[HSAIL_MAX_CONDITION_STACK];
+    int top = -1;
+
+    for (size_t i = 0; i < m_ops.size(); i++)
+    {
+        const HsailConditionOp& op = m_ops[i];
+
+        switch (op.m_op)
+        {
+            case HSAIL_CONDITION_OP_CONST:
+                stack[++top] = op.m_operand;
+                break;
+
+            case HSAIL_CONDITION_OP_WORKGROUP_ID:
+                stack[++top] = GetDim3Component(waveInfo.workGroupId, op.m_operand);
+                break;
+
+            case HSAIL_CONDITION_OP_WORKITEM_ID:
+                stack[++top] = GetDim3Component(waveInfo.workItemId[lane], op.m_operand);
+                break;
+
+            case HSAIL_CONDITION_OP_GLOBAL_ID:
+                stack[++top] = (uint64_t)GetDim3Component(waveInfo.workGroupId, op.m_operand) *
+                               GetDim3Component(workGroupSize, op.m_operand) +
+                               GetDim3Component(waveInfo.workItemId[lane], op.m_operand);
+                break;
+
+            case HSAIL_CONDITION_OP_LANE:
+                stack[++top] = (uint64_t)lane;
+                break;
+
+            case HSAIL_CONDITION_OP_EXEC_MASK:
+                stack[++top] = waveInfo.executionMask;
+                break;
+
+            case HSAIL_CONDITION_OP_ACTIVE_LANES:
+                stack[++top] = (uint64_t)__builtin_popcountll(waveInfo.executionMask);
+                break;
+
+            case HSAIL_CONDITION_OP_HIT_COUNT:
+                stack[++top] = hitCount;
+                break;
+
+            case HSAIL_CONDITION_OP_NOT:
+                stack[top] = !stack[top];
+                break;
+
+            case HSAIL_CONDITION_OP_IN_RANGE:
+                top -= 2;
+                stack[top] = stack[top + 1] <= stack[top] && stack[top] <= stack[top + 2];
+                break;
+
+            default:
+            {
+                const uint64_t b = stack[top--];
+                const uint64_t a = stack[top];
+                uint64_t result = 0;
+
+                switch (op.m_op)
+                {
+                    case HSAIL_CONDITION_OP_MOD:     result = (b == 0) ? 0 : a % b; break;
+                    case HSAIL_CONDITION_OP_BIT_AND: result = a & b;  break;
+                    case HSAIL_CONDITION_OP_EQ:      result = a == b; break;
+                    case HSAIL_CONDITION_OP_NE:      result = a != b; break;
+                    case HSAIL_CONDITION_OP_LT:      result = a < b;  break;
+                    case HSAIL_CONDITION_OP_LE:      result = a <= b; break;
+                    case HSAIL_CONDITION_OP_GT:      result = a > b;  break;
+                    case HSAIL_CONDITION_OP_GE:      result = a >= b; break;
+                    case HSAIL_CONDITION_OP_AND:     result = a && b; break;
+                    case HSAIL_CONDITION_OP_OR:      result = a || b; break;
+                    default: break;
+                }
+
+                stack[top] = result;
+                break;
+            }
+        }
+    }
+
+    return stack[top];
+}
+
+bool AgentConditionProgram::Evaluate(const HwDbgWavefrontInfo& waveInfo,
+                                     const HwDbgDim3&          workGroupSize,
+                                     const uint64_t            hitCount,
+                                     int*                      pMatchingLaneOut) const
+{
+    int matchingLane = -1;
+
+    if (m_ops.empty())
+    {
+        matchingLane = (waveInfo.executionMask != 0) ? __builtin_ctzll(waveInfo.executionMask) : 0;
+    }
+    else if (!m_isLaneDependent)
+    {
+        if (Run(waveInfo, workGroupSize, hitCount, -1) != 0)
+        {
+            matchingLane = (waveInfo.executionMask != 0) ? __builtin_ctzll(waveInfo.executionMask) : 0;
+        }
+    }
+    else
+    {
+        for (uint64_t execMask = waveInfo.executionMask; execMask != 0; execMask &= execMask - 1)
+        {
+            const int lane = __builtin_ctzll(execMask);
+
+            if (lane < HWDBG_WAVEFRONT_SIZE && Run(waveInfo, workGroupSize, hitCount, lane) != 0)
+            {
+                matchingLane = lane;
+                break;
+            }
+        }
+    }
+
+    if (pMatchingLaneOut != nullptr)
+    {
+        *pMatchingLaneOut = matchingLane;
+    }
+
+    return matchingLane != -1;
+}
+
+} // End Namespace HwDbgAgent
@@ -29,7 +29,7 @@ namespace HwDbgAgent
 HsailAgentStatus AgentContext::AllocateBinarySharedMemBuffer()
 {
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
-    status = AgentAllocSharedMemBuffer(g_DBEBINARY_SHMKEY, g_BINARY_BUFFER_MAXSIZE);
+    status = AgentAllocSharedMemBuffer(g_DBEBINARY_SHMKEY, g_BINARY_BUFFER_INITIALSIZE);
 
     if (status != HSAIL_AGENT_STATUS_SUCCESS)
     {
@@ -43,7 +43,7 @@ HsailAgentStatus AgentContext::AllocateBinarySharedMemBuffer()
 HsailAgentStatus AgentContext::FreeBinarySharedMemBuffer()
 {
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
-    status = AgentFreeSharedMemBuffer(g_DBEBINARY_SHMKEY, g_BINARY_BUFFER_MAXSIZE);
+    status = AgentFreeSharedMemBuffer(g_DBEBINARY_SHMKEY, g_BINARY_BUFFER_INITIALSIZE);
 
     if (status != HSAIL_AGENT_STATUS_SUCCESS)
     {
@@ -53,6 +53,32 @@ HsailAgentStatus AgentContext::FreeBinarySharedMemBuffer()
     return status;
 }
 
+HsailAgentStatus AgentContext::AllocateReadBatchSharedMemBuffer()
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+    status = AgentAllocSharedMemBuffer(g_READ_BATCH_SHMKEY, g_READ_BATCH_MAXSIZE);
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("AllocateReadBatchSharedMemBuffer: Could not alloc shared memory");
+    }
+
+    return status;
+}
+
+HsailAgentStatus AgentContext::FreeReadBatchSharedMemBuffer()
+{
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
+    status = AgentFreeSharedMemBuffer(g_READ_BATCH_SHMKEY, g_READ_BATCH_MAXSIZE);
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("FreeReadBatchSharedMemBuffer: Could not free read batch shared mem");
+    }
+
+    return status;
+}
+
 // This mechanism allows us to delete the binary object when we get to EndDebugging
 HsailAgentStatus AgentContext::AddKernelBinaryToContext(AgentBinary* pAgentBinary)
 {
@@ -527,6 +553,14 @@ HsailAgentStatus AgentContext::Initialize()
         return status;
     }
 
+    status = AllocateReadBatchSharedMemBuffer();
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("Could not allocate the shared memory for read batches");
+        return status;
+    }
+
     // Initialize a breakpoint manager
     m_pBPManager = new(std::nothrow) AgentBreakpointManager;
 
@@ -818,6 +852,13 @@ HsailAgentStatus AgentContext::ShutDown(const bool skipDbeShutDown)
         AGENT_ERROR("Could not free the Binary Shared memory successfully");
     }
 
+    status = FreeReadBatchSharedMemBuffer();
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("Could not free the read batch shared memory successfully");
+    }
+
     // Delete all the AgentBinary packages, we may have some left over
     for (size_t i = 0; i < m_pKernelBinaries.size(); i++)
     {
@@ -0,0 +1,113 @@
+//==============================================================================
+// Copyright (c) 2015 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief The kernels gdb wants to see dispatched
+//==============================================================================
+#include "AgentDispatchFilter.h"
+#include "AgentLogging.h"
+
+namespace HwDbgAgent
+{
+
+/// gdb may name a kernel by its symbol or by its source name, the agent finds
+/// "&m::&name" or "&name" symbols. Drop the prefixes so these all match
+static std::string NormalizeKernelName(const std::string& kernelName)
+{
+    static const std::string kernelNamePrefix = "&m::";
+
+    size_t start = 0;
+
+    if (0 == kernelName.compare(0, kernelNamePrefix.length(), kernelNamePrefix))
+    {
+        start = kernelNamePrefix.length();
+    }
+
+    if (start < kernelName.length() && '&' == kernelName[start])
+    {
+        ++start;
+    }
+
+    return kernelName.substr(start);
+}
+
+void AgentDispatchFilter::BeginUpdate()
+{
+    // The filter arrives over several packets, the predispatch callback may look
+    // at it in between. Select everything meanwhile rather than skip a dispatch
+    m_isUpdating = true;
+    m_isAllKernels = true;
+    m_isAllKernelsUpdate = false;
+    m_kernelNames.clear();
+}
+
+void AgentDispatchFilter::AddKernel(const std::string& kernelName)
+{
+    if (!m_isUpdating)
+    {
+        AGENT_ERROR("AddKernel: Dispatch filter kernel outside of an update");
+        return;
+    }
+
+    if (kernelName.empty())
+    {
+        m_isAllKernelsUpdate = true;
+    }
+    else
+    {
+        m_kernelNames.insert(NormalizeKernelName(kernelName));
+    }
+}
+
+void AgentDispatchFilter::EndUpdate()
+{
+    if (!m_isUpdating)
+    {
+        AGENT_ERROR("EndUpdate: Dispatch filter end without a begin");
+        return;
+    }
+
+    m_isUpdating = false;
+    m_isAllKernels = m_isAllKernelsUpdate;
+
+    AGENT_LOG("EndUpdate: Dispatch filter " <<
+              (m_isAllKernels ? "selects all kernels" : "selects kernels by name") << ", " <<
+              m_kernelNames.size() << " kernel names");
+}
+
+bool AgentDispatchFilter::IsAllKernels() const
+{
+    return m_isAllKernels;
+}
+
+bool AgentDispatchFilter::HasKernelNames() const
+{
+    return !m_kernelNames.empty();
+}
+
+bool AgentDispatchFilter::IsKernelSelected(const std::string& kernelName) const
+{
+    return m_isAllKernels || m_kernelNames.find(NormalizeKernelName(kernelName)) != m_kernelNames.end();
+}
+
+void AgentDispatchFilter::AddSkippedDispatch(const uint64_t kernelObject)
+{
+    ++m_unpublishedKernelObjects[kernelObject];
+}
+
+size_t AgentDispatchFilter::RemoveSkippedDispatches(const uint64_t kernelObject)
+{
+    std::unordered_map<uint64_t, size_t>::iterator it = m_unpublishedKernelObjects.find(kernelObject);
+
+    if (it == m_unpublishedKernelObjects.end())
+    {
+        return 0;
+    }
+
+    size_t numSkipped = it->second;
+    m_unpublishedKernelObjects.erase(it);
+    return numSkipped;
+}
+
+} // End Namespace HwDbgAgent
@@ -16,6 +16,7 @@
 
 #include "AgentBinary.h"
 #include "AgentLogging.h"
+#include "AgentTrace.h"
 #include "AgentUtils.h"
 #include "AgentVersion.h"
 #include "CommunicationControl.h"
@@ -334,6 +335,10 @@ void AgentSetLogging(const bool logFlag)
     }
 }
 
+bool AgentIsLoggingEnabled()
+{
+    return gs_pAgentLogManager != nullptr && gs_pAgentLogManager->m_EnableLogging;
+}
 
 // The message will add the endl always
 void AgentLog(const char* message)
@@ -485,6 +490,9 @@ void AgentLogAQLPacket(const hsa_kernel_dispatch_packet_t*  pAqlPacket)
 // Write Packet information
 void AgentLogPacketInfo(const HsailCommandPacket& incomingPacket)
 {
+    AgentTrace(AGENT_TRACE_EVENT_COMMAND, incomingPacket.m_command, incomingPacket.m_pc,
+               incomingPacket.m_numMomentaryBP);
+
     gs_pAgentLogManager->WriteLog(incomingPacket);
 }
 
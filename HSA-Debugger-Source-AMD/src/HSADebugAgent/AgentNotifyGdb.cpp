@@ -18,6 +18,7 @@
 
 #include "AgentLogging.h"
 #include "AgentNotifyGdb.h"
+#include "AgentTrace.h"
 #include "CommunicationControl.h"
 
 static const std::string AgentGetGDBNotificationString(const HsailNotification notification)
@@ -75,6 +76,10 @@ static HsailAgentStatus PushGDBNotification(const HsailNotificationPayload& payl
     }
     else
     {
+        AgentTrace(AGENT_TRACE_EVENT_NOTIFICATION, payload.m_Notification,
+                   payload.m_Notification == HSAIL_NOTIFY_BREAKPOINT_HIT ?
+                   payload.payload.BreakpointHit.m_numActiveWaves : 0);
+
         AGENT_LOG("Pushed Notification of Type: " <<
                   AgentGetGDBNotificationString(payload.m_Notification));
 
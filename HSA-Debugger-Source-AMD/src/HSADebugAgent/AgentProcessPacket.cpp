@@ -15,6 +15,8 @@
 #include <cstring>
 #include <sstream>
 #include <stdio.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 // Use some stl vectors for maintaining breakpoint handles
 #include <algorithm>
@@ -29,6 +31,7 @@
 #include "AgentProcessPacket.h"
 #include "AgentUtils.h"
 #include "CommunicationControl.h"
+#include "CommunicationParams.h"
 
 // Add DBE (Version decided by Makefile)
 #include "AMDGPUDebug.h"
@@ -150,6 +153,47 @@ static void DBEMomentaryBreakpoint(HwDbgAgent::AgentContext* pActiveContext,
     }
 }
 
+static void DBEBreakpointBatch(HwDbgAgent::AgentContext* pActiveContext,
+                               const HsailCommandPacket& ipPacket)
+{
+    HwDbgAgent::AgentBreakpointManager* pBpManager = pActiveContext->GetBpManager();
+
+    HsailAgentStatus status;
+    status = pBpManager->ApplyBreakpointBatch(pActiveContext->GetActiveHwDebugContext(),
+                                              ipPacket);
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AgentErrorLog("DBEBreakpointBatch: Could not apply the breakpoint batch\n");
+    }
+}
+
+static void DBEDispatchFilter(HwDbgAgent::AgentContext* pActiveContext,
+                              const HsailCommandPacket& ipPacket)
+{
+    HwDbgAgent::AgentDispatchFilter& filter = pActiveContext->GetBpManager()->GetDispatchFilter();
+
+    switch (ipPacket.m_command)
+    {
+        case HSAIL_COMMAND_DISPATCH_FILTER_BEGIN:
+            filter.BeginUpdate();
+            break;
+
+        case HSAIL_COMMAND_DISPATCH_FILTER_KERNEL:
+        {
+            // gdb does not have to terminate the name if it fills the field
+            std::string kernelName(ipPacket.m_kernelName,
+                                   strnlen(ipPacket.m_kernelName, AGENT_MAX_FUNC_NAME_LEN));
+            filter.AddKernel(kernelName);
+        }
+        break;
+
+        default:
+            filter.EndUpdate();
+            break;
+    }
+}
+
 // Global pointer to active context used for the expression evaluator
 // Can be fixed soon by checking a static variable in the function
 HwDbgAgent::AgentContext* g_ActiveContext = nullptr;
@@ -455,6 +499,263 @@ void* GetVarValue(int reg_type, size_t var_size, unsigned int reg_num, bool dere
     return (void*)(*(size_t*)variableValues);
 }
 
+/// Read the private (IMR_Scratch) or group (IMR_Group) memory of the work-item of
+/// the request through the DBE. The DBE only implements private memory today, so
+/// group reads come back as HSAIL_READ_STATUS_UNSUPPORTED until it supports them
+static HsailReadStatus ReadWorkItemMemory(HwDbgAgent::AgentContext* pActiveContext,
+                                          const HsailReadRequest& request,
+                                          const uint32_t memoryRegion,
+                                          const size_t offset,
+                                          void* pMemOut,
+                                          size_t* pNumBytesOut)
+{
+    HwDbgDim3 workGroupId;
+    workGroupId.x = request.m_workGroup.x;
+    workGroupId.y = request.m_workGroup.y;
+    workGroupId.z = request.m_workGroup.z;
+
+    HwDbgDim3 workItemId;
+    workItemId.x = request.m_workItem.x;
+    workItemId.y = request.m_workItem.y;
+    workItemId.z = request.m_workItem.z;
+
+    HwDbgStatus status = HwDbgReadMemory(pActiveContext->GetActiveHwDebugContext(),
+                                         memoryRegion,
+                                         workGroupId, workItemId,
+                                         offset,
+                                         request.m_size,
+                                         pMemOut,
+                                         pNumBytesOut);
+
+    if (status == HWDBG_STATUS_UNSUPPORTED)
+    {
+        return HSAIL_READ_STATUS_UNSUPPORTED;
+    }
+
+    if (status != HWDBG_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("ReadWorkItemMemory: HwDbgReadMemory of region " << memoryRegion <<
+                    " failed: " << GetDBEStatusString(status));
+        return HSAIL_READ_STATUS_FAILURE;
+    }
+
+    return HSAIL_READ_STATUS_SUCCESS;
+}
+
+/// Copy global memory of the process without trusting the address: a bad
+/// one fails the read rather than raise SIGSEGV in the application
+static HsailReadStatus ReadGlobalMemory(const size_t address,
+                                        const size_t size,
+                                        void* pMemOut,
+                                        size_t* pNumBytesOut)
+{
+    struct iovec local;
+    local.iov_base = pMemOut;
+    local.iov_len = size;
+
+    struct iovec remote;
+    remote.iov_base = (void*)address;
+    remote.iov_len = size;
+
+    ssize_t bytesRead = process_vm_readv(getpid(), &local, 1, &remote, 1, 0);
+
+    if (bytesRead < 0 || static_cast<size_t>(bytesRead) != size)
+    {
+        AGENT_ERROR("ReadGlobalMemory: Could not read " << size << " bytes at " << (void*)address);
+        return HSAIL_READ_STATUS_FAILURE;
+    }
+
+    *pNumBytesOut = size;
+    return HSAIL_READ_STATUS_SUCCESS;
+}
+
+/// Read a variable for the work-item of the request, following the location rules of GetVarValue
+static HsailReadStatus ReadVariableValue(HwDbgAgent::AgentContext* pActiveContext,
+                                         const HsailReadRequest& request,
+                                         void* pMemOut,
+                                         size_t* pNumBytesOut)
+{
+    const HsailVariableLocation& location = request.m_location;
+    *pNumBytesOut = 0;
+
+    // Like GetVarValue, only locations that do not need a register are supported
+    if (location.m_regType != LOC_REG_NONE || location.m_derefValue == 0)
+    {
+        return HSAIL_READ_STATUS_UNSUPPORTED;
+    }
+
+    size_t realLocation = location.m_offset + location.m_pieceOffset;
+
+    switch (location.m_isaMemoryRegion)
+    {
+        case 0: // = IMR_Global
+        {
+            // The location came from gdb, a bad one must not crash the application
+            return ReadGlobalMemory(realLocation, request.m_size, pMemOut, pNumBytesOut);
+        }
+
+        case 1: // = IMR_Scratch
+        case 2: // = IMR_Group
+        {
+            return ReadWorkItemMemory(pActiveContext, request, location.m_isaMemoryRegion,
+                                      realLocation, pMemOut, pNumBytesOut);
+        }
+
+        case 3: // = IMR_ExtUserData
+        {
+            // See GetVarValue, the 32 bit aligned offset is applied to the 64 bit aligned AQL arguments
+            realLocation *= 2;
+        }
+
+        // Fall through, the arguments are read like the AQL ones
+
+        case 4: // = IMR_AQL
+        case 5: // = IMR_FuncArg
+        {
+            if (g_KernelParametersBuffer == nullptr)
+            {
+                return HSAIL_READ_STATUS_FAILURE;
+            }
+
+            realLocation += (size_t)g_KernelParametersBuffer;
+            memcpy(pMemOut, (void*)realLocation, request.m_size);
+            *pNumBytesOut = request.m_size;
+        }
+        break;
+
+        default:
+        {
+            return HSAIL_READ_STATUS_UNSUPPORTED;
+        }
+    }
+
+    return HSAIL_READ_STATUS_SUCCESS;
+}
+
+/// Read a block of memory for the work-item of the request
+static HsailReadStatus ReadMemoryBlock(HwDbgAgent::AgentContext* pActiveContext,
+                                       const HsailReadRequest& request,
+                                       void* pMemOut,
+                                       size_t* pNumBytesOut)
+{
+    *pNumBytesOut = 0;
+
+    switch (request.m_memoryRegion)
+    {
+        case 0: // = IMR_Global
+        {
+            // gdb reads global memory from the process itself, the agent
+            // does not dereference any address it is sent
+            return HSAIL_READ_STATUS_UNSUPPORTED;
+        }
+
+        case 1: // = IMR_Scratch
+        case 2: // = IMR_Group
+        {
+            return ReadWorkItemMemory(pActiveContext, request, static_cast<uint32_t>(request.m_memoryRegion),
+                                      request.m_address, pMemOut, pNumBytesOut);
+        }
+
+        default:
+        {
+            return HSAIL_READ_STATUS_UNSUPPORTED;
+        }
+    }
+
+    return HSAIL_READ_STATUS_SUCCESS;
+}
+
+/// Serve all requests of a read batch, so gdb can read any number of variables
+/// and work-items without evaluating an expression in the inferior for each
+static void DBEReadBatch(HwDbgAgent::AgentContext* pActiveContext,
+                         const HsailCommandPacket& ipPacket)
+{
+    HSAIL_UNREFERENCED_PARAMETER(ipPacket);
+
+    HsailReadBatchHeader* pHeader = nullptr;
+    pHeader = (HsailReadBatchHeader*)AgentMapSharedMemBuffer(g_READ_BATCH_SHMKEY, g_READ_BATCH_MAXSIZE);
+
+    if (pHeader == nullptr)
+    {
+        AgentErrorLog("DBEReadBatch: Could not get the shared mem\n");
+        return;
+    }
+
+    // Pairs with the release store gdb does after writing the requests
+    uint32_t sequence = __atomic_load_n(&pHeader->m_sequence, __ATOMIC_ACQUIRE);
+
+    const size_t maxRequests = (g_READ_BATCH_MAXSIZE - sizeof(HsailReadBatchHeader)) / sizeof(HsailReadRequest);
+    size_t numRequests = pHeader->m_numRequests;
+
+    if (numRequests > maxRequests)
+    {
+        AGENT_ERROR("DBEReadBatch: Batch of " << numRequests << " requests does not fit, truncating");
+        numRequests = maxRequests;
+    }
+
+    HsailReadRequest* pRequests = reinterpret_cast<HsailReadRequest*>(pHeader + 1);
+    const size_t resultsStart = sizeof(HsailReadBatchHeader) + numRequests * sizeof(HsailReadRequest);
+    unsigned int failureCount = 0;
+
+    AGENT_LOG("DBEReadBatch: Serve " << numRequests << " read requests");
+
+    for (size_t i = 0; i < numRequests; i++)
+    {
+        HsailReadRequest& request = pRequests[i];
+        HsailReadStatus status = HSAIL_READ_STATUS_FAILURE;
+        size_t numBytesRead = 0;
+
+        // The results must not overlap the requests or run past the end of the shared mem
+        if (!pActiveContext->HasHwDebugStarted() ||
+            request.m_resultOffset < resultsStart ||
+            request.m_resultOffset > g_READ_BATCH_MAXSIZE ||
+            request.m_size > g_READ_BATCH_MAXSIZE - request.m_resultOffset)
+        {
+            status = HSAIL_READ_STATUS_FAILURE;
+        }
+        else
+        {
+            void* pMemOut = (void*)((char*)pHeader + request.m_resultOffset);
+
+            switch (request.m_kind)
+            {
+                case HSAIL_READ_KIND_VARIABLE:
+                    status = ReadVariableValue(pActiveContext, request, pMemOut, &numBytesRead);
+                    break;
+
+                case HSAIL_READ_KIND_MEMORY:
+                    status = ReadMemoryBlock(pActiveContext, request, pMemOut, &numBytesRead);
+                    break;
+
+                default:
+                    status = HSAIL_READ_STATUS_UNSUPPORTED;
+                    break;
+            }
+        }
+
+        if (status != HSAIL_READ_STATUS_SUCCESS)
+        {
+            failureCount++;
+        }
+
+        request.m_resultSize = numBytesRead;
+        request.m_status = status;
+    }
+
+    // Let gdb know the results are in place
+    __atomic_store_n(&pHeader->m_consumed, sequence, __ATOMIC_RELEASE);
+
+    if (AgentUnMapSharedMemBuffer((void*)pHeader) != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AgentErrorLog("DBEReadBatch: Could not unmap the shared mem\n");
+    }
+
+    if (failureCount != 0)
+    {
+        AGENT_LOG("DBEReadBatch: " << failureCount << " of " << numRequests << " requests failed");
+    }
+}
+
 void AgentProcessPacket(HwDbgAgent::AgentContext* pActiveContext,
                         const HsailCommandPacket& packet)
 {
@@ -500,6 +801,20 @@ void AgentProcessPacket(HwDbgAgent::AgentContext* pActiveContext,
             pActiveContext->SetLogging(packet.m_loggingInfo);
             break;
 
+        case HSAIL_COMMAND_BREAKPOINT_BATCH:
+            DBEBreakpointBatch(pActiveContext, packet);
+            break;
+
+        case HSAIL_COMMAND_READ_BATCH:
+            DBEReadBatch(pActiveContext, packet);
+            break;
+
+        case HSAIL_COMMAND_DISPATCH_FILTER_BEGIN:
+        case HSAIL_COMMAND_DISPATCH_FILTER_KERNEL:
+        case HSAIL_COMMAND_DISPATCH_FILTER_END:
+            DBEDispatchFilter(pActiveContext, packet);
+            break;
+
         case HSAIL_COMMAND_UNKNOWN:
             pActiveContext->PrintDBEVersion();
             AgentErrorLog("Incomplete command packet error");
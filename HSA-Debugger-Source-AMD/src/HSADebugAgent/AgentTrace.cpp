@@ -0,0 +1,455 @@
+//==============================================================================
+// Copyright (c) 2015 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Binary event trace of the agent, cheap enough for the dispatch and debug threads
+//==============================================================================
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "AgentLogging.h"
+#include "AgentTrace.h"
+
+/// The number of records in the ring of a thread, a power of 2
+static const uint64_t g_TRACE_RING_RECORDS = 16384;
+
+/// How often the writer drains the rings
+static const long g_TRACE_DRAIN_INTERVAL_MS = 10;
+
+static uint64_t GetTraceTimestamp()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+}
+
+/// The events of one thread. The thread is the only producer and the writer the
+/// only consumer, m_head and m_tail are the only state they share.
+/// A ring outlives its thread, it is handed to a later thread once it is drained
+class AgentTraceRing
+{
+public:
+    AgentTraceRing():
+        m_head(0),
+        m_tail(0),
+        m_dropped(0),
+        m_isOwned(true),
+        m_threadId(0)
+    {
+    }
+
+    void Record(const AgentTraceRecord& record)
+    {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+
+        if (head - m_tail.load(std::memory_order_acquire) >= g_TRACE_RING_RECORDS)
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        m_records[head & (g_TRACE_RING_RECORDS - 1)] = record;
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    /// Write the recorded events to fd, only called by the consumer
+    /// \return false if the file could not be written
+    bool Drain(const int fd)
+    {
+        bool isWritten = true;
+        const uint64_t dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+
+        if (dropped != 0)
+        {
+            AgentTraceRecord droppedRecord;
+            memset(&droppedRecord, 0, sizeof(droppedRecord));
+            droppedRecord.m_timestamp = GetTraceTimestamp();
+            droppedRecord.m_event = AGENT_TRACE_EVENT_DROPPED;
+            droppedRecord.m_threadId = m_threadId;
+            droppedRecord.m_args[0] = dropped;
+            isWritten = WriteRecords(fd, &droppedRecord, 1);
+        }
+
+        const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        const uint64_t head = m_head.load(std::memory_order_acquire);
+
+        if (head == tail)
+        {
+            return isWritten;
+        }
+
+        // The records may wrap around the end of the ring
+        const uint64_t first = tail & (g_TRACE_RING_RECORDS - 1);
+        const uint64_t count = head - tail;
+        const uint64_t firstCount = std::min(count, g_TRACE_RING_RECORDS - first);
+
+        isWritten = WriteRecords(fd, &m_records[first], firstCount) && isWritten;
+
+        if (firstCount < count)
+        {
+            isWritten = WriteRecords(fd, &m_records[0], count - firstCount) && isWritten;
+        }
+
+        m_tail.store(head, std::memory_order_release);
+        return isWritten;
+    }
+
+    bool IsDrained() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire) &&
+               m_dropped.load(std::memory_order_relaxed) == 0;
+    }
+
+    std::atomic<uint64_t> m_head;
+    std::atomic<uint64_t> m_tail;
+    std::atomic<uint64_t> m_dropped;
+
+    /// False once the thread that records in the ring has exited
+    std::atomic<bool> m_isOwned;
+
+    uint32_t m_threadId;
+
+private:
+    /// Disable copy constructor
+    AgentTraceRing(const AgentTraceRing&);
+
+    /// Disable assignment operator
+    AgentTraceRing& operator=(const AgentTraceRing&);
+
+    static bool WriteRecords(const int fd, const AgentTraceRecord* pRecords, const uint64_t count)
+    {
+        const char* pData = reinterpret_cast<const char*>(pRecords);
+        size_t size = count * sizeof(AgentTraceRecord);
+
+        while (size > 0)
+        {
+            ssize_t bytesWritten = write(fd, pData, size);
+
+            if (bytesWritten < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (bytesWritten <= 0)
+            {
+                return false;
+            }
+
+            pData += bytesWritten;
+            size -= bytesWritten;
+        }
+
+        return true;
+    }
+
+    AgentTraceRecord m_records[g_TRACE_RING_RECORDS];
+};
+
+static std::atomic<bool> gs_isTraceEnabled(false);
+
+/// The rings of all threads, only locked when a thread records its first event
+static std::mutex gs_traceRingsMutex;
+static std::vector<AgentTraceRing*> gs_traceRings;
+
+/// Held while the rings are drained, the writer and the post-mortem dump must not drain at once
+static std::mutex gs_traceDrainMutex;
+
+static int gs_traceFd = -1;
+static std::string gs_traceFileName;
+static pthread_t gs_traceWriterThread;
+static bool gs_isTraceWriterStarted = false;
+static std::atomic<bool> gs_isTraceWriterShutDown(false);
+
+/// Hands the calling thread's ring back when the thread exits
+class AgentTraceRingOwner
+{
+public:
+    AgentTraceRingOwner():
+        m_pRing(nullptr)
+    {
+    }
+
+    ~AgentTraceRingOwner()
+    {
+        if (m_pRing != nullptr)
+        {
+            m_pRing->m_isOwned.store(false, std::memory_order_release);
+        }
+    }
+
+    AgentTraceRing* m_pRing;
+
+private:
+    /// Disable copy constructor
+    AgentTraceRingOwner(const AgentTraceRingOwner&);
+
+    /// Disable assignment operator
+    AgentTraceRingOwner& operator=(const AgentTraceRingOwner&);
+};
+
+static thread_local AgentTraceRingOwner ts_traceRingOwner;
+
+/// The calling thread's ring, a drained ring of an exited thread or a new one
+static AgentTraceRing* GetThreadTraceRing()
+{
+    if (ts_traceRingOwner.m_pRing != nullptr)
+    {
+        return ts_traceRingOwner.m_pRing;
+    }
+
+    std::lock_guard<std::mutex> lock(gs_traceRingsMutex);
+
+    AgentTraceRing* pRing = nullptr;
+
+    for (size_t i = 0; i < gs_traceRings.size() && pRing == nullptr; ++i)
+    {
+        if (!gs_traceRings[i]->m_isOwned.load(std::memory_order_acquire) && gs_traceRings[i]->IsDrained())
+        {
+            pRing = gs_traceRings[i];
+            pRing->m_isOwned.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    if (pRing == nullptr)
+    {
+        pRing = new(std::nothrow) AgentTraceRing;
+
+        if (pRing == nullptr)
+        {
+            return nullptr;
+        }
+
+        gs_traceRings.push_back(pRing);
+    }
+
+    pRing->m_threadId = static_cast<uint32_t>(syscall(SYS_gettid));
+    ts_traceRingOwner.m_pRing = pRing;
+    return pRing;
+}
+
+/// Drain every ring to the trace file
+static bool DrainTraceRings()
+{
+    std::vector<AgentTraceRing*> rings;
+    {
+        std::lock_guard<std::mutex> lock(gs_traceRingsMutex);
+        rings = gs_traceRings;
+    }
+
+    bool isWritten = true;
+
+    for (size_t i = 0; i < rings.size(); ++i)
+    {
+        isWritten = rings[i]->Drain(gs_traceFd) && isWritten;
+    }
+
+    return isWritten;
+}
+
+static void* TraceWriterThread(void* pArgs)
+{
+    HSAIL_UNREFERENCED_PARAMETER(pArgs);
+
+    struct timespec interval;
+    interval.tv_sec = 0;
+    interval.tv_nsec = g_TRACE_DRAIN_INTERVAL_MS * 1000000;
+
+    bool isErrorReported = false;
+
+    while (!gs_isTraceWriterShutDown.load(std::memory_order_acquire))
+    {
+        nanosleep(&interval, nullptr);
+
+        std::lock_guard<std::mutex> lock(gs_traceDrainMutex);
+
+        // Keep recording, the post-mortem dump may still get through
+        if (!DrainTraceRings() && !isErrorReported)
+        {
+            AGENT_ERROR("TraceWriterThread: Could not write the trace file " << gs_traceFileName);
+            isErrorReported = true;
+        }
+    }
+
+    return nullptr;
+}
+
+static bool OpenTraceFile(const std::string& fileName)
+{
+    gs_traceFd = open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    if (gs_traceFd < 0)
+    {
+        AGENT_ERROR("OpenTraceFile: Could not open the trace file " << fileName << ", errno " << errno);
+        return false;
+    }
+
+    AgentTraceFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.m_magic, gs_AgentTraceMagic, sizeof(header.m_magic));
+    header.m_version = AGENT_TRACE_VERSION;
+    header.m_recordSize = sizeof(AgentTraceRecord);
+    header.m_startTime = GetTraceTimestamp();
+    header.m_pid = getpid();
+
+    if (write(gs_traceFd, &header, sizeof(header)) != sizeof(header))
+    {
+        AGENT_ERROR("OpenTraceFile: Could not write the trace file header");
+        close(gs_traceFd);
+        gs_traceFd = -1;
+        return false;
+    }
+
+    gs_traceFileName = fileName;
+    return true;
+}
+
+/// Disable the trace and join the writer, the caller drains what is left
+static HsailAgentStatus StopTraceWriter()
+{
+    // Threads that are still around find the trace disabled, the rings are
+    // left allocated in case one of them is past the check
+    gs_isTraceEnabled.store(false, std::memory_order_release);
+    gs_isTraceWriterShutDown.store(true, std::memory_order_release);
+
+    HsailAgentStatus status = HSAIL_AGENT_STATUS_SUCCESS;
+
+    if (pthread_join(gs_traceWriterThread, nullptr) != 0)
+    {
+        status = HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    gs_isTraceWriterStarted = false;
+    return status;
+}
+
+HsailAgentStatus AgentInitTrace()
+{
+    const char* pTracePrefixEnvVar = std::getenv("HSAIL_GDB_ENABLE_TRACE");
+
+    if (pTracePrefixEnvVar == nullptr)
+    {
+        return HSAIL_AGENT_STATUS_SUCCESS;
+    }
+
+    std::stringstream buffer;
+    buffer.str("");
+    buffer << pTracePrefixEnvVar << "_AgentTrace_PID_" << getpid() << ".bin";
+
+    if (!OpenTraceFile(buffer.str()))
+    {
+        return HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    gs_isTraceWriterShutDown.store(false, std::memory_order_relaxed);
+
+    if (pthread_create(&gs_traceWriterThread, nullptr, TraceWriterThread, nullptr) != 0)
+    {
+        AGENT_ERROR("AgentInitTrace: Could not create the trace writer thread");
+        close(gs_traceFd);
+        gs_traceFd = -1;
+        return HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    gs_isTraceWriterStarted = true;
+    gs_isTraceEnabled.store(true, std::memory_order_release);
+
+    AGENT_LOG("AgentInitTrace: The agent trace file is " << gs_traceFileName);
+    return HSAIL_AGENT_STATUS_SUCCESS;
+}
+
+HsailAgentStatus AgentCloseTrace()
+{
+    if (!gs_isTraceWriterStarted)
+    {
+        return HSAIL_AGENT_STATUS_SUCCESS;
+    }
+
+    HsailAgentStatus status = StopTraceWriter();
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("AgentCloseTrace: Could not join the trace writer thread");
+    }
+
+    std::lock_guard<std::mutex> lock(gs_traceDrainMutex);
+
+    if (!DrainTraceRings())
+    {
+        AGENT_ERROR("AgentCloseTrace: Could not write the trace file " << gs_traceFileName);
+        status = HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    close(gs_traceFd);
+    gs_traceFd = -1;
+
+    return status;
+}
+
+void AgentTrace(const AgentTraceEvent event,
+                const uint64_t arg0,
+                const uint64_t arg1,
+                const uint64_t arg2,
+                const uint64_t arg3)
+{
+    if (!gs_isTraceEnabled.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    AgentTraceRing* pRing = GetThreadTraceRing();
+
+    if (pRing == nullptr)
+    {
+        return;
+    }
+
+    AgentTraceRecord record;
+    record.m_timestamp = GetTraceTimestamp();
+    record.m_event = event;
+    record.m_threadId = pRing->m_threadId;
+    record.m_args[0] = arg0;
+    record.m_args[1] = arg1;
+    record.m_args[2] = arg2;
+    record.m_args[3] = arg3;
+    pRing->Record(record);
+}
+
+void AgentTraceDumpPostMortem()
+{
+    if (!gs_isTraceWriterStarted || !gs_isTraceEnabled.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    // exit() destroys the statics the writer drains with, so the writer has to
+    // be gone first. The join also waits for a drain it is in the middle of
+    if (StopTraceWriter() != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        std::cerr << "Agent: Could not join the trace writer thread\n";
+    }
+
+    std::lock_guard<std::mutex> lock(gs_traceDrainMutex);
+
+    bool isWritten = DrainTraceRings();
+    fsync(gs_traceFd);
+
+    std::cerr << "Agent: Post-mortem trace " << (isWritten ? "written to " : "incomplete in ")
+              << gs_traceFileName << "\n";
+    std::cerr.flush();
+}
@@ -22,6 +22,7 @@
 #include "AMDGPUDebug.h"
 
 #include "AgentLogging.h"
+#include "AgentTrace.h"
 #include "AgentUtils.h"
 #include "CommunicationParams.h"
 
@@ -35,6 +36,12 @@
 void AgentFatalExit()
 {
     AgentErrorLog("FatalExit\n");
+
+    // The trace is usually what tells us how we got here.
+    // The dump also stops the trace writer, exit() is safe afterwards
+    AgentTrace(AGENT_TRACE_EVENT_FATAL_EXIT);
+    AgentTraceDumpPostMortem();
+
     exit(-1);
 }
 
@@ -93,6 +100,12 @@ const std::string GetCommandTypeString(const HsailCommand ipCommand)
         case HSAIL_COMMAND_SET_LOGGING:
             return "HSAIL_COMMAND_CONTINUE";
 
+        case HSAIL_COMMAND_BREAKPOINT_BATCH:
+            return "HSAIL_COMMAND_BREAKPOINT_BATCH";
+
+        case HSAIL_COMMAND_READ_BATCH:
+            return "HSAIL_COMMAND_READ_BATCH";
+
         default:
             return "[Unknown Command]";
     }
@@ -7,10 +7,12 @@
 //==============================================================================
 #include <stdint.h>
 #include <cstddef>
+#include <vector>
 
 #include "AMDGPUDebug.h"
 
 #include "AgentLogging.h"
+#include "AgentTrace.h"
 #include "AgentContext.h"
 #include "AgentUtils.h"
 #include "AgentWavePrinter.h"
@@ -19,6 +21,59 @@
 
 namespace HwDbgAgent
 {
+/// The number of lanes set in an execution mask
+static uint32_t CountActiveLanes(uint64_t execMask)
+{
+    uint32_t count = 0;
+
+    for (; execMask != 0; execMask &= execMask - 1)
+    {
+        count++;
+    }
+
+    return count;
+}
+
+/// Check if the work-item IDs of a wave's active lanes follow from the first
+/// active lane's, one per lane in the work-group's x-fastest order, so that
+/// gdb can derive them rather than having them sent
+static bool AreWorkItemIdsDerivable(const HwDbgWavefrontInfo& waveInfo, const HwDbgDim3& workGroupSize)
+{
+    if (workGroupSize.x == 0 || workGroupSize.y == 0 ||
+        workGroupSize.x == g_UNKNOWN_HWDBGDIM3.x)
+    {
+        return false;
+    }
+
+    bool isFirstLane = true;
+    uint64_t firstFlatId = 0;
+    int firstLane = 0;
+
+    for (int j = 0; j < HWDBG_WAVEFRONT_SIZE; j++)
+    {
+        if ((waveInfo.executionMask & ((uint64_t)1 << j)) == 0)
+        {
+            continue;
+        }
+
+        const HwDbgDim3& id = waveInfo.workItemId[j];
+        const uint64_t flatId = id.x + (uint64_t)workGroupSize.x * (id.y + (uint64_t)workGroupSize.y * id.z);
+
+        if (isFirstLane)
+        {
+            isFirstLane = false;
+            firstFlatId = flatId;
+            firstLane = j;
+        }
+        else if (flatId != firstFlatId + (j - firstLane))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 AgentDbgWavefront::AgentDbgWavefront(HwDbgCodeAddress wavefrontProgramCounter,
                                      HwDbgWavefrontAddress wavefrontAddress)
     : m_wavefrontProgramCounter(wavefrontProgramCounter),
@@ -88,7 +143,7 @@ HsailAgentStatus AgentWavePrinter::FreeWaveInfoShmem()
     AGENT_LOG("FreeWaveInfoShmem: Free shared memory buffer");
 
     HsailAgentStatus status;
-    status = AgentFreeSharedMemBuffer(g_WAVE_BUFFER_SHMKEY, g_WAVE_BUFFER_MAXSIZE);
+    status = AgentFreeSharedMemBuffer(g_WAVE_BUFFER_SHMKEY, m_waveInfoShmemSize);
 
     if (status != HSAIL_AGENT_STATUS_SUCCESS)
     {
@@ -104,7 +159,7 @@ void AgentWavePrinter::InitializeWaveInfoShmem()
     AGENT_LOG("InitializeWaveInfoShmem: Initialize wave info shared mem");
 
     HsailAgentStatus status;
-    status = AgentAllocSharedMemBuffer(g_WAVE_BUFFER_SHMKEY, g_WAVE_BUFFER_MAXSIZE);
+    status = AgentAllocSharedMemBuffer(g_WAVE_BUFFER_SHMKEY, m_waveInfoShmemSize);
 
     if (status != HSAIL_AGENT_STATUS_SUCCESS)
     {
@@ -113,6 +168,48 @@ void AgentWavePrinter::InitializeWaveInfoShmem()
 
 }
 
+HsailAgentStatus AgentWavePrinter::GrowWaveInfoShmem(const size_t requiredSize)
+{
+    size_t newSize = m_waveInfoShmemSize;
+
+    while (newSize < requiredSize)
+    {
+        newSize *= 2;
+    }
+
+    AGENT_LOG("GrowWaveInfoShmem: Grow wave info shared mem from " << m_waveInfoShmemSize <<
+              " to " << newSize << " bytes");
+
+    // Tell gdb about the new size through the old buffer before we remove it,
+    // gdb keeps the old segment attached until it sees this
+    HsailWaveBufferHeader* pHeader = (HsailWaveBufferHeader*)AgentMapSharedMemBuffer(g_WAVE_BUFFER_SHMKEY,
+                                     m_waveInfoShmemSize);
+
+    if (pHeader != nullptr)
+    {
+        pHeader->m_numWaves = 0;
+        pHeader->m_capacity = newSize;
+        AgentUnMapSharedMemBuffer(pHeader);
+    }
+
+    HsailAgentStatus status = FreeWaveInfoShmem();
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    m_waveInfoShmemSize = newSize;
+    status = AgentAllocSharedMemBuffer(g_WAVE_BUFFER_SHMKEY, m_waveInfoShmemSize);
+
+    if (status != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("GrowWaveInfoShmem: Could not reallocate wave info shared mem");
+    }
+
+    return status;
+}
+
 AgentWavePrinter::~AgentWavePrinter()
 {
     FreeWaveInfoShmem();
@@ -195,7 +292,8 @@ HsailAgentStatus AgentWavePrinter::PrintWaveInfoBuffer(int nWaves, const HwDbgWa
 
 /// Needs a DBE context handle and a event type and sends the active wave info to gdb
 HsailAgentStatus AgentWavePrinter::SendActiveWavesToGdb(HwDbgEventType      dbeEventType,
-                                                        HwDbgContextHandle  debugHandle)
+                                                        HwDbgContextHandle  debugHandle,
+                                                        const HwDbgDim3&    workGroupSize)
 {
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
 
@@ -244,40 +342,93 @@ HsailAgentStatus AgentWavePrinter::SendActiveWavesToGdb(HwDbgEventType      dbeE
         return status;
     }
 
-    void* pShm = AgentMapSharedMemBuffer(g_WAVE_BUFFER_SHMKEY, g_WAVE_BUFFER_MAXSIZE);
+    // Size the records first, so that the buffer can be grown before we write
+    // Most waves run the whole work-group in order, their work-item IDs
+    // follow from the first active lane's and don't need to be sent
+    std::vector<uint32_t> numWorkItemIds(nWaves);
+    std::vector<bool> isDerived(nWaves);
+    size_t requiredSize = sizeof(HsailWaveBufferHeader);
+
+    for (uint32_t i = 0; i < nWaves; i++)
+    {
+        numWorkItemIds[i] = CountActiveLanes(pWaveInfo[i].executionMask);
+        isDerived[i] = numWorkItemIds[i] > 1 && AreWorkItemIdsDerivable(pWaveInfo[i], workGroupSize);
+
+        if (isDerived[i])
+        {
+            numWorkItemIds[i] = 1;
+        }
+
+        requiredSize += GetHsailWaveRecordSize(numWorkItemIds[i]);
+    }
+
+    if (requiredSize > m_waveInfoShmemSize)
+    {
+        status = GrowWaveInfoShmem(requiredSize);
+
+        if (status != HSAIL_AGENT_STATUS_SUCCESS)
+        {
+            AGENT_ERROR("SendActiveWavesToGdb: Could not grow the wave info shared mem to " << requiredSize);
+            return status;
+        }
+    }
+
+    void* pShm = AgentMapSharedMemBuffer(g_WAVE_BUFFER_SHMKEY, m_waveInfoShmemSize);
 
-    if (pShm == (int*) - 1)
+    if (pShm == nullptr)
     {
         AGENT_ERROR("SendActiveWavesToGdb: Error mapping shared mem");
         status = HSAIL_AGENT_STATUS_FAILURE;
         return status;
     }
 
-    // First zero the whole region out, we dont know how much of this region will be used
-    // The next update to this logic may be smarter about what is written here
-    memset(pShm, 0, g_WAVE_BUFFER_MAXSIZE);
+    // Only the header and the records are written, gdb does not look past m_bytesUsed
+    HsailWaveBufferHeader* pHeader = (HsailWaveBufferHeader*)pShm;
+    pHeader->m_version = HSAIL_WAVE_BUFFER_VERSION;
+    pHeader->m_headerSize = sizeof(HsailWaveBufferHeader);
+    pHeader->m_numWaves = nWaves;
+    pHeader->m_reserved = 0;
+    pHeader->m_bytesUsed = requiredSize;
+    pHeader->m_capacity = m_waveInfoShmemSize;
 
-    for (size_t i = 0; i < nWaves; i++)
+    char* pLocn = (char*)pShm + sizeof(HsailWaveBufferHeader);
+
+    for (uint32_t i = 0; i < nWaves; i++)
     {
-        HsailAgentWaveInfo* pLocn = (HsailAgentWaveInfo*)pShm + i;
-        pLocn->waveAddress = pWaveInfo[i].wavefrontAddress;
-        pLocn->execMask = pWaveInfo[i].executionMask;
-        pLocn->pc = pWaveInfo[i].codeAddress;
-
-        pLocn->workGroupId.x = static_cast<uint32_t>(pWaveInfo[i].workGroupId.x);
-        pLocn->workGroupId.y = static_cast<uint32_t>(pWaveInfo[i].workGroupId.y);
-        pLocn->workGroupId.z = static_cast<uint32_t>(pWaveInfo[i].workGroupId.z);
-
-        // We could just do a memcpy with 64*sizeof(uint32_t) but the loop is useful
-        // to check if the type of the pWaveInfo in the DBE changes
-        for (int j = 0; j < 64; j++)
+        HsailWaveRecord* pRecord = (HsailWaveRecord*)pLocn;
+        pRecord->m_recordSize = GetHsailWaveRecordSize(numWorkItemIds[i]);
+        pRecord->m_numWorkItemIds = numWorkItemIds[i];
+        pRecord->m_reserved = 0;
+        pRecord->waveAddress = pWaveInfo[i].wavefrontAddress;
+        pRecord->execMask = pWaveInfo[i].executionMask;
+        pRecord->pc = pWaveInfo[i].codeAddress;
+
+        pRecord->workGroupId.x = static_cast<uint32_t>(pWaveInfo[i].workGroupId.x);
+        pRecord->workGroupId.y = static_cast<uint32_t>(pWaveInfo[i].workGroupId.y);
+        pRecord->workGroupId.z = static_cast<uint32_t>(pWaveInfo[i].workGroupId.z);
+
+        pRecord->m_flags = isDerived[i] ? HSAIL_WAVE_RECORD_FLAGS_DERIVED_WORKITEMS : HSAIL_WAVE_RECORD_FLAGS_NONE;
+
+        // The IDs of the active lanes, in lane order
+        HsailWaveDim3* pWorkItemIds = (HsailWaveDim3*)(pRecord + 1);
+        uint32_t nWritten = 0;
+
+        for (int j = 0; j < HWDBG_WAVEFRONT_SIZE && nWritten < numWorkItemIds[i]; j++)
         {
-            pLocn->workItemId[j].x = static_cast<uint32_t>(pWaveInfo[i].workItemId[j].x);
-            pLocn->workItemId[j].y = static_cast<uint32_t>(pWaveInfo[i].workItemId[j].y);
-            pLocn->workItemId[j].z = static_cast<uint32_t>(pWaveInfo[i].workItemId[j].z);
+            if ((pRecord->execMask & ((uint64_t)1 << j)) != 0)
+            {
+                pWorkItemIds[nWritten].x = static_cast<uint32_t>(pWaveInfo[i].workItemId[j].x);
+                pWorkItemIds[nWritten].y = static_cast<uint32_t>(pWaveInfo[i].workItemId[j].y);
+                pWorkItemIds[nWritten].z = static_cast<uint32_t>(pWaveInfo[i].workItemId[j].z);
+                nWritten++;
+            }
         }
+
+        pLocn += pRecord->m_recordSize;
     }
 
+    AgentTrace(AGENT_TRACE_EVENT_WAVES_PUBLISHED, nWaves, requiredSize);
+
     status = AgentUnMapSharedMemBuffer(pShm);
     return status;
 }
@@ -0,0 +1,147 @@
+//==============================================================================
+// Copyright (c) 2015 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Micro-benchmark for the breakpoint manager's PC lookup
+///
+/// Replays a synthetic wave buffer against a large breakpoint set, the way
+/// AgentBreakpointManager::UpdateBreakpointStatistics does on every stop, once
+/// with the linear scan the manager used to do and once with the lookup the
+/// manager does now, AgentBreakpointIndex::FindFirstPC.
+/// It only needs the DBE header, not a GPU or the HSA runtime, build it with "make benchmark".
+///
+/// Usage: AgentBreakpointIndexBenchmark [numBreakpoints] [numWaves] [numStops]
+//==============================================================================
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "AgentBreakpointIndex.h"
+
+using namespace HwDbgAgent;
+
+namespace
+{
+/// The parts of an AgentBreakpoint the PC lookup looks at
+struct BenchmarkBreakpoint
+{
+    HwDbgCodeAddress m_pc;
+    bool m_isEnabled;
+};
+
+/// The lookup AgentBreakpointManager::GetBreakpointFromPC used to do
+int FindLinear(const std::vector<BenchmarkBreakpoint>& breakpoints, const HwDbgCodeAddress pc)
+{
+    for (size_t i = 0; i < breakpoints.size(); i++)
+    {
+        if (breakpoints[i].m_pc == pc && breakpoints[i].m_isEnabled)
+        {
+            return (int)i;
+        }
+    }
+
+    return -1;
+}
+
+/// Replay every stop and return the total hit count, so the work cannot be optimized away
+template<typename Lookup>
+long long ReplayStops(const std::vector<HwDbgWavefrontInfo>& waves, const int numStops,
+                      std::vector<int>& hitCounts, Lookup lookup, double& secondsOut)
+{
+    long long totalHits = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (int stop = 0; stop < numStops; stop++)
+    {
+        for (size_t i = 0; i < waves.size(); i++)
+        {
+            int bpId = lookup(waves[i].codeAddress);
+
+            if (bpId != -1)
+            {
+                hitCounts[bpId]++;
+                totalHits++;
+            }
+        }
+    }
+
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    secondsOut = std::chrono::duration<double>(end - start).count();
+
+    return totalHits;
+}
+}
+
+int main(int argc, char** argv)
+{
+    const int numBreakpoints = (argc > 1) ? atoi(argv[1]) : 4096;
+    const int numWaves       = (argc > 2) ? atoi(argv[2]) : 40960;
+    const int numStops       = (argc > 3) ? atoi(argv[3]) : 10;
+
+    if (numBreakpoints <= 0 || numWaves <= 0 || numStops <= 0)
+    {
+        fprintf(stderr, "Usage: %s [numBreakpoints] [numWaves] [numStops]\n", argv[0]);
+        return 1;
+    }
+
+    std::mt19937_64 rng(42);
+
+    // Breakpoints on every other instruction of the code object, a few of them disabled
+    std::vector<BenchmarkBreakpoint> breakpoints(numBreakpoints);
+    AgentBreakpointIndex index;
+
+    for (int i = 0; i < numBreakpoints; i++)
+    {
+        breakpoints[i].m_pc = 0x100 + 8 * (HwDbgCodeAddress)i;
+        breakpoints[i].m_isEnabled = (rng() % 16 != 0);
+        index.AddPC(breakpoints[i].m_pc, i);
+    }
+
+    // Waves spread over the whole code object, so about half of them are not at a breakpoint
+    std::vector<HwDbgWavefrontInfo> waves(numWaves);
+    std::uniform_int_distribution<HwDbgCodeAddress> pcDistribution(0, 2 * (HwDbgCodeAddress)numBreakpoints - 1);
+
+    for (int i = 0; i < numWaves; i++)
+    {
+        waves[i] = HwDbgWavefrontInfo();
+        waves[i].codeAddress = 0x100 + 4 * pcDistribution(rng);
+        waves[i].workGroupId.x = (uint32_t)i;
+    }
+
+    std::vector<int> linearHits(numBreakpoints, 0);
+    std::vector<int> indexedHits(numBreakpoints, 0);
+    double linearSeconds = 0;
+    double indexedSeconds = 0;
+
+    long long linearTotal = ReplayStops(waves, numStops, linearHits,
+                                        [&breakpoints](HwDbgCodeAddress pc) { return FindLinear(breakpoints, pc); },
+                                        linearSeconds);
+
+    long long indexedTotal = ReplayStops(waves, numStops, indexedHits,
+                                         [&breakpoints, &index](HwDbgCodeAddress pc)
+                                         {
+                                             return index.FindFirstPC(pc, [&breakpoints](const int position)
+                                             {
+                                                 return breakpoints[position].m_isEnabled;
+                                             });
+                                         },
+                                         indexedSeconds);
+
+    if (linearTotal != indexedTotal || linearHits != indexedHits)
+    {
+        fprintf(stderr, "Mismatch: linear scan counted %lld hits, index counted %lld\n", linearTotal, indexedTotal);
+        return 1;
+    }
+
+    const double lookups = (double)numWaves * numStops;
+
+    printf("%d breakpoints, %d waves, %d stops, %lld hits\n", numBreakpoints, numWaves, numStops, linearTotal);
+    printf("linear scan: %10.3f ms  %10.1f ns/wave\n", linearSeconds * 1e3, linearSeconds * 1e9 / lookups);
+    printf("hash index:  %10.3f ms  %10.1f ns/wave\n", indexedSeconds * 1e3, indexedSeconds * 1e9 / lookups);
+
+    return 0;
+}
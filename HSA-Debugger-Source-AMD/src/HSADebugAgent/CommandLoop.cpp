@@ -10,6 +10,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
+#include <time.h>
 
 // pthread and error codes
 #include <errno.h>
@@ -25,6 +26,7 @@
 #include "AgentLogging.h"
 #include "AgentNotifyGdb.h"
 #include "AgentProcessPacket.h"
+#include "AgentTrace.h"
 #include "AgentUtils.h"
 #include "AgentWavePrinter.h"
 #include "CommandLoop.h"
@@ -77,14 +79,41 @@ static bool CheckFifoAtEndDebugging(AgentContext* pActiveContext)
 }
 
 
+/// Block on the fifo for at most runCount milliseconds, servicing packets as
+/// soon as they arrive rather than polling the fifo every millisecond
 void RunFifoCommandLoop(AgentContext* pActiveContext, unsigned int runCount)
 {
-    for (unsigned int i=0; i < runCount; i++)
+    struct timespec startTime;
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+
+    RunFifoCommandLoop(pActiveContext);
+
+    while (true)
     {
-        RunFifoCommandLoop(pActiveContext);
+        struct timespec currentTime;
+        clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+        long elapsedMs = (currentTime.tv_sec - startTime.tv_sec) * 1000 +
+                         (currentTime.tv_nsec - startTime.tv_nsec) / 1000000;
+
+        if (elapsedMs >= static_cast<long>(runCount))
+        {
+            break;
+        }
 
-        // Sleep for 1ms
-        usleep(1000);
+        bool isReadable = false;
+        HsailAgentStatus status = WaitForFifoReadEnd(static_cast<int>(runCount - elapsedMs), &isReadable);
+
+        if (status != HSAIL_AGENT_STATUS_SUCCESS)
+        {
+            AGENT_LOG("RunFifoCommandLoop: Stopped waiting on the fifo");
+            break;
+        }
+
+        if (isReadable)
+        {
+            RunFifoCommandLoop(pActiveContext);
+        }
     }
 }
 
@@ -151,6 +180,7 @@ HsailAgentStatus WaitForDebugThreadCompletion()
     AGENT_LOG("WaitForDebugThreadCompletion: Start waiting for debug thread completion");
 
     int pthreadStatus =  pthread_join(DebugEventHandler, nullptr);
+    AgentTrace(AGENT_TRACE_EVENT_DEBUG_THREAD_JOINED, pthreadStatus);
 
     AGENT_LOG("WaitForDebugThreadCompletion: Finished waiting for debug thread completion");
 
@@ -222,27 +252,39 @@ static HsailAgentStatus PostBreakpointEventUpdates(AgentContext*    pActiveConte
 
 
     // If we want the reason to be nicely printed
+    // This also evaluates the breakpoint conditions
     status = bpManager->PrintStoppedReason(dbeEventType,
                                            pActiveContext->GetActiveHwDebugContext(),
+                                           pActiveContext->m_workGroupSize,
                                            pFocusControl,
                                            pIsStopNeeded);
     CommandLoopStatusCheck(status, "Error: PrintStoppedReason");
 
     // Let gdb know what the dbe told us
     // Just save it to the shmem for now, the bp manager will let gdb know # of waves
-    status = pWavePrinter->SendActiveWavesToGdb(dbeEventType,
-                                                pActiveContext->GetActiveHwDebugContext());
-    CommandLoopStatusCheck(status, "Error: SendActiveWavesToGdb");
+    // If no condition matched gdb will not look at the waves, so skip them
+    if (*pIsStopNeeded)
+    {
+        status = pWavePrinter->SendActiveWavesToGdb(dbeEventType,
+                                                    pActiveContext->GetActiveHwDebugContext(),
+                                                    pActiveContext->m_workGroupSize);
+        CommandLoopStatusCheck(status, "Error: SendActiveWavesToGdb");
+    }
 
     // Update hit counts for all breakpoints
-    // Also send notification to gdb for # of waves in buffer
+    // Also send notification to gdb for # of waves in buffer, if we stop
     status = bpManager->UpdateBreakpointStatistics(dbeEventType,
-                                                   pActiveContext->GetActiveHwDebugContext());
+                                                   pActiveContext->GetActiveHwDebugContext(),
+                                                   *pIsStopNeeded);
     CommandLoopStatusCheck(status, "Error: UpdateBreakpointStatistics");
 
-    // Clear all momentary breakpoints:
-    status = bpManager->ClearMomentaryBreakpoints(pActiveContext->GetActiveHwDebugContext());
-    CommandLoopStatusCheck(status, "Error: ClearMomentaryBreakpoints");
+    // Clear all momentary breakpoints, unless they are the step breakpoints of the line
+    // gdb is stepping through. gdb clears those itself once it leaves the line
+    if (!bpManager->IsKeepingMomentaryBreakpoints())
+    {
+        status = bpManager->ClearMomentaryBreakpoints(pActiveContext->GetActiveHwDebugContext());
+        CommandLoopStatusCheck(status, "Error: ClearMomentaryBreakpoints");
+    }
 
     AGENT_LOG("PostBreakpointEventUpdates: Exit PostBreakpointEventUpdates");
 
@@ -272,14 +314,20 @@ static int CheckTimeoutCount()
     return exitSignal;
 }
 
+// How long the debug thread blocks on the fifo before it rechecks the parent's status
+static const int g_FIFO_WAIT_TIMEOUT_MS = 100;
+
 // This function is similar to CheckTimeout count with the additional role
 // of checking the parent status by comparing parent PIDs
-static HsailParentStatus CheckParentStatus(const AgentContext* pActiveContext)
+// It is called once per FIFO wakeup, and at least once per g_FIFO_WAIT_TIMEOUT_MS
+// while idle, so the check count bounds the wait for a continue packet to
+// at most 10000 * 100ms, about 16.7 minutes, less if gdb sends other commands.
+// The caller resets checkCount every time the dispatch stops
+static HsailParentStatus CheckParentStatus(const AgentContext* pActiveContext, int& checkCount)
 {
     HsailParentStatus parentStatus;
 
     static const int maxCheckCount = 10000;
-    static int checkCount = 0;
 
     checkCount ++;
 
@@ -356,6 +404,7 @@ void* DebugEventThread(void* pArgs)
     }
 
     AgentNotifyDebugThreadID();
+    AgentTrace(AGENT_TRACE_EVENT_DEBUG_THREAD_BEGIN);
 
     bool isNormalExit = false;
     int exitSignal = 0;
@@ -369,6 +418,7 @@ void* DebugEventThread(void* pArgs)
 
         // A blocking wait
         HsailAgentStatus waitStatus = pActiveContext->WaitForEvent(&dbeEventType);
+        AgentTrace(AGENT_TRACE_EVENT_DBE_EVENT, dbeEventType, waitStatus);
 
         if (waitStatus == HSAIL_AGENT_STATUS_FAILURE)
         {
@@ -399,12 +449,14 @@ void* DebugEventThread(void* pArgs)
                 }
                 else
                 {
+                    AgentTrace(AGENT_TRACE_EVENT_STOP);
                     AGENT_LOG("DebugEventThread: Raise SIGUSR2 to stop");
                 }
             }
             else
             {
                 // We can continue the dispatch, we didn't find anything worth stopping for
+                AgentTrace(AGENT_TRACE_EVENT_NO_STOP);
                 AGENT_LOG("Continue dispatch without stopping application");
                 pActiveContext->m_ReadyToContinue = true;
             }
@@ -462,12 +514,14 @@ void* DebugEventThread(void* pArgs)
         AGENT_LOG("Spin till we get a Continue Packet from FIFO, " <<
                   "Context Ready to Continue bit = " << pActiveContext->m_ReadyToContinue);
 
-        // We spin below to ensure that the "continue" packet has come through.
+        // We wait below to ensure that the "continue" packet has come through.
         // Till the continue packet comes through, we are doing something else
         // like expression evaluation or stepping on the host side.
         //
         // Just because a packet has been seen sent by gdb, doesn't mean that
-        // the agent will see it instantly and thats why we spin reading the FIFO
+        // the agent will see it instantly and thats why we keep reading the FIFO.
+        // The thread blocks on the FIFO between reads, so it does not use any CPU
+        // while the user is working on the host side
         //
         // As part of this interaction we also check the parent's status continuously.
         // If we get a timeout, that means the check has been done way too many times
@@ -480,11 +534,26 @@ void* DebugEventThread(void* pArgs)
         // Note: even if the debug thread is not in focus or we are stepping on the
         // host side, the continue packet will be sent by continue_command() in gdb
         HsailParentStatus parentStatus = HSAIL_PARENT_STATUS_UNKNOWN;
+        int checkCount = 0;
 
         do
         {
             RunFifoCommandLoop(pActiveContext);
-            parentStatus = CheckParentStatus(pActiveContext);
+
+            if (pActiveContext->m_ReadyToContinue == false)
+            {
+                bool isReadable = false;
+
+                if (WaitForFifoReadEnd(g_FIFO_WAIT_TIMEOUT_MS, &isReadable) != HSAIL_AGENT_STATUS_SUCCESS)
+                {
+                    // The agent is shutting down, nobody will send a continue packet
+                    AGENT_LOG("DebugEventThread: Fifo wait was shut down");
+                    parentStatus = HSAIL_PARENT_STATUS_TERMINATED;
+                    break;
+                }
+            }
+
+            parentStatus = CheckParentStatus(pActiveContext, checkCount);
 
         }
         while ((pActiveContext->m_ReadyToContinue == false) &&
@@ -532,6 +601,7 @@ void* DebugEventThread(void* pArgs)
         {
             status = pActiveContext->ContinueDebugging();
             CommandLoopStatusCheck(status, "Error: ContinueDebugging");
+            AgentTrace(AGENT_TRACE_EVENT_CONTINUE);
 
             AGENT_LOG("Call ContinueDebugging from HwDbgWaitForEvent");
         }
@@ -570,6 +640,7 @@ void* DebugEventThread(void* pArgs)
     // predispatch callback
     delete pthreadParams;
 
+    AgentTrace(AGENT_TRACE_EVENT_DEBUG_THREAD_END, isNormalExit);
     AGENT_LOG("DebugEventThread: Exit debug event thread");
 
     // Exit the pthread
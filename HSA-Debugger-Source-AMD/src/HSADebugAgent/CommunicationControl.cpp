@@ -16,11 +16,18 @@
 #include <sys/stat.h>
 #include <errno.h>
 
+// Headers for the fifo wait
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+
 // Regular headers
 #include <stdlib.h>
+#include <string.h>
 #include <fcntl.h>
 #include <cassert>
 #include <iostream>
+#include <string>
 
 #include "AgentLogging.h"
 #include "AgentUtils.h"
@@ -34,46 +41,59 @@
 static int gs_FIFO_READ_DESC = 0;
 static int gs_FIFO_WRITE_DESC = 0;
 
+/// The epoll instance used to block on the read end of the fifo
+static int gs_FIFO_EPOLL_DESC = -1;
+
+/// An eventfd registered with gs_FIFO_EPOLL_DESC, written to wake up any
+/// thread blocked in WaitForFifoReadEnd when the agent shuts down
+static int gs_FIFO_SHUTDOWN_DESC = -1;
+static volatile bool gs_FIFO_SHUTDOWN = false;
+
+
+/// The debug session the debugger started us in, 0 if it did not tell us
+static int GetAgentDebugSessionId()
+{
+    static const int s_sessionId = GetDebugSessionIdFromEnv();
+    return s_sessionId;
+}
+
+/// The directory of our debug session's FIFOs, empty if the debugger did
+/// not tell us
+static const std::string& GetAgentFifoDir()
+{
+    static const std::string s_fifoDir = GetDebugSessionFifoDirFromEnv();
+    return s_fifoDir;
+}
+
+/// The SysV key of one of the shared memory segments in our debug session
+static key_t GetAgentShmKey(const key_t shmkey)
+{
+    return GetDebugSessionShmKey(shmkey, GetAgentDebugSessionId());
+}
 
 /// This function creates both the communication FIFOs that will be used
-/// \todo make FIFO naming randomly generated, use some combination of date and time
-/// FIFO naming is shown below:
+/// FIFO naming is shown below, in a debug session they are in the
+/// session's directory (see GetDebugSessionFifoName):
 /// Data flow Direction     Filename
 /// agent <-- gdb           fifo-gdb-w-agent-r
 /// agent --> gdb           fifo-agent-w-gdb-r
+/// The debugger may have created them already. FIFOs that exist but are
+/// not ours are refused, see CreateDebugSessionFifo
 HsailAgentStatus CreateCommunicationFifos()
 {
-    int status = mkfifo(gs_GdbToAgentFifoName, g_FIFO_PERMISSIONS);
-    int errno_value = errno;
-
-    if (status != 0)
+    const std::string fifoNames[] =
     {
-        if (errno_value == EEXIST)
-        {
-            AGENT_LOG("FIFO " <<  gs_GdbToAgentFifoName << " already exists");
-        }
-        else
-        {
-            AGENT_ERROR("Error creating FIFO " <<  gs_GdbToAgentFifoName);
-            return HSAIL_AGENT_STATUS_FAILURE;
-        }
-    }
-
-    status = mkfifo(gs_AgentToGdbFifoName, g_FIFO_PERMISSIONS);
-    errno_value = errno;
+        GetDebugSessionFifoName(gs_GdbToAgentFifoName, GetAgentFifoDir()),
+        GetDebugSessionFifoName(gs_AgentToGdbFifoName, GetAgentFifoDir())
+    };
 
-    if (status != 0)
+    for (const std::string& fifoName : fifoNames)
     {
-        if (errno_value == EEXIST)
+        if (!CreateDebugSessionFifo(fifoName))
         {
-            AGENT_LOG("FIFO " <<  gs_AgentToGdbFifoName << " already exists");
-        }
-        else
-        {
-            AGENT_ERROR("Error creating FIFO " <<  gs_AgentToGdbFifoName);
+            AGENT_ERROR("Error creating FIFO " << fifoName << ", errno " << errno);
             return HSAIL_AGENT_STATUS_FAILURE;
         }
-
     }
 
     return HSAIL_AGENT_STATUS_SUCCESS;
@@ -91,7 +111,8 @@ HsailAgentStatus InitFifoReadEnd()
     // Open fifo,  make this blocking ?
     // This was the old call fd = open("fifo", O_RDONLY|O_NONBLOCK);
     // The Agent will read this fifo for things to do from GDB
-    gs_FIFO_READ_DESC = open(gs_GdbToAgentFifoName, O_RDONLY | O_NONBLOCK);
+    const std::string gdbToAgentFifoName = GetDebugSessionFifoName(gs_GdbToAgentFifoName, GetAgentFifoDir());
+    gs_FIFO_READ_DESC = open(gdbToAgentFifoName.c_str(), O_RDONLY | O_NONBLOCK | O_NOFOLLOW);
 
     if (gs_FIFO_READ_DESC <= 0)
     {
@@ -100,11 +121,148 @@ HsailAgentStatus InitFifoReadEnd()
         return HSAIL_AGENT_STATUS_FAILURE;
     }
 
+    gs_FIFO_EPOLL_DESC = epoll_create1(EPOLL_CLOEXEC);
+    gs_FIFO_SHUTDOWN_DESC = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    gs_FIFO_SHUTDOWN = false;
+
+    if (gs_FIFO_EPOLL_DESC < 0 || gs_FIFO_SHUTDOWN_DESC < 0)
+    {
+        AGENT_ERROR("Error creating the fifo wait descriptors");
+        return HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    struct epoll_event readEvent;
+    memset(&readEvent, 0, sizeof(readEvent));
+    readEvent.events = EPOLLIN;
+    readEvent.data.fd = gs_FIFO_READ_DESC;
+
+    struct epoll_event shutdownEvent;
+    memset(&shutdownEvent, 0, sizeof(shutdownEvent));
+    shutdownEvent.events = EPOLLIN;
+    shutdownEvent.data.fd = gs_FIFO_SHUTDOWN_DESC;
+
+    if (epoll_ctl(gs_FIFO_EPOLL_DESC, EPOLL_CTL_ADD, gs_FIFO_READ_DESC, &readEvent) != 0 ||
+        epoll_ctl(gs_FIFO_EPOLL_DESC, EPOLL_CTL_ADD, gs_FIFO_SHUTDOWN_DESC, &shutdownEvent) != 0)
+    {
+        AGENT_ERROR("Error registering the fifo wait descriptors, errno " << errno);
+        return HSAIL_AGENT_STATUS_FAILURE;
+    }
+
     AGENT_LOG("Finished Opening FIFO GDB  ==> Agent");
 
     return HSAIL_AGENT_STATUS_SUCCESS ;
 }
 
+/// Block until the read end of the fifo has data, the timeout expires
+/// or ShutDownFifoReadEnd is called.
+/// A negative timeout waits forever
+HsailAgentStatus WaitForFifoReadEnd(const int timeoutMs, bool* pIsReadable)
+{
+    if (pIsReadable == nullptr)
+    {
+        AGENT_ERROR("WaitForFifoReadEnd: pIsReadable is nullptr");
+        return HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    *pIsReadable = false;
+
+    if (gs_FIFO_SHUTDOWN)
+    {
+        return HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    if (gs_FIFO_EPOLL_DESC < 0)
+    {
+        AGENT_ERROR("WaitForFifoReadEnd: The fifo has not been initialized");
+        return HSAIL_AGENT_STATUS_FAILURE;
+    }
+
+    struct epoll_event events[2];
+    int numEvents = epoll_wait(gs_FIFO_EPOLL_DESC, events, 2, timeoutMs);
+
+    if (numEvents < 0)
+    {
+        // A signal interrupting the wait is reported as a timeout
+        if (errno != EINTR)
+        {
+            AGENT_ERROR("WaitForFifoReadEnd: epoll_wait failed, errno " << errno);
+            return HSAIL_AGENT_STATUS_FAILURE;
+        }
+
+        return HSAIL_AGENT_STATUS_SUCCESS;
+    }
+
+    bool isHangUp = false;
+
+    for (int i = 0; i < numEvents; i++)
+    {
+        if (events[i].data.fd == gs_FIFO_SHUTDOWN_DESC)
+        {
+            return HSAIL_AGENT_STATUS_FAILURE;
+        }
+
+        if (events[i].events & EPOLLIN)
+        {
+            *pIsReadable = true;
+        }
+        else if (events[i].events & EPOLLHUP)
+        {
+            isHangUp = true;
+        }
+    }
+
+    // gdb has closed its end of the fifo. The descriptor will keep reporting
+    // a hangup, so sleep out the timeout instead of returning right away and
+    // let the caller's parent status check deal with it
+    if (isHangUp && !*pIsReadable)
+    {
+        struct pollfd shutdownPoll;
+        shutdownPoll.fd = gs_FIFO_SHUTDOWN_DESC;
+        shutdownPoll.events = POLLIN;
+        shutdownPoll.revents = 0;
+
+        if (poll(&shutdownPoll, 1, timeoutMs) > 0)
+        {
+            return HSAIL_AGENT_STATUS_FAILURE;
+        }
+    }
+
+    return HSAIL_AGENT_STATUS_SUCCESS;
+}
+
+/// Wake up any thread blocked in WaitForFifoReadEnd, all later waits fail
+/// right away
+void ShutDownFifoReadEnd()
+{
+    gs_FIFO_SHUTDOWN = true;
+
+    if (gs_FIFO_SHUTDOWN_DESC >= 0)
+    {
+        uint64_t one = 1;
+
+        if (write(gs_FIFO_SHUTDOWN_DESC, &one, sizeof(one)) != sizeof(one))
+        {
+            AGENT_ERROR("ShutDownFifoReadEnd: Could not signal the fifo shutdown event");
+        }
+    }
+}
+
+/// Close the descriptors used to wait on the fifo
+void CloseFifoReadEndEvents()
+{
+    if (gs_FIFO_EPOLL_DESC >= 0)
+    {
+        close(gs_FIFO_EPOLL_DESC);
+        gs_FIFO_EPOLL_DESC = -1;
+    }
+
+    if (gs_FIFO_SHUTDOWN_DESC >= 0)
+    {
+        close(gs_FIFO_SHUTDOWN_DESC);
+        gs_FIFO_SHUTDOWN_DESC = -1;
+    }
+}
+
 /// Return the descriptor of the fifo's read end
 int GetFifoReadEnd()
 {
@@ -123,7 +281,8 @@ HsailAgentStatus InitFifoWriteEnd()
     gs_FIFO_WRITE_DESC = -1;
 
     AGENT_LOG("Opening FIFO GDB  <== Agent");
-    gs_FIFO_WRITE_DESC = open(gs_AgentToGdbFifoName, O_WRONLY);
+    const std::string agentToGdbFifoName = GetDebugSessionFifoName(gs_AgentToGdbFifoName, GetAgentFifoDir());
+    gs_FIFO_WRITE_DESC = open(agentToGdbFifoName.c_str(), O_WRONLY | O_NOFOLLOW);
 
     if (gs_FIFO_WRITE_DESC <= 0)
     {
@@ -157,7 +316,7 @@ static const int g_TIMEOUT = 100;
 void CheckSharedMem(const key_t shmkey, const int maxShmSize)
 {
     //Check if the shared memory has been created
-    key_t key = shmkey;
+    key_t key = GetAgentShmKey(shmkey);
     int shmid;
     int count = 0;
 
@@ -178,7 +337,7 @@ void CheckSharedMem(const key_t shmkey, const int maxShmSize)
 HsailAgentStatus AgentFreeSharedMemBuffer(const key_t shmkey, const int maxShmSize)
 {
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
-    key_t key = shmkey;
+    key_t key = GetAgentShmKey(shmkey);
     int shmid = shmget(key, maxShmSize, 0666);
 
     // We do the get pointer attach and detach routine. It is unclear to me
@@ -228,7 +387,7 @@ HsailAgentStatus AgentFreeSharedMemBuffer(const key_t shmkey, const int maxShmSi
 void* AgentMapSharedMemBuffer(const key_t shmkey, const int maxShmSize)
 {
     // Send the waves to gdb
-    key_t key = shmkey;
+    key_t key = GetAgentShmKey(shmkey);
     int shmid = shmget(key, maxShmSize , 0666);
 
     if (shmid  < 0)
@@ -252,6 +411,27 @@ void* AgentMapSharedMemBuffer(const key_t shmkey, const int maxShmSize)
 }
 
 
+size_t AgentGetSharedMemBufferSize(const key_t shmkey)
+{
+    int shmid = shmget(GetAgentShmKey(shmkey), 0, 0666);
+
+    if (shmid < 0)
+    {
+        AGENT_ERROR("AgentGetSharedMemBufferSize: Error with shmget\n");
+        return 0;
+    }
+
+    struct shmid_ds shmInfo;
+
+    if (shmctl(shmid, IPC_STAT, &shmInfo) < 0)
+    {
+        AGENT_ERROR("AgentGetSharedMemBufferSize: Error with shmctl\n");
+        return 0;
+    }
+
+    return shmInfo.shm_segsz;
+}
+
 HsailAgentStatus AgentUnMapSharedMemBuffer(void* pShm)
 {
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
@@ -274,11 +454,11 @@ HsailAgentStatus AgentUnMapSharedMemBuffer(void* pShm)
     return status;
 }
 
-/// Creates a shared memory buffer, using a known key( g_SHMKEY).
+/// Creates a shared memory buffer, using a known key( g_SHMKEY) made unique to the debug session.
 /// This shared memory buffer is used in the initialization of the HSAIL debugger
 HsailAgentStatus AgentAllocSharedMemBuffer(const key_t shmkey, const int maxShmSize)
 {
-    key_t key = shmkey;
+    key_t key = GetAgentShmKey(shmkey);
     int shmid = shmget(key, maxShmSize, IPC_CREAT | 0666);
 
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
@@ -323,7 +503,7 @@ HsailAgentStatus WaitForSharedMemoryUpdate(const key_t shmkey, const int maxShmS
 
     do
     {
-        shmid = shmget(shmkey, maxShmSize, 0666);
+        shmid = shmget(GetAgentShmKey(shmkey), maxShmSize, 0666);
         sleep(1);
         count++;
 
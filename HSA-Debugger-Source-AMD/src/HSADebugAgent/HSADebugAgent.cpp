@@ -23,6 +23,7 @@
 #include "AgentNotifyGdb.h"
 #include "AgentLogging.h"
 #include "AgentContext.h"
+#include "AgentTrace.h"
 #include "AgentUtils.h"
 #include "CommunicationControl.h"
 #include "CommandLoop.h"
@@ -259,6 +260,8 @@ static void CloseCommunicationFifo()
         // Close the Agent ==> GDB fifo
         int writeFifoDescriptor = GetFifoWriteEnd();
         close(writeFifoDescriptor);
+
+        CloseFifoReadEndEvents();
     }
 }
 
@@ -369,6 +372,14 @@ extern "C" bool OnLoad(ApiTable* pTable,
         return false;
     }
 
+    // Debugging goes on without the trace if it cannot be written
+    status = AgentInitTrace();
+
+    if (status  != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("Could not initialize the agent trace");
+    }
+
     // Start the DBE, this will initialize the DBE's internal Tools RT loaders
     HwDbgStatus dbeStatus = HwDbgInit(reinterpret_cast<void*>(pTable));
 
@@ -420,6 +431,9 @@ extern "C" void OnUnload()
     AGENT_LOG("===== Unload GDB Tools Agent=====");
     HsailAgentStatus status = HSAIL_AGENT_STATUS_FAILURE;
 
+    // Wake up the debug thread if it is blocked waiting on gdb
+    ShutDownFifoReadEnd();
+
     status = HwDbgAgent::WaitForDebugThreadCompletion();
 
     if (status  != HSAIL_AGENT_STATUS_SUCCESS)
@@ -447,6 +461,13 @@ extern "C" void OnUnload()
         delete psDebuggerRTLoader ;
     }
 
+    status = AgentCloseTrace();
+
+    if (status  != HSAIL_AGENT_STATUS_SUCCESS)
+    {
+        AGENT_ERROR("OnUnload:Could not close the agent trace");
+    }
+
     status = AgentCloseLogger();
 
     if (status  != HSAIL_AGENT_STATUS_SUCCESS)
@@ -102,6 +102,14 @@ public:
     ///
     /// \return The kernel name for this code object
     const std::string GetKernelName() const;
+
+    /// Look up the kernel name an earlier dispatch of this kernel object found.
+    /// Unlike PopulateBinaryFromDBE this needs neither the DBE nor the binary
+    ///
+    /// \param[in] pAqlPacket The AQL packet for the dispatch
+    /// \param[out] kernelNameOut The kernel name
+    /// \return true if the kernel object was dispatched before and its isa did not change
+    static bool FindCachedKernelName(const hsa_kernel_dispatch_packet_t* pAqlPacket, std::string& kernelNameOut);
 };
 } // End Namespace HwDbgAgent
 
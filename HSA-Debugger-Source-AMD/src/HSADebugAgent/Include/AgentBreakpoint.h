@@ -9,15 +9,18 @@
 #ifndef _AGENT_BREAKPOINT_H_
 #define _AGENT_BREAKPOINT_H_
 
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "AgentBreakpointIndex.h"
+#include "AgentConditionProgram.h"
 #include "AgentContext.h"
 #include "AgentLogging.h"
 #include "CommunicationControl.h"
 
 namespace HwDbgAgent
 {
-/// GDB assigns a integer breakpoint id to each breakpoint
-typedef int GdbBkptId;
-
 const GdbBkptId g_UNKOWN_GDB_BKPT_ID = -9999;
 
 typedef enum
@@ -47,7 +50,8 @@ public:
     AgentBreakpointCondition():
         m_workitemID(g_UNKNOWN_HWDBGDIM3),
         m_workgroupID(g_UNKNOWN_HWDBGDIM3),
-        m_conditionCode(HSAIL_BREAKPOINT_CONDITION_ANY)
+        m_conditionCode(HSAIL_BREAKPOINT_CONDITION_ANY),
+        m_program()
     {
         AGENT_LOG("Allocate an AgentBreakpointCondition");
     }
@@ -61,6 +65,12 @@ public:
     /// \return HSAIL agent status
     HsailAgentStatus SetCondition(const HsailConditionPacket& pCondition);
 
+    /// Replace the condition by a condition program, an empty program makes the breakpoint unconditional
+    /// \param[in] pOps The condition program from the breakpoint batch
+    /// \param[in] numOps The number of operations of the program
+    /// \return HSAIL agent status, failure if the program is malformed
+    HsailAgentStatus SetProgram(const HsailConditionOp* pOps, const size_t numOps);
+
     /// Check the condition against a workgroup and workitem pair
     HsailAgentStatus CheckCondition(const HwDbgDim3 ipWorkGroup, const HwDbgDim3 ipWorkItem, bool& conditionCodeOut) const;
 
@@ -69,12 +79,18 @@ public:
     /// The checkCondition function can be implemented in multiple forms, with the SIMT model
     ///
     /// \param[in] pWaveInfo An entry from the waveinfo buffer
+    /// \param[in] workGroupSize The dispatch's work-group size, used by condition programs
+    /// \param[in] hitCount The breakpoint's hit count with this wave, used by condition programs
     /// \param[out] conditionCodeOut Return true if the condition matches
     /// \param[out] conditionTypeOut The type of condition.  Based on this type the focus control changes focus
+    /// \param[out] matchingLaneOut The lane a condition program matched, -1 for other conditions
     /// \return HSAIL agent status
     HsailAgentStatus CheckCondition(const HwDbgWavefrontInfo* pWaveInfo,
+                                    const HwDbgDim3&          workGroupSize,
+                                    const uint64_t            hitCount,
                                           bool&               conditionCodeOut,
-                                          HsailConditionCode& conditionTypeOut) const;
+                                          HsailConditionCode& conditionTypeOut,
+                                          int&                matchingLaneOut) const;
 
     /// Get function to get the workgroup, used for FocusControl
     /// \return The work group used for this condition
@@ -104,6 +120,68 @@ private:
     /// The type of condition
     HsailConditionCode m_conditionCode;
 
+    /// The program for HSAIL_BREAKPOINT_CONDITION_PROGRAM
+    AgentConditionProgram m_program;
+
+};
+
+
+/// The hits of a breakpoint by work-group and lane, published to gdb
+/// through the breakpoint statistics shared mem.
+/// Trace breakpoints only have these, they never stop the dispatch
+class AgentBreakpointStats
+{
+public:
+    AgentBreakpointStats():
+        m_waveHits(0),
+        m_workGroups(),
+        m_workGroupIndex(),
+        m_isChanged(true)
+    {
+        Clear();
+    }
+
+    /// Count a wave that reached the breakpoint
+    /// \param[in] waveInfo The wave, from the DBE's active waves
+    void AddWave(const HwDbgWavefrontInfo& waveInfo);
+
+    /// Forget all hits
+    void Clear();
+
+    /// Fill in the counters of the shared mem record, all but the work-group position
+    void GetCounters(HsailBreakpointStats& statsOut) const;
+
+    /// \return the work-groups that hit the breakpoint, in the order they first did
+    const std::vector<HsailWorkGroupHits>& GetWorkGroups() const { return m_workGroups; }
+
+    /// \return true if there were hits, or the hits were cleared, since MarkPublished
+    bool IsChanged() const { return m_isChanged; }
+
+    /// The statistics as they are now are in the shared mem
+    void MarkPublished() { m_isChanged = false; }
+
+private:
+
+    /// Disable copy constructor
+    AgentBreakpointStats(const AgentBreakpointStats&);
+
+    /// Disable assignment operator
+    AgentBreakpointStats& operator=(const AgentBreakpointStats&);
+
+    /// The number of waves that reached the breakpoint
+    uint64_t m_waveHits;
+
+    /// How often each lane was active when a wave reached the breakpoint
+    uint64_t m_laneHits[HSAIL_WAVEFRONT_SIZE];
+
+    /// The hits of each work-group
+    std::vector<HsailWorkGroupHits> m_workGroups;
+
+    /// Position of each work-group in m_workGroups
+    std::map<std::tuple<uint32_t, uint32_t, uint32_t>, size_t> m_workGroupIndex;
+
+    /// Whether the statistics changed since they were last published
+    bool m_isChanged;
 };
 
 
@@ -143,6 +221,12 @@ public:
     /// Presently hsail-gdb supports only one condition at a time per breakable line
     AgentBreakpointCondition m_condition;
 
+    /// Trace breakpoints count their hits in m_stats and never stop the dispatch
+    HsailBreakpointMode m_mode;
+
+    /// The hits of this breakpoint by work-group and lane
+    AgentBreakpointStats m_stats;
+
     AgentBreakpoint():
         m_bpState(HSAIL_BREAKPOINT_STATE_UNKNOWN),
         m_hitcount(0),
@@ -153,6 +237,8 @@ public:
         m_lineNum(-1),
         m_kernelName(""),
         m_condition(),
+        m_mode(HSAIL_BREAKPOINT_MODE_STOP),
+        m_stats(),
         m_handle(nullptr)
     {
 
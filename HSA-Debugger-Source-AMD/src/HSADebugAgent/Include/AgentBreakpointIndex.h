@@ -0,0 +1,95 @@
+//==============================================================================
+// Copyright (c) 2015 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Hash indexes over the breakpoint manager's breakpoint vectors
+//==============================================================================
+#ifndef _AGENT_BREAKPOINT_INDEX_H_
+#define _AGENT_BREAKPOINT_INDEX_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "AMDGPUDebug.h"
+
+namespace HwDbgAgent
+{
+/// GDB assigns a integer breakpoint id to each breakpoint
+typedef int GdbBkptId;
+
+/// Maps PCs and GDB IDs to positions in one of the breakpoint manager's vectors.
+/// The breakpoint statistics are updated once per active wave on every stop,
+/// so looking up the breakpoint at a wave's PC should not scan all breakpoints.
+///
+/// The index only stores positions, the owner is responsible for keeping it in
+/// sync with the vector it describes (and for rebuilding it when positions shift).
+/// It only depends on the DBE types, so it can be built without the HSA runtime
+class AgentBreakpointIndex
+{
+public:
+    AgentBreakpointIndex():
+        m_pcPositions(),
+        m_gdbIdPositions()
+    {
+    }
+
+    /// Forget all positions
+    void Clear();
+
+    /// Record that the breakpoint at position has this PC.
+    /// Positions for one PC are kept in the order they were added
+    void AddPC(const HwDbgCodeAddress pc, const int position);
+
+    /// Record that the breakpoint at position has this GDB ID.
+    /// If the GDB ID is already indexed, the first position is kept
+    void AddGdbId(const GdbBkptId gdbId, const int position);
+
+    /// Forget a GDB ID, called when it is removed from its breakpoint
+    void RemoveGdbId(const GdbBkptId gdbId);
+
+    /// \return the positions of the breakpoints at this PC, nullptr if there are none
+    const std::vector<int>* FindPC(const HwDbgCodeAddress pc) const;
+
+    /// \return the position of the breakpoint with this GDB ID, -1 if there is none
+    int FindGdbId(const GdbBkptId gdbId) const;
+
+    /// \return the first position at this PC for which accept(position) is true,
+    /// -1 if there is none
+    template<typename Accept>
+    int FindFirstPC(const HwDbgCodeAddress pc, Accept accept) const
+    {
+        const std::vector<int>* pPositions = FindPC(pc);
+
+        if (pPositions != nullptr)
+        {
+            for (size_t i = 0; i < pPositions->size(); i++)
+            {
+                if (accept(pPositions->at(i)))
+                {
+                    return pPositions->at(i);
+                }
+            }
+        }
+
+        return -1;
+    }
+
+private:
+
+    /// Disable copy constructor
+    AgentBreakpointIndex(const AgentBreakpointIndex&);
+
+    /// Disable assignment operator
+    AgentBreakpointIndex& operator=(const AgentBreakpointIndex&);
+
+    /// Positions of the breakpoints at each PC
+    std::unordered_map<HwDbgCodeAddress, std::vector<int> > m_pcPositions;
+
+    /// Position of the breakpoint owning each GDB ID
+    std::unordered_map<GdbBkptId, int> m_gdbIdPositions;
+};
+
+} // End Namespace HwDbgAgent
+
+#endif // _AGENT_BREAKPOINT_INDEX_H_
@@ -14,8 +14,12 @@
 #include <vector>
 #include <sstream>
 
+#include <hsa.h>
+
 #include "AMDGPUDebug.h"
 #include "AgentBreakpoint.h"
+#include "AgentBreakpointIndex.h"
+#include "AgentDispatchFilter.h"
 #include "AgentLogging.h"
 #include "CommunicationControl.h"
 #include "CommunicationParams.h"
@@ -41,21 +45,91 @@ private:
     /// A vector of momentary breakpoint pointers
     std::vector<AgentBreakpoint*> m_pMomentaryBreakpoints;
 
+    /// PC and GDB ID index of m_pBreakpoints
+    AgentBreakpointIndex m_breakpointIndex;
+
+    /// PC index of m_pMomentaryBreakpoints
+    AgentBreakpointIndex m_momentaryBreakpointIndex;
+
+    /// The momentary breakpoints are gdb's step breakpoints for the line being stepped,
+    /// they stay across stops until gdb clears them instead of going away with the next stop
+    bool m_keepMomentaryBreakpoints;
+
     /// Name of the file where the hsail kernel source is saved
     std::string m_kernelSourceFilename;
 
+    /// The kernels gdb wants to see dispatched
+    AgentDispatchFilter m_dispatchFilter;
+
+    /// Where PublishBreakpointStats put the statistics of a PC breakpoint
+    struct PublishedStats
+    {
+        AgentBreakpoint*    m_pBkpt;
+        HwDbgCodeAddress    m_pc;
+        HsailBreakpointMode m_mode;
+        size_t              m_firstWorkGroup;
+        size_t              m_maxWorkGroups;    ///< Work-group slots set aside, spare ones included
+        bool                m_isTruncated;      ///< Work-groups were left out for lack of space
+    };
+
+    /// The published PC breakpoints, in the order of their statistics in the shared mem
+    std::vector<PublishedStats> m_publishedStats;
+
+    /// The shared mem does not hold a layout of the statistics yet
+    bool m_isStatsLayoutStale;
+
     /// Allocate the shared mem for the momentary breakpoints
     HsailAgentStatus AllocateMomentaryBPBuffer() const;
 
     /// Free the shared mem for the momentary breakpoints
     HsailAgentStatus FreeMomentaryBPBuffer() const;
 
+    /// Allocate the shared mem for breakpoint batches
+    HsailAgentStatus AllocateBreakpointBatchBuffer() const;
+
+    /// Free the shared mem for breakpoint batches
+    HsailAgentStatus FreeBreakpointBatchBuffer() const;
+
+    /// Allocate the shared mem for the breakpoint statistics
+    HsailAgentStatus AllocateBreakpointStatsBuffer();
+
+    /// Free the shared mem for the breakpoint statistics
+    HsailAgentStatus FreeBreakpointStatsBuffer() const;
+
+    /// Bring the breakpoint statistics shared mem up to date with the hits of all PC breakpoints,
+    /// only the breakpoints that changed are written unless breakpoints came, went or outgrew their slots
+    HsailAgentStatus PublishBreakpointStats();
+
+    /// \return true if the published layout still fits the PC breakpoints
+    /// \param[out] pIsChangedOut Set if a published breakpoint has hits to write
+    bool IsStatsLayoutCurrent(bool* pIsChangedOut) const;
+
+    /// Lay out and write the statistics of all PC breakpoints
+    void WriteAllBreakpointStats(HsailBreakpointStatsHeader* pHeader);
+
+    /// Write the statistics of the published breakpoints that changed, in their slots
+    void WriteChangedBreakpointStats(HsailBreakpointStatsHeader* pHeader);
+
+    /// Create a momentary breakpoint in the DBE and add it to m_pMomentaryBreakpoints
+    HsailAgentStatus AddMomentaryBreakpoint(const HwDbgContextHandle DbeContextHandle,
+                                            const HwDbgCodeAddress   pc,
+                                            const int                lineNum);
+
     /// Called internally when we need a new temp breakpoint
     GdbBkptId CreateNewTempBreakpointId();
 
     /// To clear up memory when we destroy the breakpoint manager.
     HsailAgentStatus ClearBreakpointVectors();
 
+    /// Add the PC and GDB IDs of the breakpoint at this position of m_pBreakpoints to the index
+    void IndexBreakpoint(const int breakpointPos);
+
+    /// Remove a GDB ID from the index once the breakpoint no longer holds it
+    void UnindexGdbId(const AgentBreakpoint* pBkpt, const GdbBkptId gdbId);
+
+    /// Index m_pBreakpoints from scratch, needed when breakpoints move within the vector
+    void RebuildBreakpointIndex();
+
     /// Enable all the momentary breakpoints, done as part of the EnableAllPCBreakpoints
     HsailAgentStatus EnableAllMomentaryBreakpoints(const HwDbgContextHandle DbeContextHandle);
 
@@ -70,6 +144,41 @@ private:
     /// \return position of the breakpoint object - based on GDBID
     bool GetBreakpointFromGDBId(const GdbBkptId ipId, int* pBreakpointPosOut) const;
 
+    /// \return position of the PC breakpoint at this PC, -1 if there is none
+    int GetPCBreakpointPosition(const HwDbgCodeAddress pc) const;
+
+    /// Delete one GDB ID of the breakpoint at this position, and the breakpoint once no GDB ID is left
+    HsailAgentStatus DeleteBreakpointAt(const HwDbgContextHandle DbeContextHandle,
+                                        const int                breakpointpos,
+                                        const GdbBkptId          gdbId);
+
+    /// Disable the breakpoint at this position
+    HsailAgentStatus DisablePCBreakpointAt(const HwDbgContextHandle DbeContextHandle,
+                                           const int                breakpointpos,
+                                           const GdbBkptId          gdbId);
+
+    /// Enable the breakpoint at this position
+    HsailAgentStatus EnablePCBreakpointAt(const HwDbgContextHandle DbeContextHandle,
+                                          const int                breakpointpos,
+                                          const GdbBkptId          gdbId);
+
+    /// Apply a single operation of a breakpoint batch
+    /// \param[in] pBatch The start of the batch shared mem, the condition programs are relative to it
+    /// \param[in] batchSize The size of the batch shared mem
+    HsailAgentStatus ApplyBreakpointOp(const HwDbgContextHandle DbeContextHandle,
+                                       const HsailBreakpointOp& op,
+                                       const uint8_t*           pBatch,
+                                       const size_t             batchSize);
+
+    /// Set the condition program of the breakpoint at this position from a breakpoint batch
+    HsailAgentStatus SetBreakpointProgramAt(const int                breakpointPos,
+                                            const HsailBreakpointOp& op,
+                                            const uint8_t*           pBatch,
+                                            const size_t             batchSize);
+
+    /// Set the mode of the breakpoint at this position, switching to trace mode starts counting from zero
+    HsailAgentStatus SetBreakpointModeAt(const int breakpointPos, const uint32_t mode);
+
     /// Utility function to print the wave info for the breakpoint we just hit
     void PrintWaveInfo(const HwDbgWavefrontInfo* pWaveInfo, const HwDbgDim3* pFocusWI = nullptr) const;
 
@@ -82,7 +191,11 @@ private:
 public:
 
     AgentBreakpointManager():
-        m_kernelSourceFilename("temp_source")
+        m_keepMomentaryBreakpoints(false),
+        m_kernelSourceFilename("temp_source"),
+        m_dispatchFilter(),
+        m_publishedStats(),
+        m_isStatsLayoutStale(true)
     {
         HsailAgentStatus status = AllocateMomentaryBPBuffer();
 
@@ -90,6 +203,14 @@ public:
         {
             AGENT_ERROR("Could not initialize the shared mem buffer for momentary BP");
         }
+        else if (AllocateBreakpointBatchBuffer() != HSAIL_AGENT_STATUS_SUCCESS)
+        {
+            AGENT_ERROR("Could not initialize the shared mem buffer for breakpoint batches");
+        }
+        else if (AllocateBreakpointStatsBuffer() != HSAIL_AGENT_STATUS_SUCCESS)
+        {
+            AGENT_ERROR("Could not initialize the shared mem buffer for breakpoint statistics");
+        }
         else
         {
             AGENT_LOG("Successfully Initialized Breakpoint Manager");
@@ -139,23 +260,44 @@ public:
     HsailAgentStatus CreateMomentaryBreakpoints(const HwDbgContextHandle DbeContextHandle,
                                                 const HsailCommandPacket ipPacket);
 
+    /// Apply the batch of PC breakpoint operations that gdb wrote to shared mem
+    HsailAgentStatus ApplyBreakpointBatch(const HwDbgContextHandle DbeContextHandle,
+                                          const HsailCommandPacket ipPacket);
+
     /// Clear all momentary breakpoints
     HsailAgentStatus ClearMomentaryBreakpoints(const HwDbgContextHandle DbeContextHandle);
 
+    /// \return true if the momentary breakpoints are step breakpoints that should survive this stop
+    bool IsKeepingMomentaryBreakpoints() const;
+
     /// Checks the eventtype and then checks all the breakpoint PCs against the active wave PCs
+    /// The breakpoint conditions are evaluated here, pIsStopNeeded is false if no wave matched
+    /// Waves at trace breakpoints never need a stop
     HsailAgentStatus PrintStoppedReason(const HwDbgEventType     DbeEventType,
                                         const HwDbgContextHandle DbeContextHandlel,
+                                        const HwDbgDim3&         workGroupSize,
                                               AgentFocusWaveControl* pFocusWaveControl,
                                               bool*                  pIsStopNeeded);
 
     /// Update the hit count of each breakpoint based on what we get from GetActiveWaves
     /// EventType is passed just to check that the DBE is in the right state before calling
+    /// gdb is only notified when isStopNeeded, traps no condition matched resume without it
+    /// The hits are also counted by work-group and lane and published as the breakpoint statistics
     HsailAgentStatus UpdateBreakpointStatistics(const HwDbgEventType DbeEventType,
-                                                const HwDbgContextHandle DbeContextHandle);
+                                                const HwDbgContextHandle DbeContextHandle,
+                                                const bool isStopNeeded = true);
 
     /// Update the breakpoint statistics for kernel function breakpoints
     HsailAgentStatus ReportFunctionBreakpoint(const std::string& kernelFunctionName);
 
+    /// Accessor method to return the dispatch filter gdb sent
+    AgentDispatchFilter& GetDispatchFilter();
+
+    /// \return true if no breakpoint could stop this dispatch and gdb did not select its kernel.
+    /// Only looks at the breakpoints, the dispatch filter and the kernel names cached
+    /// by earlier dispatches, so it is safe to call before BeginDebugging
+    bool CanSkipDispatch(const hsa_kernel_dispatch_packet_t* pAqlPacket) const;
+
 };
 
 } // End Namespace HwDbgAgent
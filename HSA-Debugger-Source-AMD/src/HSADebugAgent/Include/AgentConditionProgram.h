@@ -0,0 +1,74 @@
+//==============================================================================
+// Copyright (c) 2015 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Breakpoint condition programs evaluated inside the agent
+//==============================================================================
+#ifndef _AGENT_CONDITION_PROGRAM_H_
+#define _AGENT_CONDITION_PROGRAM_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "AMDGPUDebug.h"
+#include "CommunicationControl.h"
+
+namespace HwDbgAgent
+{
+/// A condition program gdb attached to a breakpoint, see HsailConditionOpCode.
+/// Evaluating the condition in the agent lets waves that do not match resume
+/// straight away, rather than stopping the whole dispatch for gdb to filter them.
+///
+/// Programs are validated once when they are set, so evaluation does no checks
+class AgentConditionProgram
+{
+public:
+    AgentConditionProgram():
+        m_ops(),
+        m_isLaneDependent(false)
+    {
+    }
+
+    /// Validate and save a program
+    /// \param[in] pOps The program, ending at its first HSAIL_CONDITION_OP_END
+    /// \param[in] numOps The number of operations available at pOps
+    /// \return HSAIL agent status, failure if the program is malformed, the previous program is kept
+    HsailAgentStatus SetProgram(const HsailConditionOp* pOps, const size_t numOps);
+
+    /// Forget the program, the condition then always holds
+    void Clear();
+
+    /// \return true if there is no program
+    bool IsEmpty() const;
+
+    /// Evaluate the program for a wave that trapped at the breakpoint
+    ///
+    /// \param[in] waveInfo The wave, from the DBE's active waves
+    /// \param[in] workGroupSize The dispatch's work-group size, for the global IDs
+    /// \param[in] hitCount The breakpoint's hit count, this wave included
+    /// \param[out] pMatchingLaneOut The first active lane the program holds for, can be nullptr
+    /// \return true if the program holds for any active lane of the wave
+    bool Evaluate(const HwDbgWavefrontInfo& waveInfo,
+                  const HwDbgDim3&          workGroupSize,
+                  const uint64_t            hitCount,
+                  int*                      pMatchingLaneOut) const;
+
+private:
+
+    /// Run the program for one lane, -1 for a program that does not look at lanes
+    uint64_t Run(const HwDbgWavefrontInfo& waveInfo,
+                 const HwDbgDim3&          workGroupSize,
+                 const uint64_t            hitCount,
+                 const int                 lane) const;
+
+    /// The validated program, without its HSAIL_CONDITION_OP_END
+    std::vector<HsailConditionOp> m_ops;
+
+    /// True if the program reads a lane's work-item, so it runs once per active lane
+    bool m_isLaneDependent;
+};
+
+} // End Namespace HwDbgAgent
+
+#endif // _AGENT_CONDITION_PROGRAM_H_
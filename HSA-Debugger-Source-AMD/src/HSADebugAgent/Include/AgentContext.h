@@ -99,6 +99,12 @@ private:
     /// Private function to free the shared memory buffer for the binary
     HsailAgentStatus FreeBinarySharedMemBuffer();
 
+    /// Private function to initialize the shared memory buffer for read batches
+    HsailAgentStatus AllocateReadBatchSharedMemBuffer();
+
+    /// Private function to free the shared memory buffer for read batches
+    HsailAgentStatus FreeReadBatchSharedMemBuffer();
+
 public:
     /// A bit to track that we have received the continue command from the host
     bool m_ReadyToContinue;
@@ -0,0 +1,88 @@
+//==============================================================================
+// Copyright (c) 2015 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief The kernels gdb wants to see dispatched
+//==============================================================================
+#ifndef _AGENT_DISPATCH_FILTER_H_
+#define _AGENT_DISPATCH_FILTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace HwDbgAgent
+{
+/// The kernels gdb has breakpoints in, as sent by gdb.
+/// The predispatch callback leaves dispatches of other kernels alone when no
+/// PC breakpoint could stop them, without starting the DBE or publishing the binary.
+///
+/// Until gdb sends a filter every kernel is selected, so a gdb that does not know
+/// about the filter sees every dispatch like it used to
+class AgentDispatchFilter
+{
+public:
+    AgentDispatchFilter():
+        m_isAllKernels(true),
+        m_isUpdating(false),
+        m_isAllKernelsUpdate(false),
+        m_kernelNames(),
+        m_unpublishedKernelObjects()
+    {
+    }
+
+    /// Start replacing the filter, every kernel is selected until EndUpdate
+    void BeginUpdate();
+
+    /// Select the dispatches of a kernel, an empty name selects every kernel
+    void AddKernel(const std::string& kernelName);
+
+    /// Finish replacing the filter
+    void EndUpdate();
+
+    /// \return true if every dispatch is selected
+    bool IsAllKernels() const;
+
+    /// \return true if some kernels are selected by name, deciding on a dispatch needs its kernel name
+    bool HasKernelNames() const;
+
+    /// \return true if the dispatches of this kernel are selected
+    bool IsKernelSelected(const std::string& kernelName) const;
+
+    /// Remember a dispatch that was skipped, the binary of its kernel object was not published
+    void AddSkippedDispatch(const uint64_t kernelObject);
+
+    /// Forget the skipped dispatches of a kernel object once its binary is published
+    /// \return the number of dispatches whose binary publication was deferred
+    size_t RemoveSkippedDispatches(const uint64_t kernelObject);
+
+private:
+
+    /// Disable copy constructor
+    AgentDispatchFilter(const AgentDispatchFilter&);
+
+    /// Disable assignment operator
+    AgentDispatchFilter& operator=(const AgentDispatchFilter&);
+
+    /// Every kernel is selected
+    bool m_isAllKernels;
+
+    /// gdb is sending a new filter
+    bool m_isUpdating;
+
+    /// The filter being sent selects every kernel
+    bool m_isAllKernelsUpdate;
+
+    /// The selected kernels
+    std::unordered_set<std::string> m_kernelNames;
+
+    /// Skipped dispatches by kernel object, their binaries are published with the next selected dispatch
+    std::unordered_map<uint64_t, size_t> m_unpublishedKernelObjects;
+};
+
+} // End Namespace HwDbgAgent
+
+#endif // _AGENT_DISPATCH_FILTER_H_
@@ -18,12 +18,17 @@
 #define LOG_ERR_TO_STDERR 1
 
 // Macro to create a stringstream, initialize it and use existing AgentLog()
-#define AGENT_LOG(stream)           \
-{                                   \
-    std::stringstream buffer;       \
-    buffer.str("");                 \
-    buffer << stream << "\n";       \
-    AgentLog(buffer.str().c_str()); \
+// Nothing is formatted unless logging is enabled, the dispatch and debug
+// threads log on every dispatch and stop
+#define AGENT_LOG(stream)               \
+{                                       \
+    if (AgentIsLoggingEnabled())        \
+    {                                   \
+        std::stringstream buffer;       \
+        buffer.str("");                 \
+        buffer << stream << "\n";       \
+        AgentLog(buffer.str().c_str()); \
+    }                                   \
 }
 
 // Macro to create a stringstream, initialize it and use existing AgentErrorLog()
@@ -60,6 +65,9 @@ HsailAgentStatus AgentCloseLogger();
 
 void AgentSetLogging(const bool logFlag);
 
+/// True if AgentLog writes anything
+bool AgentIsLoggingEnabled();
+
 void AgentLog(const char*);
 
 void AgentLogPacketInfo(const HsailCommandPacket& incomingPacket);
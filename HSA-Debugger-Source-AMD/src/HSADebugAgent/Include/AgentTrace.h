@@ -0,0 +1,134 @@
+//==============================================================================
+// Copyright (c) 2015 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Binary event trace of the agent, cheap enough for the dispatch and debug threads
+//==============================================================================
+#ifndef _AGENT_TRACE_H_
+#define _AGENT_TRACE_H_
+
+#include <stdint.h>
+
+#include "CommunicationControl.h"
+
+// The trace is disabled by default, it is enabled by an env variable
+//
+// export HSAIL_GDB_ENABLE_TRACE='prefix' --> will write to prefix_AgentTrace_PID_$pid.bin
+//
+// Every thread records fixed size events in a ring of its own without taking a
+// lock or formatting anything, a writer thread drains the rings to the file.
+// AgentFatalExit stops the writer and drains whatever is left before the process dies.
+// The trace is separate from the text log, which still logs what it always did
+// The file is decoded offline by Tools/AgentTraceDecoder
+
+/// The events of the trace, only append to this list, decoders of older
+/// traces depend on the values
+typedef enum
+{
+    AGENT_TRACE_EVENT_UNKNOWN,
+    AGENT_TRACE_EVENT_DROPPED,              // A ring was full, the events are lost
+    AGENT_TRACE_EVENT_PREDISPATCH_BEGIN,    // The predispatch callback was entered
+    AGENT_TRACE_EVENT_PREDISPATCH_END,      // The predispatch callback is done with the dispatch
+    AGENT_TRACE_EVENT_DEBUG_THREAD_BEGIN,   // The debug event thread started
+    AGENT_TRACE_EVENT_DEBUG_THREAD_END,     // The debug event thread is exiting
+    AGENT_TRACE_EVENT_DBE_EVENT,            // HwDbgWaitForEvent returned
+    AGENT_TRACE_EVENT_STOP,                 // SIGTRAP was raised to stop in gdb
+    AGENT_TRACE_EVENT_CONTINUE,             // The dispatch was continued
+    AGENT_TRACE_EVENT_COMMAND,              // A packet was read from gdb
+    AGENT_TRACE_EVENT_NOTIFICATION,         // A notification was pushed to gdb
+    AGENT_TRACE_EVENT_WAVES_PUBLISHED,      // The wave buffer was written
+    AGENT_TRACE_EVENT_BREAKPOINT_BATCH,     // A breakpoint batch was applied
+    AGENT_TRACE_EVENT_FATAL_EXIT,           // AgentFatalExit was called
+    AGENT_TRACE_EVENT_DEBUG_THREAD_JOINED,  // The predispatch callback joined the previous debug thread
+    AGENT_TRACE_EVENT_DISPATCH_SKIPPED,     // No breakpoint can stop the dispatch, it is not debugged
+    AGENT_TRACE_EVENT_BINARY_PUBLISHED,     // gdb was notified of the dispatch's binary
+    AGENT_TRACE_EVENT_PC_BREAKPOINTS,       // The PC breakpoints the dispatch is debugged for
+    AGENT_TRACE_EVENT_NO_STOP,              // No wave met a breakpoint's condition, the dispatch goes on
+    AGENT_TRACE_EVENT_POSTDISPATCH,         // The postdispatch callback was entered
+    AGENT_TRACE_EVENT_COUNT
+} AgentTraceEvent;
+
+#define AGENT_TRACE_MAX_ARGS 4
+
+/// A single event, the meaning of the arguments depends on the event
+typedef struct _AgentTraceRecord
+{
+    uint64_t m_timestamp;                   // CLOCK_MONOTONIC, in nanoseconds
+    uint32_t m_event;                       // AgentTraceEvent
+    uint32_t m_threadId;                    // The kernel thread ID of the recording thread
+    uint64_t m_args[AGENT_TRACE_MAX_ARGS];  // Unused arguments are 0
+} AgentTraceRecord;
+
+static const char gs_AgentTraceMagic[8] = {'H', 'S', 'A', 'T', 'R', 'A', 'C', 'E'};
+
+// Version of the file layout, bumped whenever the header or the record changes
+static const uint32_t AGENT_TRACE_VERSION = 1;
+
+/// The trace file starts with this header and is followed by records. The
+/// records of a thread are in order, the threads are interleaved in chunks
+typedef struct _AgentTraceFileHeader
+{
+    char m_magic[8];            // gs_AgentTraceMagic
+    uint32_t m_version;         // AGENT_TRACE_VERSION
+    uint32_t m_recordSize;      // sizeof(AgentTraceRecord)
+    uint64_t m_startTime;       // The timestamp of the start of the trace
+    int32_t m_pid;              // The traced process
+    uint32_t m_reserved;
+} AgentTraceFileHeader;
+
+/// How to print an event, shared by the agent and the decoder
+typedef struct _AgentTraceEventInfo
+{
+    const char* m_pName;
+    const char* m_pArgNames[AGENT_TRACE_MAX_ARGS];  // nullptr for unused arguments
+} AgentTraceEventInfo;
+
+static inline const AgentTraceEventInfo& GetAgentTraceEventInfo(const uint32_t event)
+{
+    static const AgentTraceEventInfo s_eventInfo[AGENT_TRACE_EVENT_COUNT] =
+    {
+        {"UNKNOWN",             {nullptr, nullptr, nullptr, nullptr}},
+        {"DROPPED",             {"records", nullptr, nullptr, nullptr}},
+        {"PREDISPATCH_BEGIN",   {"kernel_object", "grid_x", "work_group_x", nullptr}},
+        {"PREDISPATCH_END",     {"debug_thread", nullptr, nullptr, nullptr}},
+        {"DEBUG_THREAD_BEGIN",  {nullptr, nullptr, nullptr, nullptr}},
+        {"DEBUG_THREAD_END",    {"normal_exit", nullptr, nullptr, nullptr}},
+        {"DBE_EVENT",           {"event", "status", nullptr, nullptr}},
+        {"STOP",                {nullptr, nullptr, nullptr, nullptr}},
+        {"CONTINUE",            {nullptr, nullptr, nullptr, nullptr}},
+        {"COMMAND",             {"command", "pc", "momentary_bps", nullptr}},
+        {"NOTIFICATION",        {"notification", "active_waves", nullptr, nullptr}},
+        {"WAVES_PUBLISHED",     {"waves", "bytes", nullptr, nullptr}},
+        {"BREAKPOINT_BATCH",    {"sequence", "ops", nullptr, nullptr}},
+        {"FATAL_EXIT",          {nullptr, nullptr, nullptr, nullptr}},
+        {"DEBUG_THREAD_JOINED", {"join_status", nullptr, nullptr, nullptr}},
+        {"DISPATCH_SKIPPED",    {"kernel_object", nullptr, nullptr, nullptr}},
+        {"BINARY_PUBLISHED",    {"kernel_object", "skipped_dispatches", "function_bps", nullptr}},
+        {"PC_BREAKPOINTS",      {"breakpoints", nullptr, nullptr, nullptr}},
+        {"NO_STOP",             {nullptr, nullptr, nullptr, nullptr}},
+        {"POSTDISPATCH",        {nullptr, nullptr, nullptr, nullptr}},
+    };
+
+    return s_eventInfo[event < AGENT_TRACE_EVENT_COUNT ? event : AGENT_TRACE_EVENT_UNKNOWN];
+}
+
+/// Start the writer thread if the trace is enabled in the environment
+HsailAgentStatus AgentInitTrace();
+
+/// Stop the writer thread and write the events left in the rings
+HsailAgentStatus AgentCloseTrace();
+
+/// Record an event in the calling thread's ring, does nothing if the trace is disabled.
+/// It never blocks: if the writer is behind, the event is dropped and counted
+void AgentTrace(const AgentTraceEvent event,
+                const uint64_t arg0 = 0,
+                const uint64_t arg1 = 0,
+                const uint64_t arg2 = 0,
+                const uint64_t arg3 = 0);
+
+/// Stop the writer and write the events left in the rings before the process dies.
+/// Nothing drains the rings afterwards, the process must only exit
+void AgentTraceDumpPostMortem();
+
+#endif // _AGENT_TRACE_H_
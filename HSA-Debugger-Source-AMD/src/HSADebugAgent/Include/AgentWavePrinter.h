@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "AMDGPUDebug.h"
+#include "CommunicationParams.h"
 
 namespace HwDbgAgent
 {
@@ -19,7 +20,7 @@ const int g_KERNEL_DEBUG_WORKITEMS_PER_WAVEFRONT = 64;
 
 /// This class mirrors the hdKernelDebugWavefront structure in CodeXL
 /// This class should include the struct used to communicate with GDB
-/// "HsailAgentWaveInfo m_WaveInfo;"
+/// "HsailWaveRecord m_WaveInfo;"
 class AgentDbgWavefront
 {
 private:
@@ -70,12 +71,18 @@ private:
 
     void ClearCurrentWavefronts();
 
+    /// The current size of the wave info shared memory
+    size_t m_waveInfoShmemSize;
+
     /// Free the shared memory
     HsailAgentStatus FreeWaveInfoShmem();
 
     /// Allocate the shared memory
     void InitializeWaveInfoShmem();
 
+    /// Reallocate the shared memory so that it holds at least requiredSize bytes
+    HsailAgentStatus GrowWaveInfoShmem(const size_t requiredSize);
+
     /// Private function that prints out data using the AgentOP() utility function
     HsailAgentStatus PrintWaveInfoBuffer(int nWaves, const HwDbgWavefrontInfo* pWaveInfo);
 
@@ -85,7 +92,8 @@ private:
 public:
     AgentWavePrinter():
         m_currentWavefronts(),
-        m_DispatchGlobalWorkDimensions(-1)// State is unknown initially
+        m_DispatchGlobalWorkDimensions(-1),// State is unknown initially
+        m_waveInfoShmemSize(g_WAVE_BUFFER_INITIALSIZE)
     {
         // We create the shared memory for the IPC
         InitializeWaveInfoShmem();
@@ -97,7 +105,10 @@ public:
 
 
     /// Needs a DBE context handle and a event type and sends the active wave info to gdb
-    HsailAgentStatus SendActiveWavesToGdb(HwDbgEventType dbeEventType, HwDbgContextHandle  debugHandle);
+    /// The work-group size of the dispatch lets us avoid sending most work-item IDs
+    HsailAgentStatus SendActiveWavesToGdb(HwDbgEventType      dbeEventType,
+                                          HwDbgContextHandle  debugHandle,
+                                          const HwDbgDim3&    workGroupSize);
 };
 
 } // End Namespace HwDbgAgent
@@ -8,8 +8,17 @@
 #ifndef _COMMUNICATION_PARAMS_H_
 #define _COMMUNICATION_PARAMS_H_
 
-// Value for Fifo permissions, more research necessary to figure out right values
-const int g_FIFO_PERMISSIONS = 0666;
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Permissions of the FIFOs, only the user running the debugger and the
+// agent may open them
+const int g_FIFO_PERMISSIONS = 0600;
 
 // Random number for SHM Segment which communicates the DBE memory to GDB
 const int g_DBEBINARY_SHMKEY = 1234;
@@ -20,14 +29,28 @@ const int g_MOMENTARY_BP_BUFFER_SHMKEY = 1111;
 
 const int g_ISASTREAM_SHMKEY = 4567;
 
+const int g_BREAKPOINT_BATCH_SHMKEY = 3333;
+
+const int g_READ_BATCH_SHMKEY = 5555;
+
+const int g_BREAKPOINT_STATS_SHMKEY = 6666;
+
 const size_t g_MOMENTARY_BP_BUFFER_MAXSIZE = 1024 * 1024 * 20;
 
-const size_t g_BINARY_BUFFER_MAXSIZE = 1024 * 1024 * 10;
+// Initial size of the binary buffer, the agent grows it for larger code objects
+const size_t g_BINARY_BUFFER_INITIALSIZE = 1024 * 1024 * 10;
 
-const size_t g_WAVE_BUFFER_MAXSIZE = 1024 * 1024;
+// Initial size of the wave buffer, the agent grows it for larger dispatches
+const size_t g_WAVE_BUFFER_INITIALSIZE = 1024 * 1024;
 
 const size_t g_ISASTREAM_MAXSIZE = 1024 * 1024;
 
+const size_t g_BREAKPOINT_BATCH_MAXSIZE = 1024 * 1024;
+
+const size_t g_READ_BATCH_MAXSIZE = 1024 * 1024;
+
+const size_t g_BREAKPOINT_STATS_MAXSIZE = 1024 * 1024;
+
 // The names of the Fifos - opened in GDB and the agent
 
 // The FIFO written to by the agent and read by GDB (For things like bp statistics)
@@ -36,4 +59,104 @@ const char gs_AgentToGdbFifoName[]  = "fifo-agent-w-gdb-r";
 // The FIFO written to by GDB and read by Agent (For things like create / delete bp command)
 const char gs_GdbToAgentFifoName[]  = "fifo-gdb-w-agent-r";
 
+// The environment variable the debugger passes its debug session ID to the
+// agent in. Without a session ID the agent uses the fixed keys above, so
+// only one debug session can run on a machine at a time
+const char gs_DebugSessionIdEnvVar[] = "HSAIL_DEBUG_SESSION";
+
+// The environment variable the debugger passes the directory of the
+// session's FIFOs in. Without it the agent uses the fixed FIFO names in its
+// working directory
+const char gs_DebugSessionFifoDirEnvVar[] = "HSAIL_DEBUG_SESSION_DIR";
+
+// mkdtemp template of the FIFO directory of a debug session. The debugger
+// creates it, so nobody else can create or replace FIFOs in it
+const char gs_DebugSessionFifoDirTemplate[] = "/tmp/hsail-debug-XXXXXX";
+
+// The debug session ID from the environment, 0 if there is none
+static inline int GetDebugSessionIdFromEnv()
+{
+    const char* pSessionId = std::getenv(gs_DebugSessionIdEnvVar);
+    return pSessionId == nullptr ? 0 : std::atoi(pSessionId);
+}
+
+// The FIFO directory from the environment, empty if there is none
+static inline std::string GetDebugSessionFifoDirFromEnv()
+{
+    const char* pFifoDir = std::getenv(gs_DebugSessionFifoDirEnvVar);
+    return pFifoDir == nullptr ? std::string() : std::string(pFifoDir);
+}
+
+// The SysV key of a shared memory segment in a debug session.
+// Keys of different sessions never collide, session 0 uses the fixed keys.
+// The 3 bit segment field is full, 0 is taken by unknown keys and 1 to 7 by
+// the segments below. Another segment needs a wider field, taken from the
+// session ID bits
+static inline key_t GetDebugSessionShmKey(const int shmKey, const int sessionId)
+{
+    if (sessionId <= 0)
+    {
+        return shmKey;
+    }
+
+    int segment = 0;
+
+    switch (shmKey)
+    {
+        case g_DBEBINARY_SHMKEY:           segment = 1; break;
+        case g_WAVE_BUFFER_SHMKEY:         segment = 2; break;
+        case g_MOMENTARY_BP_BUFFER_SHMKEY: segment = 3; break;
+        case g_ISASTREAM_SHMKEY:           segment = 4; break;
+        case g_BREAKPOINT_BATCH_SHMKEY:    segment = 5; break;
+        case g_READ_BATCH_SHMKEY:          segment = 6; break;
+        case g_BREAKPOINT_STATS_SHMKEY:    segment = 7; break;
+        default:                           segment = 0; break;
+    }
+
+    return (key_t)(0x40000000 | ((sessionId & 0x3fffff) << 3) | segment);
+}
+
+// The path of a FIFO in a debug session, without a FIFO directory it is
+// the fixed name
+static inline std::string GetDebugSessionFifoName(const char* pFifoName, const std::string& fifoDir)
+{
+    if (fifoDir.empty())
+    {
+        return pFifoName;
+    }
+
+    return fifoDir + "/" + pFifoName;
+}
+
+// Create a FIFO of a debug session. A path that already exists is only used
+// if it is a FIFO of the current user, anything else could have been put
+// there to read or inject packets. Returns false with errno set otherwise
+static inline bool CreateDebugSessionFifo(const std::string& fifoName)
+{
+    if (mkfifo(fifoName.c_str(), g_FIFO_PERMISSIONS) == 0)
+    {
+        return true;
+    }
+
+    if (errno != EEXIST)
+    {
+        return false;
+    }
+
+    struct stat fifoStat;
+
+    if (lstat(fifoName.c_str(), &fifoStat) != 0)
+    {
+        return false;
+    }
+
+    if (!S_ISFIFO(fifoStat.st_mode) || fifoStat.st_uid != geteuid())
+    {
+        errno = EPERM;
+        return false;
+    }
+
+    return true;
+}
+
 #endif // _COMMUNICATIONPARMS_H
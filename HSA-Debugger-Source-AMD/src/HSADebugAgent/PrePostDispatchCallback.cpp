@@ -17,6 +17,7 @@
 #include "AgentLogging.h"
 #include "AgentNotifyGdb.h"
 #include "AgentProcessPacket.h"
+#include "AgentTrace.h"
 #include "AgentUtils.h"
 #include "CommandLoop.h"
 
@@ -100,6 +101,9 @@ void PreDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArg
         return;
     }
 
+    AgentTrace(AGENT_TRACE_EVENT_PREDISPATCH_BEGIN, pAqlPacket->kernel_object,
+               pAqlPacket->grid_size_x, pAqlPacket->workgroup_size_x);
+
     if (!ValidateAQL(*pAqlPacket))
     {
         AGENT_ERROR("Invalid AQL packet.");
@@ -142,6 +146,20 @@ void PreDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArg
 
      AgentLogAQLPacket(pAqlPacket);
 
+    // Take in whatever gdb has sent so far without waiting for more.
+    // If no breakpoint can stop this dispatch and gdb did not ask for its kernel,
+    // leave it alone: no DBE, no binary copy and no waiting on gdb
+    RunFifoCommandLoop(pActiveContext);
+
+    if (pBpManager->CanSkipDispatch(pAqlPacket))
+    {
+        pBpManager->GetDispatchFilter().AddSkippedDispatch(pAqlPacket->kernel_object);
+        AgentTrace(AGENT_TRACE_EVENT_DISPATCH_SKIPPED, pAqlPacket->kernel_object);
+        AGENT_LOG("PredispatchCallback: No breakpoint can stop this dispatch, not debugging it");
+        AgentTrace(AGENT_TRACE_EVENT_PREDISPATCH_END, 0);
+        return;
+    }
+
     // We should read the fifo command loop and check for any function or source breakpoints
     // We will consume everything in the FIFO but stop in the predispatch only if any kernel
     // function breakpoints are set, 50 is just a heuristic for now.
@@ -205,6 +223,16 @@ void PreDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArg
     status = pBinary->NotifyGDB();
     PredispatchCheckStatus(status, "Error in notifying GDB!");
 
+    // Skipped dispatches of this kernel object never published the binary, gdb has it now
+    size_t numDeferredDispatches = pBpManager->GetDispatchFilter().RemoveSkippedDispatches(pAqlPacket->kernel_object);
+    AgentTrace(AGENT_TRACE_EVENT_BINARY_PUBLISHED, pAqlPacket->kernel_object, numDeferredDispatches,
+               pendingFunctionNameBP);
+
+    if (0 < numDeferredDispatches)
+    {
+        AGENT_LOG("PredispatchCallback: Published the binary after " << numDeferredDispatches << " skipped dispatches");
+    }
+
     AGENT_LOG("PredispatchCallback: Check for Function breakpoints");
     // Search for a kernel name match if any function breakpoints present
     bool isFuncBPStopNeeded = false;
@@ -260,6 +288,7 @@ void PreDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArg
         pBpManager->GetNumBreakpointsInState(HSAIL_BREAKPOINT_STATE_PENDING, HSAIL_BREAKPOINT_TYPE_PC_BP) +
         pBpManager->GetNumMomentaryBreakpointsInState(HSAIL_BREAKPOINT_STATE_PENDING) +
         pBpManager->GetNumMomentaryBreakpointsInState(HSAIL_BREAKPOINT_STATE_ENABLED);
+    AgentTrace(AGENT_TRACE_EVENT_PC_BREAKPOINTS, numPendingSrcBP);
 
     status = pBpManager->DisableAllBreakpoints(pActiveContext->GetActiveHwDebugContext());
     PredispatchCheckStatus(status, "Error in DisableAllBreakpoints");
@@ -270,6 +299,7 @@ void PreDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArg
     if (0 >= numPendingSrcBP)
     {
         AGENT_LOG("No source breakpoints available, exiting predispatch callback without starting debug thread");
+        AgentTrace(AGENT_TRACE_EVENT_PREDISPATCH_END, 0);
 
         status = AgentNotifyPredispatchState(HSAIL_PREDISPATCH_LEFT_PREDISPATCH);
         PredispatchCheckStatus(status, "Error notifying predispatch state after EndDebugging");
@@ -319,6 +349,9 @@ void PreDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArg
         PredispatchCheckStatus(status, "Error in CreateDebugEventThread");
     }
 
+    AgentTrace(AGENT_TRACE_EVENT_PREDISPATCH_END,
+               pDebugThreadArgs != nullptr && status == HSAIL_AGENT_STATUS_SUCCESS);
+
     status = AgentNotifyPredispatchState(HSAIL_PREDISPATCH_LEFT_PREDISPATCH);
     PredispatchCheckStatus(status, "Error notifying predispatch state");
 
@@ -331,6 +364,7 @@ void PreDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArg
 void PostDispatchCallback(const hsa_dispatch_callback_t* pRTParam, void* pUserArgs)
 {
     AGENT_LOG("== Post-dispatch callback ==");
+    AgentTrace(AGENT_TRACE_EVENT_POSTDISPATCH);
 
     if (pRTParam == nullptr || pRTParam->pre_dispatch)
     {
@@ -0,0 +1,181 @@
+//==============================================================================
+// Copyright (c) 2015 Advanced Micro Devices, Inc. All rights reserved.
+//
+/// \author AMD Developer Tools
+/// \file
+/// \brief Offline decoder of the agent's binary event trace
+///
+/// Prints the events of a trace written with HSAIL_GDB_ENABLE_TRACE in time
+/// order, or with -s the number of events of every kind per thread.
+/// The agent formats nothing while it records, all formatting happens here.
+/// Build it with "make tools".
+///
+/// Usage: AgentTraceDecoder [-s] traceFile
+//==============================================================================
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "AgentTrace.h"
+
+namespace
+{
+bool ReadTrace(const char* pFileName, AgentTraceFileHeader& header, std::vector<AgentTraceRecord>& records)
+{
+    FILE* pFile = fopen(pFileName, "rb");
+
+    if (pFile == nullptr)
+    {
+        fprintf(stderr, "Could not open %s\n", pFileName);
+        return false;
+    }
+
+    bool isValid = fread(&header, sizeof(header), 1, pFile) == 1 &&
+                   memcmp(header.m_magic, gs_AgentTraceMagic, sizeof(header.m_magic)) == 0;
+
+    if (!isValid)
+    {
+        fprintf(stderr, "%s is not an agent trace\n", pFileName);
+    }
+    else if (header.m_version != AGENT_TRACE_VERSION || header.m_recordSize != sizeof(AgentTraceRecord))
+    {
+        fprintf(stderr, "%s has version %u and %u byte records, expected version %u and %zu byte records\n",
+                pFileName, header.m_version, header.m_recordSize, AGENT_TRACE_VERSION, sizeof(AgentTraceRecord));
+        isValid = false;
+    }
+    else
+    {
+        AgentTraceRecord record;
+
+        while (fread(&record, sizeof(record), 1, pFile) == 1)
+        {
+            records.push_back(record);
+        }
+
+        // A post-mortem dump may have been cut short
+        if ((static_cast<size_t>(ftell(pFile)) - sizeof(header)) % sizeof(record) != 0)
+        {
+            fprintf(stderr, "%s ends in a partial record, it is ignored\n", pFileName);
+        }
+    }
+
+    fclose(pFile);
+    return isValid;
+}
+
+bool IsAddressArg(const char* pArgName)
+{
+    return strcmp(pArgName, "pc") == 0 || strcmp(pArgName, "kernel_object") == 0;
+}
+
+void PrintRecords(const AgentTraceFileHeader& header, const std::vector<AgentTraceRecord>& records)
+{
+    printf("Agent trace of process %d, %zu events\n", header.m_pid, records.size());
+
+    uint64_t previousTimestamp = header.m_startTime;
+
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        const AgentTraceRecord& record = records[i];
+        const AgentTraceEventInfo& info = GetAgentTraceEventInfo(record.m_event);
+
+        // Events recorded before the header was written show up at 0
+        const uint64_t timestamp = std::max(record.m_timestamp, header.m_startTime);
+
+        printf("%14.3f us %+12.3f us  tid %-7u %-20s", (timestamp - header.m_startTime) / 1000.0,
+               (timestamp - previousTimestamp) / 1000.0, record.m_threadId, info.m_pName);
+
+        for (int arg = 0; arg < AGENT_TRACE_MAX_ARGS; ++arg)
+        {
+            const char* pArgName = info.m_pArgNames[arg];
+
+            if (pArgName == nullptr)
+            {
+                continue;
+            }
+
+            if (IsAddressArg(pArgName))
+            {
+                printf(" %s=0x%" PRIx64, pArgName, record.m_args[arg]);
+            }
+            else
+            {
+                printf(" %s=%" PRIu64, pArgName, record.m_args[arg]);
+            }
+        }
+
+        printf("\n");
+        previousTimestamp = timestamp;
+    }
+}
+
+void PrintSummary(const std::vector<AgentTraceRecord>& records)
+{
+    std::map<std::pair<uint32_t, uint32_t>, uint64_t> eventCounts;
+    uint64_t numDropped = 0;
+
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        ++eventCounts[std::make_pair(records[i].m_threadId, records[i].m_event)];
+
+        if (records[i].m_event == AGENT_TRACE_EVENT_DROPPED)
+        {
+            numDropped += records[i].m_args[0];
+        }
+    }
+
+    printf("%-8s %-20s %12s\n", "tid", "event", "count");
+
+    for (std::map<std::pair<uint32_t, uint32_t>, uint64_t>::const_iterator it = eventCounts.begin();
+         it != eventCounts.end(); ++it)
+    {
+        printf("%-8u %-20s %12" PRIu64 "\n", it->first.first, GetAgentTraceEventInfo(it->first.second).m_pName,
+               it->second);
+    }
+
+    printf("%" PRIu64 " events were dropped\n", numDropped);
+}
+
+bool CompareTimestamps(const AgentTraceRecord& op1, const AgentTraceRecord& op2)
+{
+    return op1.m_timestamp < op2.m_timestamp;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    bool isSummary = argc == 3 && strcmp(argv[1], "-s") == 0;
+
+    if (argc != 2 && !isSummary)
+    {
+        fprintf(stderr, "Usage: %s [-s] traceFile\n", argv[0]);
+        return 1;
+    }
+
+    AgentTraceFileHeader header;
+    std::vector<AgentTraceRecord> records;
+
+    if (!ReadTrace(argv[argc - 1], header, records))
+    {
+        return 1;
+    }
+
+    // The rings are drained one thread after the other, merge them back into
+    // one timeline. Events of one thread keep their order
+    std::stable_sort(records.begin(), records.end(), CompareTimestamps);
+
+    if (isSummary)
+    {
+        PrintSummary(records);
+    }
+    else
+    {
+        PrintRecords(header, records);
+    }
+
+    return 0;
+}
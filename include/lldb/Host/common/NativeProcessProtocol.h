@@ -24,6 +24,11 @@
 
 namespace lldb_private
 {
+    struct HsaBreakpointCondition;
+    struct HsaBreakpointStatsTable;
+    struct HsaReadRequest;
+    class HsaWavefrontTable;
+    struct HsaWavefrontUpdate;
     class MemoryRegionInfo;
     class ResumeActionList;
 
@@ -362,8 +367,100 @@ namespace lldb_private
                 MainLoop &mainloop,
                 NativeProcessProtocolSP &process_sp);
 
+        //------------------------------------------------------------------
+        /// Get the HSA code object currently loaded on the GPU.
+        ///
+        /// @param[out] data_sp
+        ///     The code object bytes. The buffer is shared, not copied.
+        ///
+        /// @param[out] hash
+        ///     A content hash of the code object.
+        //------------------------------------------------------------------
+        virtual Error
+        GetHSABinary(lldb::DataBufferSP& data_sp, uint64_t& hash) {
+            return Error ("not implemented");
+        }
+
+        //------------------------------------------------------------------
+        /// Get the table of HSA wavefronts active at the last stop. Only
+        /// some of them have thread objects, the rest are only rows here.
+        //------------------------------------------------------------------
+        virtual Error
+        GetHSAWavefronts(std::shared_ptr<const HsaWavefrontTable>& table_sp) {
+            return Error ("not implemented");
+        }
+
+        //------------------------------------------------------------------
+        /// Get the HSA wavefront table of the last stop together with the
+        /// waves that were added, moved or retired since the stop before.
+        //------------------------------------------------------------------
+        virtual Error
+        GetHSAWavefrontUpdate(std::shared_ptr<const HsaWavefrontUpdate>& update_sp) {
+            return Error ("not implemented");
+        }
+
+        //------------------------------------------------------------------
+        /// Make the thread of an HSA wavefront of the last stop if it has
+        /// none yet. Waves get their thread when the client first names
+        /// them, GetThreadByID() only finds threads that already exist.
+        //------------------------------------------------------------------
         virtual Error
-        GetHSABinaryFileName(std::string& name) {
+        MaterializeHSAWavefront(lldb::tid_t tid) {
+            return Error ("not implemented");
+        }
+
+        //------------------------------------------------------------------
+        /// Have the HSA agent serve variable and memory reads for the
+        /// waves of the last stop. The work-group of each request is
+        /// taken from the wave its tid names.
+        //------------------------------------------------------------------
+        virtual Error
+        ReadHSA(std::vector<HsaReadRequest>& requests) {
+            return Error ("not implemented");
+        }
+
+        //------------------------------------------------------------------
+        /// Have the HSA agent evaluate a condition for the waves that trap
+        /// at an HSA breakpoint, an empty program removes the condition.
+        //------------------------------------------------------------------
+        virtual Error
+        SetHSABreakpointCondition(const HsaBreakpointCondition& condition) {
+            return Error ("not implemented");
+        }
+
+        //------------------------------------------------------------------
+        /// Set an HSA breakpoint to stop (HSAIL_BREAKPOINT_MODE_STOP) or
+        /// to only be counted by the agent (HSAIL_BREAKPOINT_MODE_TRACE).
+        //------------------------------------------------------------------
+        virtual Error
+        SetHSABreakpointMode(lldb::addr_t addr, uint32_t mode) {
+            return Error ("not implemented");
+        }
+
+        //------------------------------------------------------------------
+        /// Get the hits the HSA agent counted for each breakpoint, with
+        /// at most \a max_work_groups work-groups per breakpoint.
+        //------------------------------------------------------------------
+        virtual Error
+        GetHSABreakpointStats(HsaBreakpointStatsTable& table, size_t max_work_groups) {
+            return Error ("not implemented");
+        }
+
+        //------------------------------------------------------------------
+        /// Tell the HSA agent which kernels have breakpoints. Dispatches
+        /// of other kernels that no breakpoint can stop are not debugged.
+        //------------------------------------------------------------------
+        virtual Error
+        SetHSADispatchFilter(bool all_kernels, const std::vector<std::string>& kernel_names) {
+            return Error ("not implemented");
+        }
+
+        //------------------------------------------------------------------
+        /// Replace the HSA step breakpoints, the agent keeps them across
+        /// stops until they are replaced.
+        //------------------------------------------------------------------
+        virtual Error
+        SetHSAStepBreakpoints(const std::vector<lldb::addr_t>& addrs) {
             return Error ("not implemented");
         }
 
@@ -420,7 +517,7 @@ namespace lldb_private
         void
         NotifyDidExec ();
 
-        NativeThreadProtocolSP
+        virtual NativeThreadProtocolSP
         GetThreadByIDUnlocked (lldb::tid_t tid);
 
     private:
@@ -147,6 +147,11 @@ public:
     {
     }
 
+    virtual void
+    ModulesDidUnload (const ModuleList &module_list)
+    {
+    }
+
 protected:
     //------------------------------------------------------------------
     // Classes that inherit from LanguageRuntime can see and modify these
@@ -52,6 +52,10 @@ namespace lldb_private {
 template <typename B, typename S>
 struct Range;
 
+struct HsaBreakpointCondition;
+struct HsaBreakpointStatsTable;
+struct HsaReadRequest;
+
 //----------------------------------------------------------------------
 // ProcessProperties
 //----------------------------------------------------------------------
@@ -1918,6 +1922,12 @@ public:
     virtual void
     ModulesDidLoad (ModuleList &module_list);
 
+    //------------------------------------------------------------------
+    // Notify this process class that modules got unloaded.
+    //------------------------------------------------------------------
+    virtual void
+    ModulesDidUnload (ModuleList &module_list);
+
     //------------------------------------------------------------------
     /// Retrieve the list of shared libraries that are loaded for this process
     /// 
@@ -1948,6 +1958,132 @@ public:
         return StructuredData::ObjectSP();
     }
 
+    //------------------------------------------------------------------
+    /// Describe a page of the HSA wavefronts active at the current stop.
+    ///
+    /// Only some wavefronts are presented as threads, this gives access
+    /// to all of them without creating a thread for each.
+    ///
+    /// @param [in] start
+    ///     Index of the first wavefront to describe.
+    ///
+    /// @param [in] count
+    ///     The maximum number of wavefronts to describe.
+    ///
+    /// @return
+    ///     A dictionary with the total number of wavefronts in "total" and
+    ///     an array of wavefront dictionaries in "wavefronts", or an empty
+    ///     object if the process has no HSA wavefronts.
+    //------------------------------------------------------------------
+    virtual lldb_private::StructuredData::ObjectSP
+    GetHSAWavefrontsInfo (uint64_t start, uint64_t count)
+    {
+        return StructuredData::ObjectSP();
+    }
+
+    //------------------------------------------------------------------
+    /// Read HSA variables and memory on behalf of GPU work-items.
+    ///
+    /// All requests are served in one round trip, whichever waves and
+    /// work-items they are for, so a variable can be read across a
+    /// whole work-group at once.
+    ///
+    /// @param [in,out] requests
+    ///     The reads to do. The status and bytes of each are filled in.
+    ///
+    /// @return
+    ///     An error if the reads could not be done at all, individual
+    ///     requests can still fail when this succeeds.
+    //------------------------------------------------------------------
+    virtual Error
+    ReadHSA (std::vector<HsaReadRequest> &requests)
+    {
+        return Error ("HSA reads are not supported by this process");
+    }
+
+    //------------------------------------------------------------------
+    /// Have the HSA agent evaluate a condition for every wave that
+    /// traps at an HSA breakpoint. Waves the condition does not hold
+    /// for are resumed by the agent and never reported.
+    ///
+    /// @param [in] condition
+    ///     The breakpoint's load address and the compiled condition, an
+    ///     empty program removes the breakpoint's condition.
+    //------------------------------------------------------------------
+    virtual Error
+    SetHSABreakpointCondition (const HsaBreakpointCondition &condition)
+    {
+        return Error ("HSA breakpoint conditions are not supported by this process");
+    }
+
+    //------------------------------------------------------------------
+    /// Make an HSA breakpoint a trace breakpoint, whose hits the agent
+    /// counts without stopping, or make it stop again.
+    ///
+    /// @param [in] addr
+    ///     The breakpoint's load address.
+    ///
+    /// @param [in] mode
+    ///     HSAIL_BREAKPOINT_MODE_STOP or HSAIL_BREAKPOINT_MODE_TRACE.
+    //------------------------------------------------------------------
+    virtual Error
+    SetHSABreakpointMode (lldb::addr_t addr, uint32_t mode)
+    {
+        return Error ("HSA trace breakpoints are not supported by this process");
+    }
+
+    //------------------------------------------------------------------
+    /// Get the hits the HSA agent counted for each breakpoint, by
+    /// work-group and lane. The counts are kept up to date by the agent
+    /// whether or not the dispatch stops.
+    ///
+    /// @param [out] table
+    ///     The counts of every HSA breakpoint.
+    ///
+    /// @param [in] max_work_groups
+    ///     How many work-groups to get per breakpoint, those that hit
+    ///     it most come first.
+    //------------------------------------------------------------------
+    virtual Error
+    GetHSABreakpointStats (HsaBreakpointStatsTable &table, size_t max_work_groups)
+    {
+        return Error ("HSA breakpoint statistics are not supported by this process");
+    }
+
+    //------------------------------------------------------------------
+    /// Tell the HSA agent which kernels have breakpoints. The agent
+    /// lets dispatches of other kernels run without debugging them, as
+    /// long as no breakpoint can stop them, and publishes their code
+    /// objects once a dispatch of theirs is debugged.
+    ///
+    /// @param [in] all_kernels
+    ///     Debug every dispatch, as the agent does until it is told
+    ///     otherwise.
+    ///
+    /// @param [in] kernel_names
+    ///     The kernels whose dispatches are debugged.
+    //------------------------------------------------------------------
+    virtual Error
+    SetHSADispatchFilter (bool all_kernels, const std::vector<std::string> &kernel_names)
+    {
+        return Error ("HSA dispatch filters are not supported by this process");
+    }
+
+    //------------------------------------------------------------------
+    /// Replace the HSA step breakpoints, the momentary breakpoints that
+    /// end a source step through the current line. The agent keeps them
+    /// across stops until they are replaced, so they only have to be
+    /// sent again when the line changes.
+    ///
+    /// @param [in] addrs
+    ///     The step breakpoint addresses, empty to clear them.
+    //------------------------------------------------------------------
+    virtual Error
+    SetHSAStepBreakpoints (const std::vector<lldb::addr_t> &addrs)
+    {
+        return Error ("HSA step breakpoints are not supported by this process");
+    }
+
     //------------------------------------------------------------------
     /// Print a user-visible warning about a module being built with optimization
     ///
@@ -0,0 +1,139 @@
+"""
+Benchmark the HSA stop path against a mock agent, as the number of waves grows.
+
+The inferior plays the HSA debug agent's side of the FIFO and shared memory
+protocol (see mock_agent.h), so this runs without a GPU. The mock stops the
+waves at breakpoints of its own, which needs no debug info. Steps go by the
+line table though, they are only timed when the environment names a recorded
+code object with debug info, whose kernel then gets a breakpoint too:
+
+    LLDB_HSA_MOCK_CODE_OBJECT=/path/to/recorded/binary     (optional)
+    LLDB_HSA_MOCK_KERNEL=&__OpenCL_vector_copy_kernel   (optional)
+"""
+
+from __future__ import print_function
+
+import os
+import lldb
+from lldbsuite.test.lldbbench import *
+
+class HSAStopLatencyBench(BenchBase):
+
+    mydir = TestBase.compute_mydir(__file__)
+
+    def setUp(self):
+        BenchBase.setUp(self)
+        self.code_object = os.environ.get('LLDB_HSA_MOCK_CODE_OBJECT')
+        self.kernel = os.environ.get('LLDB_HSA_MOCK_KERNEL', '&__OpenCL_mock_kernel')
+        self.wave_counts = [64, 256, 1024, 4096, 16384]
+        self.num_breakpoints = 4
+        self.count = 10
+
+    @benchmarks_test
+    @skipUnlessPlatform(['linux'])
+    def test_hsa_stop_latency(self):
+        """Time HSA stops, steps and thread lists against the mock agent."""
+        self.build()
+
+        results = []
+        for num_waves in self.wave_counts:
+            results.append(self.run_dispatch(num_waves, self.count))
+
+        print()
+        print("%8s %10s %10s %12s %16s %16s" % ("waves", "stop ms", "step ms", "threads ms",
+                                                "server B/wave", "client B/wave"))
+        for (num_waves, stop_sw, step_sw, threads_sw, server_bytes, client_bytes) in results:
+            print("%8d %10.3f %10.3f %12.3f %16.1f %16.1f" % (num_waves,
+                  self.avg_ms(stop_sw), self.avg_ms(step_sw), self.avg_ms(threads_sw),
+                  float(server_bytes) / num_waves, float(client_bytes) / num_waves))
+
+    def run_dispatch(self, num_waves, count):
+        exe = os.path.join(os.getcwd(), "a.out")
+        target = self.dbg.CreateTarget(exe)
+        self.assertTrue(target, VALID_TARGET)
+
+        # With a code object every iteration stops once at a breakpoint and
+        # once for the step
+        args = ["--waves", str(num_waves), "--breakpoints", str(self.num_breakpoints),
+                "--kernel", self.kernel]
+        if self.code_object:
+            self.runCmd("language hsa breakpoint set -k %s" % self.kernel)
+            args += ["--stops", str(2 * count), "--code-object", self.code_object]
+        else:
+            args += ["--stops", str(count)]
+        process = target.LaunchSimple(args, None, self.get_process_working_directory())
+        self.assertTrue(process, PROCESS_IS_VALID)
+
+        # The first stop is for the new binary, no wave exists yet
+        self.assertEqual(process.GetState(), lldb.eStateStopped)
+        server_base = self.server_rss()
+        client_base = self.client_rss()
+        server_peak = server_base
+        client_peak = client_base
+
+        stop_sw = Stopwatch()
+        step_sw = Stopwatch()
+        threads_sw = Stopwatch()
+        for i in range(count):
+            with stop_sw:
+                process.Continue()
+            if process.GetState() != lldb.eStateStopped:
+                break
+
+            with threads_sw:
+                for thread in process:
+                    thread.GetFrameAtIndex(0).GetPC()
+            self.assertTrue(process.GetNumThreads() >= num_waves,
+                            "%d waves reported, %d threads" % (num_waves, process.GetNumThreads()))
+
+            server_peak = max(server_peak, self.server_rss())
+            client_peak = max(client_peak, self.client_rss())
+
+            if not self.code_object:
+                continue
+            with step_sw:
+                process.GetSelectedThread().StepOver()
+            if process.GetState() != lldb.eStateStopped:
+                break
+
+        while process.GetState() == lldb.eStateStopped:
+            process.Continue()
+        if self.TraceOn():
+            print(process.GetSTDOUT(1024 * 1024))
+        self.dbg.DeleteTarget(target)
+
+        return (num_waves, stop_sw, step_sw, threads_sw,
+                max(server_peak - server_base, 0), max(client_peak - client_base, 0))
+
+    @staticmethod
+    def avg_ms(stopwatch):
+        return stopwatch.avg() * 1000 if stopwatch.laps() else 0.0
+
+    @staticmethod
+    def rss_of(pid):
+        """The resident set size of a process in bytes, 0 if it is gone."""
+        try:
+            with open("/proc/%s/status" % pid) as status:
+                for line in status:
+                    if line.startswith("VmRSS:"):
+                        return int(line.split()[1]) * 1024
+        except IOError:
+            pass
+        return 0
+
+    def client_rss(self):
+        return self.rss_of("self")
+
+    def server_rss(self):
+        """The RSS of the lldb-server lldb started for the inferior."""
+        for pid in os.listdir("/proc"):
+            if not pid.isdigit():
+                continue
+            try:
+                with open("/proc/%s/stat" % pid) as stat:
+                    fields = stat.read().rsplit(")", 1)
+            except IOError:
+                continue
+            if "lldb-server" in fields[0] and int(fields[1].split()[1]) == os.getpid():
+                return self.rss_of(pid)
+        return 0
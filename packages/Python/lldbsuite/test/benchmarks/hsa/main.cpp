@@ -0,0 +1,68 @@
+//===-- main.cpp ------------------------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+// An inferior that plays an HSA dispatch through the mock agent, so the
+// debugger's HSA stop path can be timed on a machine without a GPU.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "mock_agent.h"
+
+static void
+usage(const char *progname)
+{
+    fprintf(stderr, "usage: %s [--waves N] [--stops N] [--breakpoints N] [--lanes N] [--kernel NAME] [--code-object PATH]\n",
+            progname);
+}
+
+int
+main(int argc, char const *argv[])
+{
+    MockDispatchConfig config;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+
+        if (strcmp(argv[i], "--waves") == 0)
+            config.num_waves = strtoul(value, nullptr, 0);
+        else if (strcmp(argv[i], "--stops") == 0)
+            config.num_stops = strtoul(value, nullptr, 0);
+        else if (strcmp(argv[i], "--breakpoints") == 0)
+            config.num_breakpoints = strtoul(value, nullptr, 0);
+        else if (strcmp(argv[i], "--lanes") == 0)
+            config.lanes_per_wave = strtoul(value, nullptr, 0);
+        else if (strcmp(argv[i], "--kernel") == 0)
+            config.kernel_name = value;
+        else if (strcmp(argv[i], "--code-object") == 0)
+            config.code_object_path = value;
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        ++i;
+    }
+
+    MockHsaAgent agent(config);
+    if (!agent.Initialize())
+        return 1;
+
+    bool completed = agent.RunDispatch();
+    agent.PrintReport(stdout);
+    fflush(stdout);
+    return completed ? 0 : 1;
+}
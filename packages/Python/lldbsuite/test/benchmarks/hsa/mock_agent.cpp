@@ -0,0 +1,617 @@
+//===-- mock_agent.cpp ------------------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mock_agent.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "CommunicationParams.h"
+
+namespace
+{
+
+// How long the agent serves commands after NEW_BINARY before it begins
+// debugging, the debugger stops the process in between
+const int g_BINARY_STOP_WINDOW_MS = 100;
+
+// How long to wait for the debugger to set a breakpoint after debugging
+// began, the dispatch completes if it sets none
+const int g_BREAKPOINT_WAIT_MS = 2000;
+
+// How long to wait for the debugger to open its end of the FIFO
+const int g_FIFO_OPEN_WAIT_MS = 5000;
+
+// The start of the mock's code, where a wave is when no breakpoint applies
+const uint64_t g_KERNEL_ENTRY_PC = 0;
+
+// How far apart the breakpoints the mock arms itself are
+const uint64_t g_MOCK_BREAKPOINT_SPACING = 0x10;
+
+uint64_t
+GetMicroseconds()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t
+GetExecMask(uint32_t num_lanes)
+{
+    if (num_lanes >= HSAIL_WAVEFRONT_SIZE)
+        return ~static_cast<uint64_t>(0);
+    return (static_cast<uint64_t>(1) << num_lanes) - 1;
+}
+
+} // anonymous namespace
+
+MockHsaAgent::MockHsaAgent(const MockDispatchConfig &config) :
+    m_config(config)
+{
+    m_config.num_waves = std::max<uint32_t>(m_config.num_waves, 1);
+    m_config.lanes_per_wave = std::min<uint32_t>(std::max<uint32_t>(m_config.lanes_per_wave, 1),
+                                                 HSAIL_WAVEFRONT_SIZE);
+}
+
+MockHsaAgent::~MockHsaAgent()
+{
+    if (m_read_fd >= 0)
+        close(m_read_fd);
+    if (m_write_fd >= 0)
+        close(m_write_fd);
+
+    DestroySegment(m_binary_mem);
+    DestroySegment(m_wave_mem);
+    DestroySegment(m_momentary_bp_mem);
+    DestroySegment(m_breakpoint_batch_mem);
+    DestroySegment(m_read_batch_mem);
+    DestroySegment(m_breakpoint_stats_mem);
+
+    // The FIFOs are left to the debugger, it created their directory
+}
+
+bool
+MockHsaAgent::CreateSegment(Segment &segment, int shm_key, std::size_t size)
+{
+    segment.key = GetDebugSessionShmKey(shm_key, m_session_id);
+    segment.size = size;
+
+    // A segment left over by an earlier run may be too small
+    int stale_shmid = shmget(segment.key, 0, 0666);
+    if (stale_shmid >= 0)
+        shmctl(stale_shmid, IPC_RMID, nullptr);
+
+    segment.shmid = shmget(segment.key, size, IPC_CREAT | 0666);
+    if (segment.shmid < 0)
+    {
+        fprintf(stderr, "mock-agent: shmget of key 0x%x failed: %s\n", segment.key, strerror(errno));
+        return false;
+    }
+
+    segment.addr = shmat(segment.shmid, nullptr, 0);
+    if (segment.addr == reinterpret_cast<void *>(-1))
+    {
+        fprintf(stderr, "mock-agent: shmat of key 0x%x failed: %s\n", segment.key, strerror(errno));
+        segment.addr = nullptr;
+        return false;
+    }
+
+    memset(segment.addr, 0, size);
+    return true;
+}
+
+void
+MockHsaAgent::DestroySegment(Segment &segment)
+{
+    if (segment.addr)
+        shmdt(segment.addr);
+    if (segment.shmid >= 0)
+        shmctl(segment.shmid, IPC_RMID, nullptr);
+    segment = Segment();
+}
+
+bool
+MockHsaAgent::Initialize()
+{
+    m_session_id = GetDebugSessionIdFromEnv();
+    m_read_fifo_name = GetDebugSessionFifoName(gs_GdbToAgentFifoName, GetDebugSessionFifoDirFromEnv());
+    m_write_fifo_name = GetDebugSessionFifoName(gs_AgentToGdbFifoName, GetDebugSessionFifoDirFromEnv());
+
+    if (!m_config.code_object_path.empty())
+    {
+        std::ifstream code_object(m_config.code_object_path.c_str(), std::ios::binary);
+        if (!code_object)
+        {
+            fprintf(stderr, "mock-agent: cannot read code object %s\n", m_config.code_object_path.c_str());
+            return false;
+        }
+        m_code_object.assign(std::istreambuf_iterator<char>(code_object), std::istreambuf_iterator<char>());
+    }
+
+    // Size the wave buffer for the whole dispatch up front, the debugger
+    // then never has to follow it growing
+    const std::size_t wave_buffer_size = std::max(g_WAVE_BUFFER_INITIALSIZE,
+        sizeof(HsailWaveBufferHeader) + m_config.num_waves * GetHsailWaveRecordSize(1));
+    const std::size_t binary_size = std::max(g_BINARY_BUFFER_INITIALSIZE,
+        sizeof(std::size_t) + m_code_object.size());
+
+    if (!CreateSegment(m_binary_mem, g_DBEBINARY_SHMKEY, binary_size) ||
+        !CreateSegment(m_wave_mem, g_WAVE_BUFFER_SHMKEY, wave_buffer_size) ||
+        !CreateSegment(m_momentary_bp_mem, g_MOMENTARY_BP_BUFFER_SHMKEY, g_MOMENTARY_BP_BUFFER_MAXSIZE) ||
+        !CreateSegment(m_breakpoint_batch_mem, g_BREAKPOINT_BATCH_SHMKEY, g_BREAKPOINT_BATCH_MAXSIZE) ||
+        !CreateSegment(m_read_batch_mem, g_READ_BATCH_SHMKEY, g_READ_BATCH_MAXSIZE) ||
+        !CreateSegment(m_breakpoint_stats_mem, g_BREAKPOINT_STATS_SHMKEY, g_BREAKPOINT_STATS_MAXSIZE))
+        return false;
+
+    HsailWaveBufferHeader *header = static_cast<HsailWaveBufferHeader *>(m_wave_mem.addr);
+    header->m_version = HSAIL_WAVE_BUFFER_VERSION;
+    header->m_headerSize = sizeof(HsailWaveBufferHeader);
+    header->m_bytesUsed = sizeof(HsailWaveBufferHeader);
+    header->m_capacity = m_wave_mem.size;
+
+    if (!CreateDebugSessionFifo(m_read_fifo_name) || !CreateDebugSessionFifo(m_write_fifo_name))
+    {
+        fprintf(stderr, "mock-agent: cannot create the session FIFOs: %s\n", strerror(errno));
+        return false;
+    }
+
+    m_read_fd = open(m_read_fifo_name.c_str(), O_RDONLY | O_NONBLOCK | O_NOFOLLOW);
+    if (m_read_fd < 0)
+    {
+        fprintf(stderr, "mock-agent: cannot open %s: %s\n", m_read_fifo_name.c_str(), strerror(errno));
+        return false;
+    }
+
+    // The debugger opened its read end when it launched us, a non blocking
+    // open fails until it has
+    for (int waited_ms = 0; m_write_fd < 0; waited_ms += 10)
+    {
+        m_write_fd = open(m_write_fifo_name.c_str(), O_WRONLY | O_NONBLOCK | O_NOFOLLOW);
+        if (m_write_fd >= 0)
+            break;
+        if (errno != ENXIO || waited_ms >= g_FIFO_OPEN_WAIT_MS)
+        {
+            fprintf(stderr, "mock-agent: no debugger is reading %s\n", m_write_fifo_name.c_str());
+            return false;
+        }
+        usleep(10 * 1000);
+    }
+
+    // Notifications are small and the debugger drains them at once, block
+    // rather than drop one
+    fcntl(m_write_fd, F_SETFL, fcntl(m_write_fd, F_GETFL) & ~O_NONBLOCK);
+
+    // Stops are raised with SIGTRAP like the agent does. Ignoring it keeps
+    // us alive when nobody traces us, a tracer still sees the signal
+    signal(SIGTRAP, SIG_IGN);
+    return true;
+}
+
+bool
+MockHsaAgent::Notify(const HsailNotificationPayload &payload)
+{
+    const char *data = reinterpret_cast<const char *>(&payload);
+    std::size_t written = 0;
+
+    while (written < sizeof(payload))
+    {
+        ssize_t n = write(m_write_fd, data + written, sizeof(payload) - written);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            m_disconnected = true;
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+bool
+MockHsaAgent::PublishBinary()
+{
+    uint8_t *binary = static_cast<uint8_t *>(m_binary_mem.addr);
+    const std::size_t size = m_code_object.size();
+    memcpy(binary, &size, sizeof(size));
+    if (size)
+        memcpy(binary + sizeof(size), m_code_object.data(), size);
+
+    // One wave per work-group, the debugger numbers waves by work-group
+    HsailNotificationPayload payload;
+    memset(&payload, 0, sizeof(payload));
+    payload.m_Notification = HSAIL_NOTIFY_NEW_BINARY;
+    strncpy(payload.payload.BinaryNotification.m_KernelName, m_config.kernel_name.c_str(),
+            AGENT_MAX_FUNC_NAME_LEN - 1);
+    payload.payload.BinaryNotification.m_binarySize = size;
+    payload.payload.BinaryNotification.m_workGroupSize.x = HSAIL_WAVEFRONT_SIZE;
+    payload.payload.BinaryNotification.m_workGroupSize.y = 1;
+    payload.payload.BinaryNotification.m_workGroupSize.z = 1;
+    payload.payload.BinaryNotification.m_gridSize.x = HSAIL_WAVEFRONT_SIZE * m_config.num_waves;
+    payload.payload.BinaryNotification.m_gridSize.y = 1;
+    payload.payload.BinaryNotification.m_gridSize.z = 1;
+    return Notify(payload);
+}
+
+void
+MockHsaAgent::PublishWaves(const std::vector<uint64_t> &pcs, uint32_t stop_idx)
+{
+    uint8_t *buffer = static_cast<uint8_t *>(m_wave_mem.addr);
+    HsailWaveBufferHeader *header = reinterpret_cast<HsailWaveBufferHeader *>(buffer);
+    const uint32_t record_size = GetHsailWaveRecordSize(1);
+    const uint64_t exec_mask = GetExecMask(m_config.lanes_per_wave);
+
+    std::size_t offset = header->m_headerSize;
+    for (uint32_t i = 0; i < m_config.num_waves; ++i, offset += record_size)
+    {
+        HsailWaveRecord *record = reinterpret_cast<HsailWaveRecord *>(buffer + offset);
+        record->m_recordSize = record_size;
+        record->m_flags = HSAIL_WAVE_RECORD_FLAGS_DERIVED_WORKITEMS;
+        record->workGroupId.x = i;
+        record->workGroupId.y = 0;
+        record->workGroupId.z = 0;
+        record->m_numWorkItemIds = 1;
+        record->execMask = exec_mask;
+        record->pc = pcs.empty() ? g_KERNEL_ENTRY_PC : pcs[(i + stop_idx) % pcs.size()];
+        record->waveAddress = i;
+        record->m_reserved = 0;
+
+        HsailWaveDim3 *work_item = reinterpret_cast<HsailWaveDim3 *>(record + 1);
+        work_item->x = 0;
+        work_item->y = 0;
+        work_item->z = 0;
+    }
+
+    header->m_numWaves = m_config.num_waves;
+    header->m_bytesUsed = offset;
+}
+
+void
+MockHsaAgent::ApplyBreakpointBatch()
+{
+    uint8_t *batch = static_cast<uint8_t *>(m_breakpoint_batch_mem.addr);
+    HsailBreakpointBatchHeader *header = reinterpret_cast<HsailBreakpointBatchHeader *>(batch);
+    const uint32_t sequence = __atomic_load_n(&header->m_sequence, __ATOMIC_ACQUIRE);
+
+    const std::size_t max_ops = (m_breakpoint_batch_mem.size - sizeof(*header)) / sizeof(HsailBreakpointOp);
+    const uint32_t num_ops = std::min<std::size_t>(header->m_numOps, max_ops);
+    HsailBreakpointOp *ops = reinterpret_cast<HsailBreakpointOp *>(header + 1);
+
+    for (uint32_t i = 0; i < num_ops; ++i)
+    {
+        const uint64_t pc = ops[i].m_pc;
+        ops[i].m_status = HSAIL_BREAKPOINT_OP_STATUS_SUCCESS;
+        switch (ops[i].m_op)
+        {
+        case HSAIL_BREAKPOINT_OP_CREATE:
+            if (ops[i].m_mode == HSAIL_BREAKPOINT_MODE_STOP)
+                m_breakpoints.insert(pc);
+            break;
+        case HSAIL_BREAKPOINT_OP_DELETE:
+            m_breakpoints.erase(pc);
+            m_disabled_breakpoints.erase(pc);
+            break;
+        case HSAIL_BREAKPOINT_OP_ENABLE:
+            if (m_disabled_breakpoints.erase(pc))
+                m_breakpoints.insert(pc);
+            break;
+        case HSAIL_BREAKPOINT_OP_DISABLE:
+            if (m_breakpoints.erase(pc))
+                m_disabled_breakpoints.insert(pc);
+            break;
+        case HSAIL_BREAKPOINT_OP_MODE:
+            // Trace breakpoints never stop, the mock keeps no statistics
+            if (ops[i].m_mode == HSAIL_BREAKPOINT_MODE_TRACE)
+                m_breakpoints.erase(pc);
+            else if (!m_disabled_breakpoints.count(pc))
+                m_breakpoints.insert(pc);
+            break;
+        case HSAIL_BREAKPOINT_OP_STEP_CLEAR:
+            m_step_breakpoints.clear();
+            break;
+        case HSAIL_BREAKPOINT_OP_STEP:
+            m_step_breakpoints.insert(pc);
+            break;
+        default:
+            // Conditions hold for every wave of the mock
+            break;
+        }
+    }
+
+    __atomic_store_n(&header->m_consumed, sequence, __ATOMIC_RELEASE);
+}
+
+void
+MockHsaAgent::ServeReadBatch()
+{
+    uint8_t *batch = static_cast<uint8_t *>(m_read_batch_mem.addr);
+    HsailReadBatchHeader *header = reinterpret_cast<HsailReadBatchHeader *>(batch);
+    const uint32_t sequence = __atomic_load_n(&header->m_sequence, __ATOMIC_ACQUIRE);
+
+    const std::size_t max_requests = (m_read_batch_mem.size - sizeof(*header)) / sizeof(HsailReadRequest);
+    const uint32_t num_requests = std::min<std::size_t>(header->m_numRequests, max_requests);
+    HsailReadRequest *requests = reinterpret_cast<HsailReadRequest *>(header + 1);
+
+    for (uint32_t i = 0; i < num_requests; ++i)
+    {
+        HsailReadRequest &request = requests[i];
+        request.m_resultSize = 0;
+
+        // Only private memory has something behind it, variables would need
+        // the debug info of a real code object
+        if (request.m_kind != HSAIL_READ_KIND_MEMORY || request.m_memoryRegion != 1 /* IMR_Scratch */)
+        {
+            request.m_status = HSAIL_READ_STATUS_UNSUPPORTED;
+            continue;
+        }
+
+        if (request.m_resultOffset > m_read_batch_mem.size ||
+            request.m_size > m_read_batch_mem.size - request.m_resultOffset)
+        {
+            request.m_status = HSAIL_READ_STATUS_FAILURE;
+            continue;
+        }
+
+        uint8_t *result = batch + request.m_resultOffset;
+        for (uint64_t j = 0; j < request.m_size; ++j)
+            result[j] = GetMockScratchByte(request.m_workGroup.x, request.m_workItem.x, request.m_address + j);
+        request.m_resultSize = request.m_size;
+        request.m_status = HSAIL_READ_STATUS_SUCCESS;
+    }
+
+    __atomic_store_n(&header->m_consumed, sequence, __ATOMIC_RELEASE);
+}
+
+void
+MockHsaAgent::LoadMomentaryBreakpoints(int num_breakpoints)
+{
+    const std::size_t max_breakpoints = m_momentary_bp_mem.size / sizeof(HsailMomentaryBP);
+    const HsailMomentaryBP *breakpoints = static_cast<const HsailMomentaryBP *>(m_momentary_bp_mem.addr);
+
+    for (std::size_t i = 0; i < std::min<std::size_t>(std::max(num_breakpoints, 0), max_breakpoints); ++i)
+        m_momentary_breakpoints.insert(breakpoints[i].m_pc);
+}
+
+void
+MockHsaAgent::HandleCommand(const HsailCommandPacket &packet)
+{
+    switch (packet.m_command)
+    {
+    case HSAIL_COMMAND_CREATE_BREAKPOINT:
+    case HSAIL_COMMAND_ENABLE_BREAKPOINT:
+        m_breakpoints.insert(packet.m_pc);
+        m_disabled_breakpoints.erase(packet.m_pc);
+        break;
+    case HSAIL_COMMAND_DELETE_BREAKPOINT:
+        m_breakpoints.erase(packet.m_pc);
+        m_disabled_breakpoints.erase(packet.m_pc);
+        break;
+    case HSAIL_COMMAND_DISABLE_BREAKPOINT:
+        if (m_breakpoints.erase(packet.m_pc))
+            m_disabled_breakpoints.insert(packet.m_pc);
+        break;
+    case HSAIL_COMMAND_MOMENTARY_BREAKPOINT:
+        LoadMomentaryBreakpoints(packet.m_numMomentaryBP);
+        break;
+    case HSAIL_COMMAND_BREAKPOINT_BATCH:
+        ApplyBreakpointBatch();
+        break;
+    case HSAIL_COMMAND_READ_BATCH:
+        ServeReadBatch();
+        break;
+    case HSAIL_COMMAND_CONTINUE:
+        m_continued = true;
+        break;
+    case HSAIL_COMMAND_KILL_ALL_WAVES:
+        m_killed = true;
+        m_continued = true;
+        break;
+    default:
+        // Logging and the dispatch filter do not matter to a single dispatch
+        break;
+    }
+}
+
+bool
+MockHsaAgent::ServeCommands(int timeout_ms)
+{
+    m_continued = false;
+    HsailCommandPacket packet;
+    std::size_t packet_bytes = 0;
+
+    while (!m_continued)
+    {
+        struct pollfd fifo_poll;
+        fifo_poll.fd = m_read_fd;
+        fifo_poll.events = POLLIN;
+        fifo_poll.revents = 0;
+
+        int ready = poll(&fifo_poll, 1, timeout_ms);
+        if (ready < 0 && errno == EINTR)
+            continue;
+        if (ready <= 0)
+            return ready == 0;
+
+        if (!(fifo_poll.revents & POLLIN))
+        {
+            // The debugger closed its end of the FIFO
+            m_disconnected = true;
+            return false;
+        }
+
+        ssize_t n = read(m_read_fd, reinterpret_cast<char *>(&packet) + packet_bytes,
+                         sizeof(packet) - packet_bytes);
+        if (n < 0 && (errno == EINTR || errno == EAGAIN))
+            continue;
+        if (n <= 0)
+        {
+            m_disconnected = true;
+            return false;
+        }
+
+        packet_bytes += n;
+        if (packet_bytes == sizeof(packet))
+        {
+            HandleCommand(packet);
+            packet_bytes = 0;
+        }
+    }
+    return true;
+}
+
+bool
+MockHsaAgent::RunDispatch()
+{
+    if (!PublishBinary())
+        return false;
+
+    // The debugger stops us for the new binary, it may set breakpoints
+    // meanwhile but queues them until debugging begins
+    if (!ServeCommands(g_BINARY_STOP_WINDOW_MS))
+        return false;
+
+    HsailNotificationPayload payload;
+    memset(&payload, 0, sizeof(payload));
+    payload.m_Notification = HSAIL_NOTIFY_BEGIN_DEBUGGING;
+    payload.payload.BeginDebugNotification.setDeviceFocus = true;
+    if (!Notify(payload))
+        return false;
+
+    // The debugger stops the whole process but the debug thread, which
+    // serves its commands while the dispatch is stopped
+    pthread_t debug_thread;
+    void *completed = nullptr;
+    if (pthread_create(&debug_thread, nullptr, DebugThread, this) != 0)
+    {
+        fprintf(stderr, "mock-agent: cannot start the debug thread\n");
+        return false;
+    }
+    pthread_join(debug_thread, &completed);
+    return completed != nullptr;
+}
+
+void *
+MockHsaAgent::DebugThread(void *agent)
+{
+    return static_cast<MockHsaAgent *>(agent)->RunStops() ? agent : nullptr;
+}
+
+bool
+MockHsaAgent::RunStops()
+{
+    HsailNotificationPayload payload;
+    memset(&payload, 0, sizeof(payload));
+    payload.m_Notification = HSAIL_NOTIFY_START_DEBUG_THREAD;
+    payload.payload.StartDebugThreadNotification.m_tid = syscall(SYS_gettid);
+    if (!Notify(payload))
+        return false;
+
+    // The mock's own breakpoints do not wait for the debugger, it may not
+    // have debug info to set any
+    for (uint32_t i = 0; i < m_config.num_breakpoints; ++i)
+        m_breakpoints.insert(g_KERNEL_ENTRY_PC + (i + 1) * g_MOCK_BREAKPOINT_SPACING);
+
+    const uint64_t wait_start = GetMicroseconds();
+    while (m_breakpoints.empty() && !m_killed &&
+           GetMicroseconds() - wait_start < g_BREAKPOINT_WAIT_MS * 1000)
+    {
+        if (!ServeCommands(g_BREAKPOINT_WAIT_MS / 20))
+            return false;
+    }
+
+    for (uint32_t stop_idx = 0; stop_idx < m_config.num_stops && !m_killed; ++stop_idx)
+    {
+        // A step stops every wave at the step breakpoint it reaches first,
+        // otherwise the waves are spread over the breakpoints
+        std::vector<uint64_t> pcs;
+        MockStopRecord stop;
+        if (!m_step_breakpoints.empty() || !m_momentary_breakpoints.empty())
+        {
+            std::set<uint64_t> step_pcs(m_step_breakpoints);
+            step_pcs.insert(m_momentary_breakpoints.begin(), m_momentary_breakpoints.end());
+            pcs.push_back(*step_pcs.begin());
+            stop.is_step = true;
+        }
+        else if (!m_breakpoints.empty())
+            pcs.assign(m_breakpoints.begin(), m_breakpoints.end());
+        else
+            break;
+
+        m_momentary_breakpoints.clear();
+
+        uint64_t start = GetMicroseconds();
+        PublishWaves(pcs, stop_idx);
+        stop.publish_usec = GetMicroseconds() - start;
+        stop.num_waves = m_config.num_waves;
+
+        memset(&payload, 0, sizeof(payload));
+        payload.m_Notification = HSAIL_NOTIFY_BREAKPOINT_HIT;
+        payload.payload.BreakpointHit.m_numActiveWaves = m_config.num_waves;
+        if (!Notify(payload))
+            return false;
+
+        start = GetMicroseconds();
+        kill(getpid(), SIGTRAP);
+        bool connected = ServeCommands(-1);
+        stop.stopped_usec = GetMicroseconds() - start;
+        m_stops.push_back(stop);
+
+        if (!connected)
+            return false;
+    }
+
+    memset(&payload, 0, sizeof(payload));
+    payload.m_Notification = HSAIL_NOTIFY_END_DEBUGGING;
+    payload.payload.EndDebugNotification.hasDispatchCompleted = !m_killed;
+    return Notify(payload);
+}
+
+void
+MockHsaAgent::PrintReport(FILE *out) const
+{
+    uint64_t total_publish_usec = 0;
+    uint64_t total_stopped_usec = 0;
+    uint32_t num_steps = 0;
+
+    for (std::size_t i = 0; i < m_stops.size(); ++i)
+    {
+        const MockStopRecord &stop = m_stops[i];
+        fprintf(out, "mock-agent: stop %zu %s waves %u publish %llu us stopped %llu us\n", i,
+                stop.is_step ? "step" : "breakpoint", stop.num_waves,
+                static_cast<unsigned long long>(stop.publish_usec),
+                static_cast<unsigned long long>(stop.stopped_usec));
+        total_publish_usec += stop.publish_usec;
+        total_stopped_usec += stop.stopped_usec;
+        num_steps += stop.is_step;
+    }
+
+    fprintf(out, "mock-agent: summary waves %u stops %zu steps %u publish %llu us stopped %llu us%s\n",
+            m_config.num_waves, m_stops.size(), num_steps,
+            static_cast<unsigned long long>(total_publish_usec),
+            static_cast<unsigned long long>(total_stopped_usec),
+            m_disconnected ? " (debugger went away)" : "");
+}
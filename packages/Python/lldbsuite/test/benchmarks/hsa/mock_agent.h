@@ -0,0 +1,167 @@
+//===-- mock_agent.h --------------------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef lldb_benchmarks_hsa_mock_agent_h_
+#define lldb_benchmarks_hsa_mock_agent_h_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "CommunicationControl.h"
+
+//------------------------------------------------------------------
+/// A dispatch for the mock agent to pretend to run.
+//------------------------------------------------------------------
+struct MockDispatchConfig
+{
+    uint32_t num_waves = 64;        ///< Waves reported at every stop, one per work-group
+    uint32_t num_stops = 10;        ///< Stops before the dispatch completes
+    uint32_t num_breakpoints = 0;   ///< Breakpoints of the mock's own, stopped at without debug info
+    uint32_t lanes_per_wave = HSAIL_WAVEFRONT_SIZE; ///< Active lanes of every wave
+    std::string kernel_name = "&__OpenCL_mock_kernel";
+    std::string code_object_path;   ///< A recorded code object, published as the dispatch's binary
+};
+
+//------------------------------------------------------------------
+/// What the mock agent saw of one stop.
+//------------------------------------------------------------------
+struct MockStopRecord
+{
+    uint32_t num_waves = 0;
+    bool is_step = false;           ///< Stopped at a step or momentary breakpoint
+    uint64_t publish_usec = 0;      ///< Writing the wave buffer
+    uint64_t stopped_usec = 0;      ///< From raising SIGTRAP until the debugger continued
+};
+
+//------------------------------------------------------------------
+/// The byte the mock serves at \a address of the private memory of a
+/// work-item, so tests can check what a read returned.
+//------------------------------------------------------------------
+inline uint8_t
+GetMockScratchByte (uint32_t work_group_x, uint32_t work_item_x, uint64_t address)
+{
+    return static_cast<uint8_t>(address + work_group_x + work_item_x);
+}
+
+//------------------------------------------------------------------
+/// A stand-in for the HSA debug agent.
+///
+/// It speaks the agent's side of the FIFO and shared memory protocol
+/// in CommunicationControl.h, so lldb-server and lldb can be driven
+/// through HSA stops without a GPU, the HSA runtime or the debugger
+/// engine. Waves never run: every stop reports the configured number
+/// of waves at the breakpoints the debugger set, or at its step
+/// breakpoints while it is stepping. The mock can arm breakpoints of
+/// its own too, as if they were set before the dispatch, so stops can
+/// be had without a code object for the debugger to resolve any in.
+///
+/// Like the agent, the stops are raised and served by a debug thread
+/// of their own, announced with HSAIL_NOTIFY_START_DEBUG_THREAD. It
+/// serves private memory reads with GetMockScratchByte.
+//------------------------------------------------------------------
+class MockHsaAgent
+{
+public:
+    explicit MockHsaAgent (const MockDispatchConfig &config);
+
+    ~MockHsaAgent ();
+
+    /// Create the FIFOs and shared memory segments of the debug session
+    /// in the environment, like the agent does when it is loaded.
+    bool
+    Initialize ();
+
+    /// Publish the code object and stop until the dispatch completes,
+    /// the debugger kills the waves or it goes away.
+    bool
+    RunDispatch ();
+
+    void
+    PrintReport (FILE *out) const;
+
+private:
+    struct Segment
+    {
+        key_t key = 0;
+        int shmid = -1;
+        void *addr = nullptr;
+        std::size_t size = 0;
+    };
+
+    bool
+    CreateSegment (Segment &segment, int shm_key, std::size_t size);
+
+    void
+    DestroySegment (Segment &segment);
+
+    bool
+    Notify (const HsailNotificationPayload &payload);
+
+    bool
+    PublishBinary ();
+
+    static void *
+    DebugThread (void *agent);
+
+    // The stops of the dispatch, run on the debug thread
+    bool
+    RunStops ();
+
+    void
+    PublishWaves (const std::vector<uint64_t> &pcs, uint32_t stop_idx);
+
+    // Serve debugger commands. Returns once the debugger continues the
+    // dispatch, or once no command came for timeout_ms if that is not
+    // negative. False if the debugger went away.
+    bool
+    ServeCommands (int timeout_ms);
+
+    void
+    HandleCommand (const HsailCommandPacket &packet);
+
+    void
+    ApplyBreakpointBatch ();
+
+    void
+    ServeReadBatch ();
+
+    void
+    LoadMomentaryBreakpoints (int num_breakpoints);
+
+    MockDispatchConfig m_config;
+    int m_session_id = 0;
+    int m_read_fd = -1;
+    int m_write_fd = -1;
+    std::string m_read_fifo_name;
+    std::string m_write_fifo_name;
+
+    Segment m_binary_mem;
+    Segment m_wave_mem;
+    Segment m_momentary_bp_mem;
+    Segment m_breakpoint_batch_mem;
+    Segment m_read_batch_mem;
+    Segment m_breakpoint_stats_mem;
+
+    std::vector<uint8_t> m_code_object;
+    std::set<uint64_t> m_breakpoints;           // Enabled breakpoints that stop
+    std::set<uint64_t> m_disabled_breakpoints;
+    std::set<uint64_t> m_step_breakpoints;      // Kept until the debugger clears them
+    std::set<uint64_t> m_momentary_breakpoints; // Gone with the next stop
+    bool m_continued = false;
+    bool m_killed = false;
+    bool m_disconnected = false;
+
+    std::vector<MockStopRecord> m_stops;
+};
+
+#endif // lldb_benchmarks_hsa_mock_agent_h_
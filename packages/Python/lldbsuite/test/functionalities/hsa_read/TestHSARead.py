@@ -0,0 +1,66 @@
+"""
+Test that the HSA agent serves reads while the dispatch is stopped.
+
+lldb-server stops every thread of the process at an HSA stop but the
+agent's debug thread, which serves the reads. The inferior is the mock
+agent of the HSA benchmarks, which stops the waves at a breakpoint of its
+own. If the environment names a recorded code object, the kernel gets a
+breakpoint of the debugger too:
+
+    LLDB_HSA_MOCK_CODE_OBJECT=/path/to/recorded/binary   (optional)
+    LLDB_HSA_MOCK_KERNEL=&__OpenCL_vector_copy_kernel   (optional)
+"""
+
+from __future__ import print_function
+
+import os
+import re
+import lldb
+from lldbsuite.test.lldbtest import *
+
+class HSAReadTestCase(TestBase):
+
+    mydir = TestBase.compute_mydir(__file__)
+
+    def setUp(self):
+        TestBase.setUp(self)
+        self.code_object = os.environ.get('LLDB_HSA_MOCK_CODE_OBJECT')
+        self.kernel = os.environ.get('LLDB_HSA_MOCK_KERNEL', '&__OpenCL_mock_kernel')
+
+    @skipUnlessPlatform(['linux'])
+    def test_memory_read_at_hsa_stop(self):
+        """Read the private memory of a stopped wave through the agent."""
+        self.build()
+
+        exe = os.path.join(os.getcwd(), "a.out")
+        target = self.dbg.CreateTarget(exe)
+        self.assertTrue(target, VALID_TARGET)
+
+        args = ["--waves", "4", "--stops", "1", "--breakpoints", "1", "--kernel", self.kernel]
+        if self.code_object:
+            self.runCmd("language hsa breakpoint set -k %s" % self.kernel)
+            args += ["--code-object", self.code_object]
+        process = target.LaunchSimple(args, None, self.get_process_working_directory())
+        self.assertTrue(process, PROCESS_IS_VALID)
+
+        # The first stop is for the new binary, the second at the breakpoint
+        self.assertEqual(process.GetState(), lldb.eStateStopped)
+        process.Continue()
+        self.assertEqual(process.GetState(), lldb.eStateStopped)
+
+        # The focus wave is the first wave of the stop, in work-group 0.
+        # See GetMockScratchByte for what the mock serves.
+        address = 0x10
+        work_item_x = 2
+        self.expect("language hsa memory read -b 8 -x %d 0x%x" % (work_item_x, address),
+                    substrs=["Mem:"])
+        output = self.res.GetOutput()
+        read = [int(byte, 16) for byte in re.findall(r"\b[0-9a-f]{2}\b", output.split("Mem:")[1])]
+        expected = [(address + work_item_x + i) & 0xff for i in range(8)]
+        self.assertEqual(read, expected)
+
+        # Reading again must not wait for the previous batch
+        self.expect("language hsa memory read -b 4 0x%x" % address, substrs=["Mem:"])
+
+        process.Continue()
+        self.assertEqual(process.GetState(), lldb.eStateExited)
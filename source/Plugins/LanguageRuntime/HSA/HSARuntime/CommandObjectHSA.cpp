@@ -8,7 +8,10 @@
 //===----------------------------------------------------------------------===//
 
 #include "CommandObjectHSA.h"
+#include "HsaBreakpointCondition.h"
+#include "HsaBreakpointStats.h"
 #include "HsaDebugPacket.h"
+#include "HsaReadRequest.h"
 #include "HSARuntime.h"
 #include "HSABreakpointResolver.h"
 #include "CommunicationParams.h"
@@ -26,6 +29,9 @@
 #include "lldb/Interpreter/Options.h"
 #include "lldb/Interpreter/OptionValueString.h"
 #include "lldb/Interpreter/OptionValueUInt64.h"
+#include "lldb/Core/StructuredData.h"
+#include "lldb/Breakpoint/BreakpointLocation.h"
+#include "lldb/Target/Process.h"
 #include "lldb/Target/RegisterContext.h"
 #include "lldb/Target/Target.h"
 #include "lldb/Target/Thread.h"
@@ -34,6 +40,7 @@
 #include "lldb/Symbol/SymbolFile.h"
 #include "Plugins/SymbolFile/AMDHSA/SymbolFileAMDHSA.h"
 #include "Plugins/SymbolFile/AMDHSA/FacilitiesInterface.h"
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
@@ -53,19 +60,158 @@ bool CurrentlyUnimplemented(CommandReturnObject &result)
 }
 
 
-lldb::addr_t GetFunctionAddr(Target& target, ConstString func_name) {
-    SymbolContextList sc_list;
-    target.GetImages().FindFunctions(func_name, eFunctionNameTypeAuto, true, true, false, sc_list);
-                
-    if (sc_list.GetSize() > 0) {
-        auto func = sc_list[0].function;
-        if (func)  {
-            auto addr = func->GetAddressRange().GetBaseAddress();
-            return addr.GetLoadAddress(&target);
+// Print the bytes of a variable the way its debug info encoding says,
+// anything we do not know how to format is shown as raw bytes
+static void
+DumpHSAValue(Stream &s, HwDbgInfo_encoding encoding, const uint8_t *bytes, size_t size)
+{
+    uint64_t raw = 0;
+    if (size > 0 && size <= sizeof(raw))
+        memcpy(&raw, bytes, size);
+
+    const bool is_scalar = size == 1 || size == 2 || size == 4 || size == 8;
+    switch (encoding) {
+    case HWDBGINFO_VENC_BOOLEAN:
+        if (is_scalar) {
+            s << (raw ? "true" : "false");
+            return;
+        }
+        break;
+    case HWDBGINFO_VENC_FLOAT:
+        if (size == sizeof(float)) {
+            float value;
+            memcpy(&value, bytes, sizeof(value));
+            s.Printf("%g", value);
+            return;
+        }
+        if (size == sizeof(double)) {
+            double value;
+            memcpy(&value, bytes, sizeof(value));
+            s.Printf("%g", value);
+            return;
+        }
+        break;
+    case HWDBGINFO_VENC_INTEGER:
+    case HWDBGINFO_VENC_CHARACTER:
+        if (is_scalar) {
+            const unsigned shift = 64 - 8 * size;
+            s.Printf("%" PRId64, static_cast<int64_t>(raw << shift) >> shift);
+            return;
+        }
+        break;
+    case HWDBGINFO_VENC_UINTEGER:
+    case HWDBGINFO_VENC_UCHARACTER:
+        if (is_scalar) {
+            s.Printf("%" PRIu64, raw);
+            return;
+        }
+        break;
+    case HWDBGINFO_VENC_POINTER:
+        if (is_scalar) {
+            s.Printf("0x%" PRIx64, raw);
+            return;
+        }
+        break;
+    default:
+        break;
+    }
+
+    for (size_t i=0; i < size; ++i) {
+        if (i) s << ' ';
+        s.PutHex8(bytes[i]);
+    }
+}
+
+// The numeric value of a variable, for summaries. Fails for values that
+// have no natural numeric interpretation.
+static bool
+GetHSAValueAsDouble(HwDbgInfo_encoding encoding, const uint8_t *bytes, size_t size, double &value)
+{
+    uint64_t raw = 0;
+    if (size != 1 && size != 2 && size != 4 && size != 8)
+        return false;
+    memcpy(&raw, bytes, size);
+
+    switch (encoding) {
+    case HWDBGINFO_VENC_FLOAT:
+        if (size == sizeof(float)) {
+            float f;
+            memcpy(&f, bytes, sizeof(f));
+            value = f;
+            return true;
+        }
+        if (size == sizeof(double)) {
+            memcpy(&value, bytes, sizeof(value));
+            return true;
         }
+        return false;
+    case HWDBGINFO_VENC_INTEGER:
+    case HWDBGINFO_VENC_CHARACTER: {
+        const unsigned shift = 64 - 8 * size;
+        value = static_cast<double>(static_cast<int64_t>(raw << shift) >> shift);
+        return true;
+    }
+    case HWDBGINFO_VENC_BOOLEAN:
+    case HWDBGINFO_VENC_UINTEGER:
+    case HWDBGINFO_VENC_UCHARACTER:
+    case HWDBGINFO_VENC_POINTER:
+        value = static_cast<double>(raw);
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Summarize a column of values read across work-items, so a read across a
+// large dispatch does not print a line per work-item
+static bool
+DumpHSAValueSummary(Stream &s, HwDbgInfo_encoding encoding, const HsaReadRequest &read, uint32_t n_buckets)
+{
+    const uint64_t n_lanes = read.GetLaneCount();
+    const size_t size = read.request.m_size;
+
+    std::vector<bool> failed (n_lanes, false);
+    for (uint64_t lane : read.failed_lanes) {
+        if (lane < n_lanes) failed[lane] = true;
+    }
+
+    std::vector<double> values;
+    values.reserve(n_lanes);
+    for (uint64_t lane=0; lane < n_lanes; ++lane) {
+        double value;
+        if (failed[lane]) continue;
+        if (!GetHSAValueAsDouble(encoding, read.data.data() + lane * size, size, value))
+            return false;
+        values.push_back(value);
+    }
+
+    s.Printf("work-items: %" PRIu64 ", read: %" PRIu64 ", failed: %" PRIu64 "\n",
+             n_lanes, static_cast<uint64_t>(values.size()), static_cast<uint64_t>(read.failed_lanes.size()));
+    if (values.empty())
+        return true;
+
+    const auto minmax = std::minmax_element(values.begin(), values.end());
+    const double min = *minmax.first;
+    const double max = *minmax.second;
+    double sum = 0;
+    for (double value : values) sum += value;
+    s.Printf("min: %g, max: %g, mean: %g\n", min, max, sum / values.size());
+
+    if (n_buckets == 0 || min == max)
+        return true;
+
+    std::vector<uint64_t> buckets (n_buckets, 0);
+    const double width = (max - min) / n_buckets;
+    for (double value : values) {
+        size_t bucket = static_cast<size_t>((value - min) / width);
+        ++buckets[std::min<size_t>(bucket, n_buckets - 1)];
     }
 
-    return LLDB_INVALID_ADDRESS;
+    for (uint32_t i=0; i < n_buckets; ++i) {
+        s.Printf("  [%g, %g%c: %" PRIu64 "\n", min + i * width, min + (i + 1) * width,
+                 i + 1 == n_buckets ? ']' : ')', buckets[i]);
+    }
+    return true;
 }
 
 
@@ -423,15 +569,26 @@ protected:
           return false;
       }
 	    
+      BreakpointSP bp_sp;
       if (m_options.m_pc != 0) {
 	SearchFilterSP filter_sp (new SearchFilterForUnconstrainedSearches(target));
 	BreakpointResolverSP resolver_sp (new HSABreakpointResolver(nullptr, ConstString(m_options.m_kernel_name), m_options.m_pc));
-	target->CreateBreakpoint(filter_sp, resolver_sp, false, false, false);
+	bp_sp = target->CreateBreakpoint(filter_sp, resolver_sp, false, false, false);
       }
       else {
 	SearchFilterSP filter_sp (new SearchFilterForUnconstrainedSearches(target));
 	BreakpointResolverSP resolver_sp (new HSABreakpointResolver(nullptr, ConstString(m_options.m_kernel_name)));
-	target->CreateBreakpoint(filter_sp, resolver_sp, false, false, false);
+	bp_sp = target->CreateBreakpoint(filter_sp, resolver_sp, false, false, false);
+      }
+
+      // The agent only debugs the dispatches of kernels with breakpoints
+      Process *process = m_exe_ctx.GetProcessPtr();
+      if (bp_sp && process) {
+	HSARuntime *runtime = static_cast<HSARuntime *>(process->GetLanguageRuntime(eLanguageTypeObjC));
+	if (runtime) {
+	  runtime->AddKernelBreakpoint(bp_sp->GetID(), ConstString(m_options.m_kernel_name));
+	  runtime->UpdateDispatchFilter();
+	}
       }
 
       return true;
@@ -459,6 +616,378 @@ CommandObjectHSABreakpointSet::CommandOptions::g_option_table[] =
         { 0, false, NULL, 0, 0, NULL, NULL, 0, eArgTypeNone, NULL }
 };
 
+//-------------------------------------------------------------------------
+// CommandObjectHSABreakpointCondition
+//-------------------------------------------------------------------------
+#pragma mark Condition
+
+class CommandObjectHSABreakpointCondition : public CommandObjectRaw
+{
+public:
+    CommandObjectHSABreakpointCondition (CommandInterpreter &interpreter) :
+        CommandObjectRaw (interpreter,
+                          "hsa breakpoint condition",
+                          "Have the HSA agent stop at a breakpoint only for the waves a condition holds for. "
+                          "Other waves are resumed by the agent without the dispatch stopping.\n"
+                          "The condition is over wg.x/y/z, wi.x/y/z and gid.x/y/z (work-group, work-item and "
+                          "global IDs), lane, exec, active (active lanes) and hits (hit count), with %, &, "
+                          "comparisons, 'in lo..hi', !, && and ||. It holds for a wave if it holds for any "
+                          "active lane.\n"
+                          "Without a condition, the breakpoint's condition is removed.",
+                          "hsa breakpoint condition <breakpoint-id> [<condition>]",
+                          eCommandRequiresProcess | eCommandProcessMustBeLaunched | eCommandProcessMustBePaused)
+    {
+    }
+
+    ~CommandObjectHSABreakpointCondition() override = default;
+
+protected:
+    bool
+    DoExecute(const char *raw_command, CommandReturnObject &result) override
+    {
+        std::pair<llvm::StringRef, llvm::StringRef> args = llvm::StringRef(raw_command).ltrim().split(' ');
+
+        break_id_t break_id = LLDB_INVALID_BREAK_ID;
+        if (args.first.getAsInteger(0, break_id))
+        {
+            result.AppendErrorWithFormat("'%s' takes a breakpoint ID and a condition", m_cmd_name.c_str());
+            result.SetStatus(eReturnStatusFailed);
+            return false;
+        }
+
+        BreakpointSP bp_sp = m_exe_ctx.GetTargetPtr()->GetBreakpointByID(break_id);
+        if (!bp_sp)
+        {
+            result.AppendErrorWithFormat("No breakpoint %d", break_id);
+            result.SetStatus(eReturnStatusFailed);
+            return false;
+        }
+
+        HsaBreakpointCondition condition;
+        std::string error_string;
+        if (!HsaBreakpointCondition::Compile(args.second, condition.ops, error_string))
+        {
+            result.AppendErrorWithFormat("Invalid condition: %s", error_string.c_str());
+            result.SetStatus(eReturnStatusFailed);
+            return false;
+        }
+
+        // Conditions live with the agent's breakpoints, which are by PC. A
+        // location shared with another breakpoint would put the condition
+        // on that breakpoint too.
+        const BreakpointList &breakpoints = m_exe_ctx.GetTargetPtr()->GetBreakpointList();
+        for (size_t i=0; i < bp_sp->GetNumLocations(); ++i)
+        {
+            const addr_t addr = bp_sp->GetLocationAtIndex(i)->GetLoadAddress();
+            if (addr == LLDB_INVALID_ADDRESS)
+                continue;
+
+            for (size_t j=0; j < breakpoints.GetSize(); ++j)
+            {
+                BreakpointSP other_sp = breakpoints.GetBreakpointAtIndex(j);
+                if (!other_sp || other_sp->GetID() == break_id)
+                    continue;
+                for (size_t k=0; k < other_sp->GetNumLocations(); ++k)
+                {
+                    if (other_sp->GetLocationAtIndex(k)->GetLoadAddress() != addr)
+                        continue;
+                    result.AppendErrorWithFormat("Breakpoint %d shares the location 0x%" PRIx64 " with breakpoint %d, "
+                                                 "the agent keeps one condition per address",
+                                                 break_id, addr, other_sp->GetID());
+                    result.SetStatus(eReturnStatusFailed);
+                    return false;
+                }
+            }
+        }
+
+        Process *process = m_exe_ctx.GetProcessPtr();
+        HSARuntime *runtime = static_cast<HSARuntime *>(process->GetLanguageRuntime(eLanguageTypeObjC));
+        size_t n_set = 0;
+        for (size_t i=0; i < bp_sp->GetNumLocations(); ++i)
+        {
+            condition.addr = bp_sp->GetLocationAtIndex(i)->GetLoadAddress();
+            if (condition.addr == LLDB_INVALID_ADDRESS)
+                continue;
+
+            Error error = process->SetHSABreakpointCondition(condition);
+            if (error.Fail())
+            {
+                result.AppendErrorWithFormat("Could not set the condition at 0x%" PRIx64 ": %s",
+                                             condition.addr, error.AsCString());
+                result.SetStatus(eReturnStatusFailed);
+                return false;
+            }
+            if (runtime)
+                runtime->SetConditionBreakpoint(condition.addr, condition.ops.empty() ? LLDB_INVALID_BREAK_ID : break_id);
+            ++n_set;
+        }
+
+        if (n_set == 0)
+        {
+            result.AppendErrorWithFormat("Breakpoint %d has no resolved locations", break_id);
+            result.SetStatus(eReturnStatusFailed);
+            return false;
+        }
+
+        if (condition.ops.empty())
+            result.AppendMessageWithFormat("Removed the condition of breakpoint %d.\n", break_id);
+        else
+            result.AppendMessageWithFormat("Condition of %zu operations set on %zu locations of breakpoint %d.\n",
+                                           condition.ops.size(), n_set, break_id);
+        result.SetStatus(eReturnStatusSuccessFinishResult);
+        return true;
+    }
+};
+
+//-------------------------------------------------------------------------
+// CommandObjectHSABreakpointTrace
+//-------------------------------------------------------------------------
+#pragma mark Trace
+
+class CommandObjectHSABreakpointTrace : public CommandObjectParsed
+{
+public:
+    CommandObjectHSABreakpointTrace (CommandInterpreter &interpreter) :
+        CommandObjectParsed (interpreter,
+                             "hsa breakpoint trace",
+                             "Make an HSA breakpoint a trace breakpoint. The agent counts the waves reaching it "
+                             "by work-group and lane and resumes them without the dispatch stopping, see "
+                             "'hsa breakpoint stats'. Enabling it starts counting from zero.",
+                             "hsa breakpoint trace <breakpoint-id> <enable/disable>",
+                             eCommandRequiresProcess | eCommandProcessMustBeLaunched | eCommandProcessMustBePaused)
+    {
+    }
+
+    ~CommandObjectHSABreakpointTrace() override = default;
+
+protected:
+    bool
+    DoExecute(Args &command, CommandReturnObject &result) override
+    {
+        break_id_t break_id = LLDB_INVALID_BREAK_ID;
+        if (command.GetArgumentCount() != 2 ||
+            llvm::StringRef(command.GetArgumentAtIndex(0)).getAsInteger(0, break_id))
+        {
+            result.AppendErrorWithFormat("'%s' takes a breakpoint ID and 'enable' or 'disable'", m_cmd_name.c_str());
+            result.SetStatus(eReturnStatusFailed);
+            return false;
+        }
+
+        uint32_t mode = HSAIL_BREAKPOINT_MODE_STOP;
+        const char* argument = command.GetArgumentAtIndex(1);
+        if (strcmp(argument, "enable") == 0)
+            mode = HSAIL_BREAKPOINT_MODE_TRACE;
+        else if (strcmp(argument, "disable") != 0)
+        {
+            result.AppendErrorWithFormat("Argument must be either 'enable' or 'disable'");
+            result.SetStatus(eReturnStatusFailed);
+            return false;
+        }
+
+        BreakpointSP bp_sp = m_exe_ctx.GetTargetPtr()->GetBreakpointByID(break_id);
+        if (!bp_sp)
+        {
+            result.AppendErrorWithFormat("No breakpoint %d", break_id);
+            result.SetStatus(eReturnStatusFailed);
+            return false;
+        }
+
+        // Like conditions, modes live with the agent's breakpoints, which are by PC
+        Process *process = m_exe_ctx.GetProcessPtr();
+        size_t n_set = 0;
+        for (size_t i=0; i < bp_sp->GetNumLocations(); ++i)
+        {
+            lldb::addr_t addr = bp_sp->GetLocationAtIndex(i)->GetLoadAddress();
+            if (addr == LLDB_INVALID_ADDRESS)
+                continue;
+
+            Error error = process->SetHSABreakpointMode(addr, mode);
+            if (error.Fail())
+            {
+                result.AppendErrorWithFormat("Could not set the mode at 0x%" PRIx64 ": %s", addr, error.AsCString());
+                result.SetStatus(eReturnStatusFailed);
+                return false;
+            }
+            ++n_set;
+        }
+
+        if (n_set == 0)
+        {
+            result.AppendErrorWithFormat("Breakpoint %d has no resolved locations", break_id);
+            result.SetStatus(eReturnStatusFailed);
+            return false;
+        }
+
+        result.AppendMessageWithFormat("Breakpoint %d will %s at %zu locations.\n", break_id,
+                                       mode == HSAIL_BREAKPOINT_MODE_TRACE ? "count hits without stopping" : "stop",
+                                       n_set);
+        result.SetStatus(eReturnStatusSuccessFinishResult);
+        return true;
+    }
+};
+
+//-------------------------------------------------------------------------
+// CommandObjectHSABreakpointStats
+//-------------------------------------------------------------------------
+#pragma mark Stats
+
+class CommandObjectHSABreakpointStats : public CommandObjectParsed
+{
+public:
+    CommandObjectHSABreakpointStats (CommandInterpreter &interpreter) :
+        CommandObjectParsed (interpreter,
+                             "hsa breakpoint stats",
+                             "Show how often the waves of each HSA breakpoint reached it, by lane and by "
+                             "work-group, as counted by the agent.",
+                             NULL,
+                             eCommandRequiresProcess | eCommandProcessMustBeLaunched | eCommandProcessMustBePaused),
+        m_options (interpreter)
+    {
+    }
+
+    virtual
+    ~CommandObjectHSABreakpointStats () {}
+
+    virtual Options *
+    GetOptions ()
+    {
+        return &m_options;
+    }
+
+    class CommandOptions : public Options
+    {
+    public:
+
+        CommandOptions (CommandInterpreter &interpreter) :
+            Options (interpreter),
+            m_count (8)
+        {
+        }
+
+
+        virtual
+        ~CommandOptions () {}
+
+        virtual Error
+        SetOptionValue (uint32_t option_idx, const char *option_arg)
+        {
+            Error error;
+            const int short_option = m_getopt_table[option_idx].val;
+
+            switch (short_option)
+            {
+            case 'c':
+            {
+                bool success;
+                m_count = StringConvert::ToUInt64(option_arg, 8, 0, &success);
+                if (!success)
+                    error.SetErrorStringWithFormat("invalid integer value for option '%c'", short_option);
+                break;
+            }
+            default:
+                error.SetErrorStringWithFormat ("unrecognized option '%c'", short_option);
+                break;
+            }
+
+            return error;
+        }
+
+        void
+        OptionParsingStarting ()
+        {
+            m_count = 8;
+        }
+
+        const OptionDefinition*
+        GetDefinitions ()
+        {
+            return g_option_table;
+        }
+
+        // Options table: Required for subclasses of Options.
+        static OptionDefinition g_option_table[];
+
+        uint64_t m_count;
+    };
+
+protected:
+    virtual bool
+    DoExecute (Args& command, CommandReturnObject &result)
+    {
+        HsaBreakpointStatsTable table;
+        Error error = m_exe_ctx.GetProcessRef().GetHSABreakpointStats(table, m_options.m_count);
+        if (error.Fail())
+        {
+            result.AppendErrorWithFormat("Could not get the breakpoint statistics: %s", error.AsCString());
+            result.SetStatus (eReturnStatusFailed);
+            return false;
+        }
+
+        Target *target = m_exe_ctx.GetTargetPtr();
+        Stream &s = result.GetOutputStream();
+        if (table.breakpoints.empty())
+            s.Printf("No HSA breakpoints\n");
+
+        for (const auto& stats : table.breakpoints)
+        {
+            // The agent only knows PCs, find the breakpoint they belong to
+            break_id_t break_id = LLDB_INVALID_BREAK_ID;
+            Address address;
+            address.SetLoadAddress(stats.addr, target);
+            const BreakpointList &breakpoints = target->GetBreakpointList();
+            for (size_t i=0; i < breakpoints.GetSize() && break_id == LLDB_INVALID_BREAK_ID; ++i)
+            {
+                BreakpointSP bp_sp = breakpoints.GetBreakpointAtIndex(i);
+                if (bp_sp && bp_sp->FindLocationByAddress(address))
+                    break_id = bp_sp->GetID();
+            }
+
+            s.Printf("Breakpoint %d at 0x%" PRIx64 " (%s): %" PRIu64 " waves, %" PRIu64 " lanes\n",
+                     break_id, stats.addr, stats.mode == HSAIL_BREAKPOINT_MODE_TRACE ? "trace" : "stop",
+                     stats.wave_hits, stats.GetLaneHits());
+            if (stats.wave_hits == 0)
+                continue;
+
+            s.Printf("  lanes:");
+            for (size_t lane=0; lane < stats.lane_hits.size(); ++lane)
+            {
+                if (stats.lane_hits[lane] != 0)
+                    s.Printf(" %zu:%" PRIu64, lane, stats.lane_hits[lane]);
+            }
+            s.Printf("\n");
+
+            s.Printf("  %" PRIu64 " work-groups", stats.num_work_groups);
+            if (!stats.work_groups.empty())
+                s.Printf(", hottest first:");
+            s.Printf("\n");
+            for (const auto& work_group : stats.work_groups)
+            {
+                s.Printf("    (%u, %u, %u): %" PRIu64 " waves, %" PRIu64 " lanes\n",
+                         work_group.m_workGroup.x, work_group.m_workGroup.y, work_group.m_workGroup.z,
+                         work_group.m_waveHits, work_group.m_laneHits);
+            }
+        }
+
+        if (table.truncated)
+            s.Printf("The agent ran out of room, some work-groups are counted but not listed.\n");
+
+        result.SetStatus (eReturnStatusSuccessFinishResult);
+        return true;
+    }
+
+private:
+    CommandOptions m_options;
+};
+
+OptionDefinition
+CommandObjectHSABreakpointStats::CommandOptions::g_option_table[] =
+{
+    { LLDB_OPT_SET_1, false, "count", 'c', OptionParser::eRequiredArgument, NULL, NULL, 0, eArgTypeCount,
+        "Number of work-groups to show per breakpoint, those with the most hits first." },
+
+    { 0, false, NULL, 0, 0, NULL, NULL, 0, eArgTypeNone, NULL }
+};
+
 //-------------------------------------------------------------------------
 // CommandObjectMultiwordHSABreakpoint
 //-------------------------------------------------------------------------
@@ -476,12 +1005,21 @@ public:
 
         CommandObjectSP set_command_object (new CommandObjectHSABreakpointSet (interpreter));
         CommandObjectSP all_command_object (new CommandObjectHSABreakpointAll (interpreter));
+        CommandObjectSP condition_command_object (new CommandObjectHSABreakpointCondition (interpreter));
+        CommandObjectSP trace_command_object (new CommandObjectHSABreakpointTrace (interpreter));
+        CommandObjectSP stats_command_object (new CommandObjectHSABreakpointStats (interpreter));
 
         set_command_object->SetCommandName ("hsa breakpoint set");
         all_command_object->SetCommandName ("hsa breakpoint all");
+        condition_command_object->SetCommandName ("hsa breakpoint condition");
+        trace_command_object->SetCommandName ("hsa breakpoint trace");
+        stats_command_object->SetCommandName ("hsa breakpoint stats");
 
         LoadSubCommand ("set",       set_command_object);
         LoadSubCommand ("all",       all_command_object);
+        LoadSubCommand ("condition", condition_command_object);
+        LoadSubCommand ("trace",     trace_command_object);
+        LoadSubCommand ("stats",     stats_command_object);
     }
 
 
@@ -525,7 +1063,12 @@ public:
             m_var_name (""),
             m_x (0),
             m_y (0),
-            m_z (0)
+            m_z (0),
+            m_x_end (UINT32_MAX),
+            m_y_end (UINT32_MAX),
+            m_z_end (UINT32_MAX),
+            m_summary (false),
+            m_n_buckets (8)
         {
         }
 
@@ -549,6 +1092,16 @@ public:
                 m_y = StringConvert::ToUInt64(option_arg, UINT32_MAX, 0); break;
             case 'z':
                 m_z = StringConvert::ToUInt64(option_arg, UINT32_MAX, 0); break;
+            case 'X':
+                m_x_end = StringConvert::ToUInt64(option_arg, UINT32_MAX, 0); break;
+            case 'Y':
+                m_y_end = StringConvert::ToUInt64(option_arg, UINT32_MAX, 0); break;
+            case 'Z':
+                m_z_end = StringConvert::ToUInt64(option_arg, UINT32_MAX, 0); break;
+            case 's':
+                m_summary = true; break;
+            case 'n':
+                m_n_buckets = StringConvert::ToUInt32(option_arg, 8, 0); break;
             default:
                 error.SetErrorStringWithFormat ("unrecognized option '%c'", short_option);
                 break;
@@ -564,6 +1117,11 @@ public:
             m_x = 0;
             m_y = 0;
             m_z = 0;
+            m_x_end = UINT32_MAX;
+            m_y_end = UINT32_MAX;
+            m_z_end = UINT32_MAX;
+            m_summary = false;
+            m_n_buckets = 8;
         }
 
         const OptionDefinition*
@@ -579,156 +1137,165 @@ public:
         size_t m_x;
         size_t m_y;
         size_t m_z;
+        // Last work-item of the range to read, UINT32_MAX for just m_x, m_y, m_z
+        size_t m_x_end;
+        size_t m_y_end;
+        size_t m_z_end;
+        bool m_summary;
+        uint32_t m_n_buckets;
     };
 
 protected:
     virtual bool
     DoExecute (Args& command, CommandReturnObject &result)
     {
-        auto target_sp = m_exe_ctx.GetTargetSP();
-        auto& images = target_sp->GetImages();
-
-        ModuleSP module_sp;
-        for (unsigned i=0; i < images.GetSize(); ++i) {
-            auto module = images.GetModuleAtIndex(i);
-            if (module) {
-                if (module->GetArchitecture().GetMachine() == llvm::Triple::amdgcn) {
-                    module_sp = module;
-                    break;
-                }
-            }
+        Process *process = m_exe_ctx.GetProcessPtr();
+        HSARuntime *runtime =
+          process ? static_cast<HSARuntime *>(process->GetLanguageRuntime(eLanguageTypeObjC)) : nullptr;
+        SymbolFileAMDHSA *sym_file = runtime ? runtime->GetCurrentSymbolFile() : nullptr;
+
+        if (!sym_file) {
+            result.AppendError("No HSA code object is loaded");
+            result.SetStatus (eReturnStatusFailed);
+            return false;
         }
 
-        if (!module_sp) {
-            result.AppendError("Currently unimplemented");
+        auto dbginfo = sym_file->GetDbgInfo();
+        auto start_addr = m_exe_ctx.GetThreadSP()->GetRegisterContext()->GetPC();
+        Stream &s = result.GetOutputStream();
+
+        HwDbgInfo_err err;
+        HwDbgInfo_variable var;
+        if (m_options.m_var_name.size() > 0 && (m_options.m_var_name[0] == '%' || m_options.m_var_name[0] == '$')) {
+            var = hwdbginfo_low_level_variable(dbginfo, start_addr, true, m_options.m_var_name.c_str(), &err);
+        }
+        else {
+            var = hwdbginfo_variable(dbginfo, start_addr, true, m_options.m_var_name.c_str(), &err);
+        }
+        
+
+        if (err != HWDBGINFO_E_SUCCESS) {
+            result.AppendError("Failed to get var from name: ");
+            result.AppendError(std::to_string(err).c_str());
             result.SetStatus (eReturnStatusFailed);
             return false;
         }
 
-        auto sym_vendor = module_sp->GetSymbolVendor();
-        if (sym_vendor) {
-            auto sym_file = static_cast<SymbolFileAMDHSA*>(sym_vendor->GetSymbolFile());
-            if (sym_file) {
-                auto dbginfo = sym_file->GetDbgInfo();
-                auto start_addr = m_exe_ctx.GetThreadSP()->GetRegisterContext()->GetPC();
-                Stream &s = result.GetOutputStream();
+        std::vector<char> name (m_options.m_var_name.size() + 1);
+        size_t name_len = 0;
+        std::vector<char> type_name (50);
+        size_t type_name_len = 0;
+        size_t var_size = 0;
+        HwDbgInfo_encoding enc;
+        bool is_const = false;
+        bool is_output = false;
+        err = hwdbginfo_variable_data(var, name.size(), name.data(), &name_len, type_name.size(), type_name.data(), &type_name_len, &var_size, &enc, &is_const, &is_output);
+
+        if (err != HWDBGINFO_E_SUCCESS) {
+            result.AppendError("Failed to get var info");
+            result.SetStatus (eReturnStatusFailed);
+            return false;
+        }
 
-                HwDbgInfo_err err;
-                HwDbgInfo_variable var;
-                if (m_options.m_var_name.size() > 0 && (m_options.m_var_name[0] == '%' || m_options.m_var_name[0] == '$')) {
-                    var = hwdbginfo_low_level_variable(dbginfo, start_addr, true, m_options.m_var_name.c_str(), &err);
-                }
-                else {
-                    var = hwdbginfo_variable(dbginfo, start_addr, true, m_options.m_var_name.c_str(), &err);
-                }
-                
+        
+        HwDbgInfo_locreg reg_type;
+        unsigned int reg_num;
+        bool deref_value;
+        unsigned int offset;
+        unsigned int resource;
+        unsigned int isa_memory_region;
+        unsigned int piece_offset;
+        unsigned int piece_size;
+        int const_add;
+        err = hwdbginfo_variable_location(var, &reg_type, &reg_num, &deref_value, &offset, &resource, &isa_memory_region, &piece_offset, &piece_size, &const_add);
+
+        if (err != HWDBGINFO_E_SUCCESS) {
+            result.AppendError("Failed to get var location");
+            result.SetStatus (eReturnStatusFailed);
+            return false;
+        }
 
-                if (err != HWDBGINFO_E_SUCCESS) {
-                    result.AppendError("Failed to get var from name: ");
-                    result.AppendError(std::to_string(err).c_str());
-                    result.SetStatus (eReturnStatusFailed);
-                    return false;
-                }
+        HsailVariableLocation location;
+        location.m_regType = reg_type;
+        location.m_regNum = reg_num;
+        location.m_derefValue = deref_value;
+        location.m_offset = offset;
+        location.m_resource = resource;
+        location.m_isaMemoryRegion = isa_memory_region;
+        location.m_pieceOffset = piece_offset;
+        location.m_pieceSize = piece_size;
+        location.m_constAdd = const_add;
+        location.m_reserved = 0;
+
+        HsailWaveDim3 work_item;
+        work_item.x = m_options.m_x;
+        work_item.y = m_options.m_y;
+        work_item.z = m_options.m_z;
+
+        HsailWaveDim3 work_item_end;
+        work_item_end.x = m_options.m_x_end == UINT32_MAX ? m_options.m_x : m_options.m_x_end;
+        work_item_end.y = m_options.m_y_end == UINT32_MAX ? m_options.m_y : m_options.m_y_end;
+        work_item_end.z = m_options.m_z_end == UINT32_MAX ? m_options.m_z : m_options.m_z_end;
+
+        if (work_item_end.x < work_item.x || work_item_end.y < work_item.y || work_item_end.z < work_item.z) {
+            result.AppendError("Work item range ends before it starts");
+            result.SetStatus (eReturnStatusFailed);
+            return false;
+        }
 
-                std::vector<char> name (m_options.m_var_name.size() + 1);
-                size_t name_len = 0;
-                std::vector<char> type_name (50);
-                size_t type_name_len = 0;
-                size_t var_size = 0;
-                HwDbgInfo_encoding enc;
-                bool is_const = false;
-                bool is_output = false;
-                err = hwdbginfo_variable_data(var, name.size(), name.data(), &name_len, type_name.size(), type_name.data(), &type_name_len, &var_size, &enc, &is_const, &is_output);
-
-                if (err != HWDBGINFO_E_SUCCESS) {
-                    result.AppendError("Failed to get var info");
-                    result.SetStatus (eReturnStatusFailed);
-                    return false;
-                }
+        // The agent reads the variable straight from the selected
+        // wave's work-items, nothing is evaluated in the inferior.
+        // A range of work-items is read in the same round trip.
+        HsaReadRequest read = HsaReadRequest::Variable(m_exe_ctx.GetThreadSP()->GetID(), work_item, location, var_size);
+        read.work_item_count.x = work_item_end.x - work_item.x + 1;
+        read.work_item_count.y = work_item_end.y - work_item.y + 1;
+        read.work_item_count.z = work_item_end.z - work_item.z + 1;
 
-                
-                HwDbgInfo_locreg reg_type;
-                unsigned int reg_num;
-                bool deref_value;
-                unsigned int offset;
-                unsigned int resource;
-                unsigned int isa_memory_region;
-                unsigned int piece_offset;
-                unsigned int piece_size;
-                int const_add;
-                err = hwdbginfo_variable_location(var, &reg_type, &reg_num, &deref_value, &offset, &resource, &isa_memory_region, &piece_offset, &piece_size, &const_add);
-
-                
-                lldb::addr_t func_addr = GetFunctionAddr(*target_sp, ConstString("GetVarValue"));
-
-
-                auto& thread_list = m_exe_ctx.GetProcessPtr()->GetThreadList();
-                auto old_thread = thread_list.GetSelectedThread();
-                thread_list.SetSelectedThreadByIndexID(0);
-                
-                {
-                    lldb::addr_t func_addr = GetFunctionAddr(*target_sp, ConstString("SetHsailThreadCmdInfo"));
-
-                    auto wg_id = old_thread->GetID()-1;
-
-                    std::stringstream expr;
-                    expr << "((void* (*) (unsigned, unsigned, unsigned, unsigned)) 0x";
-                    expr << std::hex << func_addr << std::dec;
-                    expr << ")(" 
-                         << wg_id << ','
-                         << m_options.m_x << ','
-                         << m_options.m_y << ','
-                         << m_options.m_z << ')';
-
-                    ValueObjectSP valobj;
-                    auto exe_scope = m_exe_ctx.GetProcessPtr()->GetThreadList().GetThreadAtIndex(0, false)->GetStackFrameAtIndex(0).get();
-                    EvaluateExpressionOptions options;
-                    options.SetExecutionPolicy(eExecutionPolicyAlways);
-                    auto res = target_sp->EvaluateExpression(expr.str().c_str(), exe_scope, valobj, options);
-
-                    if (res != eExpressionCompleted) {
-                        result.AppendError("Failed to read variable");
-                        result.SetStatus (eReturnStatusFailed);
-                        return false;
-                    }
-                }
+        HsaReadRequests requests (1, read);
+        Error error = m_exe_ctx.GetProcessPtr()->ReadHSA(requests);
 
-                std::stringstream expr;
-                expr << "((void* (*) (int, size_t, unsigned, bool, unsigned, unsigned, unsigned, unsigned, unsigned, int)) 0x";
-                expr << std::hex << func_addr << std::dec;
-                expr << ")(" 
-                     << reg_type << ','
-                     << var_size << ','
-                     << reg_num << ','
-                     << deref_value << ','
-                     << offset << ','
-                     << resource << ','
-                     << isa_memory_region << ','
-                     << piece_offset << ','
-                     << piece_size << ','
-                     << const_add << ')';
-
-                ValueObjectSP valobj;
-                auto exe_scope = m_exe_ctx.GetProcessPtr()->GetThreadList().GetThreadAtIndex(0, false)->GetStackFrameAtIndex(0).get();
-                EvaluateExpressionOptions options;
-                options.SetExecutionPolicy(eExecutionPolicyAlways);
-                auto res = target_sp->EvaluateExpression(expr.str().c_str(), exe_scope, valobj, options);
-                
-                if (res != eExpressionCompleted) {
-                    result.AppendError("Failed to read variable");
-                    result.SetStatus (eReturnStatusFailed);
-                    return false;
-                }
+        if (error.Fail() || !requests[0].Succeeded()) {
+            result.AppendErrorWithFormat("Failed to read variable: %s",
+                                         error.Fail() ? error.AsCString() : requests[0].GetStatusString());
+            result.SetStatus (eReturnStatusFailed);
+            return false;
+        }
 
-                s << "(" << type_name.data() << ") ";
-                if (valobj)
-                    valobj->DumpPrintableRepresentation(s);
-                s << '\n';
+        const HsaReadRequest& column = requests[0];
+        const uint64_t n_lanes = column.GetLaneCount();
+        if (n_lanes == 1) {
+            s << "(" << type_name.data() << ") ";
+            DumpHSAValue(s, enc, column.data.data(), column.data.size());
+            s << '\n';
+        }
+        else if (m_options.m_summary) {
+            s << "(" << type_name.data() << ") " << m_options.m_var_name.c_str() << '\n';
+            if (!DumpHSAValueSummary(s, enc, column, m_options.m_n_buckets)) {
+                result.AppendError("Values of this type cannot be summarized");
+                result.SetStatus (eReturnStatusFailed);
+                return false;
+            }
+        }
+        else {
+            s << "(" << type_name.data() << ") " << m_options.m_var_name.c_str() << '\n';
+            std::vector<bool> failed (n_lanes, false);
+            for (uint64_t lane : column.failed_lanes) {
+                if (lane < n_lanes) failed[lane] = true;
+            }
 
-                thread_list.SetSelectedThreadByID(old_thread->GetID());
+            for (uint64_t lane=0; lane < n_lanes; ++lane) {
+                const HsailWaveDim3 lane_work_item = column.GetWorkItem(lane);
+                s.Printf("  (%u, %u, %u) = ", lane_work_item.x, lane_work_item.y, lane_work_item.z);
+                if (failed[lane])
+                    s << "<unavailable>";
+                else
+                    DumpHSAValue(s, enc, column.data.data() + lane * var_size, var_size);
+                s << '\n';
             }
         }
 
+        result.SetStatus (eReturnStatusSuccessFinishResult);
+
         return result.Succeeded();
     }
 private:
@@ -747,6 +1314,16 @@ CommandObjectHSAVariableRead::CommandOptions::g_option_table[] =
           "Y work item dimension" },
         { LLDB_OPT_SET_1, false, "wi-z", 'z', OptionParser::eOptionalArgument,   NULL, NULL, 0, eArgTypeUnsignedInteger,
           "Z work item dimension" },
+        { LLDB_OPT_SET_1, false, "wi-x-end", 'X', OptionParser::eRequiredArgument,   NULL, NULL, 0, eArgTypeUnsignedInteger,
+          "Read across the X work item dimension, up to and including this one" },
+        { LLDB_OPT_SET_1, false, "wi-y-end", 'Y', OptionParser::eRequiredArgument,   NULL, NULL, 0, eArgTypeUnsignedInteger,
+          "Read across the Y work item dimension, up to and including this one" },
+        { LLDB_OPT_SET_1, false, "wi-z-end", 'Z', OptionParser::eRequiredArgument,   NULL, NULL, 0, eArgTypeUnsignedInteger,
+          "Read across the Z work item dimension, up to and including this one" },
+        { LLDB_OPT_SET_1, false, "summary", 's', OptionParser::eNoArgument,   NULL, NULL, 0, eArgTypeNone,
+          "Print the min, max, mean and a histogram of the values rather than every value" },
+        { LLDB_OPT_SET_1, false, "buckets", 'n', OptionParser::eRequiredArgument,   NULL, NULL, 0, eArgTypeCount,
+          "Number of histogram buckets of --summary" },
         { 0, false, NULL, 0, 0, NULL, NULL, 0, eArgTypeNone, NULL }
 };
 
@@ -808,7 +1385,10 @@ public:
 
         CommandOptions (CommandInterpreter &interpreter) :
             Options (interpreter),
-            m_addr(0), m_n_bytes(32)
+            m_addr(0), m_n_bytes(32),
+            m_x (0),
+            m_y (0),
+            m_z (0)
         {
         }
 
@@ -826,6 +1406,12 @@ public:
             {
             case 'b':
                 m_n_bytes = StringConvert::ToUInt64(option_arg, UINT32_MAX, 0); break;
+            case 'x':
+                m_x = StringConvert::ToUInt64(option_arg, UINT32_MAX, 0); break;
+            case 'y':
+                m_y = StringConvert::ToUInt64(option_arg, UINT32_MAX, 0); break;
+            case 'z':
+                m_z = StringConvert::ToUInt64(option_arg, UINT32_MAX, 0); break;
             default:
                 error.SetErrorStringWithFormat ("unrecognized option '%c'", short_option);
                 break;
@@ -839,6 +1425,9 @@ public:
         {
             m_addr = 0;
             m_n_bytes = 32;
+            m_x = 0;
+            m_y = 0;
+            m_z = 0;
         }
 
         const OptionDefinition*
@@ -852,6 +1441,9 @@ public:
 
         lldb::addr_t m_addr;
         size_t m_n_bytes;
+        size_t m_x;
+        size_t m_y;
+        size_t m_z;
     };
 
 protected:
@@ -865,68 +1457,39 @@ protected:
         ExecutionContext exe_ctx (m_interpreter.GetExecutionContext());
         m_options.m_addr = Args::StringToAddress(&exe_ctx, command.GetArgumentAtIndex(0), LLDB_INVALID_ADDRESS, &error);
 
+        if (m_options.m_addr == LLDB_INVALID_ADDRESS) {
+            result.AppendError("Invalid address");
+            result.SetStatus (eReturnStatusFailed);
+            return false;
+        }
 
-        auto& thread_list = m_exe_ctx.GetProcessPtr()->GetThreadList();
-        auto old_thread = thread_list.GetSelectedThread();
-        thread_list.SetSelectedThreadByIndexID(0);
-     
-        {   
-            Error err;
-            auto perms = ePermissionsWritable | ePermissionsReadable;
-            auto addr = exe_ctx.GetProcessPtr()->AllocateMemory(m_options.m_n_bytes, perms, err);
-            auto size_addr = exe_ctx.GetProcessPtr()->AllocateMemory(sizeof(size_t), perms, err);
-
-            lldb::addr_t func_addr;
-            SymbolContextList sc_list;
-            target_sp->GetImages().FindFunctions(ConstString("GetPrivateMemory"), eFunctionNameTypeAuto, true, true, false, sc_list);
-                
-            if (sc_list.GetSize() > 0) {
-                auto func = sc_list[0].function;
-                if (func)  {
-                    auto addr = func->GetAddressRange().GetBaseAddress();
-                    func_addr = addr.GetLoadAddress(target_sp.get());
-                }
-            }
-
-            std::stringstream expr;
-            expr << "((bool (*) (HwDbgDim3, HwDbgDim3, size_t, size_t, size_t, void*, size_t*)) 0x";
-            expr << std::hex << func_addr << std::dec;
-            expr << ")(" 
-                 << "HwDbgDim3{" << 0 << ',' << 0 << ',' << 0 << "},"
-                 << "HwDbgDim3{" << 0 << ',' << 0 << ',' << 0 << "},"
-                 << m_options.m_addr << ','
-                 << 0 << ','
-                 << m_options.m_n_bytes << ','
-                 << "(void*)" << addr << ','
-                 << "(size_t*)" << size_addr
-                 << ')';
-
-            ValueObjectSP valobj;
-            auto exe_scope = m_exe_ctx.GetProcessPtr()->GetThreadList().GetThreadAtIndex(0, false)->GetStackFrameAtIndex(0).get();
-            EvaluateExpressionOptions options;
-            options.SetExecutionPolicy(eExecutionPolicyAlways);
-            auto res = target_sp->EvaluateExpression(expr.str().c_str(), exe_scope, valobj, options);
-
-            if (res != eExpressionCompleted) {
-                result.AppendError("Failed to read memory");
-                result.SetStatus (eReturnStatusFailed);
-                return false;
-            }
+        HsailWaveDim3 work_item;
+        work_item.x = m_options.m_x;
+        work_item.y = m_options.m_y;
+        work_item.z = m_options.m_z;
 
+        // Private memory of the selected wave's work-item, read by the agent
+        HsaReadRequests requests;
+        requests.push_back(HsaReadRequest::Memory(m_exe_ctx.GetThreadSP()->GetID(), work_item,
+                                                  1 /* IMR_Scratch */, m_options.m_addr, m_options.m_n_bytes));
+        error = m_exe_ctx.GetProcessPtr()->ReadHSA(requests);
 
-            std::vector<char> mem (m_options.m_n_bytes);
-            auto n_read = m_exe_ctx.GetProcessPtr()->ReadMemory(addr, mem.data(), m_options.m_n_bytes, error);
-            s << "Mem: \n";
-            for (unsigned i = 0; i < n_read; ++i ) {
-                s.PutHex8(mem[i]);
-                s << ' ';
-            }
-            s << "\n";
-                
+        if (error.Fail() || !requests[0].Succeeded()) {
+            result.AppendErrorWithFormat("Failed to read memory: %s",
+                                         error.Fail() ? error.AsCString() : requests[0].GetStatusString());
+            result.SetStatus (eReturnStatusFailed);
+            return false;
         }
 
-        thread_list.SetSelectedThreadByID(old_thread->GetID());
+        const auto& mem = requests[0].data;
+        s << "Mem: \n";
+        for (unsigned i = 0; i < mem.size(); ++i ) {
+            s.PutHex8(mem[i]);
+            s << ' ';
+        }
+        s << "\n";
 
+        result.SetStatus (eReturnStatusSuccessFinishResult);
         return result.Succeeded();
     }
 private:
@@ -939,6 +1502,12 @@ CommandObjectHSAMemoryRead::CommandOptions::g_option_table[] =
 {
         { LLDB_OPT_SET_1, false, "n-bytes", 'b', OptionParser::eRequiredArgument,   NULL, NULL, 0, eArgTypeVarName,
           "Number of bytes" },
+        { LLDB_OPT_SET_1, false, "wi-x", 'x', OptionParser::eOptionalArgument,   NULL, NULL, 0, eArgTypeUnsignedInteger,
+          "X work item dimension" },
+        { LLDB_OPT_SET_1, false, "wi-y", 'y', OptionParser::eOptionalArgument,   NULL, NULL, 0, eArgTypeUnsignedInteger,
+          "Y work item dimension" },
+        { LLDB_OPT_SET_1, false, "wi-z", 'z', OptionParser::eOptionalArgument,   NULL, NULL, 0, eArgTypeUnsignedInteger,
+          "Z work item dimension" },
         { 0, false, NULL, 0, 0, NULL, NULL, 0, eArgTypeNone, NULL }
 };
 
@@ -968,6 +1537,177 @@ public:
     ~CommandObjectMultiwordHSAMemory () {}
 };
 
+//-------------------------------------------------------------------------
+// CommandObjectHSAWavefrontList
+//-------------------------------------------------------------------------
+#pragma mark Wavefront
+
+class CommandObjectHSAWavefrontList : public CommandObjectParsed
+{
+public:
+    CommandObjectHSAWavefrontList (CommandInterpreter &interpreter) :
+        CommandObjectParsed (interpreter,
+                             "hsa wavefront list",
+                             "List a page of the HSA wavefronts active at the current stop.",
+                             NULL,
+                             eCommandRequiresProcess | eCommandProcessMustBePaused),
+        m_options (interpreter)
+    {
+    }
+
+    virtual
+    ~CommandObjectHSAWavefrontList () {}
+
+    virtual Options *
+    GetOptions ()
+    {
+        return &m_options;
+    }
+
+    class CommandOptions : public Options
+    {
+    public:
+
+        CommandOptions (CommandInterpreter &interpreter) :
+            Options (interpreter),
+            m_start (0),
+            m_count (32)
+        {
+        }
+
+
+        virtual
+        ~CommandOptions () {}
+
+        virtual Error
+        SetOptionValue (uint32_t option_idx, const char *option_arg)
+        {
+            Error error;
+            const int short_option = m_getopt_table[option_idx].val;
+
+            switch (short_option)
+            {
+            case 's':
+                m_start = StringConvert::ToUInt64(option_arg, 0, 0); break;
+            case 'c':
+                m_count = StringConvert::ToUInt64(option_arg, 32, 0); break;
+            default:
+                error.SetErrorStringWithFormat ("unrecognized option '%c'", short_option);
+                break;
+            }
+
+            return error;
+        }
+
+        void
+        OptionParsingStarting ()
+        {
+            m_start = 0;
+            m_count = 32;
+        }
+
+        const OptionDefinition*
+        GetDefinitions ()
+        {
+            return g_option_table;
+        }
+
+        // Options table: Required for subclasses of Options.
+        static OptionDefinition g_option_table[];
+
+        uint64_t m_start;
+        uint64_t m_count;
+    };
+
+protected:
+    virtual bool
+    DoExecute (Args& command, CommandReturnObject &result)
+    {
+        // Ask for the rows rather than walking the thread list, most waves
+        // do not have threads
+        auto info_sp = m_exe_ctx.GetProcessRef().GetHSAWavefrontsInfo(m_options.m_start, m_options.m_count);
+        auto info = info_sp ? info_sp->GetAsDictionary() : nullptr;
+        if (!info) {
+            result.AppendError("No HSA wavefronts available");
+            result.SetStatus (eReturnStatusFailed);
+            return false;
+        }
+
+        uint64_t total = 0;
+        info->GetValueForKeyAsInteger("total", total);
+
+        Stream &s = result.GetOutputStream();
+        StructuredData::Array *waves = nullptr;
+        info->GetValueForKeyAsArray("wavefronts", waves);
+        const size_t n_waves = waves ? waves->GetSize() : 0;
+        s.Printf("Wavefronts %" PRIu64 "-%" PRIu64 " of %" PRIu64 "\n",
+                 n_waves ? m_options.m_start : 0, m_options.m_start + n_waves, total);
+
+        for (size_t i=0; i < n_waves; ++i) {
+            auto wave = waves->GetItemAtIndex(i)->GetAsDictionary();
+            if (!wave) continue;
+
+            uint64_t tid = 0, pc = 0, exec_mask = 0, wave_address = 0;
+            wave->GetValueForKeyAsInteger("tid", tid);
+            wave->GetValueForKeyAsInteger("pc", pc);
+            wave->GetValueForKeyAsInteger("exec_mask", exec_mask);
+            wave->GetValueForKeyAsInteger("wave_address", wave_address);
+
+            uint64_t wg[3] = { 0, 0, 0 };
+            StructuredData::Array *work_group = nullptr;
+            if (wave->GetValueForKeyAsArray("work_group", work_group)) {
+                for (size_t j=0; j < 3; ++j) work_group->GetItemAtIndexAsInteger(j, wg[j]);
+            }
+
+            s.Printf("  tid = 0x%" PRIx64 ", pc = 0x%" PRIx64 ", exec = 0x%16.16" PRIx64
+                     ", work-group = (%" PRIu64 ", %" PRIu64 ", %" PRIu64 "), slot = 0x%" PRIx64 "\n",
+                     tid, pc, exec_mask, wg[0], wg[1], wg[2], wave_address);
+        }
+
+        result.SetStatus (eReturnStatusSuccessFinishResult);
+        return true;
+    }
+
+private:
+    CommandOptions m_options;
+};
+
+OptionDefinition
+CommandObjectHSAWavefrontList::CommandOptions::g_option_table[] =
+{
+    { LLDB_OPT_SET_1, false, "start", 's', OptionParser::eRequiredArgument, NULL, NULL, 0, eArgTypeIndex,
+        "Index of the first wavefront to list." },
+    { LLDB_OPT_SET_1, false, "count", 'c', OptionParser::eRequiredArgument, NULL, NULL, 0, eArgTypeCount,
+        "Number of wavefronts to list." },
+
+    { 0, false, NULL, 0, 0, NULL, NULL, 0, eArgTypeNone, NULL }
+};
+
+//-------------------------------------------------------------------------
+// CommandObjectMultiwordHSAWavefront
+//-------------------------------------------------------------------------
+
+class CommandObjectMultiwordHSAWavefront : public CommandObjectMultiword
+{
+public:
+    CommandObjectMultiwordHSAWavefront (CommandInterpreter &interpreter) :
+        CommandObjectMultiword (interpreter,
+                             "hsa wavefront",
+                             "A set of commands for operating on HSA wavefronts",
+                             "hsa wavefront <command> [<command-options>]")
+    {
+        CommandObjectSP list_command_object (new CommandObjectHSAWavefrontList (interpreter));
+
+        list_command_object->SetCommandName ("hsa wavefront list");
+
+        LoadSubCommand ("list",       list_command_object);
+    }
+
+
+    virtual
+    ~CommandObjectMultiwordHSAWavefront () {}
+};
+
 //-------------------------------------------------------------------------
 // CommandObjectHSA
 //-------------------------------------------------------------------------
@@ -983,17 +1723,20 @@ CommandObjectHSA::CommandObjectHSA (CommandInterpreter &interpreter) :
     CommandObjectSP kernel_command_object (new CommandObjectMultiwordHSAKernel (interpreter));
     CommandObjectSP var_command_object (new CommandObjectMultiwordHSAVariable (interpreter));
     CommandObjectSP mem_command_object (new CommandObjectMultiwordHSAMemory (interpreter));
+    CommandObjectSP wave_command_object (new CommandObjectMultiwordHSAWavefront (interpreter));
     
 
     breakpoint_command_object->SetCommandName ("hsa breakpoint");
     kernel_command_object->SetCommandName ("hsa kernel");
     var_command_object->SetCommandName ("hsa variable");
     mem_command_object->SetCommandName ("hsa memory");
+    wave_command_object->SetCommandName ("hsa wavefront");
 
     LoadSubCommand ("breakpoint",       breakpoint_command_object);
     LoadSubCommand ("kernel",           kernel_command_object);
     LoadSubCommand ("variable",         var_command_object);
     LoadSubCommand ("memory",         mem_command_object);
+    LoadSubCommand ("wavefront",      wave_command_object);
 }
 
 CommandObjectHSA::~CommandObjectHSA ()
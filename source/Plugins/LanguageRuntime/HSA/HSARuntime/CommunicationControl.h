@@ -32,6 +32,11 @@ typedef enum
     HSAIL_COMMAND_MOMENTARY_BREAKPOINT, // Set an HSAIL momentary breakpoint (which is automatically deleted)
     HSAIL_COMMAND_CONTINUE,             // Continue the inferior process
     HSAIL_COMMAND_SET_LOGGING,          // Configure the logging in the Agent
+    HSAIL_COMMAND_BREAKPOINT_BATCH,     // Apply the batch of PC breakpoint operations in shared mem
+    HSAIL_COMMAND_READ_BATCH,           // Serve the batch of variable / memory reads in shared mem
+    HSAIL_COMMAND_DISPATCH_FILTER_BEGIN,  // Start replacing the kernels GDB wants to see dispatched
+    HSAIL_COMMAND_DISPATCH_FILTER_KERNEL, // Add m_kernelName to the dispatch filter, an empty name adds every kernel
+    HSAIL_COMMAND_DISPATCH_FILTER_END,    // The dispatch filter is complete
 } HsailCommand;
 
 typedef enum
@@ -174,11 +179,205 @@ typedef struct _HsailMomentaryBP
     int m_lineNum;      // The line number for this breakpoint
 } HsailMomentaryBP;
 
+typedef enum
+{
+    HSAIL_BREAKPOINT_OP_UNKNOWN,
+    HSAIL_BREAKPOINT_OP_CREATE,     // Create a breakpoint at m_pc
+    HSAIL_BREAKPOINT_OP_DELETE,     // Delete the breakpoint at m_pc
+    HSAIL_BREAKPOINT_OP_ENABLE,     // Enable the breakpoint at m_pc
+    HSAIL_BREAKPOINT_OP_DISABLE,    // Disable the breakpoint at m_pc
+    HSAIL_BREAKPOINT_OP_CONDITION,  // Replace the condition of the breakpoint at m_pc
+    HSAIL_BREAKPOINT_OP_MODE,       // Set the mode of the breakpoint at m_pc to m_mode
+    HSAIL_BREAKPOINT_OP_STEP_CLEAR, // Delete all momentary breakpoints, the step breakpoints of the last line
+    HSAIL_BREAKPOINT_OP_STEP        // Set a momentary breakpoint at m_pc that lasts until the next HSAIL_BREAKPOINT_OP_STEP_CLEAR
+} HsailBreakpointOpCode;
+
+typedef enum
+{
+    HSAIL_BREAKPOINT_OP_STATUS_PENDING, // Not applied yet, GDB writes operations with this status
+    HSAIL_BREAKPOINT_OP_STATUS_SUCCESS, // Applied
+    HSAIL_BREAKPOINT_OP_STATUS_FAILURE  // The agent could not apply it, for example a condition it cannot run
+} HsailBreakpointOpStatus;
+
+typedef enum
+{
+    HSAIL_BREAKPOINT_MODE_STOP,     // Stop the dispatch when the condition holds
+    HSAIL_BREAKPOINT_MODE_TRACE     // Only count the hits in the statistics, never stop
+} HsailBreakpointMode;
+
+// A single operation of a breakpoint batch, breakpoints are identified by PC
+typedef struct _HsailBreakpointOp
+{
+    HsailBreakpointOpCode m_op;     // What to do
+    int m_gdbBreakpointID;          // The GDB ID to create / delete / enable / disable
+    uint64_t m_pc;                  // The PC of the breakpoint
+    int m_lineNum;                  // The line number, only used by HSAIL_BREAKPOINT_OP_CREATE
+    uint32_t m_numConditionOps;     // The length of the condition program, 0 for an unconditional breakpoint
+    uint64_t m_conditionOffset;     // Where the condition program is, from the start of the shared mem
+    uint32_t m_mode;                // HsailBreakpointMode, used by HSAIL_BREAKPOINT_OP_CREATE and HSAIL_BREAKPOINT_OP_MODE
+    uint32_t m_status;              // HsailBreakpointOpStatus, written by the agent before it consumes the batch
+} HsailBreakpointOp;
+
+// A breakpoint condition is a small stack program, evaluated by the agent for
+// every wave that traps at the breakpoint before anything is reported to gdb.
+// The program runs once for each active lane of the wave, or once for the wave
+// if it does not look at lanes, and the wave stops if it leaves non zero on the
+// stack for any lane. Comparisons push 1 or 0, all values are unsigned 64 bit.
+typedef enum
+{
+    HSAIL_CONDITION_OP_END,             // End of the program, the top of the stack is the result
+    HSAIL_CONDITION_OP_CONST,           // Push m_operand
+    HSAIL_CONDITION_OP_WORKGROUP_ID,    // Push dimension m_operand (0 x, 1 y, 2 z) of the work-group ID
+    HSAIL_CONDITION_OP_WORKITEM_ID,     // Push dimension m_operand of the lane's work-item ID
+    HSAIL_CONDITION_OP_GLOBAL_ID,       // Push dimension m_operand of the lane's global work-item ID
+    HSAIL_CONDITION_OP_LANE,            // Push the lane number
+    HSAIL_CONDITION_OP_EXEC_MASK,       // Push the wave's execution mask
+    HSAIL_CONDITION_OP_ACTIVE_LANES,    // Push the number of active lanes of the wave
+    HSAIL_CONDITION_OP_HIT_COUNT,       // Push the number of waves that hit the breakpoint, this one included
+    HSAIL_CONDITION_OP_MOD,             // Pop b and a, push a % b (0 if b is 0)
+    HSAIL_CONDITION_OP_BIT_AND,         // Pop b and a, push a & b
+    HSAIL_CONDITION_OP_EQ,              // Pop b and a, push a == b
+    HSAIL_CONDITION_OP_NE,              // Pop b and a, push a != b
+    HSAIL_CONDITION_OP_LT,              // Pop b and a, push a < b
+    HSAIL_CONDITION_OP_LE,              // Pop b and a, push a <= b
+    HSAIL_CONDITION_OP_GT,              // Pop b and a, push a > b
+    HSAIL_CONDITION_OP_GE,              // Pop b and a, push a >= b
+    HSAIL_CONDITION_OP_IN_RANGE,        // Pop hi, lo and a, push lo <= a && a <= hi
+    HSAIL_CONDITION_OP_AND,             // Pop b and a, push a && b
+    HSAIL_CONDITION_OP_OR,              // Pop b and a, push a || b
+    HSAIL_CONDITION_OP_NOT              // Pop a, push !a
+} HsailConditionOpCode;
+
+// A single instruction of a condition program
+typedef struct _HsailConditionOp
+{
+    uint32_t m_op;          // HsailConditionOpCode
+    uint32_t m_reserved;    // Keeps the operand 8 byte aligned
+    uint64_t m_operand;     // Only used by the push operations
+} HsailConditionOp;
+
+#define HSAIL_MAX_CONDITION_OPS 64
+
+#define HSAIL_MAX_CONDITION_STACK 16
+
+// The breakpoint batch shared mem starts with this header, followed by m_numOps HsailBreakpointOp
+// and the condition programs they point to.
+// GDB increments m_sequence for every batch and sends HSAIL_COMMAND_BREAKPOINT_BATCH,
+// the agent sets m_consumed to m_sequence once it has applied the batch and
+// set the m_status of every operation.
+// GDB does not write a new batch until the previous one has been consumed.
+typedef struct _HsailBreakpointBatchHeader
+{
+    uint32_t m_sequence;    // Written by GDB
+    uint32_t m_consumed;    // Written by the agent
+    uint32_t m_numOps;      // The number of operations following the header
+    uint32_t m_reserved;    // Keeps the operations 8 byte aligned
+} HsailBreakpointBatchHeader;
+
+// The breakpoint statistics shared mem starts with this header, followed by
+// m_numBreakpoints HsailBreakpointStats and then m_numWorkGroups HsailWorkGroupHits,
+// the work-groups of each breakpoint are contiguous. Spare slots may follow the
+// work-groups of a breakpoint, m_numWorkGroups counts them too.
+// The agent updates the statistics of the breakpoints that changed after every
+// breakpoint event, trace hits included, and gdb reads them whenever it likes:
+// m_sequence is odd while the agent writes, a copy is consistent if m_sequence
+// was the same even number before and after it was taken.
+typedef struct _HsailBreakpointStatsHeader
+{
+    uint32_t m_sequence;        // Written by the agent
+    uint32_t m_numBreakpoints;  // The number of breakpoints following the header
+    uint32_t m_numWorkGroups;   // The number of work-group slots following the breakpoints
+    uint32_t m_isTruncated;     // Non zero if work-groups were left out for lack of space
+} HsailBreakpointStatsHeader;
+
+#define HSAIL_WAVEFRONT_SIZE 64
+
+// The hits of a PC breakpoint since it was created or last set to trace mode
+typedef struct _HsailBreakpointStats
+{
+    uint64_t m_pc;                              // The PC of the breakpoint
+    uint32_t m_mode;                            // HsailBreakpointMode
+    uint32_t m_numWorkGroups;                   // The number of work-groups that hit the breakpoint
+    uint64_t m_firstWorkGroup;                  // Index of its first HsailWorkGroupHits
+    uint64_t m_waveHits;                        // The number of waves that reached the breakpoint
+    uint64_t m_laneHits[HSAIL_WAVEFRONT_SIZE];  // How often each lane was active when a wave reached it
+} HsailBreakpointStats;
+
+// The hits of a PC breakpoint by the waves of one work-group
+typedef struct _HsailWorkGroupHits
+{
+    HsailWaveDim3 m_workGroup;  // The work-group
+    uint32_t m_reserved;        // Keeps the counts 8 byte aligned
+    uint64_t m_waveHits;        // The number of its waves that reached the breakpoint
+    uint64_t m_laneHits;        // The active lanes of those waves
+} HsailWorkGroupHits;
+
+typedef enum
+{
+    HSAIL_READ_KIND_UNKNOWN,
+    HSAIL_READ_KIND_VARIABLE,       // Read a variable at the location the debug info gives for it
+    HSAIL_READ_KIND_MEMORY          // Read m_size bytes at m_address in m_memoryRegion
+} HsailReadKind;
+
+typedef enum
+{
+    HSAIL_READ_STATUS_PENDING,      // Not served yet
+    HSAIL_READ_STATUS_SUCCESS,      // m_resultSize bytes were written at m_resultOffset
+    HSAIL_READ_STATUS_UNSUPPORTED,  // The location or memory region cannot be read
+    HSAIL_READ_STATUS_FAILURE       // The DBE could not read the memory
+} HsailReadStatus;
+
+// A variable location, as returned by hwdbginfo_variable_location
+typedef struct _HsailVariableLocation
+{
+    int32_t m_regType;              // The register holding the location
+    uint32_t m_regNum;              // The register number
+    uint32_t m_derefValue;          // Non zero if the location holds the address of the value
+    uint32_t m_offset;              // Offset added to the location
+    uint32_t m_resource;            // The resource (UAV / segment) number
+    uint32_t m_isaMemoryRegion;     // The IMR_* memory region the value is in
+    uint32_t m_pieceOffset;         // Offset of the piece of the value
+    uint32_t m_pieceSize;           // Size of the piece of the value
+    int32_t m_constAdd;             // Constant added to the value
+    uint32_t m_reserved;            // Keeps the location 8 byte aligned
+} HsailVariableLocation;
+
+// A single request of a read batch. The work-group and work-item select whose
+// private or group memory is read, they are ignored for the other memory regions.
+// Private and group reads are served by the DBE, which only implements private
+// memory so far: group reads fail with HSAIL_READ_STATUS_UNSUPPORTED until it does.
+typedef struct _HsailReadRequest
+{
+    uint32_t m_kind;                // HsailReadKind, written by GDB
+    uint32_t m_status;              // HsailReadStatus, written by the agent
+    HsailWaveDim3 m_workGroup;      // The work-group to read for
+    HsailWaveDim3 m_workItem;       // The work-item to read for
+    HsailVariableLocation m_location;   // Only used by HSAIL_READ_KIND_VARIABLE
+    uint64_t m_memoryRegion;        // Only used by HSAIL_READ_KIND_MEMORY, the IMR_* memory region
+    uint64_t m_address;             // Only used by HSAIL_READ_KIND_MEMORY, the address in m_memoryRegion
+    uint64_t m_size;                // The number of bytes to read
+    uint64_t m_resultOffset;        // Where the agent writes the bytes, from the start of the shared mem
+    uint64_t m_resultSize;          // The number of bytes the agent wrote, written by the agent
+} HsailReadRequest;
+
+// The read batch shared mem starts with this header, followed by m_numRequests HsailReadRequest
+// and the space their results are written to.
+// GDB increments m_sequence for every batch and sends HSAIL_COMMAND_READ_BATCH,
+// the agent sets m_consumed to m_sequence once all results are written.
+typedef struct _HsailReadBatchHeader
+{
+    uint32_t m_sequence;    // Written by GDB
+    uint32_t m_consumed;    // Written by the agent
+    uint32_t m_numRequests; // The number of requests following the header
+    uint32_t m_reserved;    // Keeps the requests 8 byte aligned
+} HsailReadBatchHeader;
+
 typedef enum
 {
     HSAIL_BREAKPOINT_CONDITION_UNKNOWN, // Unknown condition,
     HSAIL_BREAKPOINT_CONDITION_ANY,     // No condition, always returns true
-    HSAIL_BREAKPOINT_CONDITION_EQUAL    // The workgroup and workitem are present in the waveinfo buffer
+    HSAIL_BREAKPOINT_CONDITION_EQUAL,   // The workgroup and workitem are present in the waveinfo buffer
+    HSAIL_BREAKPOINT_CONDITION_PROGRAM  // The condition program holds for an active lane of the wave
 } HsailConditionCode;
 
 typedef struct _HsailConditionPacket
@@ -212,16 +411,56 @@ typedef uint32_t HsailWaveAddress;
 // the program counter (byte offset in the ISA binary)
 typedef uint64_t HsailProgramCounter;
 
+// Version of the wave buffer layout below, the agent bumps it whenever
+// the header or the record layout changes
+static const uint32_t HSAIL_WAVE_BUFFER_VERSION = 1;
+
+typedef enum
+{
+    HSAIL_WAVE_RECORD_FLAGS_NONE = 0,
+
+    // Only the work-item ID of the first active lane is stored, the others
+    // follow it in the work-group's x-fastest order, one per lane
+    HSAIL_WAVE_RECORD_FLAGS_DERIVED_WORKITEMS = 1
+
+} HsailWaveRecordFlags;
+
+// The wave buffer starts with this header and is followed by m_numWaves
+// variable length HsailWaveRecords. Only the first m_bytesUsed bytes are
+// written on a stop, the rest of the buffer holds stale data.
+typedef struct _HsailWaveBufferHeader
+{
+    uint32_t                m_version;           /**< HSAIL_WAVE_BUFFER_VERSION */
+    uint32_t                m_headerSize;        /**< offset of the first record */
+    uint32_t                m_numWaves;          /**< number of records */
+    uint32_t                m_reserved;
+    uint64_t                m_bytesUsed;         /**< size of the header and all records */
+    uint64_t                m_capacity;          /**< size of the buffer, larger than the mapping once the agent grows it */
+
+} HsailWaveBufferHeader;
+
 // We have filtered out the Databreakpointinfo for now
-typedef struct _HsailAgentWaveInfo
+// A record is followed by m_numWorkItemIds work-item IDs (local IDs within
+// the work-group), one per active lane in lane order, or just the first
+// one if the record has HSAIL_WAVE_RECORD_FLAGS_DERIVED_WORKITEMS
+typedef struct _HsailWaveRecord
 {
+    uint32_t                m_recordSize;        /**< size of the record and its work-item IDs, a multiple of 8 */
+    uint32_t                m_flags;             /**< HsailWaveRecordFlags */
     HsailWaveDim3           workGroupId;         /**< work-group id */
-    HsailWaveDim3           workItemId[64];      /**< work-item id (local id within a work-group) */
+    uint32_t                m_numWorkItemIds;    /**< number of work-item IDs following the record */
     uint64_t                execMask;            /**< the execution mask of the work-items */
-    HsailWaveAddress        waveAddress;         /**< the hw wave slot address (not unique for the dispatch) */
     HsailProgramCounter     pc;                  /**< the program counter for the wave */
+    HsailWaveAddress        waveAddress;         /**< the hw wave slot address (not unique for the dispatch) */
+    uint32_t                m_reserved;
 
-} HsailAgentWaveInfo;
+} HsailWaveRecord;
+
+// The size of a wave record carrying numWorkItemIds work-item IDs
+static inline uint32_t GetHsailWaveRecordSize(uint32_t numWorkItemIds)
+{
+    return (uint32_t)((sizeof(HsailWaveRecord) + numWorkItemIds * sizeof(HsailWaveDim3) + 7) & ~(size_t)7);
+}
 
 
 // A constant value to use when we send a packet that doesnt use the m_pc field
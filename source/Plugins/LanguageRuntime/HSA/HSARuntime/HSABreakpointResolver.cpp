@@ -9,12 +9,9 @@
 
 #include "llvm/ADT/Triple.h"
 #include "lldb/Core/Module.h"
-#include "lldb/Core/DataExtractor.h"
-#include "lldb/Symbol/ObjectFile.h"
 #include "lldb/Symbol/SymbolVendor.h"
 #include "lldb/Symbol/SymbolFile.h"
 #include "HSABreakpointResolver.h"
-#include "Plugins/SymbolFile/AMDHSA/FacilitiesInterface.h"
 #include "Plugins/SymbolFile/AMDHSA/SymbolFileAMDHSA.h"
 
 using namespace lldb;
@@ -34,17 +31,6 @@ HSABreakpointResolver::SearchCallback(SearchFilter &filter,
   if (module_sp->GetArchitecture().GetMachine() != llvm::Triple::amdgcn) 
     return Searcher::eCallbackReturnContinue;    
 
-  const size_t max_addrs = 10240;
-  std::vector<HwDbgInfo_addr> addrs (max_addrs);
-  size_t n_addrs = 0;
-
-  auto obj_file = module_sp->GetObjectFile();
-  if (!obj_file) {
-    return Searcher::eCallbackReturnContinue;
-  }
-
-  HwDbgInfo_err err;
-
   auto sym_vendor = module_sp->GetSymbolVendor();
   if (!sym_vendor) 
       return Searcher::eCallbackReturnContinue;    
@@ -53,62 +39,22 @@ HSABreakpointResolver::SearchCallback(SearchFilter &filter,
   if (!sym_file)
       return Searcher::eCallbackReturnContinue;    
 
-  auto dbginfo = static_cast<SymbolFileAMDHSA*>(sym_file)->GetDbgInfo();
-
-  if (m_type == Type::KernelEntry) {
-       err = hwdbginfo_all_mapped_addrs(dbginfo, max_addrs, addrs.data(), &n_addrs);
-
-      if (err != HWDBGINFO_E_SUCCESS) {
-          return Searcher::eCallbackReturnContinue;
-      } 
-  } 
-  else {
-      auto loc = hwdbginfo_make_code_location(nullptr, m_line);
-      if (loc == nullptr) {
-          return Searcher::eCallbackReturnContinue;
-      }
-
-      HwDbgInfo_code_location resolvedLoc;
-      auto err = hwdbginfo_nearest_mapped_line(dbginfo, loc, &resolvedLoc);
-      hwdbginfo_release_code_locations(&loc, 1);
-    
-      if (err != HWDBGINFO_E_SUCCESS) { 
-          return Searcher::eCallbackReturnContinue;
-      }
-
-      err = hwdbginfo_line_to_addrs(dbginfo, resolvedLoc, max_addrs, addrs.data(), &n_addrs);
+  auto hsa_sym_file = static_cast<SymbolFileAMDHSA*>(sym_file);
 
-      if (err != HWDBGINFO_E_SUCCESS) {
-          return Searcher::eCallbackReturnContinue;
-      } 
-
-      hwdbginfo_release_code_locations(&resolvedLoc, 1);
-  }
-
-  auto kernel_name = static_cast<SymbolFileAMDHSA*>(sym_file)->GetKernelName();
-  if (kernel_name == m_kernel_name) {
-      m_breakpoint->AddLocation(addrs[0]);
+  // The symbol file indexed its kernel when the module loaded, code
+  // objects of other kernels are passed over with a single lookup
+  HwDbgInfo_addr entry_addr;
+  if (!hsa_sym_file->FindKernelEntry(m_kernel_name, entry_addr))
       return Searcher::eCallbackReturnContinue;
-  }
 
-  auto start_addr = addrs[0];
-  std::vector<HwDbgInfo_frame_context> frames (100);
-  size_t n_frames;
-  err = hwdbginfo_addr_call_stack(dbginfo, start_addr, frames.size(), frames.data(), &n_frames);
-
-  if (err != HWDBGINFO_E_SUCCESS) {
+  if (m_type == Type::KernelEntry) {
+      m_breakpoint->AddLocation(entry_addr);
       return Searcher::eCallbackReturnContinue;
-  } 
-
-  HwDbgInfo_addr pc, fp, mp;
-  HwDbgInfo_code_location loc;
-  std::vector<char> func_name (100);
-  size_t func_name_len;
-  err = hwdbginfo_frame_context_details(frames[0], &pc, &fp, &mp, &loc, func_name.size(), func_name.data(), &func_name_len);
+  }
 
-  if (ConstString(func_name.data()) == m_kernel_name || kernel_name == m_kernel_name) {
+  auto addrs = hsa_sym_file->FindLineAddresses(m_line);
+  if (!addrs.empty())
       m_breakpoint->AddLocation(addrs[0]);
-  }
 
   return Searcher::eCallbackReturnContinue;
 }
@@ -65,7 +65,11 @@ public:
     lldb::BreakpointResolverSP
     CopyForBreakpoint(Breakpoint &breakpoint) override
     {
-        lldb::BreakpointResolverSP ret_sp(new HSABreakpointResolver(&breakpoint, m_kernel_name));
+        lldb::BreakpointResolverSP ret_sp;
+        if (m_type == Type::KernelLine)
+            ret_sp.reset(new HSABreakpointResolver(&breakpoint, m_kernel_name, m_line));
+        else
+            ret_sp.reset(new HSABreakpointResolver(&breakpoint, m_kernel_name));
         return ret_sp;
     }
 
@@ -9,15 +9,23 @@
 
 // C Includes
 // C++ Includes
+#include <algorithm>
+
 // Other libraries and framework includes
 #include "HSARuntime.h"
 #include "CommandObjectHSA.h"
 
 #include "lldb/lldb-private.h"
+#include "lldb/Breakpoint/Breakpoint.h"
+#include "lldb/Breakpoint/BreakpointLocation.h"
+#include "lldb/Core/Debugger.h"
+#include "lldb/Core/Log.h"
 #include "lldb/Core/PluginManager.h"
+#include "lldb/Core/StreamFile.h"
 #include "lldb/Core/ModuleList.h"
 #include "lldb/Symbol/SymbolVendor.h"
 #include "lldb/Symbol/SymbolFile.h"
+#include "lldb/Target/Process.h"
 #include "lldb/Target/Target.h"
 #include "Plugins/SymbolFile/AMDHSA/SymbolFileAMDHSA.h"
 #include "HSABreakpointResolver.h"
@@ -109,9 +117,14 @@ HSARuntime::GetCommandObject(lldb_private::CommandInterpreter& interpreter)
 HSARuntime::~HSARuntime() = default;
 
 HSARuntime::HSARuntime (Process* process)
-  : lldb_private::CPPLanguageRuntime(process)
+  : lldb_private::CPPLanguageRuntime(process),
+    m_breakpoint_listener ("lldb.hsa.runtime.breakpoint-listener"),
+    m_hsa_modules_mutex (Mutex::eMutexTypeRecursive),
+    m_hsa_modules (),
+    m_current_module ()
 {
-  
+    // The events are handled before every resume, see ProcessBreakpointEvents
+    m_breakpoint_listener.StartListeningForEvents (&process->GetTarget(), Target::eBroadcastBitBreakpointChanged);
 }
 
 LanguageRuntime *
@@ -129,29 +142,221 @@ HSARuntime::ModulesDidLoad (const ModuleList &module_list)
     for (size_t i = 0; i < num_modules; i++)
     {
         auto mod = module_list.GetModuleAtIndex (i);
-        if (IsHSAModule (*mod))
+        if (mod && IsHSAModule (*mod))
         {
             auto sym_vendor = mod->GetSymbolVendor();
-            if (sym_vendor) {
-                auto sym_file = sym_vendor->GetSymbolFile();
-                if (sym_file) {
-                    auto kernel_name = static_cast<SymbolFileAMDHSA*>(sym_file)->GetKernelName();
-
-                    auto& target = GetProcess()->GetTarget();
-                    SearchFilterSP filter_sp (new SearchFilterForUnconstrainedSearches(target.shared_from_this()));
-                    BreakpointResolverSP resolver_sp (new HSABreakpointResolver(nullptr, kernel_name));
-                    target.CreateBreakpoint(filter_sp, resolver_sp, false, false, false);
-                }
+            SymbolFileAMDHSA* sym_file = nullptr;
+            if (sym_vendor)
+                sym_file = static_cast<SymbolFileAMDHSA*>(sym_vendor->GetSymbolFile());
+
+            // A code object is loaded when the GPU starts running it, so the
+            // last one loaded is the current one until the process says otherwise
+            {
+                Mutex::Locker hsa_locker (m_hsa_modules_mutex);
+                HSAModule& hsa_module = m_hsa_modules[mod.get()];
+                hsa_module.m_module_sp = mod;
+                hsa_module.m_symbol_file = sym_file;
+                m_current_module = hsa_module;
             }
 
+            if (sym_file && m_break_all_kernels) {
+                auto kernel_name = sym_file->GetKernelName();
+
+                auto& target = GetProcess()->GetTarget();
+                SearchFilterSP filter_sp (new SearchFilterForUnconstrainedSearches(target.shared_from_this()));
+                BreakpointResolverSP resolver_sp (new HSABreakpointResolver(nullptr, kernel_name));
+                BreakpointSP bp_sp = target.CreateBreakpoint(filter_sp, resolver_sp, false, false, false);
+                if (bp_sp)
+                    AddKernelBreakpoint(bp_sp->GetID(), kernel_name);
+            }
         }
     }
 }
 
+void
+HSARuntime::ModulesDidUnload (const ModuleList &module_list)
+{
+    Mutex::Locker locker (module_list.GetMutex ());
+    Mutex::Locker hsa_locker (m_hsa_modules_mutex);
+
+    size_t num_modules = module_list.GetSize();
+    for (size_t i = 0; i < num_modules; i++)
+    {
+        auto mod = module_list.GetModuleAtIndex (i);
+        if (!mod || m_hsa_modules.erase (mod.get()) == 0)
+            continue;
+
+        if (m_current_module.m_module_sp == mod)
+            m_current_module = HSAModule();
+    }
+}
+
+void
+HSARuntime::SetCurrentHSAModule (const ModuleSP& module_sp)
+{
+    Mutex::Locker hsa_locker (m_hsa_modules_mutex);
+
+    auto pos = m_hsa_modules.find (module_sp.get());
+    if (pos != m_hsa_modules.end())
+        m_current_module = pos->second;
+}
+
+ModuleSP
+HSARuntime::GetCurrentHSAModule ()
+{
+    Mutex::Locker hsa_locker (m_hsa_modules_mutex);
+    return m_current_module.m_module_sp;
+}
+
+SymbolFileAMDHSA*
+HSARuntime::GetCurrentSymbolFile ()
+{
+    Mutex::Locker hsa_locker (m_hsa_modules_mutex);
+    return m_current_module.m_symbol_file;
+}
+
+size_t
+HSARuntime::GetNumHSAModules ()
+{
+    Mutex::Locker hsa_locker (m_hsa_modules_mutex);
+    return m_hsa_modules.size();
+}
 
 void 
 HSARuntime::SetBreakAllKernels (bool do_break) {
     m_break_all_kernels = do_break;
+    UpdateDispatchFilter();
+}
+
+void
+HSARuntime::AddKernelBreakpoint (break_id_t break_id, const ConstString& kernel_name) {
+    Mutex::Locker hsa_locker (m_hsa_modules_mutex);
+    m_kernel_breakpoints[break_id] = kernel_name;
+}
+
+void
+HSARuntime::UpdateDispatchFilter () {
+    Process* process = GetProcess();
+    if (!process)
+        return;
+
+    bool all_kernels = m_break_all_kernels;
+    std::vector<std::string> kernel_names;
+    {
+        Mutex::Locker hsa_locker (m_hsa_modules_mutex);
+        auto pos = m_kernel_breakpoints.begin();
+        while (pos != m_kernel_breakpoints.end()) {
+            BreakpointSP bp_sp = process->GetTarget().GetBreakpointByID(pos->first);
+            if (!bp_sp) {
+                pos = m_kernel_breakpoints.erase(pos);
+                continue;
+            }
+
+            if (bp_sp->IsEnabled()) {
+                if (pos->second.IsEmpty())
+                    all_kernels = true;
+                else
+                    kernel_names.push_back(pos->second.GetCString());
+            }
+            ++pos;
+        }
+
+        // Unresolved breakpoints and breakpoints in code objects need the
+        // dispatches of every kernel
+        BreakpointList& breakpoints = process->GetTarget().GetBreakpointList();
+        Mutex::Locker bp_locker;
+        breakpoints.GetListMutex(bp_locker);
+        for (size_t i=0; i < breakpoints.GetSize() && !all_kernels; ++i) {
+            BreakpointSP bp_sp = breakpoints.GetBreakpointAtIndex(i);
+            if (!bp_sp || !bp_sp->IsEnabled() || m_kernel_breakpoints.count(bp_sp->GetID()))
+                continue;
+
+            if (bp_sp->GetNumLocations() == 0)
+                all_kernels = true;
+            for (size_t j=0; j < bp_sp->GetNumLocations() && !all_kernels; ++j) {
+                ModuleSP module_sp = bp_sp->GetLocationAtIndex(j)->GetAddress().GetModule();
+                if (module_sp && IsHSAModule(*module_sp))
+                    all_kernels = true;
+            }
+        }
+    }
+
+    if (all_kernels)
+        kernel_names.clear();
+    std::sort(kernel_names.begin(), kernel_names.end());
+    if (m_dispatch_filter_sent && all_kernels == m_sent_all_kernels && kernel_names == m_sent_kernel_names)
+        return;
+
+    // Processes without an HSA agent do not take filters, that is fine.
+    // They are not asked again until the filter changes.
+    m_dispatch_filter_sent = true;
+    m_sent_all_kernels = all_kernels;
+    m_sent_kernel_names = kernel_names;
+
+    Error error = process->SetHSADispatchFilter(all_kernels, kernel_names);
+    if (error.Fail()) {
+        Log *log (GetLogIfAnyCategoriesSet (LIBLLDB_LOG_BREAKPOINTS));
+        if (log)
+            log->Printf ("HSARuntime::%s: %s", __FUNCTION__, error.AsCString());
+    }
+}
+
+void
+HSARuntime::ProcessBreakpointEvents () {
+    Process* process = GetProcess();
+    if (!process)
+        return;
+
+    bool is_changed = !m_dispatch_filter_sent;
+    EventSP event_sp;
+    while (m_breakpoint_listener.GetNextEvent(event_sp)) {
+        is_changed = true;
+
+        const BreakpointEventType event_type = Breakpoint::BreakpointEventData::GetBreakpointEventTypeFromEvent(event_sp);
+        BreakpointSP bp_sp = Breakpoint::BreakpointEventData::GetBreakpointFromEvent(event_sp);
+        if (!bp_sp)
+            continue;
+
+        if (event_type == eBreakpointEventTypeRemoved) {
+            auto pos = m_condition_breakpoints.begin();
+            while (pos != m_condition_breakpoints.end()) {
+                if (pos->second == bp_sp->GetID())
+                    pos = m_condition_breakpoints.erase(pos);
+                else
+                    ++pos;
+            }
+        }
+        else if (event_type == eBreakpointEventTypeLocationsAdded) {
+            // The agent would run the other breakpoint's condition for this one too
+            const size_t num_locations = Breakpoint::BreakpointEventData::GetNumBreakpointLocationsFromEvent(event_sp);
+            for (size_t i=0; i < num_locations; ++i) {
+                BreakpointLocationSP loc_sp = Breakpoint::BreakpointEventData::GetBreakpointLocationAtIndexFromEvent(event_sp, i);
+                if (!loc_sp)
+                    continue;
+
+                auto pos = m_condition_breakpoints.find(loc_sp->GetLoadAddress());
+                if (pos == m_condition_breakpoints.end() || pos->second == bp_sp->GetID())
+                    continue;
+
+                StreamSP error_sp = process->GetTarget().GetDebugger().GetAsyncErrorStream();
+                error_sp->Printf("warning: breakpoint %d has a location at 0x%" PRIx64 ", the HSA agent "
+                                 "applies the condition of breakpoint %d there\n",
+                                 bp_sp->GetID(), loc_sp->GetLoadAddress(), pos->second);
+                error_sp->Flush();
+            }
+        }
+    }
+
+    if (is_changed)
+        UpdateDispatchFilter();
+}
+
+void
+HSARuntime::SetConditionBreakpoint (addr_t addr, break_id_t break_id) {
+    if (break_id == LLDB_INVALID_BREAK_ID)
+        m_condition_breakpoints.erase(addr);
+    else
+        m_condition_breakpoints[addr] = break_id;
 }
 
 bool 
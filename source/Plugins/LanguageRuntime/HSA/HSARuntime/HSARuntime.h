@@ -10,12 +10,19 @@
 #ifndef liblldb_HSARuntime_h_
 #define liblldb_HSARuntime_h_
 
+#include <map>
+#include <unordered_map>
+
 #include "lldb/lldb-private.h"
+#include "lldb/Core/Listener.h"
+#include "lldb/Host/Mutex.h"
 #include "lldb/Target/CPPLanguageRuntime.h"
 #include "lldb/Target/LanguageRuntime.h"
 #include "lldb/Core/Module.h"
 #include "lldb/Symbol/Type.h"
 
+class SymbolFileAMDHSA;
+
 namespace lldb_private {
 
 class HSARuntime : public lldb_private::CPPLanguageRuntime
@@ -27,8 +34,69 @@ public:
     void
     ModulesDidLoad (const lldb_private::ModuleList &module_list) override;
 
+    void
+    ModulesDidUnload (const lldb_private::ModuleList &module_list) override;
+
     void SetBreakAllKernels (bool do_break);
 
+    //------------------------------------------------------------------
+    // Dispatch filter
+    //
+    // The agent only debugs the dispatches of kernels with breakpoints,
+    // unless breakpoints are set on all kernels. HSA breakpoints record
+    // their kernel here and the filter is sent whenever they change.
+    //
+    // Other breakpoints need every dispatch: one without locations may be
+    // waiting for the code object of a kernel that was never debugged,
+    // and one in a code object is a PC the agent checks in whichever
+    // kernel runs. The runtime follows the target's breakpoint events and
+    // the filter selects all kernels while there are such breakpoints.
+    //------------------------------------------------------------------
+
+    // Record the kernel an HSA breakpoint is for, an empty name for any kernel
+    void
+    AddKernelBreakpoint (lldb::break_id_t break_id, const ConstString& kernel_name);
+
+    // Send the kernels of the enabled HSA breakpoints to the agent, if
+    // they changed since the filter was last sent
+    void
+    UpdateDispatchFilter ();
+
+    // Called by the process before it resumes, handles the breakpoint
+    // events since the last resume
+    void
+    ProcessBreakpointEvents ();
+
+    // The agent keeps one condition per address. Record which breakpoint
+    // set the condition at an address, LLDB_INVALID_BREAK_ID for none, to
+    // warn when another breakpoint gets a location there.
+    void
+    SetConditionBreakpoint (lldb::addr_t addr, lldb::break_id_t break_id);
+
+    //------------------------------------------------------------------
+    // Code objects
+    //
+    // The runtime indexes the amdgcn modules of the target as they load
+    // and unload, so finding the code object of the running dispatch does
+    // not scan every image of the host application.
+    //------------------------------------------------------------------
+
+    // Called by the process when the code object of the running dispatch changes
+    void
+    SetCurrentHSAModule (const lldb::ModuleSP& module_sp);
+
+    // The code object of the running dispatch, the last one loaded if the
+    // process has not said which one is running
+    lldb::ModuleSP
+    GetCurrentHSAModule ();
+
+    // The symbol file of the current code object
+    SymbolFileAMDHSA*
+    GetCurrentSymbolFile ();
+
+    size_t
+    GetNumHSAModules ();
+
 
     //------------------------------------------------------------------
     // Static Functions
@@ -69,7 +137,25 @@ private:
     bool IsHSAModule (const lldb_private::Module& module_sp);
 
     HSARuntime(Process *process);
+    // Kernels only get an entry breakpoint as they load after "hsa kernel breakpoint all enable"
     bool m_break_all_kernels = false;
+
+    std::map<lldb::break_id_t, ConstString> m_kernel_breakpoints;
+
+    Listener m_breakpoint_listener;
+    bool m_dispatch_filter_sent = false;
+    bool m_sent_all_kernels = false;
+    std::vector<std::string> m_sent_kernel_names;
+    std::map<lldb::addr_t, lldb::break_id_t> m_condition_breakpoints;
+
+    struct HSAModule {
+        lldb::ModuleSP m_module_sp;
+        SymbolFileAMDHSA* m_symbol_file;
+    };
+
+    Mutex m_hsa_modules_mutex;
+    std::unordered_map<Module*, HSAModule> m_hsa_modules;
+    HSAModule m_current_module;
 };
 
 } // namespace lldb_private
@@ -0,0 +1,287 @@
+//===-- HsaBreakpointCondition.cpp ------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "HsaBreakpointCondition.h"
+
+using namespace lldb_private;
+
+namespace {
+    // A recursive descent compiler from condition expressions to the
+    // agent's postfix stack program
+    //
+    //   expr    := and ('||' and)*
+    //   and     := unary ('&&' unary)*
+    //   unary   := '!' unary | compare
+    //   compare := value [cmp value | 'in' value '..' value]
+    //   value   := term (('%' | '&') term)*
+    //   term    := number | name | '(' expr ')'
+    class ConditionCompiler {
+    public:
+        ConditionCompiler (llvm::StringRef text, std::vector<HsailConditionOp>& ops)
+            : m_text (text), m_pos (0), m_ops (ops) {}
+
+        bool Compile (std::string& error) {
+            m_ops.clear();
+            if (!ParseExpr()) {
+                error = m_error;
+                return false;
+            }
+            SkipSpace();
+            if (m_pos != m_text.size()) {
+                error = "unexpected '" + m_text.substr(m_pos).str() + "'";
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        void SkipSpace () {
+            while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos])))
+                ++m_pos;
+        }
+
+        bool Accept (llvm::StringRef token) {
+            SkipSpace();
+            if (!m_text.substr(m_pos).startswith(token))
+                return false;
+            m_pos += token.size();
+            return true;
+        }
+
+        bool Fail (const std::string& error) {
+            if (m_error.empty())
+                m_error = error;
+            return false;
+        }
+
+        void Emit (HsailConditionOpCode op, uint64_t operand = 0) {
+            HsailConditionOp condition_op;
+            condition_op.m_op = op;
+            condition_op.m_reserved = 0;
+            condition_op.m_operand = operand;
+            m_ops.push_back(condition_op);
+        }
+
+        bool ParseExpr () {
+            if (!ParseAnd()) return false;
+            while (Accept("||")) {
+                if (!ParseAnd()) return false;
+                Emit(HSAIL_CONDITION_OP_OR);
+            }
+            return true;
+        }
+
+        bool ParseAnd () {
+            if (!ParseUnary()) return false;
+            while (Accept("&&")) {
+                if (!ParseUnary()) return false;
+                Emit(HSAIL_CONDITION_OP_AND);
+            }
+            return true;
+        }
+
+        bool ParseUnary () {
+            SkipSpace();
+            // "!=" is only ever an operator after a value
+            if (Accept("!")) {
+                if (!ParseUnary()) return false;
+                Emit(HSAIL_CONDITION_OP_NOT);
+                return true;
+            }
+            return ParseCompare();
+        }
+
+        bool ParseCompare () {
+            if (!ParseValue()) return false;
+
+            // Longer operators first, so "<=" is not taken for "<"
+            static const struct { const char* token; HsailConditionOpCode op; } k_compares[] = {
+                { "==", HSAIL_CONDITION_OP_EQ }, { "!=", HSAIL_CONDITION_OP_NE },
+                { "<=", HSAIL_CONDITION_OP_LE }, { ">=", HSAIL_CONDITION_OP_GE },
+                { "<",  HSAIL_CONDITION_OP_LT }, { ">",  HSAIL_CONDITION_OP_GT },
+            };
+            for (const auto& compare : k_compares) {
+                if (Accept(compare.token)) {
+                    if (!ParseValue()) return false;
+                    Emit(compare.op);
+                    return true;
+                }
+            }
+
+            SkipSpace();
+            llvm::StringRef rest = m_text.substr(m_pos);
+            if (rest.startswith("in") && (rest.size() == 2 || !IsNameChar(rest[2]))) {
+                m_pos += 2;
+                if (!ParseValue()) return false;
+                if (!Accept("..")) return Fail("expected '..' in range");
+                if (!ParseValue()) return false;
+                Emit(HSAIL_CONDITION_OP_IN_RANGE);
+            }
+            return true;
+        }
+
+        bool ParseValue () {
+            if (!ParseTerm()) return false;
+            while (true) {
+                if (Accept("%")) {
+                    if (!ParseTerm()) return false;
+                    Emit(HSAIL_CONDITION_OP_MOD);
+                }
+                else if (!m_text.substr(m_pos).ltrim().startswith("&&") && Accept("&")) {
+                    if (!ParseTerm()) return false;
+                    Emit(HSAIL_CONDITION_OP_BIT_AND);
+                }
+                else {
+                    return true;
+                }
+            }
+        }
+
+        static bool IsNameChar (char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+        }
+
+        bool ParseTerm () {
+            SkipSpace();
+            if (m_pos >= m_text.size())
+                return Fail("unexpected end of condition");
+
+            if (Accept("(")) {
+                if (!ParseExpr()) return false;
+                if (!Accept(")")) return Fail("expected ')'");
+                return true;
+            }
+
+            if (std::isdigit(static_cast<unsigned char>(m_text[m_pos]))) {
+                std::string number = m_text.substr(m_pos).str();
+                char* end = nullptr;
+                errno = 0;
+                uint64_t value = std::strtoull(number.c_str(), &end, 0);
+                if (errno == ERANGE)
+                    return Fail("number out of range: " + number.substr(0, end - number.c_str()));
+                // Stop at a range's "..", strtoull does not take it
+                m_pos += end - number.c_str();
+                Emit(HSAIL_CONDITION_OP_CONST, value);
+                return true;
+            }
+
+            std::size_t end = m_pos;
+            while (end < m_text.size() && IsNameChar(m_text[end]) &&
+                   !m_text.substr(end).startswith(".."))
+                ++end;
+            llvm::StringRef name = m_text.slice(m_pos, end);
+            if (name.empty())
+                return Fail("unexpected '" + m_text.substr(m_pos).str() + "'");
+            m_pos = end;
+
+            if (name == "lane") { Emit(HSAIL_CONDITION_OP_LANE); return true; }
+            if (name == "exec") { Emit(HSAIL_CONDITION_OP_EXEC_MASK); return true; }
+            if (name == "active") { Emit(HSAIL_CONDITION_OP_ACTIVE_LANES); return true; }
+            if (name == "hits") { Emit(HSAIL_CONDITION_OP_HIT_COUNT); return true; }
+
+            std::pair<llvm::StringRef, llvm::StringRef> parts = name.split('.');
+            HsailConditionOpCode op;
+            if (parts.first == "wg")
+                op = HSAIL_CONDITION_OP_WORKGROUP_ID;
+            else if (parts.first == "wi")
+                op = HSAIL_CONDITION_OP_WORKITEM_ID;
+            else if (parts.first == "gid")
+                op = HSAIL_CONDITION_OP_GLOBAL_ID;
+            else
+                return Fail("unknown value '" + name.str() + "'");
+
+            if (parts.second.size() != 1 || parts.second[0] < 'x' || parts.second[0] > 'z')
+                return Fail("expected '" + parts.first.str() + ".x', '.y' or '.z'");
+
+            Emit(op, parts.second[0] - 'x');
+            return true;
+        }
+
+        llvm::StringRef m_text;
+        std::size_t m_pos;
+        std::vector<HsailConditionOp>& m_ops;
+        std::string m_error;
+    };
+}
+
+bool HsaBreakpointCondition::Compile (llvm::StringRef text, std::vector<HsailConditionOp>& ops, std::string& error) {
+    ops.clear();
+    if (text.trim().empty())
+        return true;
+
+    ConditionCompiler compiler (text, ops);
+    if (!compiler.Compile(error))
+        return false;
+
+    // The agent rejects programs it cannot run, say why here instead
+    int depth = 0;
+    int max_depth = 0;
+    for (const auto& op : ops) {
+        switch (op.m_op) {
+        case HSAIL_CONDITION_OP_NOT: break;
+        case HSAIL_CONDITION_OP_IN_RANGE: depth -= 2; break;
+        case HSAIL_CONDITION_OP_CONST: case HSAIL_CONDITION_OP_WORKGROUP_ID:
+        case HSAIL_CONDITION_OP_WORKITEM_ID: case HSAIL_CONDITION_OP_GLOBAL_ID:
+        case HSAIL_CONDITION_OP_LANE: case HSAIL_CONDITION_OP_EXEC_MASK:
+        case HSAIL_CONDITION_OP_ACTIVE_LANES: case HSAIL_CONDITION_OP_HIT_COUNT:
+            max_depth = std::max(max_depth, ++depth); break;
+        default: --depth; break;
+        }
+    }
+
+    if (ops.size() > HSAIL_MAX_CONDITION_OPS || max_depth > HSAIL_MAX_CONDITION_STACK) {
+        error = "condition is too complex for the agent";
+        return false;
+    }
+    return true;
+}
+
+JSONObject::SP
+lldb_private::HsaBreakpointConditionToJSON (const HsaBreakpointCondition& condition) {
+    JSONArray::SP ops_sp = std::make_shared<JSONArray>();
+    for (const auto& op : condition.ops) {
+        JSONArray::SP op_sp = std::make_shared<JSONArray>();
+        op_sp->AppendObject(std::make_shared<JSONNumber>(static_cast<uint64_t>(op.m_op)));
+        op_sp->AppendObject(std::make_shared<JSONNumber>(op.m_operand));
+        ops_sp->AppendObject(op_sp);
+    }
+
+    JSONObject::SP condition_sp = std::make_shared<JSONObject>();
+    condition_sp->SetObject("addr", std::make_shared<JSONNumber>(static_cast<uint64_t>(condition.addr)));
+    condition_sp->SetObject("ops", ops_sp);
+    return condition_sp;
+}
+
+bool
+lldb_private::HsaBreakpointConditionFromJSON (const StructuredData::ObjectSP& object_sp, HsaBreakpointCondition& condition) {
+    StructuredData::Dictionary* dict = object_sp ? object_sp->GetAsDictionary() : nullptr;
+    StructuredData::Array* ops = nullptr;
+    if (!dict || !dict->GetValueForKeyAsInteger("addr", condition.addr) ||
+        !dict->GetValueForKeyAsArray("ops", ops) || ops->GetSize() > HSAIL_MAX_CONDITION_OPS)
+        return false;
+
+    condition.ops.clear();
+    for (size_t i=0; i < ops->GetSize(); ++i) {
+        StructuredData::Array* op_array = nullptr;
+        HsailConditionOp op;
+        std::memset(&op, 0, sizeof(op));
+        if (!ops->GetItemAtIndexAsArray(i, op_array) || op_array->GetSize() != 2 ||
+            !op_array->GetItemAtIndexAsInteger(0, op.m_op) ||
+            !op_array->GetItemAtIndexAsInteger(1, op.m_operand))
+            return false;
+        condition.ops.push_back(op);
+    }
+    return true;
+}
@@ -0,0 +1,63 @@
+//===-- HsaBreakpointCondition.h --------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef liblldb_HsaBreakpointCondition_h_
+#define liblldb_HsaBreakpointCondition_h_
+
+// C Includes
+// C++ Includes
+#include <string>
+#include <vector>
+// Other libraries and framework includes
+#include "llvm/ADT/StringRef.h"
+// Project includes
+#include "lldb/lldb-types.h"
+#include "lldb/lldb-defines.h"
+#include "lldb/Core/StructuredData.h"
+#include "lldb/Utility/JSON.h"
+#include "CommunicationControl.h"
+
+namespace lldb_private {
+    //------------------------------------------------------------------
+    /// A condition on an HSA breakpoint, evaluated by the agent for
+    /// every wave that traps there. Waves it does not hold for resume
+    /// without the dispatch stopping.
+    ///
+    /// Conditions are written as expressions over the wave and its
+    /// lanes and compiled to the agent's stack program, for example
+    ///
+    ///     gid.x % 1024 == 0 && wg.y in 2..5
+    ///
+    /// Values are wg.{x,y,z}, wi.{x,y,z}, gid.{x,y,z}, lane, exec,
+    /// active (the number of active lanes) and hits (the waves that
+    /// reached the breakpoint, this one included), and integers.
+    /// Operators are %, &, ==, !=, <, <=, >, >=, "in lo..hi", !, &&,
+    /// || and parentheses. A condition holds for a wave if it holds
+    /// for any of its active lanes.
+    //------------------------------------------------------------------
+    struct HsaBreakpointCondition {
+        lldb::addr_t addr = LLDB_INVALID_ADDRESS; ///< The breakpoint's PC
+        std::vector<HsailConditionOp> ops;        ///< The program, empty for an unconditional breakpoint
+
+        /// Compile a condition, an empty text gives an empty program
+        static bool
+        Compile (llvm::StringRef text, std::vector<HsailConditionOp>& ops, std::string& error);
+    };
+
+    // The jHSABreakpointCondition packet carries a condition as a JSON
+    // object, the program as an array of [op, operand] pairs
+
+    JSONObject::SP
+    HsaBreakpointConditionToJSON (const HsaBreakpointCondition& condition);
+
+    bool
+    HsaBreakpointConditionFromJSON (const StructuredData::ObjectSP& object_sp, HsaBreakpointCondition& condition);
+} // namespace lldb_private
+
+#endif // liblldb_HsaBreakpointCondition_h_
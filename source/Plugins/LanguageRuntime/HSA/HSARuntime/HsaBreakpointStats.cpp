@@ -0,0 +1,180 @@
+//===-- HsaBreakpointStats.cpp ----------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#include "HsaBreakpointStats.h"
+
+using namespace lldb_private;
+
+uint64_t HsaBreakpointStats::GetLaneHits () const {
+    return std::accumulate(lane_hits.begin(), lane_hits.end(), static_cast<uint64_t>(0));
+}
+
+JSONObject::SP
+lldb_private::HsaBreakpointStatsToJSON (const HsaBreakpointStatsTable& table) {
+    JSONArray::SP breakpoints_sp = std::make_shared<JSONArray>();
+    for (const auto& stats : table.breakpoints) {
+        JSONArray::SP lanes_sp = std::make_shared<JSONArray>();
+        for (uint64_t hits : stats.lane_hits)
+            lanes_sp->AppendObject(std::make_shared<JSONNumber>(hits));
+
+        JSONArray::SP work_groups_sp = std::make_shared<JSONArray>();
+        for (const auto& work_group : stats.work_groups) {
+            JSONArray::SP work_group_sp = std::make_shared<JSONArray>();
+            work_group_sp->AppendObject(std::make_shared<JSONNumber>(static_cast<uint64_t>(work_group.m_workGroup.x)));
+            work_group_sp->AppendObject(std::make_shared<JSONNumber>(static_cast<uint64_t>(work_group.m_workGroup.y)));
+            work_group_sp->AppendObject(std::make_shared<JSONNumber>(static_cast<uint64_t>(work_group.m_workGroup.z)));
+            work_group_sp->AppendObject(std::make_shared<JSONNumber>(work_group.m_waveHits));
+            work_group_sp->AppendObject(std::make_shared<JSONNumber>(work_group.m_laneHits));
+            work_groups_sp->AppendObject(work_group_sp);
+        }
+
+        JSONObject::SP stats_sp = std::make_shared<JSONObject>();
+        stats_sp->SetObject("addr", std::make_shared<JSONNumber>(static_cast<uint64_t>(stats.addr)));
+        stats_sp->SetObject("mode", std::make_shared<JSONNumber>(static_cast<uint64_t>(stats.mode)));
+        stats_sp->SetObject("waves", std::make_shared<JSONNumber>(stats.wave_hits));
+        stats_sp->SetObject("lanes", lanes_sp);
+        stats_sp->SetObject("num_work_groups", std::make_shared<JSONNumber>(stats.num_work_groups));
+        stats_sp->SetObject("work_groups", work_groups_sp);
+        breakpoints_sp->AppendObject(stats_sp);
+    }
+
+    JSONObject::SP table_sp = std::make_shared<JSONObject>();
+    table_sp->SetObject("truncated", std::make_shared<JSONNumber>(static_cast<uint64_t>(table.truncated)));
+    table_sp->SetObject("breakpoints", breakpoints_sp);
+    return table_sp;
+}
+
+static bool
+BreakpointStatsFromJSON (StructuredData::Dictionary* dict, HsaBreakpointStats& stats) {
+    StructuredData::Array* lanes = nullptr;
+    StructuredData::Array* work_groups = nullptr;
+    if (!dict || !dict->GetValueForKeyAsInteger("addr", stats.addr) ||
+        !dict->GetValueForKeyAsInteger("mode", stats.mode) ||
+        !dict->GetValueForKeyAsInteger("waves", stats.wave_hits) ||
+        !dict->GetValueForKeyAsInteger("num_work_groups", stats.num_work_groups) ||
+        !dict->GetValueForKeyAsArray("lanes", lanes) || lanes->GetSize() > HSAIL_WAVEFRONT_SIZE ||
+        !dict->GetValueForKeyAsArray("work_groups", work_groups))
+        return false;
+
+    stats.lane_hits.assign(lanes->GetSize(), 0);
+    for (size_t i=0; i < lanes->GetSize(); ++i) {
+        if (!lanes->GetItemAtIndexAsInteger(i, stats.lane_hits[i]))
+            return false;
+    }
+
+    stats.work_groups.clear();
+    for (size_t i=0; i < work_groups->GetSize(); ++i) {
+        StructuredData::Array* work_group_array = nullptr;
+        HsailWorkGroupHits work_group;
+        std::memset(&work_group, 0, sizeof(work_group));
+        if (!work_groups->GetItemAtIndexAsArray(i, work_group_array) || work_group_array->GetSize() != 5 ||
+            !work_group_array->GetItemAtIndexAsInteger(0, work_group.m_workGroup.x) ||
+            !work_group_array->GetItemAtIndexAsInteger(1, work_group.m_workGroup.y) ||
+            !work_group_array->GetItemAtIndexAsInteger(2, work_group.m_workGroup.z) ||
+            !work_group_array->GetItemAtIndexAsInteger(3, work_group.m_waveHits) ||
+            !work_group_array->GetItemAtIndexAsInteger(4, work_group.m_laneHits))
+            return false;
+        stats.work_groups.push_back(work_group);
+    }
+    return true;
+}
+
+bool
+lldb_private::HsaBreakpointStatsFromJSON (const StructuredData::ObjectSP& object_sp, HsaBreakpointStatsTable& table) {
+    StructuredData::Dictionary* dict = object_sp ? object_sp->GetAsDictionary() : nullptr;
+    StructuredData::Array* breakpoints = nullptr;
+    uint64_t truncated = 0;
+    if (!dict || !dict->GetValueForKeyAsInteger("truncated", truncated) ||
+        !dict->GetValueForKeyAsArray("breakpoints", breakpoints))
+        return false;
+
+    table.truncated = truncated != 0;
+    table.breakpoints.clear();
+    for (size_t i=0; i < breakpoints->GetSize(); ++i) {
+        StructuredData::Dictionary* stats_dict = nullptr;
+        HsaBreakpointStats stats;
+        if (!breakpoints->GetItemAtIndexAsDictionary(i, stats_dict) || !BreakpointStatsFromJSON(stats_dict, stats))
+            return false;
+        table.breakpoints.push_back(stats);
+    }
+    return true;
+}
+
+bool
+lldb_private::HsaBreakpointStatsTryCopy (const uint8_t* buffer, std::size_t size, std::vector<uint8_t>& copy) {
+    if (!buffer || size < sizeof(HsailBreakpointStatsHeader))
+        return false;
+
+    // m_sequence is odd while the agent writes, a copy is only good if it
+    // did not change while the copy was taken
+    const auto header = reinterpret_cast<const HsailBreakpointStatsHeader*>(buffer);
+    const uint32_t sequence = __atomic_load_n(&header->m_sequence, __ATOMIC_ACQUIRE);
+    if (sequence & 1)
+        return false;
+
+    const HsailBreakpointStatsHeader copied_header = *header;
+    const std::size_t used = sizeof(HsailBreakpointStatsHeader) +
+                             copied_header.m_numBreakpoints * sizeof(HsailBreakpointStats) +
+                             copied_header.m_numWorkGroups * sizeof(HsailWorkGroupHits);
+    if (used > size)
+        return false;
+    copy.assign(buffer, buffer + used);
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return sequence == __atomic_load_n(&header->m_sequence, __ATOMIC_RELAXED);
+}
+
+bool
+lldb_private::HsaBreakpointStatsFromCopy (const std::vector<uint8_t>& copy, std::size_t max_work_groups,
+                                          HsaBreakpointStatsTable& table) {
+    if (copy.size() < sizeof(HsailBreakpointStatsHeader))
+        return false;
+
+    HsailBreakpointStatsHeader header;
+    std::memcpy(&header, copy.data(), sizeof(header));
+    if (copy.size() < sizeof(HsailBreakpointStatsHeader) +
+                      header.m_numBreakpoints * sizeof(HsailBreakpointStats) +
+                      header.m_numWorkGroups * sizeof(HsailWorkGroupHits))
+        return false;
+
+    const HsailBreakpointStats* stats = reinterpret_cast<const HsailBreakpointStats*>(copy.data() + sizeof(HsailBreakpointStatsHeader));
+    const HsailWorkGroupHits* work_groups = reinterpret_cast<const HsailWorkGroupHits*>(stats + header.m_numBreakpoints);
+
+    table.truncated = header.m_isTruncated != 0;
+    table.breakpoints.clear();
+    for (uint32_t i=0; i < header.m_numBreakpoints; ++i) {
+        // Spare slots may follow the work-groups of a breakpoint, only the
+        // first m_numWorkGroups of its slots are used
+        const HsailBreakpointStats& agent_stats = stats[i];
+        if (agent_stats.m_firstWorkGroup + agent_stats.m_numWorkGroups > header.m_numWorkGroups)
+            return false;
+
+        HsaBreakpointStats bp_stats;
+        bp_stats.addr = agent_stats.m_pc;
+        bp_stats.mode = agent_stats.m_mode;
+        bp_stats.wave_hits = agent_stats.m_waveHits;
+        bp_stats.lane_hits.assign(agent_stats.m_laneHits, agent_stats.m_laneHits + HSAIL_WAVEFRONT_SIZE);
+        bp_stats.num_work_groups = agent_stats.m_numWorkGroups;
+
+        // Only the hottest work-groups are worth sending
+        const HsailWorkGroupHits* first = work_groups + agent_stats.m_firstWorkGroup;
+        bp_stats.work_groups.assign(first, first + agent_stats.m_numWorkGroups);
+        const std::size_t n_kept = std::min(bp_stats.work_groups.size(), max_work_groups);
+        std::partial_sort(bp_stats.work_groups.begin(), bp_stats.work_groups.begin() + n_kept, bp_stats.work_groups.end(),
+                          [] (const HsailWorkGroupHits& a, const HsailWorkGroupHits& b) { return a.m_waveHits > b.m_waveHits; });
+        bp_stats.work_groups.resize(n_kept);
+
+        table.breakpoints.push_back(bp_stats);
+    }
+    return true;
+}
@@ -0,0 +1,73 @@
+//===-- HsaBreakpointStats.h ------------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef liblldb_HsaBreakpointStats_h_
+#define liblldb_HsaBreakpointStats_h_
+
+// C Includes
+// C++ Includes
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+// Other libraries and framework includes
+// Project includes
+#include "lldb/lldb-types.h"
+#include "lldb/lldb-defines.h"
+#include "lldb/Core/StructuredData.h"
+#include "lldb/Utility/JSON.h"
+#include "CommunicationControl.h"
+
+namespace lldb_private {
+    //------------------------------------------------------------------
+    /// The hits of an HSA breakpoint, as counted by the agent for every
+    /// wave that reached it. Trace breakpoints are only counted, the
+    /// agent resumes their waves without stopping the dispatch.
+    //------------------------------------------------------------------
+    struct HsaBreakpointStats {
+        lldb::addr_t addr = LLDB_INVALID_ADDRESS;  ///< The breakpoint's PC
+        uint32_t mode = HSAIL_BREAKPOINT_MODE_STOP; ///< HsailBreakpointMode
+        uint64_t wave_hits = 0;                     ///< Waves that reached the breakpoint
+        std::vector<uint64_t> lane_hits;            ///< How often each lane was active in those waves
+        uint64_t num_work_groups = 0;               ///< Work-groups whose waves reached the breakpoint
+        std::vector<HsailWorkGroupHits> work_groups; ///< The hottest of them, most wave hits first
+
+        uint64_t GetLaneHits () const;
+    };
+
+    struct HsaBreakpointStatsTable {
+        bool truncated = false;     ///< The agent ran out of space for some work-groups
+        std::vector<HsaBreakpointStats> breakpoints;
+    };
+
+    // The jHSABreakpointStats packet carries the table as a JSON object,
+    // work-groups as [x, y, z, waves, lanes] arrays
+
+    JSONObject::SP
+    HsaBreakpointStatsToJSON (const HsaBreakpointStatsTable& table);
+
+    bool
+    HsaBreakpointStatsFromJSON (const StructuredData::ObjectSP& object_sp, HsaBreakpointStatsTable& table);
+
+    // The agent publishes the statistics in shared memory, laid out as
+    // described at HsailBreakpointStatsHeader
+
+    /// Take one copy of the statistics at buffer, which holds size bytes.
+    /// Fails if the agent was writing them while they were copied, or if
+    /// they do not fit in the buffer; the caller tries again later
+    bool
+    HsaBreakpointStatsTryCopy (const uint8_t* buffer, std::size_t size, std::vector<uint8_t>& copy);
+
+    /// Parse a copy taken by HsaBreakpointStatsTryCopy, keeping the
+    /// max_work_groups hottest work-groups of each breakpoint
+    bool
+    HsaBreakpointStatsFromCopy (const std::vector<uint8_t>& copy, std::size_t max_work_groups,
+                                HsaBreakpointStatsTable& table);
+} // namespace lldb_private
+
+#endif // liblldb_HsaBreakpointStats_h_
@@ -1,7 +1,10 @@
 #include <cstring>
+#include <errno.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 #include "CommunicationParams.h"
 #include "CommunicationControl.h"
@@ -41,26 +44,160 @@ void HsaPacket::dispatch (int fd) const {
   write(fd, reinterpret_cast<const void*>(&m_packet), sizeof(m_packet));
 }
 
-HsaDebugComms::HsaDebugComms () {
+HsaDebugComms::HsaDebugComms ()
+  : remove_fifos(false),
+    read_fd(-1),
+    write_fd(-1),
+    epoll_fd(-1),
+    shutdown_fd(-1),
+    is_shutdown(false) {
+}
+
+HsaDebugComms::~HsaDebugComms () {
+  closeFds();
+
+  // The session directory is ours, nobody else will clean it up
+  if (remove_fifos) {
+    unlink(GetDebugSessionFifoName(gs_AgentToGdbFifoName, fifo_dir).c_str());
+    unlink(GetDebugSessionFifoName(gs_GdbToAgentFifoName, fifo_dir).c_str());
+    rmdir(fifo_dir.c_str());
+  }
+}
+
+void HsaDebugComms::closeWriteEnd() {
+  std::lock_guard<std::mutex> guard(write_mutex);
+  if (write_fd >= 0) close(write_fd);
+  write_fd = -1;
+}
 
+void HsaDebugComms::closeFds() {
+  closeWriteEnd();
+  for (int* fd : {&read_fd, &epoll_fd, &shutdown_fd}) {
+    if (*fd >= 0) close(*fd);
+    *fd = -1;
+  }
 }
 
-void HsaDebugComms::init() {
-  mkfifo(gs_GdbToAgentFifoName, g_FIFO_PERMISSIONS);
-  mkfifo(gs_AgentToGdbFifoName, g_FIFO_PERMISSIONS);
+void HsaDebugComms::init(const std::string& fifo_dir, bool owns_fifo_dir) {
+  this->fifo_dir = fifo_dir;
+  read_fifo_name = GetDebugSessionFifoName(gs_AgentToGdbFifoName, fifo_dir);
+  write_fifo_name = GetDebugSessionFifoName(gs_GdbToAgentFifoName, fifo_dir);
+  remove_fifos = owns_fifo_dir;
+
+  // Without FIFOs readPacket fails right away, and with the names gone
+  // nothing that is not our FIFO is ever opened
+  for (const std::string* name : {&write_fifo_name, &read_fifo_name}) {
+    if (!CreateDebugSessionFifo(*name)) {
+      LogMsg("HsaDebugComms::init: could not create %s (%d), not connecting to the agent", name->c_str(), errno);
+      read_fifo_name.clear();
+      write_fifo_name.clear();
+      return;
+    }
+  }
+
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  shutdown_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (epoll_fd < 0 || shutdown_fd < 0) {
+    LogMsg("HsaDebugComms::init: could not create epoll/eventfd descriptors");
+    return;
+  }
+
+  epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.fd = shutdown_fd;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, shutdown_fd, &ev);
 
-  read_fd = open(gs_AgentToGdbFifoName, O_RDONLY | O_NONBLOCK);
-  write_fd = open(gs_GdbToAgentFifoName, O_WRONLY);
+  openReadEnd();
+
+  // The write end is opened once the agent has connected, see readPacket.
+  // Opening it here would block this thread until an agent is loaded,
+  // which may never happen.
 }
 
-void HsaDebugComms::dispatchPacket (const HsaPacket& packet) {
+bool HsaDebugComms::openReadEnd() {
+  if (read_fd >= 0) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, read_fd, nullptr);
+    close(read_fd);
+  }
+
+  read_fd = open(read_fifo_name.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC | O_NOFOLLOW);
+  if (read_fd < 0) {
+    LogMsg("HsaDebugComms: could not open %s", read_fifo_name.c_str());
+    return false;
+  }
+
+  epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.fd = read_fd;
+  return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, read_fd, &ev) == 0;
+}
+
+bool HsaDebugComms::openWriteEnd() {
+  if (write_fd >= 0) return true;
+
+  // Non-blocking open fails with ENXIO instead of hanging if the agent
+  // hasn't opened its read end yet. Writes themselves stay blocking.
+  write_fd = open(write_fifo_name.c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC | O_NOFOLLOW);
+  if (write_fd < 0) {
+    LogMsg("HsaDebugComms: agent has not opened %s yet", write_fifo_name.c_str());
+    return false;
+  }
+
+  fcntl(write_fd, F_SETFL, fcntl(write_fd, F_GETFL) & ~O_NONBLOCK);
+  return true;
+}
+
+void HsaDebugComms::shutdown() {
+  is_shutdown = true;
+  if (shutdown_fd >= 0) {
+    uint64_t one = 1;
+    write(shutdown_fd, &one, sizeof(one));
+  }
+}
+
+bool HsaDebugComms::dispatchPacket (const HsaPacket& packet) {
+  std::lock_guard<std::mutex> guard(write_mutex);
+  if (!openWriteEnd()) {
+    LogMsg("HsaDebugComms::dispatchPacket: no agent connected, dropping command %d",
+           static_cast<int>(packet.getCommand()));
+    return false;
+  }
   packet.dispatch(write_fd);
+  return true;
 }
 
 std::unique_ptr<HsaDebugNotificationPacket> HsaDebugComms::readPacket () {
-  return HsaDebugNotificationPacket::readFromFd(read_fd);
-}
+  while (!is_shutdown) {
+    // A packet may already be sitting in the FIFO from a previous wakeup
+    auto packet = HsaDebugNotificationPacket::readFromFd(read_fd);
+    if (packet) {
+      std::lock_guard<std::mutex> guard(write_mutex);
+      openWriteEnd();
+      return packet;
+    }
+
+    epoll_event ev;
+    int n_events = epoll_wait(epoll_fd, &ev, 1, -1);
+    if (n_events < 0) {
+      if (errno == EINTR) continue;
+      LogMsg("HsaDebugComms::readPacket: epoll_wait failed (%d)", errno);
+      return nullptr;
+    }
+
+    if (n_events == 0 || ev.data.fd == shutdown_fd) continue;
+
+    if ((ev.events & EPOLLHUP) && !(ev.events & EPOLLIN)) {
+      // The agent closed its end. Drop our write end too, since writing to
+      // a FIFO without a reader raises SIGPIPE, and reopen the read end so
+      // that the next agent to load can connect and we stop getting HUPs.
+      LogMsg("HsaDebugComms::readPacket: agent disconnected");
+      closeWriteEnd();
+      openReadEnd();
+    }
+  }
 
+  return nullptr;
+}
 
 std::unique_ptr<HsaDebugNotificationPacket> HsaDebugNotificationPacket::readFromFd (int fd) {
   HsailNotificationPayload packet;
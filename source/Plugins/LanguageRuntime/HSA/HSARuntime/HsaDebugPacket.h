@@ -14,6 +14,8 @@
 #include <string>
 #include <cstdio>
 #include <memory>
+#include <atomic>
+#include <mutex>
 #include "CommunicationControl.h"
 
 class HsaPacket {
@@ -23,6 +25,7 @@ public:
   void dispatch (int stream) const;
 
   bool isCreateBreakpoint() const { return m_packet.m_command == HSAIL_COMMAND_CREATE_BREAKPOINT; }
+  HsailCommand getCommand() const { return m_packet.m_command; }
 
 protected:
   HsailCommandPacket m_packet;
@@ -91,6 +94,45 @@ public:
   }
 };
 
+class HsaBreakpointBatchPacket : public HsaPacket {
+public:
+  HsaBreakpointBatchPacket () {
+    m_packet.m_command = HSAIL_COMMAND_BREAKPOINT_BATCH;
+  }
+};
+
+class HsaReadBatchPacket : public HsaPacket {
+public:
+  HsaReadBatchPacket () {
+    m_packet.m_command = HSAIL_COMMAND_READ_BATCH;
+  }
+};
+
+// The dispatch filter goes out as a begin packet, one packet per kernel
+// and an end packet. An empty kernel name selects every kernel.
+class HsaDispatchFilterBeginPacket : public HsaPacket {
+public:
+  HsaDispatchFilterBeginPacket () {
+    m_packet.m_command = HSAIL_COMMAND_DISPATCH_FILTER_BEGIN;
+  }
+};
+
+class HsaDispatchFilterKernelPacket : public HsaPacket {
+public:
+  HsaDispatchFilterKernelPacket (std::string kernel_name) {
+    m_packet.m_command = HSAIL_COMMAND_DISPATCH_FILTER_KERNEL;
+
+    strncpy(m_packet.m_kernelName, kernel_name.c_str(), AGENT_MAX_FUNC_NAME_LEN);
+  }
+};
+
+class HsaDispatchFilterEndPacket : public HsaPacket {
+public:
+  HsaDispatchFilterEndPacket () {
+    m_packet.m_command = HSAIL_COMMAND_DISPATCH_FILTER_END;
+  }
+};
+
 class HsaSetLoggingPacket : public HsaPacket {
 public:
   HsaSetLoggingPacket (HsailLogCommand logging_command) {
@@ -122,13 +164,44 @@ public:
 class HsaDebugComms {
 public:
   HsaDebugComms();
-  void init();
-  void dispatchPacket (const HsaPacket& packet);
+  ~HsaDebugComms();
+  // Create and open the FIFOs of a debug session, see GetDebugSessionFifoName.
+  // With owns_fifo_dir the FIFOs and fifo_dir are removed when done.
+  void init(const std::string& fifo_dir, bool owns_fifo_dir);
+
+  // Returns false, and logs it, if no agent is connected. The packet is
+  // dropped then: commands are only meaningful to the agent they were
+  // issued against, a later agent must not see them.
+  bool dispatchPacket (const HsaPacket& packet);
+
+  // Blocks until the agent sends a notification or shutdown() is called.
+  // Returns nullptr on shutdown.
   std::unique_ptr<HsaDebugNotificationPacket> readPacket ();
 
+  // Wakes up a reader blocked in readPacket() and makes it return nullptr.
+  // Safe to call from any thread.
+  void shutdown();
+  bool isShutdown() const { return is_shutdown; }
+
 private:
+  bool openReadEnd();
+  // Call with write_mutex held
+  bool openWriteEnd();
+  void closeWriteEnd();
+  void closeFds();
+
+  std::string fifo_dir;
+  std::string read_fifo_name;
+  std::string write_fifo_name;
+  bool remove_fifos;
   int read_fd;
+  // The reader thread drops the write end when the agent goes away while
+  // other threads dispatch packets through it
+  std::mutex write_mutex;
   int write_fd;
+  int epoll_fd;
+  int shutdown_fd;
+  std::atomic<bool> is_shutdown;
 };
 
 
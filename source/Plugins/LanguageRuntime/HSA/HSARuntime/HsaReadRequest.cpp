@@ -0,0 +1,310 @@
+//===-- HsaReadRequest.cpp --------------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstring>
+
+#include "HsaReadRequest.h"
+#include "lldb/Utility/StringExtractor.h"
+
+using namespace lldb_private;
+
+HsaReadRequest::HsaReadRequest () {
+    std::memset(&request, 0, sizeof(request));
+    request.m_kind = HSAIL_READ_KIND_UNKNOWN;
+    request.m_status = HSAIL_READ_STATUS_PENDING;
+    work_item_count.x = work_item_count.y = work_item_count.z = 1;
+}
+
+uint64_t HsaReadRequest::GetLaneCount () const {
+    return static_cast<uint64_t>(work_item_count.x) * work_item_count.y * work_item_count.z;
+}
+
+HsailWaveDim3 HsaReadRequest::GetWorkItem (uint64_t lane) const {
+    HsailWaveDim3 work_item = request.m_workItem;
+    work_item.x += lane % work_item_count.x;
+    work_item.y += (lane / work_item_count.x) % work_item_count.y;
+    work_item.z += lane / (static_cast<uint64_t>(work_item_count.x) * work_item_count.y);
+    return work_item;
+}
+
+HsaReadRequest HsaReadRequest::GetLane (uint64_t lane) const {
+    HsaReadRequest lane_read;
+    lane_read.tid = tid;
+    lane_read.request = request;
+    lane_read.request.m_workItem = GetWorkItem(lane);
+    return lane_read;
+}
+
+bool HsaReadRequest::IsLaneInWorkGroup (uint64_t lane, const HsailWaveDim3& group_size) const {
+    // Computed in 64 bits, the box can run past the end of a 32-bit work-item ID
+    const uint64_t offsets[] = {
+        lane % work_item_count.x,
+        (lane / work_item_count.x) % work_item_count.y,
+        lane / (static_cast<uint64_t>(work_item_count.x) * work_item_count.y)
+    };
+    const uint32_t starts[] = { request.m_workItem.x, request.m_workItem.y, request.m_workItem.z };
+    const uint32_t sizes[] = { group_size.x, group_size.y, group_size.z };
+
+    for (size_t i=0; i < 3; ++i) {
+        const uint64_t end = sizes[i] != 0 ? sizes[i] : static_cast<uint64_t>(UINT32_MAX) + 1;
+        if (starts[i] + offsets[i] >= end)
+            return false;
+    }
+    return true;
+}
+
+void HsaReadRequest::BeginLanes () {
+    data.assign(GetLaneCount() * request.m_size, 0);
+    failed_lanes.clear();
+    request.m_status = HSAIL_READ_STATUS_PENDING;
+    request.m_resultSize = data.size();
+}
+
+void HsaReadRequest::SetLaneResult (uint64_t lane, const HsaReadRequest& lane_read) {
+    if (lane_read.Succeeded()) {
+        const std::size_t size = std::min<std::size_t>(lane_read.data.size(), request.m_size);
+        std::copy(lane_read.data.begin(), lane_read.data.begin() + size, data.begin() + lane * request.m_size);
+        request.m_status = HSAIL_READ_STATUS_SUCCESS;
+    }
+    else {
+        failed_lanes.push_back(lane);
+        if (!Succeeded())
+            request.m_status = lane_read.request.m_status;
+    }
+}
+
+// The IMR_* memory regions a memory read can name
+static const uint64_t k_region_global = 0;  // IMR_Global
+static const uint64_t k_region_group = 2;   // IMR_Group, the last one
+
+bool HsaReadRequest::IsGlobalMemory () const {
+    return request.m_kind == HSAIL_READ_KIND_MEMORY && request.m_memoryRegion == k_region_global;
+}
+
+HsaReadRequest HsaReadRequest::Variable (lldb::tid_t tid, const HsailWaveDim3& work_item,
+                                         const HsailVariableLocation& location, uint64_t size) {
+    HsaReadRequest read;
+    read.tid = tid;
+    read.request.m_kind = HSAIL_READ_KIND_VARIABLE;
+    read.request.m_workItem = work_item;
+    read.request.m_location = location;
+    read.request.m_size = size;
+    return read;
+}
+
+HsaReadRequest HsaReadRequest::Memory (lldb::tid_t tid, const HsailWaveDim3& work_item,
+                                       uint64_t memory_region, uint64_t address, uint64_t size) {
+    HsaReadRequest read;
+    read.tid = tid;
+    read.request.m_kind = HSAIL_READ_KIND_MEMORY;
+    read.request.m_workItem = work_item;
+    read.request.m_memoryRegion = memory_region;
+    read.request.m_address = address;
+    read.request.m_size = size;
+    return read;
+}
+
+const char* HsaReadRequest::GetStatusString () const {
+    switch (request.m_status) {
+    case HSAIL_READ_STATUS_PENDING: return "not read";
+    case HSAIL_READ_STATUS_SUCCESS: return "success";
+    case HSAIL_READ_STATUS_UNSUPPORTED: return "location not supported";
+    case HSAIL_READ_STATUS_FAILURE: return "read failed";
+    default: return "unknown status";
+    }
+}
+
+static JSONArray::SP
+Dim3ToJSON (const HsailWaveDim3& dim) {
+    JSONArray::SP array_sp = std::make_shared<JSONArray>();
+    array_sp->AppendObject(std::make_shared<JSONNumber>(static_cast<uint64_t>(dim.x)));
+    array_sp->AppendObject(std::make_shared<JSONNumber>(static_cast<uint64_t>(dim.y)));
+    array_sp->AppendObject(std::make_shared<JSONNumber>(static_cast<uint64_t>(dim.z)));
+    return array_sp;
+}
+
+static bool
+Dim3FromJSON (StructuredData::Dictionary* dict, llvm::StringRef key, HsailWaveDim3& dim) {
+    StructuredData::Array* array = nullptr;
+    if (!dict->GetValueForKeyAsArray(key, array) || array->GetSize() != 3)
+        return false;
+    return array->GetItemAtIndexAsInteger(0, dim.x) &&
+           array->GetItemAtIndexAsInteger(1, dim.y) &&
+           array->GetItemAtIndexAsInteger(2, dim.z);
+}
+
+// The location is sent as an array of its fields, signed fields go as
+// their unsigned bit pattern
+static JSONArray::SP
+LocationToJSON (const HsailVariableLocation& location) {
+    const uint32_t fields[] = {
+        static_cast<uint32_t>(location.m_regType), location.m_regNum, location.m_derefValue,
+        location.m_offset, location.m_resource, location.m_isaMemoryRegion,
+        location.m_pieceOffset, location.m_pieceSize, static_cast<uint32_t>(location.m_constAdd)
+    };
+
+    JSONArray::SP array_sp = std::make_shared<JSONArray>();
+    for (uint32_t field : fields)
+        array_sp->AppendObject(std::make_shared<JSONNumber>(static_cast<uint64_t>(field)));
+    return array_sp;
+}
+
+static bool
+LocationFromJSON (StructuredData::Dictionary* dict, HsailVariableLocation& location) {
+    StructuredData::Array* array = nullptr;
+    uint32_t fields[9];
+    if (!dict->GetValueForKeyAsArray("location", array) || array->GetSize() != 9)
+        return false;
+    for (size_t i=0; i < 9; ++i) {
+        if (!array->GetItemAtIndexAsInteger(i, fields[i]))
+            return false;
+    }
+
+    location.m_regType = static_cast<int32_t>(fields[0]);
+    location.m_regNum = fields[1];
+    location.m_derefValue = fields[2];
+    location.m_offset = fields[3];
+    location.m_resource = fields[4];
+    location.m_isaMemoryRegion = fields[5];
+    location.m_pieceOffset = fields[6];
+    location.m_pieceSize = fields[7];
+    location.m_constAdd = static_cast<int32_t>(fields[8]);
+    location.m_reserved = 0;
+    return true;
+}
+
+JSONArray::SP
+lldb_private::HsaReadRequestsToJSON (const HsaReadRequests& requests) {
+    JSONArray::SP array_sp = std::make_shared<JSONArray>();
+    for (const auto& read : requests) {
+        JSONObject::SP read_sp = std::make_shared<JSONObject>();
+        read_sp->SetObject("tid", std::make_shared<JSONNumber>(static_cast<uint64_t>(read.tid)));
+        read_sp->SetObject("kind", std::make_shared<JSONNumber>(static_cast<uint64_t>(read.request.m_kind)));
+        read_sp->SetObject("work_item", Dim3ToJSON(read.request.m_workItem));
+        read_sp->SetObject("size", std::make_shared<JSONNumber>(read.request.m_size));
+        if (read.GetLaneCount() != 1)
+            read_sp->SetObject("count", Dim3ToJSON(read.work_item_count));
+
+        if (read.request.m_kind == HSAIL_READ_KIND_VARIABLE) {
+            read_sp->SetObject("location", LocationToJSON(read.request.m_location));
+        }
+        else {
+            read_sp->SetObject("region", std::make_shared<JSONNumber>(read.request.m_memoryRegion));
+            read_sp->SetObject("address", std::make_shared<JSONNumber>(read.request.m_address));
+        }
+
+        array_sp->AppendObject(read_sp);
+    }
+    return array_sp;
+}
+
+bool
+lldb_private::HsaReadRequestsFromJSON (const StructuredData::ObjectSP& object_sp, HsaReadRequests& requests) {
+    StructuredData::Array* array = object_sp ? object_sp->GetAsArray() : nullptr;
+    if (!array)
+        return false;
+
+    requests.clear();
+    requests.reserve(array->GetSize());
+    for (size_t i=0; i < array->GetSize(); ++i) {
+        StructuredData::Dictionary* dict = nullptr;
+        if (!array->GetItemAtIndexAsDictionary(i, dict))
+            return false;
+
+        HsaReadRequest read;
+        uint32_t kind = HSAIL_READ_KIND_UNKNOWN;
+        if (!dict->GetValueForKeyAsInteger("tid", read.tid) ||
+            !dict->GetValueForKeyAsInteger("kind", kind) ||
+            !dict->GetValueForKeyAsInteger("size", read.request.m_size) ||
+            !Dim3FromJSON(dict, "work_item", read.request.m_workItem))
+            return false;
+
+        if (dict->HasKey("count") && !Dim3FromJSON(dict, "count", read.work_item_count))
+            return false;
+        if (read.GetLaneCount() == 0)
+            return false;
+
+        read.request.m_kind = kind;
+        if (kind == HSAIL_READ_KIND_VARIABLE) {
+            if (!LocationFromJSON(dict, read.request.m_location))
+                return false;
+        }
+        else if (kind == HSAIL_READ_KIND_MEMORY) {
+            if (!dict->GetValueForKeyAsInteger("region", read.request.m_memoryRegion) ||
+                !dict->GetValueForKeyAsInteger("address", read.request.m_address) ||
+                read.request.m_memoryRegion > k_region_group)
+                return false;
+        }
+        else
+            return false;
+
+        requests.push_back(read);
+    }
+    return true;
+}
+
+JSONArray::SP
+lldb_private::HsaReadResultsToJSON (const HsaReadRequests& requests) {
+    static const char k_hex_digits[] = "0123456789abcdef";
+
+    JSONArray::SP array_sp = std::make_shared<JSONArray>();
+    for (const auto& read : requests) {
+        std::string hex;
+        hex.reserve(read.data.size() * 2);
+        for (uint8_t byte : read.data) {
+            hex.push_back(k_hex_digits[byte >> 4]);
+            hex.push_back(k_hex_digits[byte & 0xf]);
+        }
+
+        JSONObject::SP result_sp = std::make_shared<JSONObject>();
+        result_sp->SetObject("status", std::make_shared<JSONNumber>(static_cast<uint64_t>(read.request.m_status)));
+        result_sp->SetObject("data", std::make_shared<JSONString>(hex));
+        if (!read.failed_lanes.empty()) {
+            JSONArray::SP failed_sp = std::make_shared<JSONArray>();
+            for (uint64_t lane : read.failed_lanes)
+                failed_sp->AppendObject(std::make_shared<JSONNumber>(lane));
+            result_sp->SetObject("failed", failed_sp);
+        }
+        array_sp->AppendObject(result_sp);
+    }
+    return array_sp;
+}
+
+bool
+lldb_private::HsaReadResultsFromJSON (const StructuredData::ObjectSP& object_sp, HsaReadRequests& requests) {
+    StructuredData::Array* array = object_sp ? object_sp->GetAsArray() : nullptr;
+    if (!array || array->GetSize() != requests.size())
+        return false;
+
+    for (size_t i=0; i < requests.size(); ++i) {
+        StructuredData::Dictionary* dict = nullptr;
+        std::string hex;
+        if (!array->GetItemAtIndexAsDictionary(i, dict) ||
+            !dict->GetValueForKeyAsInteger("status", requests[i].request.m_status) ||
+            !dict->GetValueForKeyAsString("data", hex))
+            return false;
+
+        requests[i].data.resize(hex.size() / 2);
+        StringExtractor extractor (hex.c_str());
+        extractor.GetHexBytes(requests[i].data.data(), requests[i].data.size(), 0);
+        requests[i].request.m_resultSize = requests[i].data.size();
+
+        requests[i].failed_lanes.clear();
+        StructuredData::Array* failed = nullptr;
+        if (dict->GetValueForKeyAsArray("failed", failed)) {
+            for (size_t j=0; j < failed->GetSize(); ++j) {
+                uint64_t lane = 0;
+                if (failed->GetItemAtIndexAsInteger(j, lane))
+                    requests[i].failed_lanes.push_back(lane);
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,99 @@
+//===-- HsaReadRequest.h ----------------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef liblldb_HsaReadRequest_h_
+#define liblldb_HsaReadRequest_h_
+
+// C Includes
+// C++ Includes
+#include <cstdint>
+#include <vector>
+// Other libraries and framework includes
+// Project includes
+#include "lldb/lldb-types.h"
+#include "lldb/lldb-defines.h"
+#include "lldb/Core/StructuredData.h"
+#include "lldb/Utility/JSON.h"
+#include "CommunicationControl.h"
+
+namespace lldb_private {
+    //------------------------------------------------------------------
+    /// A read of a variable or of memory on behalf of work-items of a
+    /// wave. Any number of requests, for any number of work-items, are
+    /// served by the agent in one round trip through shared memory.
+    ///
+    /// A request can cover a box of work-items, starting at
+    /// request.m_workItem. Their values come back as one packed column,
+    /// lane i at i * request.m_size, lanes ordered x fastest.
+    //------------------------------------------------------------------
+    struct HsaReadRequest {
+        lldb::tid_t tid = LLDB_INVALID_THREAD_ID; ///< The wave, the stub fills in its work-group
+        HsailReadRequest request;                 ///< What to read, in the agent's format
+        HsailWaveDim3 work_item_count;            ///< Size of the box of work-items to read for
+        std::vector<uint8_t> data;                ///< The bytes read, zero for failed lanes
+        std::vector<uint64_t> failed_lanes;       ///< Lanes that could not be read
+
+        HsaReadRequest ();
+
+        uint64_t GetLaneCount () const;
+
+        /// The work-item of a lane of the box
+        HsailWaveDim3 GetWorkItem (uint64_t lane) const;
+
+        /// A request for a single lane of the box
+        HsaReadRequest GetLane (uint64_t lane) const;
+
+        /// True if the work-item of a lane exists in a work-group of
+        /// group_size work-items, a size of 0 meaning unknown. Boxes can
+        /// reach past the end of the work-group, those lanes are not read.
+        bool IsLaneInWorkGroup (uint64_t lane, const HsailWaveDim3& group_size) const;
+
+        // Gathering the results of single lane requests into the column,
+        // the request succeeds if any lane does
+        void BeginLanes ();
+        void SetLaneResult (uint64_t lane, const HsaReadRequest& lane_read);
+
+        static HsaReadRequest
+        Variable (lldb::tid_t tid, const HsailWaveDim3& work_item,
+                  const HsailVariableLocation& location, uint64_t size);
+
+        static HsaReadRequest
+        Memory (lldb::tid_t tid, const HsailWaveDim3& work_item,
+                uint64_t memory_region, uint64_t address, uint64_t size);
+
+        bool Succeeded () const { return request.m_status == HSAIL_READ_STATUS_SUCCESS; }
+
+        /// True for a read of global memory. That is the process's own
+        /// memory, the stub reads it rather than have the agent dereference
+        /// an address it was sent
+        bool IsGlobalMemory () const;
+
+        /// A description of request.m_status for error messages
+        const char* GetStatusString () const;
+    };
+
+    using HsaReadRequests = std::vector<HsaReadRequest>;
+
+    // The jHSARead packet carries the requests one way and their results
+    // the other way as JSON arrays, in the same order
+
+    JSONArray::SP
+    HsaReadRequestsToJSON (const HsaReadRequests& requests);
+
+    bool
+    HsaReadRequestsFromJSON (const StructuredData::ObjectSP& object_sp, HsaReadRequests& requests);
+
+    JSONArray::SP
+    HsaReadResultsToJSON (const HsaReadRequests& requests);
+
+    bool
+    HsaReadResultsFromJSON (const StructuredData::ObjectSP& object_sp, HsaReadRequests& requests);
+} // namespace lldb_private
+
+#endif // liblldb_HsaReadRequest_h_
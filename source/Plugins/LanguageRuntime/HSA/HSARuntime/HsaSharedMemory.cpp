@@ -0,0 +1,75 @@
+//===-- HsaSharedMemory.cpp -------------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include "HsaSharedMemory.h"
+#include "HsaUtils.h"
+
+using namespace lldb_private;
+
+HsaSharedMemorySegment::HsaSharedMemorySegment (key_t key, std::size_t min_size)
+    : m_key(key),
+      m_min_size(min_size),
+      m_mutex(),
+      m_mapping()
+{
+}
+
+HsaSharedMemorySegment::~HsaSharedMemorySegment () {
+    Detach();
+}
+
+HsaSharedMemoryMapping::~HsaSharedMemoryMapping () {
+    shmdt(m_addr);
+}
+
+bool HsaSharedMemorySegment::Attach () {
+    if (m_mapping) return true;
+
+    int shmid = shmget(m_key, m_min_size, 0666);
+    if (shmid < 0) {
+        LogMsg("HsaSharedMemorySegment: shmget failed for key %d", m_key);
+        return false;
+    }
+
+    // The agent may have created the segment larger than we asked for
+    struct shmid_ds info;
+    if (shmctl(shmid, IPC_STAT, &info) < 0) {
+        LogMsg("HsaSharedMemorySegment: shmctl failed for key %d", m_key);
+        return false;
+    }
+
+    void* addr = shmat(shmid, NULL, 0);
+    if (addr == NULL || addr == ((void*)-1)) {
+        LogMsg("HsaSharedMemorySegment: shmat failed for key %d", m_key);
+        return false;
+    }
+
+    LogMsg("HsaSharedMemorySegment: attached key %d (shmid %d, %zu bytes)", m_key, shmid,
+           static_cast<std::size_t>(info.shm_segsz));
+    m_mapping = std::make_shared<HsaSharedMemoryMapping>(addr, static_cast<std::size_t>(info.shm_segsz));
+    return true;
+}
+
+void HsaSharedMemorySegment::Detach () {
+    // The memory is shmdt'd once no view uses it anymore
+    m_mapping.reset();
+}
+
+void HsaSharedMemorySegment::Invalidate () {
+    Mutex::Locker locker (m_mutex);
+    Detach();
+}
+
+bool HsaSharedMemorySegment::IsAttached () const {
+    Mutex::Locker locker (m_mutex);
+    return m_mapping != nullptr;
+}
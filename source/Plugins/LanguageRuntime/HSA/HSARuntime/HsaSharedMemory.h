@@ -0,0 +1,126 @@
+//===-- HsaSharedMemory.h ---------------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef liblldb_HsaSharedMemory_h_
+#define liblldb_HsaSharedMemory_h_
+
+// C Includes
+#include <sys/types.h>
+// C++ Includes
+#include <cstddef>
+#include <memory>
+// Other libraries and framework includes
+#include "lldb/Host/Mutex.h"
+// Project includes
+
+namespace lldb_private {
+    //------------------------------------------------------------------
+    /// One shmat of a segment. It is shmdt'd when the last reference to
+    /// it goes away, not when the segment is invalidated, so views taken
+    /// before an Invalidate() keep pointing at mapped memory.
+    //------------------------------------------------------------------
+    class HsaSharedMemoryMapping {
+    public:
+        HsaSharedMemoryMapping (void* addr, std::size_t size) : m_addr(addr), m_size(size) {}
+        ~HsaSharedMemoryMapping ();
+
+        HsaSharedMemoryMapping (const HsaSharedMemoryMapping&) = delete;
+        HsaSharedMemoryMapping& operator= (const HsaSharedMemoryMapping&) = delete;
+
+        void* GetAddress () const { return m_addr; }
+        std::size_t GetSize () const { return m_size; }
+
+    private:
+        void* const m_addr;
+        const std::size_t m_size;
+    };
+
+    typedef std::shared_ptr<HsaSharedMemoryMapping> HsaSharedMemoryMappingSP;
+
+    //------------------------------------------------------------------
+    /// A typed, bounds-checked window onto an attached shared memory
+    /// segment. Views share the mapping they came from, they stay valid
+    /// after the segment is invalidated but then show the old segment.
+    //------------------------------------------------------------------
+    template <typename T>
+    class HsaSharedMemoryView {
+    public:
+        HsaSharedMemoryView () : m_mapping(), m_data(nullptr), m_count(0) {}
+        HsaSharedMemoryView (const HsaSharedMemoryMappingSP& mapping, T* data, std::size_t count)
+            : m_mapping(mapping), m_data(data), m_count(count) {}
+
+        explicit operator bool() const { return m_data != nullptr; }
+
+        std::size_t size() const { return m_count; }
+        T* data() const { return m_data; }
+
+        /// Returns nullptr if idx is outside of the segment
+        T* at (std::size_t idx) const {
+            return idx < m_count ? m_data + idx : nullptr;
+        }
+
+        /// Returns a view of the same memory starting byte_offset bytes in,
+        /// reinterpreted as U. Empty if the offset is out of range.
+        template <typename U>
+        HsaSharedMemoryView<U> Subview (std::size_t byte_offset) const {
+            const std::size_t n_bytes = m_count * sizeof(T);
+            if (!m_data || byte_offset > n_bytes) return HsaSharedMemoryView<U>();
+
+            auto base = reinterpret_cast<char*>(m_data) + byte_offset;
+            return HsaSharedMemoryView<U>(m_mapping, reinterpret_cast<U*>(base), (n_bytes - byte_offset) / sizeof(U));
+        }
+
+    private:
+        HsaSharedMemoryMappingSP m_mapping;
+        T* m_data;
+        std::size_t m_count;
+    };
+
+    //------------------------------------------------------------------
+    /// A SysV shared memory segment owned by the HSA agent. The segment
+    /// is attached lazily on first use and kept attached until the agent
+    /// tells us it has been released or reallocated, so that hot paths
+    /// like reading the PC of a wavefront are a plain memory load.
+    //------------------------------------------------------------------
+    class HsaSharedMemorySegment {
+    public:
+        /// The segment may be larger than min_size, views cover all of it
+        HsaSharedMemorySegment (key_t key, std::size_t min_size);
+        ~HsaSharedMemorySegment ();
+
+        HsaSharedMemorySegment (const HsaSharedMemorySegment&) = delete;
+        HsaSharedMemorySegment& operator= (const HsaSharedMemorySegment&) = delete;
+
+        template <typename T>
+        HsaSharedMemoryView<T> Get () {
+            Mutex::Locker locker (m_mutex);
+            if (!Attach()) return HsaSharedMemoryView<T>();
+            return HsaSharedMemoryView<T>(m_mapping, static_cast<T*>(m_mapping->GetAddress()),
+                                          m_mapping->GetSize() / sizeof(T));
+        }
+
+        /// Drop the current mapping. The next Get() will attach again, picking
+        /// up a segment the agent may have recreated under the same key.
+        /// Outstanding views keep the old mapping alive until they go away.
+        void Invalidate ();
+
+        bool IsAttached () const;
+
+    private:
+        bool Attach ();
+        void Detach ();
+
+        const key_t m_key;
+        const std::size_t m_min_size;
+        mutable Mutex m_mutex;
+        HsaSharedMemoryMappingSP m_mapping;
+    };
+} // namespace lldb_private
+
+#endif // liblldb_HsaSharedMemory_h_
@@ -0,0 +1,138 @@
+//===-- HsaWavefrontTable.cpp -----------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <numeric>
+
+#include "HsaWavefrontTable.h"
+
+using namespace lldb_private;
+
+const std::size_t HsaWavefrontTable::npos;
+
+// The records of a wave buffer, stopping at the first one that does not fit
+static std::vector<const HsailWaveRecord*>
+GetWaveRecords (const uint8_t* buffer, std::size_t buffer_size) {
+    std::vector<const HsailWaveRecord*> records;
+    if (!buffer || buffer_size < sizeof(HsailWaveBufferHeader))
+        return records;
+
+    const auto header = reinterpret_cast<const HsailWaveBufferHeader*>(buffer);
+    const std::size_t end = std::min<uint64_t>(header->m_bytesUsed, buffer_size);
+
+    records.reserve(header->m_numWaves);
+    std::size_t offset = header->m_headerSize;
+    for (uint32_t i=0; i < header->m_numWaves; ++i) {
+        if (offset + sizeof(HsailWaveRecord) > end)
+            break;
+
+        const auto record = reinterpret_cast<const HsailWaveRecord*>(buffer + offset);
+        if (record->m_recordSize < GetHsailWaveRecordSize(0) || offset + record->m_recordSize > end)
+            break;
+
+        records.push_back(record);
+        offset += record->m_recordSize;
+    }
+    return records;
+}
+
+HsaWavefrontTable::HsaWavefrontTable (const uint8_t* buffer, std::size_t buffer_size,
+                                      const HsailWaveDim3& group_size)
+{
+    const std::vector<const HsailWaveRecord*> waves = GetWaveRecords(buffer, buffer_size);
+    const std::size_t num_waves = waves.size();
+
+    std::vector<uint64_t> global_ids (num_waves);
+    for (std::size_t i=0; i < num_waves; ++i) {
+        const auto& wg = waves[i]->workGroupId;
+        global_ids[i] = wg.x + wg.y * group_size.x + wg.z * group_size.x * group_size.y;
+    }
+
+    // Sort an index rather than the wave records themselves, records are
+    // variable length and live in shared memory
+    std::vector<std::size_t> order (num_waves);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&global_ids] (std::size_t lhs, std::size_t rhs) {
+        return global_ids[lhs] < global_ids[rhs];
+    });
+    order.erase(std::unique(order.begin(), order.end(), [&global_ids] (std::size_t lhs, std::size_t rhs) {
+        return global_ids[lhs] == global_ids[rhs];
+    }), order.end());
+
+    m_global_ids.reserve(order.size());
+    m_pcs.reserve(order.size());
+    m_exec_masks.reserve(order.size());
+    m_work_group_ids.reserve(order.size());
+    m_wave_addresses.reserve(order.size());
+
+    for (std::size_t idx : order) {
+        const auto& wave = *waves[idx];
+        m_global_ids.push_back(global_ids[idx]);
+        m_pcs.push_back(wave.pc);
+        m_exec_masks.push_back(wave.execMask);
+        m_work_group_ids.push_back(wave.workGroupId);
+        m_wave_addresses.push_back(wave.waveAddress);
+    }
+
+    m_by_address.resize(m_global_ids.size());
+    std::iota(m_by_address.begin(), m_by_address.end(), 0);
+    std::sort(m_by_address.begin(), m_by_address.end(), [this] (std::size_t lhs, std::size_t rhs) {
+        if (m_wave_addresses[lhs] != m_wave_addresses[rhs])
+            return m_wave_addresses[lhs] < m_wave_addresses[rhs];
+        return m_global_ids[lhs] < m_global_ids[rhs];
+    });
+}
+
+std::size_t HsaWavefrontTable::FindGlobalID (uint64_t global_id) const {
+    auto pos = std::lower_bound(m_global_ids.begin(), m_global_ids.end(), global_id);
+    if (pos == m_global_ids.end() || *pos != global_id) return npos;
+    return pos - m_global_ids.begin();
+}
+
+HsaWavefrontDelta HsaWavefrontDelta::Compute (const HsaWavefrontTable& from, const HsaWavefrontTable& to) {
+    HsaWavefrontDelta delta;
+
+    // Walk both tables in address order, like merging two sorted lists
+    auto key = [] (const HsaWavefrontTable& table, std::size_t row) {
+        return std::make_pair(table.m_wave_addresses[row], table.m_global_ids[row]);
+    };
+
+    std::size_t i = 0, j = 0;
+    while (i < from.m_by_address.size() && j < to.m_by_address.size()) {
+        const std::size_t from_row = from.m_by_address[i];
+        const std::size_t to_row = to.m_by_address[j];
+        const auto from_key = key(from, from_row);
+        const auto to_key = key(to, to_row);
+
+        if (from_key < to_key) {
+            delta.retired.push_back(from_row);
+            ++i;
+        }
+        else if (to_key < from_key) {
+            delta.added.push_back(to_row);
+            ++j;
+        }
+        else {
+            if (from.m_pcs[from_row] != to.m_pcs[to_row] ||
+                from.m_exec_masks[from_row] != to.m_exec_masks[to_row]) {
+                delta.moved.push_back(to_row);
+            }
+            ++i;
+            ++j;
+        }
+    }
+    for (; i < from.m_by_address.size(); ++i) delta.retired.push_back(from.m_by_address[i]);
+    for (; j < to.m_by_address.size(); ++j) delta.added.push_back(to.m_by_address[j]);
+
+    // Report rows in table order, which is global ID order
+    std::sort(delta.added.begin(), delta.added.end());
+    std::sort(delta.moved.begin(), delta.moved.end());
+    std::sort(delta.retired.begin(), delta.retired.end());
+    return delta;
+}
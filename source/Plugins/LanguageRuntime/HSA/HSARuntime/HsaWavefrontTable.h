@@ -0,0 +1,105 @@
+//===-- HsaWavefrontTable.h -------------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef liblldb_HsaWavefrontTable_h_
+#define liblldb_HsaWavefrontTable_h_
+
+// C Includes
+// C++ Includes
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+// Other libraries and framework includes
+// Project includes
+#include "CommunicationControl.h"
+
+namespace lldb_private {
+    class HsaWavefrontTable;
+
+    //------------------------------------------------------------------
+    /// The difference between the wavefront tables of two stops. Waves
+    /// are matched by hardware slot address and global ID; a slot that
+    /// was handed to a different wave shows up as retired and added.
+    //------------------------------------------------------------------
+    struct HsaWavefrontDelta {
+        std::vector<std::size_t> added;   ///< Rows of the new table
+        std::vector<std::size_t> moved;   ///< Rows of the new table whose PC or exec mask changed
+        std::vector<std::size_t> retired; ///< Rows of the old table
+
+        bool IsEmpty () const { return added.empty() && moved.empty() && retired.empty(); }
+
+        static HsaWavefrontDelta Compute (const HsaWavefrontTable& from, const HsaWavefrontTable& to);
+    };
+
+    //------------------------------------------------------------------
+    /// The wavefronts active at one stop, stored column by column and
+    /// sorted by global ID. A dispatch can have tens of thousands of
+    /// waves, so rows are plain values and thread objects are only
+    /// created for the waves a client actually looks at.
+    //------------------------------------------------------------------
+    class HsaWavefrontTable {
+    public:
+        static const std::size_t npos = static_cast<std::size_t>(-1);
+
+        HsaWavefrontTable () = default;
+
+        //------------------------------------------------------------------
+        /// Build a table from the agent's wave buffer, a header followed by
+        /// variable length records. Records that do not fit in buffer_size
+        /// are dropped. Waves that map to the same global ID are reported
+        /// once, by the first of them.
+        //------------------------------------------------------------------
+        HsaWavefrontTable (const uint8_t* buffer, std::size_t buffer_size,
+                           const HsailWaveDim3& group_size);
+
+        std::size_t GetSize () const { return m_global_ids.size(); }
+        bool IsEmpty () const { return m_global_ids.empty(); }
+
+        uint64_t GetGlobalID (std::size_t idx) const { return m_global_ids[idx]; }
+        HsailProgramCounter GetPC (std::size_t idx) const { return m_pcs[idx]; }
+        uint64_t GetExecMask (std::size_t idx) const { return m_exec_masks[idx]; }
+        HsailWaveDim3 GetWorkGroupID (std::size_t idx) const { return m_work_group_ids[idx]; }
+        HsailWaveAddress GetWaveAddress (std::size_t idx) const { return m_wave_addresses[idx]; }
+
+        /// Returns the row of the wave with the given global ID, or npos
+        std::size_t FindGlobalID (uint64_t global_id) const;
+
+    private:
+        friend struct HsaWavefrontDelta;
+
+        // Rows ordered by wave address, then global ID
+        std::vector<std::size_t> m_by_address;
+        std::vector<uint64_t> m_global_ids;
+        std::vector<HsailProgramCounter> m_pcs;
+        std::vector<uint64_t> m_exec_masks;
+        std::vector<HsailWaveDim3> m_work_group_ids;
+        std::vector<HsailWaveAddress> m_wave_addresses;
+    };
+
+    // Tables are immutable once published, readers can hold on to one
+    // while the reader thread publishes the next
+    using HsaWavefrontTableSP = std::shared_ptr<const HsaWavefrontTable>;
+
+    //------------------------------------------------------------------
+    /// A wavefront table together with how it differs from the table of
+    /// the previous stop, so consumers only touch the waves that changed.
+    //------------------------------------------------------------------
+    struct HsaWavefrontUpdate {
+        uint32_t version = 0;      ///< Version of table
+        uint32_t base_version = 0; ///< Version of base_table, the previous stop
+        HsaWavefrontTableSP table;
+        HsaWavefrontTableSP base_table;
+        HsaWavefrontDelta delta;
+    };
+
+    using HsaWavefrontUpdateSP = std::shared_ptr<const HsaWavefrontUpdate>;
+} // namespace lldb_private
+
+#endif // liblldb_HsaWavefrontTable_h_
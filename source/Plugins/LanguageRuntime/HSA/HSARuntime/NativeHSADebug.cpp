@@ -1,51 +1,16 @@
 #include "NativeHSADebug.h"
 #include <cstdlib>
+#include <fstream>
+#include <iterator>
 #include <memory>
 #include <sys/mman.h>
+#include <unistd.h>
 
 #include "HsaUtils.h"
 
 using namespace lldb_private;
 
 
-template <typename T>
-struct shmem_delete {
-    void operator() (T* t) {
-        shmdt(t);
-    }
-};
-
-template <typename T>
-using shmem_ptr = std::unique_ptr<T, shmem_delete<T>>;
-
-template <typename T>
-shmem_ptr<T> SharedMemGet (int key, std::size_t max_size) {
-    int shmid = shmget(key, max_size, 0666);
-
-    if (shmid < 0) {
-        return nullptr;
-    }
-
-    auto pShm = shmat(shmid, NULL, 0);
-    if (pShm == NULL || pShm == ((void*)-1)) {
-        return nullptr;
-    }
-
-    return shmem_ptr<T>{static_cast<T*>(pShm)};
-}
-
-shmem_ptr<HsailAgentWaveInfo> GetWaveInfoMem() {
-    return SharedMemGet<HsailAgentWaveInfo>(g_WAVE_BUFFER_SHMKEY, g_WAVE_BUFFER_MAXSIZE);
-}
-
-shmem_ptr<HsailMomentaryBP> GetMomentaryBpMem() {
-    return SharedMemGet<HsailMomentaryBP>(g_MOMENTARY_BP_BUFFER_SHMKEY, g_MOMENTARY_BP_BUFFER_MAXSIZE);
-}
-
-shmem_ptr<char> GetBinaryMem() {
-    return SharedMemGet<char>(g_DBEBINARY_SHMKEY, g_BINARY_BUFFER_MAXSIZE);
-}
-
 void NativeHSADebug::FlushPacketBuffer() {
     for (auto& packet : m_packet_buffer) {
         LogMsg("HSARuntime::FlushPacketBuffer: Dispatching");
@@ -71,37 +36,439 @@ void NativeHSADebug::SetMomentaryBreakpoint(HwDbgInfo_addr addr) {
 
 void NativeHSADebug::DispatchMomentaryBreakpoints() {
     LogBkpt("NativeHSADebug::DispatchMomentaryBreakpoints");
-    auto momentary_bp_up = GetMomentaryBpMem();
-    auto momentary_bp = momentary_bp_up.get();
+    auto momentary_bp = m_momentary_bp_mem.Get<HsailMomentaryBP>();
+    if (!momentary_bp) {
+        LogBkpt("NativeHSADebug::DispatchMomentaryBreakpoints: momentary breakpoint buffer unavailable");
+        m_momentary_breakpoints.clear();
+        return;
+    }
 
-    for (size_t i=0; i < m_momentary_breakpoints.size(); ++i) {
-        momentary_bp[i].m_pc = m_momentary_breakpoints[i];
+    std::size_t n_bkpts = std::min(m_momentary_breakpoints.size(), momentary_bp.size());
+    if (n_bkpts < m_momentary_breakpoints.size()) {
+        LogBkpt("NativeHSADebug::DispatchMomentaryBreakpoints: dropping %zu breakpoints that do not fit",
+                m_momentary_breakpoints.size() - n_bkpts);
     }
 
-    HsaMomentaryBreakpointPacket packet (m_momentary_breakpoints.size());
+    for (size_t i=0; i < n_bkpts; ++i) {
+        momentary_bp.at(i)->m_pc = m_momentary_breakpoints[i];
+    }
+
+    HsaMomentaryBreakpointPacket packet (n_bkpts);
     DispatchPacket(packet);
     m_momentary_breakpoints.clear();
 }
 
+static HsailBreakpointOp MakeBreakpointOp(HsailBreakpointOpCode op, HwDbgInfo_addr addr) {
+    // lldb does not number its breakpoints for the agent, the agent finds
+    // them by PC
+    HsailBreakpointOp bp_op;
+    bp_op.m_op = op;
+    bp_op.m_gdbBreakpointID = 0;
+    bp_op.m_pc = addr;
+    bp_op.m_lineNum = 0;
+    bp_op.m_numConditionOps = 0;
+    bp_op.m_conditionOffset = 0;
+    bp_op.m_mode = HSAIL_BREAKPOINT_MODE_STOP;
+    bp_op.m_status = HSAIL_BREAKPOINT_OP_STATUS_PENDING;
+    return bp_op;
+}
+
+void NativeHSADebug::QueueBreakpointOp(HsailBreakpointOpCode op, HwDbgInfo_addr addr) {
+    Mutex::Locker locker (m_breakpoint_ops_mutex);
+    m_breakpoint_ops.push_back(MakeBreakpointOp(op, addr));
+}
+
+void NativeHSADebug::SetStepBreakpoints(const std::vector<HwDbgInfo_addr>& addrs) {
+    LogBkpt("NativeHSADebug::SetStepBreakpoints: %zu step breakpoints", addrs.size());
+
+    // Queued together so the new set always lands in the same batch as
+    // the clear of the old one
+    Mutex::Locker locker (m_breakpoint_ops_mutex);
+    m_breakpoint_ops.push_back(MakeBreakpointOp(HSAIL_BREAKPOINT_OP_STEP_CLEAR, 0));
+    for (auto addr : addrs)
+        m_breakpoint_ops.push_back(MakeBreakpointOp(HSAIL_BREAKPOINT_OP_STEP, addr));
+}
+
+// Wait for the agent to catch up with the last batch we published. The
+// agent's debug thread serves batches from its command loop, which is
+// where it waits while the dispatch is stopped. NativeProcessLinux leaves
+// that thread running when it stops the process, so this normally returns
+// within microseconds; back off gradually so a slow agent does not keep
+// us spinning for the whole second.
+static bool WaitForSequenceConsumed(const uint32_t* sequence_ptr, const uint32_t* consumed_ptr) {
+    static const uint64_t k_timeout_usec = 1000000;
+    static const useconds_t k_max_backoff_usec = 1000;
+
+    uint64_t waited_usec = 0;
+    useconds_t backoff_usec = 1;
+    while (true) {
+        uint32_t sequence = *sequence_ptr;
+        uint32_t consumed = __atomic_load_n(consumed_ptr, __ATOMIC_ACQUIRE);
+        if (sequence == consumed) return true;
+        if (waited_usec >= k_timeout_usec) return false;
+
+        usleep(backoff_usec);
+        waited_usec += backoff_usec;
+        backoff_usec = std::min<useconds_t>(backoff_usec * 2, k_max_backoff_usec);
+    }
+}
+
+bool NativeHSADebug::WaitForBreakpointBatchConsumed(const HsaSharedMemoryView<HsailBreakpointBatchHeader>& header) {
+    return WaitForSequenceConsumed(&header.at(0)->m_sequence, &header.at(0)->m_consumed);
+}
+
+void NativeHSADebug::DispatchBreakpointOpPacket(const HsailBreakpointOp& op) {
+    switch (op.m_op) {
+    case HSAIL_BREAKPOINT_OP_CREATE:
+        DispatchPacket(HsaCreateBreakpointPacket(op.m_pc, op.m_gdbBreakpointID, "", op.m_lineNum));
+        break;
+    case HSAIL_BREAKPOINT_OP_DELETE:
+        DispatchPacket(HsaDeleteBreakpointPacket(op.m_gdbBreakpointID));
+        break;
+    case HSAIL_BREAKPOINT_OP_ENABLE:
+        DispatchPacket(HsaEnableBreakpointPacket(op.m_gdbBreakpointID));
+        break;
+    case HSAIL_BREAKPOINT_OP_DISABLE:
+        DispatchPacket(HsaDisableBreakpointPacket(op.m_gdbBreakpointID));
+        break;
+    case HSAIL_BREAKPOINT_OP_STEP_CLEAR:
+    case HSAIL_BREAKPOINT_OP_STEP:
+        // Momentary breakpoint packets are gone with the next stop, the
+        // step plan would stop seeing the line's other exits
+        LogBkpt("NativeHSADebug::DispatchBreakpointOpPacket: step breakpoint at 0x%" PRIx64 " dropped", op.m_pc);
+        break;
+    default:
+        break;
+    }
+
+    // Packets have no room for a condition program or mode
+    if (op.m_op == HSAIL_BREAKPOINT_OP_CONDITION || op.m_numConditionOps != 0)
+        LogBkpt("NativeHSADebug::DispatchBreakpointOpPacket: condition at 0x%" PRIx64 " dropped", op.m_pc);
+    if (op.m_op == HSAIL_BREAKPOINT_OP_MODE || op.m_mode != HSAIL_BREAKPOINT_MODE_STOP)
+        LogBkpt("NativeHSADebug::DispatchBreakpointOpPacket: mode at 0x%" PRIx64 " dropped", op.m_pc);
+}
+
+Error NativeHSADebug::TakeBreakpointBatchStatus() {
+    auto batch_mem = m_breakpoint_batch_mem.Get<uint8_t>();
+    auto header = batch_mem.Subview<HsailBreakpointBatchHeader>(0);
+    auto batch_ops = batch_mem.Subview<HsailBreakpointOp>(sizeof(HsailBreakpointBatchHeader));
+    if (!header.at(0))
+        return Error();
+
+    // The operations of a consumed batch are not read again, clearing
+    // them keeps a failure from being reported twice
+    const std::size_t n_ops = std::min<std::size_t>(header.at(0)->m_numOps, batch_ops.size());
+    header.at(0)->m_numOps = 0;
+
+    Error error;
+    for (std::size_t i=0; i < n_ops; ++i) {
+        const HsailBreakpointOp& op = *batch_ops.at(i);
+        if (op.m_status != HSAIL_BREAKPOINT_OP_STATUS_FAILURE)
+            continue;
+
+        LogBkpt("NativeHSADebug::TakeBreakpointBatchStatus: operation %u at 0x%" PRIx64 " failed", op.m_op, op.m_pc);
+        if (error.Success()) {
+            if (op.m_op == HSAIL_BREAKPOINT_OP_CONDITION || op.m_numConditionOps != 0)
+                error.SetErrorStringWithFormat("the agent could not apply the condition at 0x%" PRIx64, op.m_pc);
+            else
+                error.SetErrorStringWithFormat("the agent could not apply the breakpoint change at 0x%" PRIx64, op.m_pc);
+        }
+    }
+    return error;
+}
+
+Error NativeHSADebug::ApplyBreakpointOps() {
+    if (!m_debugging_begun)
+        return Error();
+
+    auto header = m_breakpoint_batch_mem.Get<uint8_t>().Subview<HsailBreakpointBatchHeader>(0);
+    if (!header.at(0))
+        return Error("breakpoint batch buffer unavailable");
+
+    const uint32_t sequence = header.at(0)->m_sequence;
+    Error error = DispatchBreakpointOps();
+    if (error.Fail() || header.at(0)->m_sequence == sequence)
+        return error;
+
+    if (!WaitForBreakpointBatchConsumed(header))
+        return Error("the agent has not applied the breakpoint batch");
+    return TakeBreakpointBatchStatus();
+}
+
+Error NativeHSADebug::DispatchBreakpointOps() {
+    std::vector<HsailBreakpointOp> ops;
+    std::vector<std::vector<HsailConditionOp>> programs;
+    {
+        Mutex::Locker locker (m_breakpoint_ops_mutex);
+        ops.swap(m_breakpoint_ops);
+
+        // A breakpoint's condition and mode go out with its creation and
+        // with every change, the latest ones are those that count
+        for (auto& op : ops) {
+            programs.emplace_back();
+            if (op.m_op == HSAIL_BREAKPOINT_OP_CREATE || op.m_op == HSAIL_BREAKPOINT_OP_MODE) {
+                auto mode = m_breakpoint_modes.find(op.m_pc);
+                if (mode != m_breakpoint_modes.end())
+                    op.m_mode = mode->second;
+            }
+            if (op.m_op != HSAIL_BREAKPOINT_OP_CREATE && op.m_op != HSAIL_BREAKPOINT_OP_CONDITION)
+                continue;
+            auto condition = m_breakpoint_conditions.find(op.m_pc);
+            if (condition != m_breakpoint_conditions.end())
+                programs.back() = condition->second;
+        }
+    }
+    if (ops.empty()) return Error();
+
+    LogBkpt("NativeHSADebug::DispatchBreakpointOps: %zu breakpoint operations", ops.size());
+
+    auto batch_mem = m_breakpoint_batch_mem.Get<uint8_t>();
+    auto header = batch_mem.Subview<HsailBreakpointBatchHeader>(0);
+    auto batch_ops = batch_mem.Subview<HsailBreakpointOp>(sizeof(HsailBreakpointBatchHeader));
+
+    std::size_t n_batched = 0;
+    if (!header.at(0)) {
+        LogBkpt("NativeHSADebug::DispatchBreakpointOps: breakpoint batch buffer unavailable");
+    }
+    else if (!WaitForBreakpointBatchConsumed(header)) {
+        LogBkpt("NativeHSADebug::DispatchBreakpointOps: agent has not consumed the previous batch");
+    }
+    else {
+        // Failures of the previous batch that nobody waited for
+        TakeBreakpointBatchStatus();
+
+        // The condition programs follow the operations, each 8 byte aligned
+        std::size_t used = sizeof(HsailBreakpointBatchHeader);
+        while (n_batched < ops.size()) {
+            std::size_t needed = sizeof(HsailBreakpointOp) + programs[n_batched].size() * sizeof(HsailConditionOp);
+            if (used + needed > batch_mem.size()) break;
+            used += needed;
+            ++n_batched;
+        }
+
+        std::size_t program_offset = sizeof(HsailBreakpointBatchHeader) + n_batched * sizeof(HsailBreakpointOp);
+        for (std::size_t i=0; i < n_batched; ++i) {
+            HsailBreakpointOp& op = ops[i];
+            op.m_numConditionOps = programs[i].size();
+            op.m_conditionOffset = programs[i].empty() ? 0 : program_offset;
+            if (!programs[i].empty()) {
+                std::copy(programs[i].begin(), programs[i].end(),
+                          reinterpret_cast<HsailConditionOp*>(batch_mem.at(program_offset)));
+                program_offset += programs[i].size() * sizeof(HsailConditionOp);
+            }
+        }
+
+        std::copy(ops.begin(), ops.begin() + n_batched, batch_ops.data());
+        header.at(0)->m_numOps = n_batched;
+
+        // Publish the operations before the new sequence number, the agent
+        // reads the sequence number first
+        __atomic_store_n(&header.at(0)->m_sequence, header.at(0)->m_sequence + 1, __ATOMIC_RELEASE);
+
+        HsaBreakpointBatchPacket packet;
+        DispatchPacket(packet);
+    }
+
+    // Whatever did not make it into the batch goes out one packet at a
+    // time. The FIFO keeps these behind the batch doorbell, but without
+    // their conditions.
+    Error error;
+    for (std::size_t i=n_batched; i < ops.size(); ++i) {
+        DispatchBreakpointOpPacket(ops[i]);
+        if (error.Success() && !programs[i].empty())
+            error.SetErrorStringWithFormat("the condition at 0x%" PRIx64 " did not fit in the breakpoint batch", ops[i].m_pc);
+    }
+    return error;
+}
+
+Error NativeHSADebug::DispatchReadBatch(HsaReadRequests& requests, std::size_t start, std::size_t end) {
+    auto batch_mem = m_read_batch_mem.Get<uint8_t>();
+    auto header = batch_mem.Subview<HsailReadBatchHeader>(0);
+    auto batch_requests = batch_mem.Subview<HsailReadRequest>(sizeof(HsailReadBatchHeader));
+    if (!header.at(0))
+        return Error("read batch buffer unavailable");
+
+    if (!WaitForSequenceConsumed(&header.at(0)->m_sequence, &header.at(0)->m_consumed))
+        return Error("agent has not served the previous read batch");
+
+    // The results follow the requests, each 8 byte aligned
+    std::size_t result_offset = sizeof(HsailReadBatchHeader) + (end - start) * sizeof(HsailReadRequest);
+    for (std::size_t i=start; i < end; ++i) {
+        result_offset = (result_offset + 7) & ~static_cast<std::size_t>(7);
+        HsailReadRequest& request = *batch_requests.at(i - start);
+        request = requests[i].request;
+        request.m_status = HSAIL_READ_STATUS_PENDING;
+        request.m_resultOffset = result_offset;
+        request.m_resultSize = 0;
+        result_offset += request.m_size;
+    }
+    header.at(0)->m_numRequests = end - start;
+
+    // Publish the requests before the new sequence number, the agent reads
+    // the sequence number first
+    __atomic_store_n(&header.at(0)->m_sequence, header.at(0)->m_sequence + 1, __ATOMIC_RELEASE);
+
+    // Reads are only served while the dispatch is stopped, never buffered
+    // behind a continue
+    HsaReadBatchPacket packet;
+    if (!m_comms.dispatchPacket(packet))
+        return Error("no HSA agent is connected");
+
+    if (!WaitForSequenceConsumed(&header.at(0)->m_sequence, &header.at(0)->m_consumed))
+        return Error("agent did not serve the read batch");
+
+    for (std::size_t i=start; i < end; ++i) {
+        const HsailReadRequest& served = *batch_requests.at(i - start);
+        HsaReadRequest& read = requests[i];
+        read.request.m_status = served.m_status;
+        read.request.m_resultSize = std::min(served.m_resultSize, served.m_size);
+        read.data.clear();
+        if (served.m_status == HSAIL_READ_STATUS_SUCCESS) {
+            const uint8_t* result = batch_mem.at(served.m_resultOffset);
+            read.data.assign(result, result + read.request.m_resultSize);
+        }
+    }
+
+    return Error();
+}
+
+Error NativeHSADebug::ReadBatch(HsaReadRequests& requests) {
+    if (!m_debugging_begun || m_kernel_state != KernelState::Started)
+        return Error("no HSA dispatch is being debugged");
+
+    Mutex::Locker locker (m_read_batch_mutex);
+
+    // The agent sizes the buffer, not us
+    const std::size_t capacity = m_read_batch_mem.Get<uint8_t>().size();
+    if (capacity == 0)
+        return Error("read batch buffer unavailable");
+
+    // Pack as many requests as fit into each batch
+    std::size_t start = 0;
+    while (start < requests.size()) {
+        std::size_t used = sizeof(HsailReadBatchHeader);
+        std::size_t end = start;
+        while (end < requests.size()) {
+            std::size_t needed = sizeof(HsailReadRequest) + ((requests[end].request.m_size + 7) & ~static_cast<uint64_t>(7));
+            if (used + needed > capacity) break;
+            used += needed;
+            ++end;
+        }
+
+        if (end == start) {
+            // Too big to ever fit, let the client split it up
+            requests[start].request.m_status = HSAIL_READ_STATUS_UNSUPPORTED;
+            requests[start].data.clear();
+            ++start;
+            continue;
+        }
+
+        Error error = DispatchReadBatch(requests, start, end);
+        if (error.Fail())
+            return error;
+        start = end;
+    }
+
+    return Error();
+}
+
+std::size_t NativeHSADebug::GetReadBatchCapacity() {
+    Mutex::Locker locker (m_read_batch_mutex);
+    return m_read_batch_mem.Get<uint8_t>().size();
+}
+
+HsailWaveDim3 NativeHSADebug::GetWorkGroupSize() {
+    Mutex::Locker locker (m_wavefront_mutex);
+    return m_work_group_size;
+}
+
 void NativeHSADebug::DeleteBreakpoint(HwDbgInfo_addr addr) {
-    HsaDeleteBreakpointPacket packet (0);
-    DispatchPacket(packet);
+    {
+        Mutex::Locker locker (m_breakpoint_ops_mutex);
+        m_breakpoint_conditions.erase(addr);
+        m_breakpoint_modes.erase(addr);
+    }
+    QueueBreakpointOp(HSAIL_BREAKPOINT_OP_DELETE, addr);
 }
 
 void NativeHSADebug::EnableBreakpoint(HwDbgInfo_addr addr) {
-    HsaEnableBreakpointPacket packet (0);
-    DispatchPacket(packet);
+    QueueBreakpointOp(HSAIL_BREAKPOINT_OP_ENABLE, addr);
 }
 
 void NativeHSADebug::DisableBreakpoint(HwDbgInfo_addr addr) {
-    HsaDisableBreakpointPacket packet (0);
-    DispatchPacket(packet);
+    QueueBreakpointOp(HSAIL_BREAKPOINT_OP_DISABLE, addr);
 }
 
 void NativeHSADebug::SetBreakpoint(HwDbgInfo_addr addr) {
-    auto line = 0;
-    HsaCreateBreakpointPacket packet (addr, 0, "", line);
-    DispatchPacket(packet);
+    QueueBreakpointOp(HSAIL_BREAKPOINT_OP_CREATE, addr);
+}
+
+void NativeHSADebug::SetBreakpointCondition(HwDbgInfo_addr addr, const std::vector<HsailConditionOp>& ops) {
+    {
+        Mutex::Locker locker (m_breakpoint_ops_mutex);
+        if (ops.empty())
+            m_breakpoint_conditions.erase(addr);
+        else
+            m_breakpoint_conditions[addr] = ops;
+    }
+    QueueBreakpointOp(HSAIL_BREAKPOINT_OP_CONDITION, addr);
+}
+
+void NativeHSADebug::SetBreakpointMode(HwDbgInfo_addr addr, HsailBreakpointMode mode) {
+    {
+        Mutex::Locker locker (m_breakpoint_ops_mutex);
+        if (mode == HSAIL_BREAKPOINT_MODE_STOP)
+            m_breakpoint_modes.erase(addr);
+        else
+            m_breakpoint_modes[addr] = mode;
+    }
+    QueueBreakpointOp(HSAIL_BREAKPOINT_OP_MODE, addr);
+}
+
+Error NativeHSADebug::GetBreakpointStats(HsaBreakpointStatsTable& table, std::size_t max_work_groups) {
+    auto stats_mem = m_breakpoint_stats_mem.Get<uint8_t>();
+    if (!stats_mem.Subview<HsailBreakpointStatsHeader>(0).at(0))
+        return Error("breakpoint statistics buffer unavailable");
+
+    // The agent may be rewriting the statistics, take copies until one
+    // was not overlapped by a write. Writes take microseconds, but the
+    // agent can be stopped in the middle of one
+    static const int k_max_attempts = 1000;
+    std::vector<uint8_t> copy;
+    bool consistent = false;
+    for (int attempt=0; attempt < k_max_attempts && !consistent; ++attempt) {
+        consistent = HsaBreakpointStatsTryCopy(stats_mem.data(), stats_mem.size(), copy);
+        if (!consistent)
+            usleep(10);
+    }
+    if (!consistent)
+        return Error("the agent is updating the breakpoint statistics");
+
+    if (!HsaBreakpointStatsFromCopy(copy, max_work_groups, table))
+        return Error("malformed breakpoint statistics");
+
+    return Error();
+}
+
+void NativeHSADebug::SetDispatchFilter(bool all_kernels, const std::vector<std::string>& kernel_names) {
+    LogBkpt("NativeHSADebug::SetDispatchFilter: %s, %zu kernels", all_kernels ? "all kernels" : "by name",
+            kernel_names.size());
+
+    // The agent selects every kernel while it takes in the filter, so it
+    // never skips a dispatch it is halfway through being told about
+    DispatchPacket(HsaDispatchFilterBeginPacket());
+    if (all_kernels)
+        DispatchPacket(HsaDispatchFilterKernelPacket(""));
+    for (const auto& kernel_name : kernel_names) {
+        if (kernel_name.size() >= AGENT_MAX_FUNC_NAME_LEN) {
+            // A truncated name would never match, have the agent stop for every kernel instead
+            LogBkpt("NativeHSADebug::SetDispatchFilter: kernel name %s is too long", kernel_name.c_str());
+            DispatchPacket(HsaDispatchFilterKernelPacket(""));
+            continue;
+        }
+        DispatchPacket(HsaDispatchFilterKernelPacket(kernel_name));
+    }
+    DispatchPacket(HsaDispatchFilterEndPacket());
 }
 
 void NativeHSADebug::KillAllWaves() {
@@ -114,6 +481,14 @@ void NativeHSADebug::Continue() {
         DispatchMomentaryBreakpoints();
     }
 
+    // Before the agent has started debugging the batch buffer does not
+    // exist yet, queued operations go out in DebuggingBegun
+    if (m_debugging_begun) {
+        Error error = DispatchBreakpointOps();
+        if (error.Fail())
+            LogBkpt("NativeHSADebug::Continue: %s", error.AsCString());
+    }
+
     HsaContinueDispatchPacket packet;
     DispatchPacket(packet);
 }
@@ -122,12 +497,17 @@ void NativeHSADebug::Continue() {
 void NativeHSADebug::DebuggingBegun(const HsaDebugNotificationPacket& packet) {
     m_debugging_begun = true;
     m_kernel_state = KernelState::Started;
-  
+
+    // Breakpoints have to be in place before any buffered continue
+    Error error = DispatchBreakpointOps();
+    if (error.Fail())
+        LogBkpt("NativeHSADebug::DebuggingBegun: %s", error.AsCString());
     FlushPacketBuffer();
 }
 
 void NativeHSADebug::DebuggingEnded(const HsaDebugNotificationPacket& packet) {
     m_kernel_state = KernelState::Ended;
+    m_debug_thread_tid = LLDB_INVALID_THREAD_ID;
 }
 
 
@@ -135,42 +515,61 @@ void NativeHSADebug::Predispatch(const HsaDebugNotificationPacket& packet) {
 }
 
 void NativeHSADebug::StartDebugThread(const HsaDebugNotificationPacket& packet) {
+    // Comes before the first breakpoint notification of the dispatch, so
+    // it is known by the time the process stops for one
+    m_debug_thread_tid = packet.m_packet.payload.StartDebugThreadNotification.m_tid;
+    LogMsg("NativeHSADebug::StartDebugThread: agent debug thread %" PRIu64, static_cast<uint64_t>(m_debug_thread_tid));
 }
 
 void NativeHSADebug::NewBinary(const HsaDebugNotificationPacket& packet) {
     m_has_new_binary = true;
 
+    Mutex::Locker locker (m_wavefront_mutex);
     m_n_work_groups = packet.m_packet.payload.BinaryNotification.m_workGroupSize;
     m_work_items = packet.m_packet.payload.BinaryNotification.m_gridSize;
     m_work_group_size.x = m_work_items.x == 0 || m_n_work_groups.x == 0 ? 0 : m_work_items.x / m_n_work_groups.x;
     m_work_group_size.y = m_work_items.y == 0 || m_n_work_groups.y == 0 ? 0 : m_work_items.y / m_n_work_groups.y;
     m_work_group_size.z = m_work_items.z == 0 || m_n_work_groups.z == 0 ? 0 : m_work_items.z / m_n_work_groups.z;
+    locker.Unlock();
 
     //signal as soon as possible to avoid race conditions
     m_native_process.Signal(SIGCHLD);
 }
 
+// 64-bit FNV-1a, stable across processes so client and server agree on it
+static uint64_t HashBinary (const uint8_t* data, std::size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (std::size_t i=0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
 bool NativeHSADebug::HasNewBinary() {
     if (!m_has_new_binary) return false;
 
-    auto raw_bin_up = GetBinaryMem();
-    auto raw_bin = raw_bin_up.get();
-
-    std::size_t binary_size = reinterpret_cast<std::size_t*>(raw_bin)[0];
-    std::vector<char> binary (binary_size);
-    raw_bin += sizeof(std::size_t);
-    std::copy(raw_bin, raw_bin + binary_size, std::begin(binary));
-
-    llvm::SmallString<PATH_MAX> output_file_path{};
-    int temp_fd;
-    llvm::sys::fs::createTemporaryFile("hsa_binary.%%%%%%", "", temp_fd, output_file_path);
-    File file (temp_fd, true);
-
-    m_binary_file = output_file_path.c_str();
-
-    size_t bytes_written = binary.size();
-    if (file.Write(binary.data(), bytes_written).Success()) {
+    // The agent grows the binary buffer for large code objects, attach
+    // whatever segment it wrote this binary to
+    m_binary_mem.Invalidate();
+    auto binary_mem = m_binary_mem.Get<uint8_t>();
+    auto binary_size_ptr = binary_mem.Subview<std::size_t>(0).at(0);
+    if (!binary_size_ptr) {
+        LogMsg("NativeHSADebug::HasNewBinary: binary buffer unavailable");
+        return false;
+    }
 
+    // This is the only copy out of shared memory, the gdb-remote server
+    // streams straight out of this buffer
+    auto raw_bin = binary_mem.Subview<uint8_t>(sizeof(std::size_t));
+    std::size_t binary_size = std::min(*binary_size_ptr, raw_bin.size());
+    lldb::DataBufferSP binary_sp (new DataBufferHeap(raw_bin.data(), binary_size));
+    uint64_t hash = HashBinary(binary_sp->GetBytes(), binary_sp->GetByteSize());
+
+    {
+        Mutex::Locker locker (m_binary_mutex);
+        m_binary_data_sp = binary_sp;
+        m_binary_hash = hash;
     }
 
     m_has_new_binary = false;
@@ -178,13 +577,49 @@ bool NativeHSADebug::HasNewBinary() {
     return true;
 }
 
+bool NativeHSADebug::GetBinary(lldb::DataBufferSP& data_sp, uint64_t& hash) {
+    Mutex::Locker locker (m_binary_mutex);
+    if (!m_binary_data_sp) return false;
+
+    data_sp = m_binary_data_sp;
+    hash = m_binary_hash;
+    return true;
+}
+
+void NativeHSADebug::AgentUnloaded(const HsaDebugNotificationPacket& packet) {
+    // The agent releases its segments when it unloads and a later agent
+    // will create new ones under the same keys, so drop our mappings
+    m_debug_thread_tid = LLDB_INVALID_THREAD_ID;
+    InvalidateSharedMemory();
+}
+
+void NativeHSADebug::InvalidateSharedMemory() {
+    m_wave_info_mem.Invalidate();
+    m_momentary_bp_mem.Invalidate();
+    m_binary_mem.Invalidate();
+    m_breakpoint_batch_mem.Invalidate();
+    m_read_batch_mem.Invalidate();
+    m_breakpoint_stats_mem.Invalidate();
+}
+
 void NativeHSADebug::FocusChanged(const HsaDebugNotificationPacket& packet) {
 
 }
 
+NativeHSADebug::~NativeHSADebug() {
+    // Wake the reader thread out of its blocking wait and let it exit
+    // before m_comms goes away
+    m_comms.shutdown();
+    if (m_reader_thread.IsJoinable()) {
+        m_reader_thread.Join(nullptr);
+    }
+}
+
 void NativeHSADebug::DoRun () {
-    m_comms.init();
-    while (true) {
+    m_comms.init(m_session.fifo_dir, m_session.owns_fifo_dir);
+    while (!m_comms.isShutdown()) {
+        // Blocks until the agent writes to the FIFO, so this thread is
+        // idle while the GPU is running
         auto packet = m_comms.readPacket();
 
         if (packet) {
@@ -192,7 +627,7 @@ void NativeHSADebug::DoRun () {
             switch (packet->m_packet.m_Notification) {
             case HSAIL_NOTIFY_BREAKPOINT_HIT: LogMsg("HSAIL_NOTIFY_BREAKPOINT_HIT"); BreakpointHit(*packet); break;
             case HSAIL_NOTIFY_NEW_BINARY: LogMsg("HSAIL_NOTIFY_NEW_BINARY"); NewBinary(*packet); break;
-            case HSAIL_NOTIFY_AGENT_UNLOAD: LogMsg("HSAIL_NOTIFY_AGENT_UNLOAD"); break;
+            case HSAIL_NOTIFY_AGENT_UNLOAD: LogMsg("HSAIL_NOTIFY_AGENT_UNLOAD"); AgentUnloaded(*packet); break;
             case HSAIL_NOTIFY_BEGIN_DEBUGGING: LogMsg("HSAIL_NOTIFY_BEGIN_DEBUGGING"); DebuggingBegun(*packet); break;
             case HSAIL_NOTIFY_END_DEBUGGING: LogMsg("HSAIL_NOTIFY_END_DEBUGGING"); DebuggingEnded(*packet); break;
             case HSAIL_NOTIFY_FOCUS_CHANGE: LogMsg("HSAIL_NOTIFY_FOCUS_CHANGE"); FocusChanged(*packet); break;
@@ -201,10 +636,65 @@ void NativeHSADebug::DoRun () {
             case HSAIL_NOTIFY_UNKNOWN:
             default: break;
             }
+        } else {
+            LogMsg("NativeHSADebug: notification channel closed");
+            break;
         }
     }
 }
 
+HsaDebugSession HsaDebugSession::Create () {
+    HsaDebugSession session;
+
+    // Unique among the debug servers running on this machine, unless the
+    // user picked a session for an agent that was not launched by us
+    session.id = GetDebugSessionIdFromEnv() > 0 ? GetDebugSessionIdFromEnv() : getpid();
+    session.fifo_dir = GetDebugSessionFifoDirFromEnv();
+    if (!session.fifo_dir.empty())
+        return session;
+
+    std::string fifo_dir (gs_DebugSessionFifoDirTemplate);
+    if (mkdtemp(&fifo_dir[0]) == nullptr) {
+        LogMsg("HsaDebugSession::Create: could not create a FIFO directory (%d), using the fixed FIFO names", errno);
+        return session;
+    }
+
+    session.fifo_dir = fifo_dir;
+    session.owns_fifo_dir = true;
+    return session;
+}
+
+HsaDebugSession HsaDebugSession::FromProcess (lldb::pid_t pid) {
+    const std::string proc_dir = "/proc/" + std::to_string(pid);
+    std::ifstream environ_file (proc_dir + "/environ");
+    const std::string environ ((std::istreambuf_iterator<char>(environ_file)), std::istreambuf_iterator<char>());
+
+    const std::string id_var = std::string(gs_DebugSessionIdEnvVar) + "=";
+    const std::string dir_var = std::string(gs_DebugSessionFifoDirEnvVar) + "=";
+
+    // Entries are NUL terminated
+    HsaDebugSession session;
+    std::size_t pos = 0;
+    while (pos < environ.size()) {
+        std::size_t end = environ.find('\0', pos);
+        if (end == std::string::npos)
+            end = environ.size();
+
+        const std::string entry = environ.substr(pos, end - pos);
+        if (entry.compare(0, id_var.size(), id_var) == 0)
+            session.id = std::max(std::atoi(entry.c_str() + id_var.size()), 0);
+        else if (entry.compare(0, dir_var.size(), dir_var) == 0)
+            session.fifo_dir = entry.substr(dir_var.size());
+        pos = end + 1;
+    }
+
+    // The fixed FIFO names are relative to the agent's working directory,
+    // not ours
+    if (session.fifo_dir.empty())
+        session.fifo_dir = proc_dir + "/cwd";
+    return session;
+}
+
 void* NativeHSADebug::Run(void* void_debug) {
     auto debug = static_cast<NativeHSADebug*>(void_debug);
     debug->DoRun();
@@ -213,21 +703,63 @@ void* NativeHSADebug::Run(void* void_debug) {
 
 
 void NativeHSADebug::UpdateWavefrontInfo (std::size_t num_waves, HsailWaveDim3 work_group_size) {
-    Mutex::Locker locker (m_wavefront_mutex);
+    auto wave_buffer = m_wave_info_mem.Get<uint8_t>();
+    auto header = wave_buffer.Subview<HsailWaveBufferHeader>(0).at(0);
+
+    // The agent grew the buffer for this dispatch, it left the new size in
+    // the old buffer before removing it
+    if (header && header->m_capacity > wave_buffer.size()) {
+        LogMsg("NativeHSADebug::UpdateWavefrontInfo: wave buffer grew to %" PRIu64 " bytes", header->m_capacity);
+        m_wave_info_mem.Invalidate();
+        wave_buffer = m_wave_info_mem.Get<uint8_t>();
+        header = wave_buffer.Subview<HsailWaveBufferHeader>(0).at(0);
+    }
 
-    auto wave_info = GetWaveInfoMem();
-    m_wavefront_info.clear();
-    m_new_wavefronts.clear();
-  
-    if (m_wavefront_info.size() != num_waves) {
-        for (size_t i=0; i < num_waves; ++i) {
-            m_new_wavefronts.emplace(wave_info.get()[i], work_group_size);
-        }
+    if (!header || header->m_version != HSAIL_WAVE_BUFFER_VERSION) {
+        LogMsg("NativeHSADebug::UpdateWavefrontInfo: unsupported wave buffer version %u",
+               header ? header->m_version : 0);
+        wave_buffer = HsaSharedMemoryView<uint8_t>();
     }
+    else if (header->m_numWaves != num_waves) {
+        LogMsg("NativeHSADebug::UpdateWavefrontInfo: %zu waves reported, buffer holds %u",
+               num_waves, header->m_numWaves);
+    }
+
+    // Build the new table outside of the lock, readers keep using the
+    // previous one until we swap it in below
+    HsaWavefrontTableSP wavefronts = std::make_shared<HsaWavefrontTable>(wave_buffer.data(), wave_buffer.size(),
+                                                                         work_group_size);
+
+    Mutex::Locker locker (m_wavefront_mutex);
+    m_wavefront_info = wavefronts;
+    ++m_wavefront_version;
+    m_wavefront_condition.Broadcast();
+}
 
-    for (size_t i=0; i < num_waves; ++i) {
-        m_wavefront_info.emplace(wave_info.get()[i], work_group_size);
+HsaWavefrontTableSP NativeHSADebug::GetWavefrontInfo (uint32_t* version) {
+    Mutex::Locker locker (m_wavefront_mutex);
+
+    if (version) *version = m_wavefront_version;
+    if (!m_wavefront_info) return std::make_shared<HsaWavefrontTable>();
+    return m_wavefront_info;
+}
+
+HsaWavefrontTableSP NativeHSADebug::WaitForWavefrontInfo (uint32_t version, uint64_t timeout_usec,
+                                                          uint32_t* new_version, bool* timed_out) {
+    Mutex::Locker locker (m_wavefront_mutex);
+
+    TimeValue abstime = TimeValue::Now();
+    abstime.OffsetWithMicroSeconds(timeout_usec);
+
+    bool did_time_out = false;
+    while (m_wavefront_version <= version && !did_time_out) {
+        m_wavefront_condition.Wait(m_wavefront_mutex, &abstime, &did_time_out);
     }
+
+    if (timed_out) *timed_out = did_time_out && m_wavefront_version <= version;
+    if (new_version) *new_version = m_wavefront_version;
+    if (!m_wavefront_info) return std::make_shared<HsaWavefrontTable>();
+    return m_wavefront_info;
 }
 
 void NativeHSADebug::BreakpointHit(const HsaDebugNotificationPacket& packet) {
@@ -238,16 +770,23 @@ void NativeHSADebug::BreakpointHit(const HsaDebugNotificationPacket& packet) {
     m_kernel_state = KernelState::Started;
 }
 
-NativeHSADebug::Registers NativeHSADebug::ReadRegisters (uint32_t frame_idx) {
-    Registers reg;
+bool NativeHSADebug::ReadWaveRegisters (uint64_t global_id, WaveRegisters& regs) {
+    HsaWavefrontTableSP wavefronts = GetWavefrontInfo();
+    std::size_t idx = wavefronts->FindGlobalID(global_id);
+    if (idx == HsaWavefrontTable::npos) return false;
 
-    return reg;
+    regs.pc = wavefronts->GetPC(idx);
+    regs.exec_mask = wavefronts->GetExecMask(idx);
+    regs.wave_address = wavefronts->GetWaveAddress(idx);
+    regs.work_group_id = wavefronts->GetWorkGroupID(idx);
+    return true;
 }
 
-HwDbgInfo_addr NativeHSADebug::GetPC (size_t wavefront_idx) {
-    auto wave_info = GetWaveInfoMem();
-    if (!wave_info) return 0;
-    return wave_info.get()[wavefront_idx].pc;
+HwDbgInfo_addr NativeHSADebug::GetPC (uint64_t global_id) {
+    HsaWavefrontTableSP wavefronts = GetWavefrontInfo();
+    std::size_t idx = wavefronts->FindGlobalID(global_id);
+    if (idx == HsaWavefrontTable::npos) return 0;
+    return wavefronts->GetPC(idx);
 }
 
 bool NativeHSADebug::JustHitBreakpoint (size_t wavefront_idx) {
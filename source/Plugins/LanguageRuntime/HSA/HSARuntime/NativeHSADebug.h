@@ -14,116 +14,250 @@
 // C Includes
 // C++ Includes
 #include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
 #include <unordered_map>
+#include "lldb/Core/DataBufferHeap.h"
 #include "lldb/Core/Error.h"
+#include "lldb/Host/Condition.h"
 #include "lldb/Host/File.h"
 #include "lldb/Core/StreamFile.h"
 #include "lldb/Core/Stream.h"
 #include "lldb/Host/common/NativeProcessProtocol.h"
 #include "lldb/Host/Mutex.h"
+#include "lldb/Host/HostThread.h"
 #include "lldb/Host/ThreadLauncher.h"
+#include "lldb/Host/TimeValue.h"
 // Other libraries and framework includes
 #include "llvm/Support/FileSystem.h"
 // Project includes
+#include "HsaBreakpointStats.h"
 #include "HsaDebugPacket.h"
+#include "HsaReadRequest.h"
+#include "HsaSharedMemory.h"
+#include "HsaWavefrontTable.h"
 #include "CommunicationParams.h"
 #include "Plugins/SymbolFile/AMDHSA/FacilitiesInterface.h"
 
 namespace lldb_private {
-    class HsaWavefront {
-    public:
-        HsaWavefront (const HsailAgentWaveInfo& info, const HsailWaveDim3& group_size) 
-            : m_global_id (0),
-              m_wave_info (info)
-        {
-            const auto& wg = info.workGroupId;
-            m_global_id = wg.x + wg.y * group_size.x + wg.z * group_size.x * group_size.y;
-        }
-
-        uint64_t GetGlobalID() const { return m_global_id; }
-        HsailWaveDim3 GetWorkGroupID() const { return m_wave_info.workGroupId; }
-        const HsailWaveDim3* GetWorkItemIDs() const { return m_wave_info.workItemId; }
-        uint64_t GetExecMask() const { return m_wave_info.execMask; }
-        HsailWaveAddress GetWaveAddress() const { return m_wave_info.waveAddress; }
-        HsailProgramCounter GetPC() const { return m_wave_info.pc; }
+    void handleSigAlrm (int sig);
 
-    private:
-        uint64_t m_global_id;
-        HsailAgentWaveInfo m_wave_info;
-        
+    //------------------------------------------------------------------
+    /// Where the agent of a process meets its debugger: the session ID
+    /// makes the shared memory keys unique, the FIFOs are in fifo_dir.
+    //------------------------------------------------------------------
+    struct HsaDebugSession {
+        int id = 0;                 ///< 0 for the fixed shared memory keys
+        std::string fifo_dir;       ///< Empty for the fixed FIFO names
+        bool owns_fifo_dir = false; ///< Remove the FIFOs and fifo_dir when done
+
+        //------------------------------------------------------------------
+        /// A new session for a process we launch, its agent gets it in its
+        /// environment. The FIFOs go into a new private directory.
+        //------------------------------------------------------------------
+        static HsaDebugSession Create();
+
+        //------------------------------------------------------------------
+        /// The session the agent of a running process was started in, read
+        /// from its environment. An agent that was not started in a session
+        /// uses the fixed keys, and the fixed FIFO names in its working
+        /// directory.
+        //------------------------------------------------------------------
+        static HsaDebugSession FromProcess(lldb::pid_t pid);
     };
 
-    using HsaWavefronts = std::set<HsaWavefront>;
-
-    inline bool operator< (const HsaWavefront& rhs, const HsaWavefront& lhs) {
-        return rhs.GetGlobalID() < lhs.GetGlobalID();
-    }
-
-    void handleSigAlrm (int sig);
-
     class NativeHSADebug {
     private:
         void FlushPacketBuffer();
         void DispatchPacket (const HsaPacket& packet);
     
     public:
-        NativeHSADebug(NativeProcessProtocol& native_process)
-            : m_native_process(native_process),
+        NativeHSADebug(NativeProcessProtocol& native_process, const HsaDebugSession& session)
+            : m_session(session),
+              m_wave_info_mem(GetDebugSessionShmKey(g_WAVE_BUFFER_SHMKEY, session.id), 0),
+              m_momentary_bp_mem(GetDebugSessionShmKey(g_MOMENTARY_BP_BUFFER_SHMKEY, session.id), 0),
+              m_binary_mem(GetDebugSessionShmKey(g_DBEBINARY_SHMKEY, session.id), 0),
+              m_breakpoint_batch_mem(GetDebugSessionShmKey(g_BREAKPOINT_BATCH_SHMKEY, session.id), 0),
+              m_read_batch_mem(GetDebugSessionShmKey(g_READ_BATCH_SHMKEY, session.id), 0),
+              m_breakpoint_stats_mem(GetDebugSessionShmKey(g_BREAKPOINT_STATS_SHMKEY, session.id), 0),
+              m_native_process(native_process),
               m_has_new_binary(false)
         {
             lldb_private::Error error;
-            lldb_private::ThreadLauncher::LaunchThread("NativeHSADebug",
-                                                       Run, this,
-                                                       &error);
+            m_reader_thread = lldb_private::ThreadLauncher::LaunchThread("NativeHSADebug",
+                                                                         Run, this,
+                                                                         &error);
         }
 
-        HsaWavefronts GetNewWavefronts() {
-            Mutex::Locker locker (m_wavefront_mutex);
-
-            HsaWavefronts ret;
-            std::swap(m_new_wavefronts, ret);
-            return ret;
-        }
-
-        const HsaWavefronts& GetWavefrontInfo() {
-            Mutex::Locker locker (m_wavefront_mutex);
-            return m_wavefront_info;
-        }
+        ~NativeHSADebug();
+
+        const HsaDebugSession& GetSession() const { return m_session; }
+
+        //------------------------------------------------------------------
+        /// Get the latest published wavefront table.
+        ///
+        /// @param[out] version
+        ///     If non-null, set to the version of the returned table.
+        ///     Versions start at 0 (no snapshot yet) and increase by one
+        ///     every time the agent reports a breakpoint hit.
+        //------------------------------------------------------------------
+        HsaWavefrontTableSP GetWavefrontInfo(uint32_t* version = nullptr);
+
+        //------------------------------------------------------------------
+        /// Block until a table newer than \a version is published, or
+        /// until \a timeout_usec microseconds have passed.
+        ///
+        /// @return
+        ///     The latest table. If the wait timed out this is the
+        ///     table at \a version (or older) and \a timed_out is set.
+        //------------------------------------------------------------------
+        HsaWavefrontTableSP WaitForWavefrontInfo(uint32_t version, uint64_t timeout_usec,
+                                                 uint32_t* new_version, bool* timed_out);
 
         void SetBreakpoint(HwDbgInfo_addr addr);
         void DeleteBreakpoint(HwDbgInfo_addr addr);
         void EnableBreakpoint(HwDbgInfo_addr addr);
         void DisableBreakpoint(HwDbgInfo_addr addr);
 
+        //------------------------------------------------------------------
+        /// Have the agent evaluate a condition for every wave that traps
+        /// at a breakpoint, waves it does not hold for are resumed by the
+        /// agent without stopping. An empty program removes the condition.
+        ///
+        /// The condition goes out with the next breakpoint batch and stays
+        /// with the breakpoint until it is deleted.
+        //------------------------------------------------------------------
+        void SetBreakpointCondition(HwDbgInfo_addr addr, const std::vector<HsailConditionOp>& ops);
+
+        //------------------------------------------------------------------
+        /// Send the queued breakpoint operations now and wait for the agent
+        /// to apply them. Only the agent's debug thread applies batches, so
+        /// this is for HSA stops, where that thread keeps running.
+        ///
+        /// @return
+        ///     An error naming the first operation the agent could not
+        ///     apply, for example a condition it cannot run.
+        //------------------------------------------------------------------
+        Error ApplyBreakpointOps();
+
+        // Trace breakpoints are counted by the agent but never stop, the
+        // mode goes out with the next breakpoint batch like conditions do
+        void SetBreakpointMode(HwDbgInfo_addr addr, HsailBreakpointMode mode);
+
+        //------------------------------------------------------------------
+        /// Tell the agent which kernels the client has breakpoints in.
+        /// Dispatches of other kernels that no PC breakpoint can stop run
+        /// without the agent debugging them or publishing their binary.
+        ///
+        /// @param[in] all_kernels
+        ///     Debug every dispatch, as the agent does until it gets a
+        ///     filter.
+        ///
+        /// @param[in] kernel_names
+        ///     The kernels to debug the dispatches of.
+        //------------------------------------------------------------------
+        void SetDispatchFilter(bool all_kernels, const std::vector<std::string>& kernel_names);
+
         void SetMomentaryBreakpoint(HwDbgInfo_addr addrs);
+
+        //------------------------------------------------------------------
+        /// Replace the step breakpoints, the momentary breakpoints of the
+        /// line being stepped through. Unlike other momentary breakpoints
+        /// the agent keeps them across stops, so they only go out again
+        /// once the line changes. An empty set clears them.
+        ///
+        /// The set goes out with the next breakpoint batch.
+        //------------------------------------------------------------------
+        void SetStepBreakpoints(const std::vector<HwDbgInfo_addr>& addrs);
         void KillAllWaves();
         void Continue();
         void DebuggingBegun(const HsaDebugNotificationPacket& packet);
         void DebuggingEnded(const HsaDebugNotificationPacket& packet);
         void NewBinary(const HsaDebugNotificationPacket& packet);
         void FocusChanged(const HsaDebugNotificationPacket& packet);
+        void AgentUnloaded(const HsaDebugNotificationPacket& packet);
+
+        // Detach from the agent's shared memory segments; they are
+        // attached again on next use
+        void InvalidateSharedMemory();
 
         bool HasNewBinary();
 
         bool IsKernelFinished() { return m_kernel_state == KernelState::Ended; }
 
-        HwDbgInfo_addr GetPC(size_t wavefront_idx);
+        // The agent thread that serves our commands while a dispatch is
+        // debugged, LLDB_INVALID_THREAD_ID outside of a dispatch. It has
+        // to keep running while the process is stopped, reads and
+        // breakpoint batches are only served by it.
+        lldb::tid_t GetDebugThreadID() const { return m_debug_thread_tid; }
+
+        // Program counter of the wave with the given global ID at the
+        // last stop
+        HwDbgInfo_addr GetPC(uint64_t global_id);
 
         static void* Run(void*);
         void DoRun();
 
-        struct Registers {
+        // The registers of a wave as the agent captured them when the
+        // dispatch stopped, one row of the wavefront table
+        struct WaveRegisters {
             HwDbgInfo_addr pc;
-            HwDbgInfo_addr fp;
-            HwDbgInfo_addr mp;
+            uint64_t exec_mask;
+            HsailWaveAddress wave_address;
+            HsailWaveDim3 work_group_id;
         };
-        Registers ReadRegisters (uint32_t frame_idx);
+
+        // Registers of the wave with the given global ID at the last
+        // stop, false if that wave is not stopped
+        bool ReadWaveRegisters (uint64_t global_id, WaveRegisters& regs);
 
         bool JustHitBreakpoint(size_t wavefront_idx);
 
-        std::string GetBinaryFileName() {
-            return m_binary_file;
-        }
+        //------------------------------------------------------------------
+        /// Get the code object most recently published by the agent.
+        ///
+        /// @param[out] hash
+        ///     A content hash of the code object, clients use it to skip
+        ///     transferring a code object they already have.
+        ///
+        /// @return
+        ///     false if the agent has not published a code object yet.
+        //------------------------------------------------------------------
+        bool GetBinary(lldb::DataBufferSP& data_sp, uint64_t& hash);
+
+        //------------------------------------------------------------------
+        /// Have the agent serve variable and memory reads while the
+        /// dispatch is stopped. The work-group of every request must be
+        /// filled in already.
+        ///
+        /// Requests are sent through shared memory in as few batches as
+        /// fit, the status and bytes of each are filled in on return.
+        ///
+        /// @return
+        ///     An error if the agent could not be asked, individual
+        ///     requests can still fail when this succeeds.
+        //------------------------------------------------------------------
+        Error ReadBatch(HsaReadRequests& requests);
+
+        // Size of the agent's read batch buffer, 0 if it is unavailable.
+        // A request and its result have to fit into it in one piece
+        std::size_t GetReadBatchCapacity();
+
+        // Work-items per work-group of the dispatch being debugged, 0 in
+        // dimensions the agent did not report
+        HsailWaveDim3 GetWorkGroupSize();
+
+        //------------------------------------------------------------------
+        /// Get the hits the agent counted for every HSA breakpoint. The
+        /// agent keeps them up to date in shared memory, so they can be
+        /// read whether or not the dispatch is stopped.
+        ///
+        /// @param[in] max_work_groups
+        ///     How many work-groups to return per breakpoint, those with
+        ///     the most wave hits.
+        //------------------------------------------------------------------
+        Error GetBreakpointStats(HsaBreakpointStatsTable& table, std::size_t max_work_groups);
 
     private:
         enum class KernelState {
@@ -138,14 +272,31 @@ namespace lldb_private {
 
         void DispatchMomentaryBreakpoints();
 
+        // Breakpoint changes are queued and sent to the agent as one batch
+        // through shared memory, before the agent is continued
+        void QueueBreakpointOp(HsailBreakpointOpCode op, HwDbgInfo_addr addr);
+        Error DispatchBreakpointOps();
+        bool WaitForBreakpointBatchConsumed(const HsaSharedMemoryView<HsailBreakpointBatchHeader>& header);
+        void DispatchBreakpointOpPacket(const HsailBreakpointOp& op);
+
+        // The agent sets the status of every operation of a batch it
+        // consumes, reports the first failure of the last batch once
+        Error TakeBreakpointBatchStatus();
+
+        // Sends the requests [start, end) as one batch and waits for the results
+        Error DispatchReadBatch(HsaReadRequests& requests, std::size_t start, std::size_t end);
+
         HsaDebugComms m_comms;
+        HostThread m_reader_thread;
         bool m_debugging_begun = false;
         std::vector<std::unique_ptr<HsaPacket>> m_packet_buffer;
         KernelState m_kernel_state = KernelState::NotStarted;
+        std::atomic<lldb::tid_t> m_debug_thread_tid { LLDB_INVALID_THREAD_ID };
 
         Mutex m_wavefront_mutex;
-        HsaWavefronts m_wavefront_info;
-        HsaWavefronts m_new_wavefronts;
+        Condition m_wavefront_condition;
+        HsaWavefrontTableSP m_wavefront_info;
+        uint32_t m_wavefront_version = 0;
         HsailWaveDim3 m_n_work_groups;
         HsailWaveDim3 m_work_items;
         HsailWaveDim3 m_work_group_size;
@@ -153,9 +304,26 @@ namespace lldb_private {
 
         std::vector<HwDbgInfo_addr> m_momentary_breakpoints;
 
+        Mutex m_breakpoint_ops_mutex;
+        std::vector<HsailBreakpointOp> m_breakpoint_ops;
+        std::unordered_map<HwDbgInfo_addr, std::vector<HsailConditionOp>> m_breakpoint_conditions;
+        std::unordered_map<HwDbgInfo_addr, HsailBreakpointMode> m_breakpoint_modes;
+
+        Mutex m_read_batch_mutex;
+
+        const HsaDebugSession m_session;
+        HsaSharedMemorySegment m_wave_info_mem;
+        HsaSharedMemorySegment m_momentary_bp_mem;
+        HsaSharedMemorySegment m_binary_mem;
+        HsaSharedMemorySegment m_breakpoint_batch_mem;
+        HsaSharedMemorySegment m_read_batch_mem;
+        HsaSharedMemorySegment m_breakpoint_stats_mem;
+
         NativeProcessProtocol& m_native_process;
         
-        std::string m_binary_file;
+        Mutex m_binary_mutex;
+        lldb::DataBufferSP m_binary_data_sp;
+        uint64_t m_binary_hash = 0;
         bool m_has_new_binary;
     };
 
@@ -7,6 +7,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <cstring>
+
 #include "NativeRegisterContextHSA.h"
 
 #define DECLARE_REGISTER_INFOS_HSA_STRUCT
@@ -26,10 +28,48 @@ using namespace lldb_private;
 namespace
 {
     static const uint32_t 
-    g_regs[] = { 0, 1, 2, LLDB_INVALID_REGNUM };
+    g_regs[] = { gpr_pc_hsa, gpr_fp_hsa, gpr_mp_hsa, LLDB_INVALID_REGNUM };
+
+    static const uint32_t
+    g_wave_regs[] = { wave_exec_hsa, wave_address_hsa, wave_group_x_hsa, wave_group_y_hsa, wave_group_z_hsa, LLDB_INVALID_REGNUM };
 
+    // Only the first set is expedited in stop replies, the wave registers
+    // are read with the g packet when the client asks for them
     static const RegisterSet
-    g_reg_set_hsa = { "General Purpose Registers", "gpr", 3, g_regs };
+    g_reg_sets_hsa[] = {
+        { "General Purpose Registers", "gpr", k_num_gpr_registers_hsa, g_regs },
+        { "Wave Registers", "wave", k_num_wave_registers_hsa, g_wave_regs }
+    };
+
+    static const uint32_t k_num_register_sets_hsa = sizeof(g_reg_sets_hsa) / sizeof(g_reg_sets_hsa[0]);
+
+    // The value of a register of the wave, the call frame registers need
+    // the debug info so the client computes them
+    static uint64_t
+    GetWaveRegisterValue (const NativeHSADebug::WaveRegisters& regs, uint32_t reg)
+    {
+        switch (reg)
+        {
+        case gpr_pc_hsa:        return regs.pc;
+        case wave_exec_hsa:     return regs.exec_mask;
+        case wave_address_hsa:  return regs.wave_address;
+        case wave_group_x_hsa:  return regs.work_group_id.x;
+        case wave_group_y_hsa:  return regs.work_group_id.y;
+        case wave_group_z_hsa:  return regs.work_group_id.z;
+        default:                return 0;
+        }
+    }
+
+    // The thread's wave as captured at the last stop, thread IDs are the
+    // wave's global ID plus one
+    static Error
+    ReadWaveRegisters (NativeHSADebug& hsa_debug, lldb::tid_t tid, NativeHSADebug::WaveRegisters& regs)
+    {
+        Error error;
+        if (!hsa_debug.ReadWaveRegisters(tid-1, regs))
+            error.SetErrorStringWithFormat("wave %" PRIu64 " is not stopped", tid-1);
+        return error;
+    }
 }
 
 NativeRegisterContextHSA*
@@ -52,33 +92,51 @@ NativeRegisterContextHSA::NativeRegisterContextHSA (NativeThreadProtocol &native
 uint32_t
 NativeRegisterContextHSA::GetRegisterSetCount () const
 {
-    return 1;
+    return k_num_register_sets_hsa;
 }
 
 uint32_t
 NativeRegisterContextHSA::GetUserRegisterCount() const
 {
-    return 3;
+    return k_num_registers;
 }
 
 uint32_t
 NativeRegisterContextHSA::GetRegisterCount() const
 {
-    return 3;
+    return k_num_registers;
 }
 
 
 const RegisterSet *
 NativeRegisterContextHSA::GetRegisterSet (uint32_t set_index) const
 {
-    return &g_reg_set_hsa;
+    if (set_index >= k_num_register_sets_hsa)
+        return nullptr;
+    return &g_reg_sets_hsa[set_index];
 }
 
 Error
 NativeRegisterContextHSA::ReadRegister (const RegisterInfo *reg_info, RegisterValue &reg_value)
 {
-    reg_value = (uint64_t)m_hsa_debug.GetPC(m_thread.GetID()-1);
-    return Error();
+    if (!reg_info)
+        return Error("reg_info NULL");
+
+    const uint32_t reg = reg_info->kinds[lldb::eRegisterKindLLDB];
+    if (reg >= k_num_registers)
+        return Error("register %" PRIu32 " is not an HSA register", reg);
+
+    NativeHSADebug::WaveRegisters regs;
+    Error error = ReadWaveRegisters(m_hsa_debug, m_thread.GetID(), regs);
+    if (error.Fail())
+        return error;
+
+    const uint64_t value = GetWaveRegisterValue(regs, reg);
+    if (reg_info->byte_size == sizeof(uint32_t))
+        reg_value.SetUInt32(static_cast<uint32_t>(value));
+    else
+        reg_value.SetUInt64(value);
+    return error;
 }
 
 Error
@@ -90,11 +148,29 @@ NativeRegisterContextHSA::WriteRegister (const RegisterInfo *reg_info, const Reg
 Error
 NativeRegisterContextHSA::ReadAllRegisterValues (lldb::DataBufferSP &data_sp)
 {
-    uint64_t data[] = { 0 };
-    for (int i=0; i<3; ++i) data[i] = m_hsa_debug.GetPC(m_thread.GetID()-1);
-    
-    data_sp.reset(new DataBufferHeap(data, sizeof(data)));
-    return Error();
+    // Every register comes from the same row of the wave snapshot, look
+    // it up once and lay the registers out like the g packet does
+    NativeHSADebug::WaveRegisters regs;
+    Error error = ReadWaveRegisters(m_hsa_debug, m_thread.GetID(), regs);
+    if (error.Fail())
+        return error;
+
+    DataBufferHeap* data = new DataBufferHeap(k_register_data_size_hsa, 0);
+    data_sp.reset(data);
+
+    for (uint32_t reg = 0; reg < k_num_registers; ++reg)
+    {
+        const RegisterInfo& reg_info = g_register_infos_hsa[reg];
+        const uint64_t value = GetWaveRegisterValue(regs, reg);
+        if (reg_info.byte_size == sizeof(uint32_t))
+        {
+            const uint32_t value32 = static_cast<uint32_t>(value);
+            ::memcpy(data->GetBytes() + reg_info.byte_offset, &value32, sizeof(value32));
+        }
+        else
+            ::memcpy(data->GetBytes() + reg_info.byte_offset, &value, sizeof(value));
+    }
+    return error;
 }
 
 Error
@@ -108,5 +184,7 @@ NativeRegisterContextHSA::WriteAllRegisterValues (const lldb::DataBufferSP &data
 const RegisterInfo *
 NativeRegisterContextHSA::GetRegisterInfoAtIndex (uint32_t reg) const
 {
+    if (reg >= k_num_registers)
+        return nullptr;
     return &g_register_infos_hsa[reg];
 }
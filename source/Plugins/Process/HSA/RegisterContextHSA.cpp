@@ -35,17 +35,28 @@ uint32_t g_gpr_regnums[] =
     gpr_mp_hsa,
 };
 
+static const
+uint32_t g_wave_regnums[] =
+{
+    wave_exec_hsa,
+    wave_address_hsa,
+    wave_group_x_hsa,
+    wave_group_y_hsa,
+    wave_group_z_hsa,
+};
+
 
 // Number of register sets provided by this context.
 enum
 {
-    k_num_register_sets = 1
+    k_num_register_sets = 2
 };
 
 static const RegisterSet
 g_reg_sets_hsa[k_num_register_sets] =
 {
-    { "General Purpose Registers",  "gpr", 3, g_gpr_regnums }
+    { "General Purpose Registers",  "gpr", k_num_gpr_registers_hsa, g_gpr_regnums },
+    { "Wave Registers",  "wave", k_num_wave_registers_hsa, g_wave_regnums }
 };
 
 
@@ -65,15 +76,18 @@ GetRegisterInfoCount()
     return static_cast<uint32_t>(sizeof(g_register_infos_hsa) / sizeof(g_register_infos_hsa[0]));
 }
 
-RegisterContextHSA::RegisterContextHSA(Thread &thread, uint32_t concrete_frame_idx) :
+RegisterContextHSA::RegisterContextHSA(Thread &thread, uint32_t concrete_frame_idx, UnwindHSA &unwinder) :
     RegisterContext(thread, concrete_frame_idx),
     m_register_info_p(GetRegisterInfoPtr()),
+    m_unwinder(unwinder),
+    m_registers(),
+    m_registers_valid(false),
     m_register_info_count(GetRegisterInfoCount())
 {
 }
 
 void RegisterContextHSA::InvalidateAllRegisters() {
-
+    m_registers_valid = false;
 }
 
 const lldb_private::RegisterInfo *
@@ -84,12 +98,12 @@ RegisterContextHSA::GetRegisterInfoAtIndex(size_t reg)
 
 size_t
 RegisterContextHSA::GetRegisterSetCount() {
-    return 1;
+    return k_num_register_sets;
 }
 
 const RegisterSet*
 RegisterContextHSA::GetRegisterSet(size_t reg) {
-    if (reg == 0) 
+    if (reg < k_num_register_sets) 
         return g_reg_sets_hsa + reg;
     else
         return nullptr;
@@ -104,10 +118,24 @@ RegisterContextHSA::GetRegisterCount()
 
 bool 
 RegisterContextHSA::ReadRegister(const RegisterInfo* reg_info, RegisterValue &reg_value) {
-    ReadAllRegisters();
+    if (!reg_info)
+        return false;
 
     const uint32_t reg_num = reg_info->kinds[eRegisterKindLLDB];
-    reg_value = m_registers[reg_num];
+    if (reg_num >= k_num_gpr_registers_hsa) {
+        // The wave registers do not change between frames, the frame 0
+        // context reads them for the whole wave at once
+        RegisterContextSP reg_ctx_sp (m_thread.GetRegisterContext());
+        if (!reg_ctx_sp || reg_ctx_sp.get() == this)
+            return false;
+        const RegisterInfo* wave_reg_info = reg_ctx_sp->GetRegisterInfoAtIndex(reg_num);
+        return wave_reg_info && reg_ctx_sp->ReadRegister(wave_reg_info, reg_value);
+    }
+
+    if (!ReadAllRegisters())
+        return false;
+
+    reg_value.SetUInt64(m_registers[reg_num]);
     return true;
 }
 
@@ -117,21 +145,19 @@ RegisterContextHSA::WriteRegister(const RegisterInfo* reg_info, const RegisterVa
 }
 
 bool RegisterContextHSA::ReadAllRegisters() {
-    ProcessSP process_sp (CalculateProcess());
-    if (process_sp) {
-        UnwindHSA unwinder (m_thread);
-
-        lldb::addr_t pc;
-        lldb::addr_t fp;
-        unwinder.DoGetFrameInfoAtIndex(m_concrete_frame_idx, fp, pc);
-        m_registers[0] = pc;
-        m_registers[1] = fp;
-        m_registers[2] = 0;
-
+    if (m_registers_valid)
         return true;
-    }
 
-    return false;
+    // The call stack is looked up once per stop by the thread's unwinder
+    const SymbolFileAMDHSA::CallFrame* frame = m_unwinder.GetCallFrame(m_concrete_frame_idx);
+    if (!frame)
+        return false;
+
+    m_registers[gpr_pc_hsa] = frame->m_pc;
+    m_registers[gpr_fp_hsa] = frame->m_fp;
+    m_registers[gpr_mp_hsa] = frame->m_mp;
+    m_registers_valid = true;
+    return true;
 }
 
 uint32_t
@@ -16,11 +16,13 @@
 
 namespace lldb_private {
 
+class UnwindHSA;
+
 class RegisterContextHSA
     : public lldb_private::RegisterContext
 {
 public:
-    RegisterContextHSA(Thread &thread, uint32_t concrete_frame_idx);
+    RegisterContextHSA(Thread &thread, uint32_t concrete_frame_idx, UnwindHSA &unwinder);
 
     ~RegisterContextHSA() override;
 
@@ -54,7 +56,9 @@ private:
   
 
     const lldb_private::RegisterInfo *m_register_info_p;
-    uint32_t m_registers[3];
+    UnwindHSA &m_unwinder;
+    uint64_t m_registers[3];    // pc, fp and mp of the frame, the wave registers are the same for all frames
+    bool m_registers_valid;
     uint32_t m_register_info_count;
 };
 
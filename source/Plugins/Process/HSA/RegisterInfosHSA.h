@@ -27,16 +27,33 @@ enum
   gpr_pc_hsa,
   gpr_fp_hsa,
   gpr_mp_hsa,
-  k_num_registers
+  wave_exec_hsa,
+  wave_address_hsa,
+  wave_group_x_hsa,
+  wave_group_y_hsa,
+  wave_group_z_hsa,
+  k_num_registers,
+  k_num_gpr_registers_hsa = wave_exec_hsa,
+  k_num_wave_registers_hsa = k_num_registers - wave_exec_hsa
 };
 
+// The registers of a wave are laid out in this order in the g packet, the
+// wave registers come from the agent's snapshot of the stopped waves
+static const uint32_t k_register_data_size_hsa = 48;
+
 static RegisterInfo g_register_infos_hsa[] = {
 // General purpose registers
 //  NAME        ALT     SZ  OFFSET              ENCODING        FORMAT          EH_FRAME                DWARF               GENERIC                     PROCESS PLUGIN          LLDB NATIVE   VALUE REGS    INVALIDATE REGS
 //  ======      ======= ==  =============       =============   ============    ===============         ===============     =========================   =====================   ============= ==========    ===============
-{   "pc",       nullptr, 4, 0,      eEncodingUint,  eFormatHex,     { gpr_pc_hsa,           gpr_pc_hsa,           LLDB_REGNUM_GENERIC_PC,   LLDB_REGNUM_GENERIC_PC,    gpr_pc_hsa      },      nullptr,        nullptr},
-{   "fp",       nullptr, 4, 0,      eEncodingUint,  eFormatHex,     { gpr_fp_hsa,           gpr_fp_hsa,           LLDB_REGNUM_GENERIC_FP,   LLDB_REGNUM_GENERIC_FP,    gpr_fp_hsa      },      nullptr,        nullptr},
-{   "mp",       nullptr, 4, 0,      eEncodingUint,  eFormatHex,     { gpr_mp_hsa,           gpr_mp_hsa,           LLDB_REGNUM_GENERIC_ARG1,   LLDB_INVALID_REGNUM,    gpr_mp_hsa      },      nullptr,        nullptr}
+{   "pc",       nullptr, 8, 0,      eEncodingUint,  eFormatHex,     { gpr_pc_hsa,           gpr_pc_hsa,           LLDB_REGNUM_GENERIC_PC,   LLDB_REGNUM_GENERIC_PC,    gpr_pc_hsa      },      nullptr,        nullptr},
+{   "fp",       nullptr, 8, 8,      eEncodingUint,  eFormatHex,     { gpr_fp_hsa,           gpr_fp_hsa,           LLDB_REGNUM_GENERIC_FP,   LLDB_REGNUM_GENERIC_FP,    gpr_fp_hsa      },      nullptr,        nullptr},
+{   "mp",       nullptr, 8, 16,     eEncodingUint,  eFormatHex,     { gpr_mp_hsa,           gpr_mp_hsa,           LLDB_REGNUM_GENERIC_ARG1,   LLDB_INVALID_REGNUM,    gpr_mp_hsa      },      nullptr,        nullptr},
+// Wave registers
+{   "exec",     nullptr, 8, 24,     eEncodingUint,  eFormatHex,     { wave_exec_hsa,        wave_exec_hsa,        LLDB_INVALID_REGNUM,      LLDB_INVALID_REGNUM,       wave_exec_hsa    },      nullptr,        nullptr},
+{   "wave",     nullptr, 4, 32,     eEncodingUint,  eFormatHex,     { wave_address_hsa,     wave_address_hsa,     LLDB_INVALID_REGNUM,      LLDB_INVALID_REGNUM,       wave_address_hsa },      nullptr,        nullptr},
+{   "wg_x",     nullptr, 4, 36,     eEncodingUint,  eFormatDecimal, { wave_group_x_hsa,     wave_group_x_hsa,     LLDB_INVALID_REGNUM,      LLDB_INVALID_REGNUM,       wave_group_x_hsa },      nullptr,        nullptr},
+{   "wg_y",     nullptr, 4, 40,     eEncodingUint,  eFormatDecimal, { wave_group_y_hsa,     wave_group_y_hsa,     LLDB_INVALID_REGNUM,      LLDB_INVALID_REGNUM,       wave_group_y_hsa },      nullptr,        nullptr},
+{   "wg_z",     nullptr, 4, 44,     eEncodingUint,  eFormatDecimal, { wave_group_z_hsa,     wave_group_z_hsa,     LLDB_INVALID_REGNUM,      LLDB_INVALID_REGNUM,       wave_group_z_hsa },      nullptr,        nullptr}
 };
 
 #endif // DECLARE_REGISTER_INFOS_HSA_STRUCT
@@ -11,6 +11,8 @@
 
 // C Includes
 // C++ Includes
+#include <algorithm>
+
 // Other libraries and framework includes
 // Project includes
 #include "lldb/Core/Log.h"
@@ -28,6 +30,7 @@
 #include "lldb/Target/ThreadPlanStepOut.h"
 #include "lldb/Target/ThreadPlanStepThrough.h"
 
+#include "Plugins/LanguageRuntime/HSA/HSARuntime/HSARuntime.h"
 #include "Plugins/SymbolFile/AMDHSA/SymbolFileAMDHSA.h"
 
 using namespace lldb_private;
@@ -90,7 +93,7 @@ ThreadPlanStepOverHSA::ShouldStop (Event *event_ptr)
         {
             if (m_addr_context.line_entry.line == new_context.line_entry.line)
             {
-                ClearMomentaryBreakpoints();
+                // The agent still has this line's step breakpoints
                 return false;
             }
         }
@@ -111,7 +114,6 @@ ThreadPlanStepOverHSA::ShouldStop (Event *event_ptr)
         return true;
     }
 
-    ClearMomentaryBreakpoints();
     SetMomentaryBreakpoints();
     return false;
 }
@@ -178,68 +180,71 @@ ThreadPlanStepOverHSA::WillStop ()
     return true;
 }
 
+// The step breakpoints of a line are precomputed by the symbol file and go
+// to the agent as one batch, which keeps them until the line changes. So
+// stepping through a loop sends nothing at all while it stays on the line.
 void
 ThreadPlanStepOverHSA::SetMomentaryBreakpoints() 
 {
-    Target& target = GetTarget();
+    Log *log(lldb_private::GetLogIfAllCategoriesSet (LIBLLDB_LOG_STEP));
+    ProcessSP process_sp = m_thread.GetProcess();
 
-    auto& images = target.GetImages();
+    auto runtime = static_cast<HSARuntime*>(process_sp->GetLanguageRuntime(eLanguageTypeObjC));
+    if (!runtime)
+        return;
 
-    ModuleSP module;
-    for (unsigned i=0; i < images.GetSize(); ++i) {
-        auto module_sp = images.GetModuleAtIndex(i);
-        if (module_sp) {
-            if (module_sp->GetArchitecture().GetMachine() == llvm::Triple::amdgcn) {
-                module = module_sp;
-                break;
-            }
-        }
-    }
+    auto sym_file = runtime->GetCurrentSymbolFile();
+    if (!sym_file)
+        return;
 
-    if (module) {
-        auto sym_vendor = module->GetSymbolVendor();
-        if (sym_vendor) {
-            auto sym_file = static_cast<SymbolFileAMDHSA*>(sym_vendor->GetSymbolFile());
-            if (sym_file) {
-                auto pc = GetThread().GetRegisterContext()->GetPC();
-                auto addrs = sym_file->GetStepOverAddresses(pc);
-
-                for (auto addr : addrs) {
-                    const bool is_hardware = true; //used for "momentary" breakpoints
-                    const bool is_internal = true;
-                    auto bp = target.CreateBreakpoint(addr, is_internal, is_hardware);
-                    m_momentary_breakpoints.push_back(bp);
-                }
-            }
-        }
+    auto pc = GetThread().GetRegisterContext()->GetPC();
+    SymbolFileAMDHSA::LineStepAddressesSP step_sp = sym_file->GetLineStepAddresses(pc);
+    if (step_sp && step_sp == m_step_line)
+        return;
+
+    if (!step_sp) {
+        ClearMomentaryBreakpoints();
+        return;
     }
+
+    m_step_line = step_sp;
+    m_step_addresses.assign(step_sp->m_step_over.begin(), step_sp->m_step_over.end());
+
+    Error error = process_sp->SetHSAStepBreakpoints(m_step_addresses);
+    if (log)
+        log->Printf("ThreadPlanStepOverHSA set %zu step breakpoints: %s", m_step_addresses.size(),
+                    error.Success() ? "ok" : error.AsCString());
 }
 
 void
 ThreadPlanStepOverHSA::ClearMomentaryBreakpoints() 
 {
-    for (auto bp : m_momentary_breakpoints) {
-        GetTarget().RemoveBreakpointByID(bp->GetID());
-    }
+    if (!m_step_line)
+        return;
+
+    m_step_line.reset();
+    m_step_addresses.clear();
+
+    ProcessSP process_sp = m_thread.GetProcess();
+    if (process_sp)
+        process_sp->SetHSAStepBreakpoints(m_step_addresses);
 }
 
 bool
 ThreadPlanStepOverHSA::HitMomentaryBreakpoint(StopInfoSP stop_info_sp) 
 {
-    if (stop_info_sp->GetStopReason() != eStopReasonBreakpoint) 
+    if (!stop_info_sp)
         return false;
 
-    break_id_t bp_site_id = stop_info_sp->GetValue();
-    BreakpointSiteSP bp_site_sp = m_thread.GetProcess()->GetBreakpointSiteList().FindByID(bp_site_id);
-
-    if (!bp_site_sp) return false;
-    
-    for (auto bp : m_momentary_breakpoints) {
-        if (bp_site_sp->IsBreakpointAtThisSite(bp->GetID()))
-            return true;
-    }
+    // Step breakpoints have no breakpoint site, the stop shows up as a
+    // trace while we step. A site of some other breakpoint may share the
+    // address.
+    StopReason reason = stop_info_sp->GetStopReason();
+    if (reason != eStopReasonBreakpoint && reason != eStopReasonTrace)
+        return false;
 
-    return false;
+    addr_t pc = m_thread.GetRegisterContext()->GetPC();
+    return std::binary_search(m_step_addresses.begin(), m_step_addresses.end(), pc);
 }
 
 StateType
@@ -45,7 +45,8 @@ private:
     bool HitMomentaryBreakpoint(lldb::StopInfoSP stop_info_sp);
 
     SymbolContext m_addr_context;
-    std::vector<lldb::BreakpointSP> m_momentary_breakpoints;
+    std::shared_ptr<const void> m_step_line;     // The line whose step breakpoints the agent has
+    std::vector<lldb::addr_t> m_step_addresses;  // Its step over addresses, sorted
 
     DISALLOW_COPY_AND_ASSIGN (ThreadPlanStepOverHSA);
 };
@@ -34,67 +34,55 @@ UnwindHSA::UnwindHSA (Thread &thread) :
 
 {}
 
+const SymbolFileAMDHSA::CallStackSP&
+UnwindHSA::GetCallStack() {
+    if (m_call_stack_sp)
+        return m_call_stack_sp;
+
+    if (!m_runtime)
+        return m_call_stack_sp;
+
+    auto sym_file = m_runtime->GetCurrentSymbolFile();
+    if (sym_file) {
+        auto pc = m_thread.GetRegisterContext()->GetPC();
+        m_call_stack_sp = sym_file->GetCallStack(pc);
+    }
+
+    return m_call_stack_sp;
+}
+
+const SymbolFileAMDHSA::CallFrame*
+UnwindHSA::GetCallFrame(uint32_t frame_idx) {
+    const auto& call_stack_sp = GetCallStack();
+    if (!call_stack_sp || frame_idx >= call_stack_sp->size())
+        return nullptr;
+
+    return &(*call_stack_sp)[frame_idx];
+}
+
 uint32_t
 UnwindHSA::DoGetFrameCount() {
-    return 1;
+    const auto& call_stack_sp = GetCallStack();
+    if (!call_stack_sp || call_stack_sp->empty())
+        return 1;
+    return call_stack_sp->size();
 }
 
 bool
 UnwindHSA::DoGetFrameInfoAtIndex(uint32_t frame_idx,
 				 lldb::addr_t& cfa,
 				 lldb::addr_t& start_pc) {
-    auto thread_reg = m_thread.GetRegisterContext();
-    auto pc = thread_reg->GetPC();
-
-    auto target_sp = m_thread.CalculateTarget();
-    auto& images = target_sp->GetImages();
-
-    ModuleSP module_sp;
-    for (unsigned i=0; i < images.GetSize(); ++i) {
-        auto module = images.GetModuleAtIndex(i);
-        if (module) {
-            if (module->GetArchitecture().GetMachine() == llvm::Triple::amdgcn) {
-                module_sp = module;
-                break;
-            }
-        }
-    }
-
-    if (!module_sp)
+    const SymbolFileAMDHSA::CallFrame* frame = GetCallFrame(frame_idx);
+    if (!frame)
         return false;
 
-    auto sym_vendor = module_sp->GetSymbolVendor();
-    if (sym_vendor) {
-        auto sym_file = static_cast<SymbolFileAMDHSA*>(sym_vendor->GetSymbolFile());
-        if (sym_file) {
-            auto dbginfo = sym_file->GetDbgInfo();
-
-            std::vector<HwDbgInfo_frame_context> frames (100);
-            size_t n_frames;
-            hwdbginfo_addr_call_stack(dbginfo, pc, frames.size(), frames.data(), &n_frames);
-            
-            if (frame_idx < n_frames) {
-                HwDbgInfo_addr pc, fp, mp;
-                HwDbgInfo_code_location loc;
-                std::vector<char> func_name (100);
-                auto err = hwdbginfo_frame_context_details(frames[frame_idx], &pc, &fp, &mp, &loc, func_name.size(), func_name.data(), &n_frames);
-                
-                if (err != HWDBGINFO_E_SUCCESS) {
-                    return false;
-                }
-
-                cfa = fp;
-                start_pc = pc;
-                return true;
-            }
-        }
-    }    
-
-    return false;
+    cfa = frame->m_fp;
+    start_pc = frame->m_pc;
+    return true;
 }
 
 RegisterContextSP
 UnwindHSA::DoCreateRegisterContextForFrame(StackFrame *frame) {
-  return RegisterContextSP(new RegisterContextHSA(*frame->GetThread(), frame->GetFrameIndex()));
+  return RegisterContextSP(new RegisterContextHSA(*frame->GetThread(), frame->GetFrameIndex(), *this));
 }
 
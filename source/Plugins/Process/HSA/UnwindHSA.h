@@ -22,6 +22,7 @@
 #include "lldb/Symbol/UnwindPlan.h"
 #include "lldb/Target/RegisterContext.h"
 #include "lldb/Target/Unwind.h"
+#include "Plugins/SymbolFile/AMDHSA/SymbolFileAMDHSA.h"
 
 
 namespace lldb_private {
@@ -36,13 +37,17 @@ public:
 
     ~UnwindHSA() override = default;
 
-protected:
-    friend class lldb_private::RegisterContextHSA;
+    // A frame of the call stack at the thread's PC, nullptr if there is no
+    // such frame. Register contexts read pc, fp and mp from it instead of
+    // unwinding again.
+    const SymbolFileAMDHSA::CallFrame*
+    GetCallFrame(uint32_t frame_idx);
 
+protected:
     void
     DoClear() override
     {
-
+        m_call_stack_sp.reset();
     }
 
     uint32_t
@@ -58,7 +63,12 @@ protected:
 
 
 private:
+    // The call stack at the thread's PC, looked up once per stop
+    const SymbolFileAMDHSA::CallStackSP&
+    GetCallStack();
+
     HSARuntime* m_runtime;
+    SymbolFileAMDHSA::CallStackSP m_call_stack_sp;
 
     //------------------------------------------------------------------
     // For UnwindHSA only
@@ -42,6 +42,7 @@
 #include "lldb/Utility/StringExtractor.h"
 
 #include "Plugins/Process/POSIX/ProcessPOSIXLog.h"
+#include "Plugins/LanguageRuntime/HSA/HSARuntime/HsaBreakpointCondition.h"
 #include "Plugins/Process/HSA/NativeBreakpointHSA.h"
 #include "Plugins/Process/HSA/NativeThreadHSA.h"
 #include "NativeThreadLinux.h"
@@ -441,9 +442,7 @@ NativeProcessLinux::NativeProcessLinux () :
     m_supports_mem_region (eLazyBoolCalculate),
     m_mem_region_cache (),
     m_mem_region_cache_mutex(),
-    m_pending_notification_tid(LLDB_INVALID_THREAD_ID),
-    m_hsa_debug(new NativeHSADebug(*this))
-
+    m_pending_notification_tid(LLDB_INVALID_THREAD_ID)
 {
 }
 
@@ -460,6 +459,9 @@ NativeProcessLinux::LaunchInferior (
     const ProcessLaunchInfo &launch_info,
     Error &error)
 {
+    // The process joins a new debug session with us
+    m_hsa_debug.reset(new NativeHSADebug(*this, HsaDebugSession::Create()));
+
     m_sigchld_handle = mainloop.RegisterSignal(SIGCHLD,
             [this] (MainLoopBase &) { SigchldHandler(); }, error);
     if (! m_sigchld_handle)
@@ -488,6 +490,10 @@ NativeProcessLinux::AttachToInferior (MainLoop &mainloop, lldb::pid_t pid, Error
     if (log)
         log->Printf ("NativeProcessLinux::%s (pid = %" PRIi64 ")", __FUNCTION__, pid);
 
+    // Its agent already picked its keys and FIFOs, from the session it was
+    // launched in if any
+    m_hsa_debug.reset(new NativeHSADebug(*this, HsaDebugSession::FromProcess(pid)));
+
     m_sigchld_handle = mainloop.RegisterSignal(SIGCHLD,
             [this] (MainLoopBase &) { SigchldHandler(); }, error);
     if (! m_sigchld_handle)
@@ -553,6 +559,26 @@ NativeProcessLinux::Launch(LaunchArgs *args, Error &error)
     if (envp == NULL || envp[0] == NULL)
         envp = const_cast<const char **>(environ);
 
+    // Tell the HSA agent which debug session it belongs to, so that its
+    // shared memory and FIFOs don't collide with other sessions' on this
+    // machine. Built before the fork, the child must not allocate.
+    const HsaDebugSession& hsa_session = m_hsa_debug->GetSession();
+    const std::string hsa_session_var = std::string(gs_DebugSessionIdEnvVar) + "=";
+    const std::string hsa_session_entry = hsa_session_var + std::to_string(hsa_session.id);
+    const std::string hsa_fifo_dir_var = std::string(gs_DebugSessionFifoDirEnvVar) + "=";
+    const std::string hsa_fifo_dir_entry = hsa_fifo_dir_var + hsa_session.fifo_dir;
+    std::vector<const char *> hsa_envp;
+    for (const char **env = envp; *env; ++env) {
+        if (strncmp(*env, hsa_session_var.c_str(), hsa_session_var.size()) != 0 &&
+            strncmp(*env, hsa_fifo_dir_var.c_str(), hsa_fifo_dir_var.size()) != 0)
+            hsa_envp.push_back(*env);
+    }
+    hsa_envp.push_back(hsa_session_entry.c_str());
+    if (!hsa_session.fifo_dir.empty())
+        hsa_envp.push_back(hsa_fifo_dir_entry.c_str());
+    hsa_envp.push_back(NULL);
+    envp = hsa_envp.data();
+
     if ((pid = terminal.Fork(err_str, err_len)) == static_cast<lldb::pid_t> (-1))
     {
         error.SetErrorToGenericError();
@@ -1033,6 +1059,19 @@ NativeProcessLinux::MonitorCallback(lldb::pid_t pid,
         return;
     }
 
+    // The HSA agent's debug thread runs through HSA stops. Signals it gets
+    // meanwhile are passed on rather than starting a stop of their own,
+    // ptrace events and traps still take the usual path.
+    if (info_err.Success() && IsHSAAgentThread(*thread_sp) && GetState() == eStateStopped &&
+        (info.si_signo != SIGTRAP || info.si_code <= 0))
+    {
+        if (log)
+            log->Printf ("NativeProcessLinux::%s() HSA agent thread %" PRIu64 " got signal %d while stopped, passing it on",
+                         __FUNCTION__, pid, info.si_signo);
+        ResumeThread(*thread_sp, eStateRunning, info.si_signo == SIGTRAP ? LLDB_INVALID_SIGNAL_NUMBER : info.si_signo);
+        return;
+    }
+
     // Get details on the signal raised.
     if (info_err.Success())
     {
@@ -1158,11 +1197,8 @@ NativeProcessLinux::WaitForNewThread(::pid_t tid)
     ThreadWasCreated(*new_thread_sp);
 }
 
-const HsaWavefronts& GetHSAWavefronts (NativeHSADebug& hsa_debug) {
-    while (hsa_debug.GetWavefrontInfo().empty()){}
-
-    return hsa_debug.GetWavefrontInfo();
-}
+// How long to wait for the agent's breakpoint notification after its SIGTRAP
+static const uint64_t g_hsa_wavefront_timeout_usec = 5 * TimeValue::MicroSecPerSec;
 
 void
 NativeProcessLinux::MonitorSIGTRAP(const siginfo_t &info, NativeThreadLinux &thread)
@@ -1175,21 +1211,58 @@ NativeProcessLinux::MonitorSIGTRAP(const siginfo_t &info, NativeThreadLinux &thr
     Mutex::Locker locker (m_threads_mutex);
 
     if (info.si_code == 0) {
-        const auto& waves = GetHSAWavefronts(*m_hsa_debug);
-
-        for (auto thread_sp : m_hsa_threads) {
-            m_threads.erase(std::find(m_threads.begin(), m_threads.end(), thread_sp));
+        // The agent raises SIGTRAP after writing the breakpoint notification,
+        // but the notification is read on another thread, so wait for the
+        // snapshot of this stop rather than reusing the previous one
+        bool timed_out = false;
+        HsaWavefrontTableSP waves_sp = m_hsa_debug->WaitForWavefrontInfo(m_hsa_wavefront_version,
+                                                                         g_hsa_wavefront_timeout_usec,
+                                                                         &m_hsa_wavefront_version,
+                                                                         &timed_out);
+        if (timed_out && log)
+            log->Printf ("NativeProcessLinux::%s() timed out waiting for wavefronts", __FUNCTION__);
+
+        // Diff against the previous stop so only the threads of waves that
+        // went away need touching, thread objects of the rest are kept
+        std::shared_ptr<HsaWavefrontUpdate> update_sp = std::make_shared<HsaWavefrontUpdate>();
+        update_sp->version = m_hsa_wavefront_version;
+        update_sp->table = waves_sp;
+        if (m_hsa_wavefront_update) {
+            update_sp->base_version = m_hsa_wavefront_update->version;
+            update_sp->base_table = m_hsa_wavefront_update->table;
+        }
+        else {
+            update_sp->base_table = std::make_shared<HsaWavefrontTable>();
         }
+        update_sp->delta = HsaWavefrontDelta::Compute(*update_sp->base_table, *waves_sp);
 
-        m_hsa_threads.clear();
+        m_hsa_wavefronts = waves_sp;
+        m_hsa_wavefront_update = update_sp;
 
         if (log)
-            log->Printf ("NativeProcessLinux::%s() %" PRIu64 " wavefronts found", __FUNCTION__, waves.size());
+            log->Printf ("NativeProcessLinux::%s() %" PRIu64 " wavefronts found, %" PRIu64 " added, %" PRIu64 " moved, %" PRIu64 " retired",
+                         __FUNCTION__, static_cast<uint64_t>(waves_sp->GetSize()),
+                         static_cast<uint64_t>(update_sp->delta.added.size()),
+                         static_cast<uint64_t>(update_sp->delta.moved.size()),
+                         static_cast<uint64_t>(update_sp->delta.retired.size()));
+
+        for (std::size_t row : update_sp->delta.retired) {
+            const lldb::tid_t tid = update_sp->base_table->GetGlobalID(row)+1;
+            auto pos = std::find_if(m_hsa_threads.begin(), m_hsa_threads.end(),
+                                    [tid](const NativeThreadHSASP& thread_sp) { return thread_sp->GetID() == tid; });
+            // The wave may have changed slots, keep its thread if so
+            if (pos != m_hsa_threads.end() && waves_sp->FindGlobalID(tid-1) == HsaWavefrontTable::npos) {
+                NativeThreadHSASP thread_sp = *pos;
+                RemoveHSAThread(thread_sp);
+            }
+        }
 
-        for (const auto& wave : waves) {
-            NativeThreadHSASP hsa_thread = std::make_shared<NativeThreadHSA>(this, wave.GetGlobalID()+1, *m_hsa_debug);
-            m_threads.push_back(hsa_thread);
-            m_hsa_threads.push_back(hsa_thread);
+        // The first wave is the focus, the rest are materialized when the
+        // client asks about them
+        lldb::tid_t focus_tid = thread.GetID();
+        if (!waves_sp->IsEmpty()) {
+            focus_tid = waves_sp->GetGlobalID(0)+1;
+            MaterializeHSAThread(focus_tid);
         }
 
         if (log)
@@ -1200,8 +1273,17 @@ NativeProcessLinux::MonitorSIGTRAP(const siginfo_t &info, NativeThreadLinux &thr
                 thread_sp->SetStoppedByBreakpoint();
             }
         }
-        thread.SetStoppedWithNoReason();
-        StopRunningThreads((*m_hsa_threads.begin())->GetID());
+
+        // The agent's debug thread waits in its command loop until the
+        // dispatch is continued and serves reads from there, so it is left
+        // running. If the SIGTRAP landed on it, it is dropped.
+        if (!waves_sp->IsEmpty())
+            m_hsa_agent_tid = m_hsa_debug->GetDebugThreadID();
+        if (IsHSAAgentThread(thread))
+            ResumeThread(thread, eStateRunning, LLDB_INVALID_SIGNAL_NUMBER);
+        else
+            thread.SetStoppedWithNoReason();
+        StopRunningThreads(focus_tid);
         return;
     }
 
@@ -1803,6 +1885,7 @@ NativeProcessLinux::Resume (const ResumeActionList &resume_actions)
     }
 
 
+    bool resume_hsa = false;
     for (auto thread_sp : m_threads)
     {
         const ResumeAction *const action = resume_actions.GetActionForThread (thread_sp->GetID (), true);
@@ -1813,10 +1896,16 @@ NativeProcessLinux::Resume (const ResumeActionList &resume_actions)
             const int signo = action->signal;
             if (IsHSAThread(*thread_sp)) {
                 ResumeHSAThread(static_cast<NativeThreadHSA &>(*thread_sp), action->state, signo);
+                resume_hsa = true;
             }
         }
     }
 
+    // All waves of a dispatch are resumed together, whichever of them have
+    // thread objects
+    if (resume_hsa)
+        m_hsa_debug->Continue();
+
 
     for (auto thread_sp : m_threads)
     {
@@ -1843,9 +1932,11 @@ NativeProcessLinux::Resume (const ResumeActionList &resume_actions)
         case eStateRunning:
         case eStateStepping:
         {
-            // Run the thread, possibly feeding it the signal.
+            // Run the thread, possibly feeding it the signal. The HSA agent's
+            // debug thread was never stopped.
             const int signo = action->signal;
-            if (!IsHSAThread(*thread_sp)) {
+            if (!IsHSAThread(*thread_sp) &&
+                !(IsHSAAgentThread(*thread_sp) && StateIsRunningState(thread_sp->GetState()))) {
                 ResumeThread(static_cast<NativeThreadLinux &>(*thread_sp), action->state, signo);
             }
             break;
@@ -1861,6 +1952,7 @@ NativeProcessLinux::Resume (const ResumeActionList &resume_actions)
         }
     }
 
+    m_hsa_agent_tid = LLDB_INVALID_THREAD_ID;
     return Error();
 }
 
@@ -1887,6 +1979,48 @@ NativeProcessLinux::Detach ()
     if (GetID () == LLDB_INVALID_PROCESS_ID)
         return error;
 
+    // ptrace only lets go of stopped threads, the HSA agent's debug thread
+    // may still be running through an HSA stop. Other signals may reach it
+    // before the SIGSTOP, they are sent again once it is detached so the
+    // SIGSTOP is never left pending to stop the detached process.
+    lldb::tid_t agent_tid = LLDB_INVALID_THREAD_ID;
+    std::vector<int> agent_signals;
+    if (NativeThreadLinuxSP agent_thread_sp = GetThreadByID(m_hsa_agent_tid))
+    {
+        if (StateIsRunningState(agent_thread_sp->GetState()))
+        {
+            agent_tid = agent_thread_sp->GetID();
+            agent_thread_sp->RequestStop();
+            while (true)
+            {
+                int status = 0;
+                if (waitpid(agent_tid, &status, __WALL) < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    break;
+                }
+
+                // The thread is gone
+                if (!WIFSTOPPED(status))
+                {
+                    agent_tid = LLDB_INVALID_THREAD_ID;
+                    break;
+                }
+
+                const int signo = WSTOPSIG(status);
+                if (signo == SIGSTOP)
+                    break;
+
+                // A ptrace event stop carries no signal of the thread's own
+                if ((status >> 16) == 0)
+                    agent_signals.push_back(signo);
+                PtraceWrapper(PTRACE_CONT, agent_tid);
+            }
+        }
+    }
+    m_hsa_agent_tid = LLDB_INVALID_THREAD_ID;
+
     for (auto thread_sp : m_threads)
     {
         Error e = Detach(thread_sp->GetID());
@@ -1894,6 +2028,9 @@ NativeProcessLinux::Detach ()
             error = e; // Save the error, but still attempt to detach from other threads.
     }
 
+    for (int signo : agent_signals)
+        syscall(SYS_tgkill, static_cast<::pid_t>(GetID()), static_cast<::pid_t>(agent_tid), signo);
+
     return error;
 }
 
@@ -3089,9 +3226,210 @@ NativeProcessLinux::ResumeHSAThread(NativeThreadHSA &thread, lldb::StateType sta
         llvm_unreachable("Unhandled state for ResumeHSAThread");
     }
 
-    if (thread.GetID() == 1)
-        m_hsa_debug->Continue();
+    return Error();
+}
+
+NativeThreadHSASP
+NativeProcessLinux::MaterializeHSAThread(lldb::tid_t tid)
+{
+    for (auto thread_sp : m_hsa_threads) {
+        if (thread_sp->GetID() == tid)
+            return thread_sp;
+    }
+
+    if (!m_hsa_wavefronts || m_hsa_wavefronts->FindGlobalID(tid-1) == HsaWavefrontTable::npos)
+        return NativeThreadHSASP();
+
+    NativeThreadHSASP thread_sp = std::make_shared<NativeThreadHSA>(this, tid, *m_hsa_debug);
+    if (m_hsa_debug->JustHitBreakpoint(tid))
+        thread_sp->SetStoppedByBreakpoint();
+    else
+        thread_sp->SetStoppedWithNoReason();
+
+    m_threads.push_back(thread_sp);
+    m_hsa_threads.push_back(thread_sp);
+    return thread_sp;
+}
+
+void
+NativeProcessLinux::RemoveHSAThread(const NativeThreadHSASP &thread_sp)
+{
+    auto pos = std::find(m_threads.begin(), m_threads.end(), thread_sp);
+    if (pos != m_threads.end())
+        m_threads.erase(pos);
+
+    auto hsa_pos = std::find(m_hsa_threads.begin(), m_hsa_threads.end(), thread_sp);
+    if (hsa_pos != m_hsa_threads.end())
+        m_hsa_threads.erase(hsa_pos);
+}
+
+Error
+NativeProcessLinux::MaterializeHSAWavefront(lldb::tid_t tid)
+{
+    Mutex::Locker locker (m_threads_mutex);
+    if (!MaterializeHSAThread(tid))
+        return Error("tid %" PRIu64 " is not an HSA wavefront of the last stop", tid);
+    return Error();
+}
+
+Error
+NativeProcessLinux::GetHSAWavefrontUpdate(HsaWavefrontUpdateSP& update_sp)
+{
+    Mutex::Locker locker (m_threads_mutex);
+    if (!m_hsa_wavefront_update)
+        return Error("no HSA wavefronts active");
+    update_sp = m_hsa_wavefront_update;
+    return Error();
+}
+
+Error
+NativeProcessLinux::SetHSABreakpointCondition(const HsaBreakpointCondition& condition)
+{
+    if (!m_hsa_debug)
+        return Error("HSA debugging is not enabled");
+    if (!IsHSAAddress(condition.addr))
+        return Error("0x%" PRIx64 " is not an HSA address", condition.addr);
+
+    m_hsa_debug->SetBreakpointCondition(condition.addr, condition.ops);
+
+    // At an HSA stop the agent's debug thread is left running and takes the
+    // condition right away. Otherwise it goes out when the process resumes,
+    // and a condition the agent cannot run is only logged.
+    if (m_hsa_agent_tid != LLDB_INVALID_THREAD_ID)
+        return m_hsa_debug->ApplyBreakpointOps();
+    return Error();
+}
+
+Error
+NativeProcessLinux::SetHSABreakpointMode(lldb::addr_t addr, uint32_t mode)
+{
+    if (!m_hsa_debug)
+        return Error("HSA debugging is not enabled");
+    if (!IsHSAAddress(addr))
+        return Error("0x%" PRIx64 " is not an HSA address", addr);
+    if (mode != HSAIL_BREAKPOINT_MODE_STOP && mode != HSAIL_BREAKPOINT_MODE_TRACE)
+        return Error("unknown breakpoint mode %u", mode);
+
+    m_hsa_debug->SetBreakpointMode(addr, static_cast<HsailBreakpointMode>(mode));
+    return Error();
+}
+
+Error
+NativeProcessLinux::GetHSABreakpointStats(HsaBreakpointStatsTable& table, size_t max_work_groups)
+{
+    if (!m_hsa_debug)
+        return Error("HSA debugging is not enabled");
+    return m_hsa_debug->GetBreakpointStats(table, max_work_groups);
+}
+
+Error
+NativeProcessLinux::SetHSADispatchFilter(bool all_kernels, const std::vector<std::string>& kernel_names)
+{
+    if (!m_hsa_debug)
+        return Error("HSA debugging is not enabled");
+
+    m_hsa_debug->SetDispatchFilter(all_kernels, kernel_names);
+    return Error();
+}
+
+Error
+NativeProcessLinux::SetHSAStepBreakpoints(const std::vector<lldb::addr_t>& addrs)
+{
+    if (!m_hsa_debug)
+        return Error("HSA debugging is not enabled");
 
+    m_hsa_debug->SetStepBreakpoints(std::vector<HwDbgInfo_addr>(addrs.begin(), addrs.end()));
+    return Error();
+}
+
+Error
+NativeProcessLinux::ReadHSA(HsaReadRequests& requests)
+{
+    HsaWavefrontTableSP waves_sp;
+    {
+        Mutex::Locker locker (m_threads_mutex);
+        waves_sp = m_hsa_wavefronts;
+    }
+    if (!m_hsa_debug || !waves_sp)
+        return Error("no HSA wavefronts active");
+
+    // The agent reads private memory by work-group, which the client
+    // names by wave. Requests for a box of work-items go to the agent one
+    // work-item at a time, all in the same batch.
+    const HsailWaveDim3 group_size = m_hsa_debug->GetWorkGroupSize();
+    const std::size_t capacity = m_hsa_debug->GetReadBatchCapacity();
+    HsaReadRequests lanes;
+    std::vector<std::pair<std::size_t, uint64_t>> positions;
+    for (std::size_t i=0; i < requests.size(); ++i) {
+        HsaReadRequest& read = requests[i];
+        const std::size_t row = waves_sp->FindGlobalID(read.tid-1);
+        if (row == HsaWavefrontTable::npos) {
+            read.request.m_status = HSAIL_READ_STATUS_FAILURE;
+            continue;
+        }
+
+        // Every lane takes a request slot and its result in the batch
+        // buffer, a box that cannot go out in one batch is refused before
+        // anything is allocated for it
+        const uint64_t lane_size = sizeof(HsailReadRequest) + ((read.request.m_size + 7) & ~static_cast<uint64_t>(7));
+        if (capacity <= sizeof(HsailReadBatchHeader) ||
+            read.GetLaneCount() > (capacity - sizeof(HsailReadBatchHeader)) / lane_size) {
+            read.request.m_status = HSAIL_READ_STATUS_UNSUPPORTED;
+            read.data.clear();
+            continue;
+        }
+
+        read.request.m_workGroup = waves_sp->GetWorkGroupID(row);
+        read.BeginLanes();
+
+        // Global memory is the process's and the same for every work-item,
+        // it is read here rather than dereferenced by the agent
+        if (read.IsGlobalMemory()) {
+            HsaReadRequest lane_read = read.GetLane(0);
+            lane_read.data.resize(read.request.m_size);
+            size_t bytes_read = 0;
+            Error read_error = ReadMemory(read.request.m_address, lane_read.data.data(), lane_read.data.size(), bytes_read);
+            lane_read.request.m_status = read_error.Success() && bytes_read == lane_read.data.size() ?
+                                         HSAIL_READ_STATUS_SUCCESS : HSAIL_READ_STATUS_FAILURE;
+            for (uint64_t lane=0; lane < read.GetLaneCount(); ++lane)
+                read.SetLaneResult(lane, lane_read);
+            continue;
+        }
+
+        // Work-items past the end of the work-group do not exist. Their
+        // lanes fail without going to the agent
+        const uint64_t n_lanes = read.GetLaneCount();
+        for (uint64_t lane=0; lane < n_lanes; ++lane) {
+            HsaReadRequest lane_read = read.GetLane(lane);
+            if (!read.IsLaneInWorkGroup(lane, group_size)) {
+                lane_read.request.m_status = HSAIL_READ_STATUS_FAILURE;
+                read.SetLaneResult(lane, lane_read);
+                continue;
+            }
+            lanes.push_back(lane_read);
+            positions.push_back(std::make_pair(i, lane));
+        }
+    }
+
+    if (lanes.empty())
+        return Error();
+
+    Error error = m_hsa_debug->ReadBatch(lanes);
+    if (error.Fail())
+        return error;
+
+    for (std::size_t i=0; i < positions.size(); ++i)
+        requests[positions[i].first].SetLaneResult(positions[i].second, lanes[i]);
+    return Error();
+}
+
+Error
+NativeProcessLinux::GetHSAWavefronts(HsaWavefrontTableSP& table_sp)
+{
+    Mutex::Locker locker (m_threads_mutex);
+    if (!m_hsa_wavefronts)
+        return Error("no HSA wavefronts active");
+    table_sp = m_hsa_wavefronts;
     return Error();
 }
 
@@ -3173,14 +3511,19 @@ NativeProcessLinux::StopRunningThreads(const lldb::tid_t triggering_tid)
         if (StateIsRunningState(thread_sp->GetState())) {
             if (IsHSAThread(*thread_sp)) {
                 if (m_hsa_debug->IsKernelFinished()) {
-                    it = m_threads.erase(std::find(m_threads.begin(), m_threads.end(), thread_sp));
+                    auto hsa_pos = std::find(m_hsa_threads.begin(), m_hsa_threads.end(), thread_sp);
+                    if (hsa_pos != m_hsa_threads.end())
+                        m_hsa_threads.erase(hsa_pos);
+                    m_hsa_wavefronts.reset();
+                    m_hsa_wavefront_update.reset();
+                    it = m_threads.erase(it);
                     continue;
                 }
                 else {
                     static_pointer_cast<NativeThreadHSA>(thread_sp)->SetStoppedWithNoReason();
                 }
             }
-            else {
+            else if (!IsHSAAgentThread(*thread_sp)) {
                 static_pointer_cast<NativeThreadLinux>(thread_sp)->RequestStop();
             }
         }
@@ -3207,7 +3550,7 @@ NativeProcessLinux::SignalIfAllThreadsStopped()
 
     for (const auto &thread_sp: m_threads)
     {
-        if (StateIsRunningState(thread_sp->GetState())) {
+        if (StateIsRunningState(thread_sp->GetState()) && !IsHSAAgentThread(*thread_sp)) {
             if (log)
                 log->Printf("NativeProcessLinux::%s wanted to signal, but thread %" PRIu64 " is still running", __FUNCTION__, thread_sp->GetID());
             return; // Some threads are still running. Don't signal yet.
@@ -3357,7 +3700,8 @@ NativeProcessLinux::PtraceWrapper(int req, lldb::pid_t pid, void *addr, void *da
 }
 
 Error
-NativeProcessLinux::GetHSABinaryFileName(std::string& name) {
-    name = m_hsa_debug->GetBinaryFileName();
+NativeProcessLinux::GetHSABinary(lldb::DataBufferSP& data_sp, uint64_t& hash) {
+    if (!m_hsa_debug->GetBinary(data_sp, hash))
+        return Error("no HSA code object loaded");
     return Error();
 }
@@ -116,7 +116,34 @@ namespace process_linux {
         GetFileLoadAddress(const llvm::StringRef& file_name, lldb::addr_t& load_addr) override;
 
         Error
-        GetHSABinaryFileName(std::string& name) override;
+        GetHSABinary(lldb::DataBufferSP& data_sp, uint64_t& hash) override;
+
+        Error
+        GetHSAWavefronts(HsaWavefrontTableSP& table_sp) override;
+
+        Error
+        GetHSAWavefrontUpdate(HsaWavefrontUpdateSP& update_sp) override;
+
+        Error
+        MaterializeHSAWavefront(lldb::tid_t tid) override;
+
+        Error
+        ReadHSA(HsaReadRequests& requests) override;
+
+        Error
+        SetHSABreakpointCondition(const HsaBreakpointCondition& condition) override;
+
+        Error
+        SetHSABreakpointMode(lldb::addr_t addr, uint32_t mode) override;
+
+        Error
+        GetHSABreakpointStats(HsaBreakpointStatsTable& table, size_t max_work_groups) override;
+
+        Error
+        SetHSADispatchFilter(bool all_kernels, const std::vector<std::string>& kernel_names) override;
+
+        Error
+        SetHSAStepBreakpoints(const std::vector<lldb::addr_t>& addrs) override;
 
         NativeThreadLinuxSP
         GetThreadByID(lldb::tid_t id);
@@ -155,7 +182,26 @@ namespace process_linux {
         std::map<lldb::tid_t, lldb::addr_t> m_threads_stepping_with_breakpoint;
 
         NativeHSADebugUP m_hsa_debug;
+        // Thread objects for the waves that have been focused or queried,
+        // every other active wave is only a row in m_hsa_wavefronts
         std::vector<std::shared_ptr<NativeThreadHSA>> m_hsa_threads;
+        HsaWavefrontTableSP m_hsa_wavefronts;
+        // What changed between the previous stop and this one
+        HsaWavefrontUpdateSP m_hsa_wavefront_update;
+        uint32_t m_hsa_wavefront_version = 0;
+        // The HSA agent's debug thread, while it is left running through an
+        // HSA stop to serve reads and breakpoint batches.
+        //
+        // This is the one exception to "every thread of a stopped process is
+        // stopped", and it only holds from the HSA stop until the next
+        // resume, which clears it:
+        // - the thread's state stays eStateRunning, the stub refuses its
+        //   registers and stop info, and jThreadsInfo leaves it out;
+        // - nothing else may ptrace it, it is not in a ptrace-stop;
+        // - signals it gets are passed on rather than starting a stop;
+        // - Detach stops it first, passing on any signal that arrives
+        //   before the SIGSTOP.
+        lldb::tid_t m_hsa_agent_tid = LLDB_INVALID_THREAD_ID;
 
         /// @class LauchArgs
         ///
@@ -335,6 +381,18 @@ namespace process_linux {
         Error
         ResumeHSAThread(NativeThreadHSA &thread, lldb::StateType state, int signo);
 
+        std::shared_ptr<NativeThreadHSA>
+        MaterializeHSAThread(lldb::tid_t tid);
+
+        void
+        RemoveHSAThread(const std::shared_ptr<NativeThreadHSA> &thread_sp);
+
+        bool
+        IsHSAAgentThread(const NativeThreadProtocol &thread) const
+        {
+            return m_hsa_agent_tid != LLDB_INVALID_THREAD_ID && thread.GetID() == m_hsa_agent_tid;
+        }
+
         void
         ThreadWasCreated(NativeThreadLinux &thread);
 
@@ -22,6 +22,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Triple.h"
 #include "lldb/Interpreter/Args.h"
+#include "lldb/Core/DataBufferHeap.h"
 #include "lldb/Core/Log.h"
 #include "lldb/Core/ModuleSpec.h"
 #include "lldb/Core/State.h"
@@ -4603,16 +4604,83 @@ GDBRemoteCommunicationClient::ServeSymbolLookups(lldb_private::Process *process)
     }
 }
 
-std::string
-GDBRemoteCommunicationClient::GetHSABinaryFileName() {
+bool
+GDBRemoteCommunicationClient::GetHSABinaryInfo (uint64_t &hash, uint64_t &size)
+{
     StringExtractorGDBRemote response;
-    if (SendPacketAndWaitForResponse("hsaBin", response, false) == PacketResult::Success)
+    if (SendPacketAndWaitForResponse("hsaBin", response, false) != PacketResult::Success)
+        return false;
+    if (!response.IsNormalResponse())
+        return false;
+
+    bool got_hash = false;
+    bool got_size = false;
+    std::string name;
+    std::string value;
+    while (response.GetNameColonValue(name, value))
     {
-        Error error;
-        (void)ParseHostIOPacketResponse (response, UINT64_MAX, error);
-        return response.GetStringRef();
+        if (name.compare("hash") == 0)
+            hash = StringConvert::ToUInt64(value.c_str(), 0, 16, &got_hash);
+        else if (name.compare("size") == 0)
+            size = StringConvert::ToUInt64(value.c_str(), 0, 16, &got_size);
     }
-    
-    return "";
+    return got_hash && got_size;
+}
+
+lldb::DataBufferSP
+GDBRemoteCommunicationClient::ReadHSABinary (uint64_t size, Error &error)
+{
+    // Leave room for the packet framing and the 'm'/'l' marker. Escaping
+    // can grow a chunk, the server is free to send less than we ask for.
+    uint64_t chunk_size = GetRemoteMaxPacketSize();
+    chunk_size = chunk_size > 64 ? chunk_size - 64 : 0x1000;
+
+    std::unique_ptr<DataBufferHeap> data_ap (new DataBufferHeap(size, 0));
+    uint64_t offset = 0;
+    bool done = false;
+    while (!done)
+    {
+        lldb_private::StreamString packet;
+        packet.Printf("qXfer:hsa-binary:read::%" PRIx64 ",%" PRIx64, offset, chunk_size);
+
+        StringExtractorGDBRemote response;
+        if (SendPacketAndWaitForResponse(packet.GetData(), packet.GetSize(), response, false) != PacketResult::Success)
+        {
+            error.SetErrorString("qXfer:hsa-binary:read failed to send");
+            return lldb::DataBufferSP();
+        }
+
+        const char marker = response.GetChar();
+        if (marker != 'm' && marker != 'l')
+        {
+            error.SetErrorStringWithFormat("qXfer:hsa-binary:read unexpected response: %s", response.GetStringRef().c_str());
+            return lldb::DataBufferSP();
+        }
+        done = marker == 'l';
+
+        std::string chunk;
+        response.GetEscapedBinaryData(chunk);
+        if (chunk.empty() && !done)
+        {
+            error.SetErrorString("qXfer:hsa-binary:read returned no data");
+            return lldb::DataBufferSP();
+        }
+        if (offset + chunk.size() > size)
+        {
+            error.SetErrorString("qXfer:hsa-binary:read returned more data than advertised");
+            return lldb::DataBufferSP();
+        }
+
+        memcpy(data_ap->GetBytes() + offset, chunk.data(), chunk.size());
+        offset += chunk.size();
+    }
+
+    if (offset != size)
+    {
+        error.SetErrorStringWithFormat("qXfer:hsa-binary:read returned %" PRIu64 " of %" PRIu64 " bytes", offset, size);
+        return lldb::DataBufferSP();
+    }
+
+    return lldb::DataBufferSP(data_ap.release());
 }
 
@@ -572,8 +572,21 @@ public:
     void
     ServeSymbolLookups(lldb_private::Process *process);
 
-    std::string
-    GetHSABinaryFileName();
+    //------------------------------------------------------------------
+    /// Ask the server about the HSA code object currently on the GPU.
+    ///
+    /// @return
+    ///     false if there is no code object or the request failed.
+    //------------------------------------------------------------------
+    bool
+    GetHSABinaryInfo (uint64_t &hash, uint64_t &size);
+
+    //------------------------------------------------------------------
+    /// Stream \a size bytes of the HSA code object from the server with
+    /// qXfer:hsa-binary:read, in chunks sized to the remote packet limit.
+    //------------------------------------------------------------------
+    lldb::DataBufferSP
+    ReadHSABinary (uint64_t size, lldb_private::Error &error);
     
 protected:
     LazyBool m_supports_not_sending_acks;
@@ -16,6 +16,7 @@
 
 // C Includes
 // C++ Includes
+#include <algorithm>
 #include <cstring>
 #include <chrono>
 #include <thread>
@@ -51,6 +52,10 @@
 #include "Utility/UriParser.h"
 #include "ProcessGDBRemote.h"
 #include "ProcessGDBRemoteLog.h"
+#include "Plugins/LanguageRuntime/HSA/HSARuntime/HsaBreakpointCondition.h"
+#include "Plugins/LanguageRuntime/HSA/HSARuntime/HsaBreakpointStats.h"
+#include "Plugins/LanguageRuntime/HSA/HSARuntime/HsaReadRequest.h"
+#include "Plugins/LanguageRuntime/HSA/HSARuntime/HsaWavefrontTable.h"
 
 using namespace lldb;
 using namespace lldb_private;
@@ -109,6 +114,8 @@ GDBRemoteCommunicationServerLLGS::RegisterPacketHandlers()
                                   &GDBRemoteCommunicationServerLLGS::Handle_D);
     RegisterMemberFunctionHandler(StringExtractorGDBRemote::eServerPacketType_hsaBin,
                                   &GDBRemoteCommunicationServerLLGS::Handle_hsaBin);
+    RegisterMemberFunctionHandler(StringExtractorGDBRemote::eServerPacketType_g,
+                                  &GDBRemoteCommunicationServerLLGS::Handle_g);
     RegisterMemberFunctionHandler(StringExtractorGDBRemote::eServerPacketType_H,
                                   &GDBRemoteCommunicationServerLLGS::Handle_H);
     RegisterMemberFunctionHandler(StringExtractorGDBRemote::eServerPacketType_I,
@@ -157,6 +164,22 @@ GDBRemoteCommunicationServerLLGS::RegisterPacketHandlers()
                                   &GDBRemoteCommunicationServerLLGS::Handle_qWatchpointSupportInfo);
     RegisterMemberFunctionHandler(StringExtractorGDBRemote::eServerPacketType_qXfer_auxv_read,
                                   &GDBRemoteCommunicationServerLLGS::Handle_qXfer_auxv_read);
+    RegisterMemberFunctionHandler(StringExtractorGDBRemote::eServerPacketType_qXfer_hsa_binary_read,
+                                  &GDBRemoteCommunicationServerLLGS::Handle_qXfer_hsa_binary_read);
+    RegisterMemberFunctionHandler(StringExtractorGDBRemote::eServerPacketType_jHSAWavefrontsDelta,
+                                  &GDBRemoteCommunicationServerLLGS::Handle_jHSAWavefrontsDelta);
+    RegisterMemberFunctionHandler(StringExtractorGDBRemote::eServerPacketType_jHSARead,
+                                  &GDBRemoteCommunicationServerLLGS::Handle_jHSARead);
+    RegisterMemberFunctionHandler(StringExtractorGDBRemote::eServerPacketType_jHSABreakpointCondition,
+                                  &GDBRemoteCommunicationServerLLGS::Handle_jHSABreakpointCondition);
+    RegisterMemberFunctionHandler(StringExtractorGDBRemote::eServerPacketType_jHSABreakpointMode,
+                                  &GDBRemoteCommunicationServerLLGS::Handle_jHSABreakpointMode);
+    RegisterMemberFunctionHandler(StringExtractorGDBRemote::eServerPacketType_jHSABreakpointStats,
+                                  &GDBRemoteCommunicationServerLLGS::Handle_jHSABreakpointStats);
+    RegisterMemberFunctionHandler(StringExtractorGDBRemote::eServerPacketType_jHSADispatchFilter,
+                                  &GDBRemoteCommunicationServerLLGS::Handle_jHSADispatchFilter);
+    RegisterMemberFunctionHandler(StringExtractorGDBRemote::eServerPacketType_jHSAStepBreakpoints,
+                                  &GDBRemoteCommunicationServerLLGS::Handle_jHSAStepBreakpoints);
     RegisterMemberFunctionHandler(StringExtractorGDBRemote::eServerPacketType_s,
                                   &GDBRemoteCommunicationServerLLGS::Handle_s);
     RegisterMemberFunctionHandler(StringExtractorGDBRemote::eServerPacketType_stop_reason,
@@ -530,6 +553,15 @@ GetStopReasonString(StopReason stop_reason)
     return nullptr;
 }
 
+// A stopped process may leave a thread running, like the HSA agent's debug
+// thread through an HSA stop. It has no registers or stop info to report
+// until the process resumes and stops again.
+static bool
+IsThreadRunningWhileStopped(NativeThreadProtocol &thread)
+{
+    return StateIsRunningState(thread.GetState());
+}
+
 static JSONArray::SP
 GetJSONThreadsInfo(NativeProcessProtocol &process, bool abridged)
 {
@@ -545,6 +577,9 @@ GetJSONThreadsInfo(NativeProcessProtocol &process, bool abridged)
     {
         lldb::tid_t tid = thread_sp->GetID();
 
+        if (IsThreadRunningWhileStopped(*thread_sp))
+            continue;
+
         // Grab the reason this thread stopped.
         struct ThreadStopInfo tid_stop_info;
         std::string description;
@@ -621,10 +656,18 @@ GDBRemoteCommunicationServerLLGS::SendStopReplyPacketForThread (lldb::tid_t tid)
                 __FUNCTION__, m_debugged_process_sp->GetID (), tid);
 
     // Ensure we can get info on the given thread.
-    NativeThreadProtocolSP thread_sp (m_debugged_process_sp->GetThreadByID (tid));
+    NativeThreadProtocolSP thread_sp (GetClientThreadByID (tid));
     if (!thread_sp)
         return SendErrorResponse (51);
 
+    if (IsThreadRunningWhileStopped (*thread_sp))
+    {
+        if (log)
+            log->Printf ("GDBRemoteCommunicationServerLLGS::%s tid %" PRIu64 " is running, it has no stop info",
+                    __FUNCTION__, tid);
+        return SendErrorResponse (52);
+    }
+
     // Grab the reason this thread stopped.
     struct ThreadStopInfo tid_stop_info;
     std::string description;
@@ -1692,6 +1735,78 @@ GDBRemoteCommunicationServerLLGS::Handle_qsThreadInfo (StringExtractorGDBRemote
     return SendPacketNoLock ("l", 1);
 }
 
+GDBRemoteCommunication::PacketResult
+GDBRemoteCommunicationServerLLGS::Handle_g (StringExtractorGDBRemote &packet)
+{
+    Log *log (GetLogIfAnyCategoriesSet(LIBLLDB_LOG_THREAD));
+
+    // Get the thread to use.
+    NativeThreadProtocolSP thread_sp = GetThreadFromSuffix (packet);
+    if (!thread_sp)
+    {
+        if (log)
+            log->Printf ("GDBRemoteCommunicationServerLLGS::%s failed, no thread available", __FUNCTION__);
+        return SendErrorResponse (0x15);
+    }
+
+    if (IsThreadRunningWhileStopped (*thread_sp))
+    {
+        if (log)
+            log->Printf ("GDBRemoteCommunicationServerLLGS::%s tid %" PRIu64 " is running, its registers cannot be accessed", __FUNCTION__, thread_sp->GetID ());
+        return SendErrorResponse (0x15);
+    }
+
+    // Get the thread's register context.
+    NativeRegisterContextSP reg_context_sp (thread_sp->GetRegisterContext ());
+    if (!reg_context_sp)
+    {
+        if (log)
+            log->Printf ("GDBRemoteCommunicationServerLLGS::%s pid %" PRIu64 " tid %" PRIu64 " failed, no register context available for the thread", __FUNCTION__, m_debugged_process_sp->GetID (), thread_sp->GetID ());
+        return SendErrorResponse (0x15);
+    }
+
+    // Lay every register out at its offset, the client reads them all at once
+    // instead of sending a p packet per register.
+    std::vector<uint8_t> regs_buffer;
+    const uint32_t reg_count = reg_context_sp->GetUserRegisterCount ();
+    for (uint32_t reg_index = 0; reg_index < reg_count; ++reg_index)
+    {
+        const RegisterInfo *reg_info = reg_context_sp->GetRegisterInfoAtIndex (reg_index);
+        if (!reg_info)
+        {
+            if (log)
+                log->Printf ("GDBRemoteCommunicationServerLLGS::%s failed, register %" PRIu32 " returned NULL", __FUNCTION__, reg_index);
+            return SendErrorResponse (0x15);
+        }
+
+        if (reg_info->value_regs != nullptr)
+            continue; // Only send registers that are not contained in other registers.
+
+        RegisterValue reg_value;
+        Error error = reg_context_sp->ReadRegister (reg_info, reg_value);
+        if (error.Fail ())
+        {
+            if (log)
+                log->Printf ("GDBRemoteCommunicationServerLLGS::%s failed, read of register %" PRIu32 " (%s) failed: %s", __FUNCTION__, reg_index, reg_info->name, error.AsCString ());
+            return SendErrorResponse (0x15);
+        }
+
+        if (reg_info->byte_offset + reg_info->byte_size > regs_buffer.size ())
+            regs_buffer.resize (reg_info->byte_offset + reg_info->byte_size);
+
+        const uint32_t byte_size = std::min<uint32_t> (reg_value.GetByteSize (), reg_info->byte_size);
+        if (byte_size > 0 && reg_value.GetBytes ())
+            memcpy (regs_buffer.data () + reg_info->byte_offset, reg_value.GetBytes (), byte_size);
+    }
+
+    // FIXME flip as needed to get data in big/little endian format for this host.
+    StreamGDBRemote response;
+    for (uint8_t byte : regs_buffer)
+        response.PutHex8 (byte);
+
+    return SendPacketNoLock (response.GetData (), response.GetSize ());
+}
+
 GDBRemoteCommunication::PacketResult
 GDBRemoteCommunicationServerLLGS::Handle_p (StringExtractorGDBRemote &packet)
 {
@@ -1716,6 +1831,13 @@ GDBRemoteCommunicationServerLLGS::Handle_p (StringExtractorGDBRemote &packet)
         return SendErrorResponse (0x15);
     }
 
+    if (IsThreadRunningWhileStopped (*thread_sp))
+    {
+        if (log)
+            log->Printf ("GDBRemoteCommunicationServerLLGS::%s tid %" PRIu64 " is running, its registers cannot be accessed", __FUNCTION__, thread_sp->GetID ());
+        return SendErrorResponse (0x15);
+    }
+
     // Get the thread's register context.
     NativeRegisterContextSP reg_context_sp (thread_sp->GetRegisterContext ());
     if (!reg_context_sp)
@@ -1814,6 +1936,13 @@ GDBRemoteCommunicationServerLLGS::Handle_P (StringExtractorGDBRemote &packet)
         return SendErrorResponse (0x28);
     }
 
+    if (IsThreadRunningWhileStopped (*thread_sp))
+    {
+        if (log)
+            log->Printf ("GDBRemoteCommunicationServerLLGS::%s tid %" PRIu64 " is running, its registers cannot be accessed", __FUNCTION__, thread_sp->GetID ());
+        return SendErrorResponse (0x28);
+    }
+
     // Get the thread's register context.
     NativeRegisterContextSP reg_context_sp (thread_sp->GetRegisterContext ());
     if (!reg_context_sp)
@@ -1876,17 +2005,21 @@ GDBRemoteCommunicationServerLLGS::Handle_hsaBin (StringExtractorGDBRemote &packe
         return SendErrorResponse (0x15);
     }
 
-    StreamGDBRemote response;
-    std::string file_name;
-    auto err = m_debugged_process_sp->GetHSABinaryFileName(file_name);
-    if (log)
-        log->Printf ("GDBRemoteCommunicationServerLLGS::%s file name is %s", __FUNCTION__, file_name.c_str());
-
-    if (err.Success()) {
-        response.PutCString(file_name.data());
-        return SendPacketNoLock(response.GetData(), response.GetSize());
+    lldb::DataBufferSP binary_sp;
+    uint64_t hash = 0;
+    Error error = m_debugged_process_sp->GetHSABinary(binary_sp, hash);
+    if (error.Fail())
+    {
+        if (log)
+            log->Printf ("GDBRemoteCommunicationServerLLGS::%s failed: %s", __FUNCTION__, error.AsCString());
+        return SendErrorResponse (0x0);
     }
-    return SendErrorResponse (0x0);
+
+    // Only describe the code object here, the client fetches the bytes with
+    // qXfer:hsa-binary:read if it does not already have a copy with this hash
+    StreamGDBRemote response;
+    response.Printf ("hash:%" PRIx64 ";size:%" PRIx64 ";", hash, static_cast<uint64_t>(binary_sp->GetByteSize ()));
+    return SendPacketNoLock(response.GetData(), response.GetSize());
 }
 
 GDBRemoteCommunication::PacketResult
@@ -1933,7 +2066,7 @@ GDBRemoteCommunicationServerLLGS::Handle_H (StringExtractorGDBRemote &packet)
     // Ensure we have the given thread when not specifying -1 (all threads) or 0 (any thread).
     if (tid != LLDB_INVALID_THREAD_ID && tid != 0)
     {
-        NativeThreadProtocolSP thread_sp (m_debugged_process_sp->GetThreadByID (tid));
+        NativeThreadProtocolSP thread_sp (GetClientThreadByID (tid));
         if (!thread_sp)
         {
             if (log)
@@ -2589,6 +2722,67 @@ GDBRemoteCommunicationServerLLGS::Handle_qXfer_auxv_read (StringExtractorGDBRemo
 #endif
 }
 
+GDBRemoteCommunication::PacketResult
+GDBRemoteCommunicationServerLLGS::Handle_qXfer_hsa_binary_read (StringExtractorGDBRemote &packet)
+{
+    Log *log (GetLogIfAnyCategoriesSet(LIBLLDB_LOG_PROCESS));
+
+    // Parse out the offset.
+    packet.SetFilePos (strlen("qXfer:hsa-binary:read::"));
+    if (packet.GetBytesLeft () < 1)
+        return SendIllFormedResponse (packet, "qXfer:hsa-binary:read:: packet missing offset");
+
+    const uint64_t offset = packet.GetHexMaxU64 (false, std::numeric_limits<uint64_t>::max ());
+    if (offset == std::numeric_limits<uint64_t>::max ())
+        return SendIllFormedResponse (packet, "qXfer:hsa-binary:read:: packet missing offset");
+
+    // Parse out comma.
+    if (packet.GetBytesLeft () < 1 || packet.GetChar () != ',')
+        return SendIllFormedResponse (packet, "qXfer:hsa-binary:read:: packet missing comma after offset");
+
+    // Parse out the length.
+    const uint64_t length = packet.GetHexMaxU64 (false, std::numeric_limits<uint64_t>::max ());
+    if (length == std::numeric_limits<uint64_t>::max ())
+        return SendIllFormedResponse (packet, "qXfer:hsa-binary:read:: packet missing length");
+
+    // Make sure we have a valid process.
+    if (!m_debugged_process_sp || (m_debugged_process_sp->GetID () == LLDB_INVALID_PROCESS_ID))
+    {
+        if (log)
+            log->Printf ("GDBRemoteCommunicationServerLLGS::%s failed, no process available", __FUNCTION__);
+        return SendErrorResponse (0x10);
+    }
+
+    // The process hands out its own buffer, so unlike auxv there is no
+    // need to hold on to a copy between chunks.
+    lldb::DataBufferSP binary_sp;
+    uint64_t hash = 0;
+    Error error = m_debugged_process_sp->GetHSABinary (binary_sp, hash);
+    if (error.Fail () || !binary_sp)
+    {
+        if (log)
+            log->Printf ("GDBRemoteCommunicationServerLLGS::%s failed, no HSA code object", __FUNCTION__);
+        return SendErrorResponse (0x11);
+    }
+
+    StreamGDBRemote response;
+    if (offset >= binary_sp->GetByteSize ())
+    {
+        // We have nothing left to send.
+        response.PutChar ('l');
+    }
+    else
+    {
+        const uint64_t bytes_remaining = binary_sp->GetByteSize () - offset;
+        const uint64_t bytes_to_read = (length > bytes_remaining) ? bytes_remaining : length;
+
+        response.PutChar (bytes_to_read >= bytes_remaining ? 'l' : 'm');
+        response.PutEscapedBytes (binary_sp->GetBytes () + offset, bytes_to_read);
+    }
+
+    return SendPacketNoLock(response.GetData(), response.GetSize());
+}
+
 GDBRemoteCommunication::PacketResult
 GDBRemoteCommunicationServerLLGS::Handle_QSaveRegisterState (StringExtractorGDBRemote &packet)
 {
@@ -2607,6 +2801,13 @@ GDBRemoteCommunicationServerLLGS::Handle_QSaveRegisterState (StringExtractorGDBR
             return SendIllFormedResponse (packet, "No thread was is set with the Hg packet");
     }
 
+    if (IsThreadRunningWhileStopped (*thread_sp))
+    {
+        if (log)
+            log->Printf ("GDBRemoteCommunicationServerLLGS::%s tid %" PRIu64 " is running, its registers cannot be accessed", __FUNCTION__, thread_sp->GetID ());
+        return SendErrorResponse (0x15);
+    }
+
     // Grab the register context for the thread.
     NativeRegisterContextSP reg_context_sp (thread_sp->GetRegisterContext ());
     if (!reg_context_sp)
@@ -2670,6 +2871,13 @@ GDBRemoteCommunicationServerLLGS::Handle_QRestoreRegisterState (StringExtractorG
             return SendIllFormedResponse (packet, "No thread was is set with the Hg packet");
     }
 
+    if (IsThreadRunningWhileStopped (*thread_sp))
+    {
+        if (log)
+            log->Printf ("GDBRemoteCommunicationServerLLGS::%s tid %" PRIu64 " is running, its registers cannot be accessed", __FUNCTION__, thread_sp->GetID ());
+        return SendErrorResponse (0x15);
+    }
+
     // Grab the register context for the thread.
     NativeRegisterContextSP reg_context_sp (thread_sp->GetRegisterContext ());
     if (!reg_context_sp)
@@ -2837,6 +3045,283 @@ GDBRemoteCommunicationServerLLGS::Handle_jThreadsInfo (StringExtractorGDBRemote
     return SendPacketNoLock (escaped_response.GetData(), escaped_response.GetSize());
 }
 
+static JSONObject::SP
+GetJSONForHSAWavefront(const HsaWavefrontTable &table, size_t idx)
+{
+    JSONObject::SP wave_obj_sp = std::make_shared<JSONObject>();
+    wave_obj_sp->SetObject("tid", std::make_shared<JSONNumber>(table.GetGlobalID (idx) + 1));
+    wave_obj_sp->SetObject("pc", std::make_shared<JSONNumber>(table.GetPC (idx)));
+    wave_obj_sp->SetObject("exec_mask", std::make_shared<JSONNumber>(table.GetExecMask (idx)));
+    wave_obj_sp->SetObject("wave_address", std::make_shared<JSONNumber>(static_cast<uint64_t>(table.GetWaveAddress (idx))));
+
+    const HsailWaveDim3 work_group = table.GetWorkGroupID (idx);
+    JSONArray::SP work_group_sp = std::make_shared<JSONArray>();
+    work_group_sp->AppendObject(std::make_shared<JSONNumber>(static_cast<uint64_t>(work_group.x)));
+    work_group_sp->AppendObject(std::make_shared<JSONNumber>(static_cast<uint64_t>(work_group.y)));
+    work_group_sp->AppendObject(std::make_shared<JSONNumber>(static_cast<uint64_t>(work_group.z)));
+    wave_obj_sp->SetObject("work_group", work_group_sp);
+
+    return wave_obj_sp;
+}
+
+GDBRemoteCommunication::PacketResult
+GDBRemoteCommunicationServerLLGS::Handle_jHSAWavefrontsDelta (StringExtractorGDBRemote &packet)
+{
+    Log *log (GetLogIfAnyCategoriesSet (LIBLLDB_LOG_PROCESS | LIBLLDB_LOG_THREAD));
+
+    // Ensure we have a debugged process.
+    if (!m_debugged_process_sp || (m_debugged_process_sp->GetID () == LLDB_INVALID_PROCESS_ID))
+        return SendErrorResponse (50);
+
+    // Parse out the version of the wavefront table the client already has.
+    packet.SetFilePos (strlen ("jHSAWavefrontsDelta:"));
+    const uint32_t client_version = packet.GetHexMaxU32 (false, std::numeric_limits<uint32_t>::max ());
+    if (client_version == std::numeric_limits<uint32_t>::max ())
+        return SendIllFormedResponse (packet, "jHSAWavefrontsDelta: packet missing version");
+
+    HsaWavefrontUpdateSP update_sp;
+    Error error = m_debugged_process_sp->GetHSAWavefrontUpdate (update_sp);
+    if (error.Fail ())
+    {
+        if (log)
+            log->Printf ("GDBRemoteCommunicationServerLLGS::%s failed: %s", __FUNCTION__, error.AsCString ());
+        return SendErrorResponse (51);
+    }
+
+    const HsaWavefrontTable &table = *update_sp->table;
+    JSONArray::SP added_sp = std::make_shared<JSONArray>();
+    JSONArray::SP moved_sp = std::make_shared<JSONArray>();
+    JSONArray::SP retired_sp = std::make_shared<JSONArray>();
+
+    // A client that is up to date gets nothing, one that is more than one
+    // stop behind gets the whole table
+    const bool up_to_date = client_version == update_sp->version;
+    const bool full = !up_to_date && client_version != update_sp->base_version;
+    if (full)
+    {
+        for (size_t idx = 0; idx < table.GetSize (); ++idx)
+            added_sp->AppendObject(GetJSONForHSAWavefront(table, idx));
+    }
+    else if (!up_to_date)
+    {
+        for (size_t idx : update_sp->delta.added)
+            added_sp->AppendObject(GetJSONForHSAWavefront(table, idx));
+        for (size_t idx : update_sp->delta.moved)
+            moved_sp->AppendObject(GetJSONForHSAWavefront(table, idx));
+        for (size_t idx : update_sp->delta.retired)
+            retired_sp->AppendObject(std::make_shared<JSONNumber>(update_sp->base_table->GetGlobalID (idx) + 1));
+    }
+
+    JSONObject::SP reply_sp = std::make_shared<JSONObject>();
+    reply_sp->SetObject("version", std::make_shared<JSONNumber>(static_cast<uint64_t>(update_sp->version)));
+    if (full)
+        reply_sp->SetObject("full", std::make_shared<JSONTrue>());
+    else
+        reply_sp->SetObject("full", std::make_shared<JSONFalse>());
+    reply_sp->SetObject("total", std::make_shared<JSONNumber>(static_cast<uint64_t>(table.GetSize ())));
+    reply_sp->SetObject("added", added_sp);
+    reply_sp->SetObject("moved", moved_sp);
+    reply_sp->SetObject("retired", retired_sp);
+
+    StreamString response;
+    reply_sp->Write(response);
+    StreamGDBRemote escaped_response;
+    escaped_response.PutEscapedBytes(response.GetData(), response.GetSize());
+    return SendPacketNoLock (escaped_response.GetData(), escaped_response.GetSize());
+}
+
+GDBRemoteCommunication::PacketResult
+GDBRemoteCommunicationServerLLGS::Handle_jHSARead (StringExtractorGDBRemote &packet)
+{
+    Log *log (GetLogIfAnyCategoriesSet (LIBLLDB_LOG_PROCESS));
+
+    // Ensure we have a debugged process.
+    if (!m_debugged_process_sp || (m_debugged_process_sp->GetID () == LLDB_INVALID_PROCESS_ID))
+        return SendErrorResponse (50);
+
+    // The rest of the packet is a JSON array of requests.
+    packet.SetFilePos (strlen ("jHSARead:"));
+    HsaReadRequests requests;
+    if (!HsaReadRequestsFromJSON (StructuredData::ParseJSON (packet.Peek () ? packet.Peek () : ""), requests))
+        return SendIllFormedResponse (packet, "jHSARead: malformed request array");
+
+    Error error = m_debugged_process_sp->ReadHSA (requests);
+    if (error.Fail ())
+    {
+        if (log)
+            log->Printf ("GDBRemoteCommunicationServerLLGS::%s failed: %s", __FUNCTION__, error.AsCString ());
+        return SendErrorResponse (51);
+    }
+
+    StreamString response;
+    HsaReadResultsToJSON (requests)->Write(response);
+    StreamGDBRemote escaped_response;
+    escaped_response.PutEscapedBytes(response.GetData(), response.GetSize());
+    return SendPacketNoLock (escaped_response.GetData(), escaped_response.GetSize());
+}
+
+GDBRemoteCommunication::PacketResult
+GDBRemoteCommunicationServerLLGS::Handle_jHSABreakpointCondition (StringExtractorGDBRemote &packet)
+{
+    Log *log (GetLogIfAnyCategoriesSet (LIBLLDB_LOG_BREAKPOINTS));
+
+    // Ensure we have a debugged process.
+    if (!m_debugged_process_sp || (m_debugged_process_sp->GetID () == LLDB_INVALID_PROCESS_ID))
+        return SendErrorResponse (50);
+
+    // The rest of the packet is a JSON object with the breakpoint's address
+    // and the condition program.
+    packet.SetFilePos (strlen ("jHSABreakpointCondition:"));
+    HsaBreakpointCondition condition;
+    if (!HsaBreakpointConditionFromJSON (StructuredData::ParseJSON (packet.Peek () ? packet.Peek () : ""), condition))
+        return SendIllFormedResponse (packet, "jHSABreakpointCondition: malformed condition");
+
+    Error error = m_debugged_process_sp->SetHSABreakpointCondition (condition);
+    if (error.Fail ())
+    {
+        if (log)
+            log->Printf ("GDBRemoteCommunicationServerLLGS::%s failed: %s", __FUNCTION__, error.AsCString ());
+        return SendErrorResponse (52);
+    }
+
+    return SendOKResponse ();
+}
+
+GDBRemoteCommunication::PacketResult
+GDBRemoteCommunicationServerLLGS::Handle_jHSABreakpointMode (StringExtractorGDBRemote &packet)
+{
+    Log *log (GetLogIfAnyCategoriesSet (LIBLLDB_LOG_BREAKPOINTS));
+
+    // Ensure we have a debugged process.
+    if (!m_debugged_process_sp || (m_debugged_process_sp->GetID () == LLDB_INVALID_PROCESS_ID))
+        return SendErrorResponse (50);
+
+    // The rest of the packet is a JSON object with the breakpoint's address
+    // and its mode.
+    packet.SetFilePos (strlen ("jHSABreakpointMode:"));
+    StructuredData::ObjectSP object_sp = StructuredData::ParseJSON (packet.Peek () ? packet.Peek () : "");
+    StructuredData::Dictionary *dict = object_sp ? object_sp->GetAsDictionary () : nullptr;
+    lldb::addr_t addr = LLDB_INVALID_ADDRESS;
+    uint32_t mode = 0;
+    if (!dict || !dict->GetValueForKeyAsInteger ("addr", addr) || !dict->GetValueForKeyAsInteger ("mode", mode))
+        return SendIllFormedResponse (packet, "jHSABreakpointMode: malformed mode");
+
+    Error error = m_debugged_process_sp->SetHSABreakpointMode (addr, mode);
+    if (error.Fail ())
+    {
+        if (log)
+            log->Printf ("GDBRemoteCommunicationServerLLGS::%s failed: %s", __FUNCTION__, error.AsCString ());
+        return SendErrorResponse (53);
+    }
+
+    return SendOKResponse ();
+}
+
+GDBRemoteCommunication::PacketResult
+GDBRemoteCommunicationServerLLGS::Handle_jHSABreakpointStats (StringExtractorGDBRemote &packet)
+{
+    Log *log (GetLogIfAnyCategoriesSet (LIBLLDB_LOG_BREAKPOINTS));
+
+    // Ensure we have a debugged process.
+    if (!m_debugged_process_sp || (m_debugged_process_sp->GetID () == LLDB_INVALID_PROCESS_ID))
+        return SendErrorResponse (50);
+
+    // The rest of the packet is a JSON object with the number of
+    // work-groups wanted per breakpoint.
+    packet.SetFilePos (strlen ("jHSABreakpointStats:"));
+    StructuredData::ObjectSP object_sp = StructuredData::ParseJSON (packet.Peek () ? packet.Peek () : "");
+    StructuredData::Dictionary *dict = object_sp ? object_sp->GetAsDictionary () : nullptr;
+    uint64_t max_work_groups = 0;
+    if (!dict || !dict->GetValueForKeyAsInteger ("max_work_groups", max_work_groups))
+        return SendIllFormedResponse (packet, "jHSABreakpointStats: malformed request");
+
+    HsaBreakpointStatsTable table;
+    Error error = m_debugged_process_sp->GetHSABreakpointStats (table, max_work_groups);
+    if (error.Fail ())
+    {
+        if (log)
+            log->Printf ("GDBRemoteCommunicationServerLLGS::%s failed: %s", __FUNCTION__, error.AsCString ());
+        return SendErrorResponse (54);
+    }
+
+    StreamString response;
+    HsaBreakpointStatsToJSON (table)->Write(response);
+    StreamGDBRemote escaped_response;
+    escaped_response.PutEscapedBytes(response.GetData(), response.GetSize());
+    return SendPacketNoLock (escaped_response.GetData(), escaped_response.GetSize());
+}
+
+GDBRemoteCommunication::PacketResult
+GDBRemoteCommunicationServerLLGS::Handle_jHSADispatchFilter (StringExtractorGDBRemote &packet)
+{
+    Log *log (GetLogIfAnyCategoriesSet (LIBLLDB_LOG_BREAKPOINTS));
+
+    // Ensure we have a debugged process.
+    if (!m_debugged_process_sp || (m_debugged_process_sp->GetID () == LLDB_INVALID_PROCESS_ID))
+        return SendErrorResponse (50);
+
+    // The rest of the packet is a JSON object, {"all":0|1,"kernels":[names]}
+    packet.SetFilePos (strlen ("jHSADispatchFilter:"));
+    StructuredData::ObjectSP object_sp = StructuredData::ParseJSON (packet.Peek () ? packet.Peek () : "");
+    StructuredData::Dictionary *dict = object_sp ? object_sp->GetAsDictionary () : nullptr;
+    StructuredData::Array *kernels = nullptr;
+    uint64_t all_kernels = 0;
+    if (!dict || !dict->GetValueForKeyAsInteger ("all", all_kernels) || !dict->GetValueForKeyAsArray ("kernels", kernels))
+        return SendIllFormedResponse (packet, "jHSADispatchFilter: malformed filter");
+
+    std::vector<std::string> kernel_names (kernels->GetSize ());
+    for (size_t i = 0; i < kernel_names.size (); ++i)
+    {
+        if (!kernels->GetItemAtIndexAsString (i, kernel_names[i]))
+            return SendIllFormedResponse (packet, "jHSADispatchFilter: malformed kernel name");
+    }
+
+    Error error = m_debugged_process_sp->SetHSADispatchFilter (all_kernels != 0, kernel_names);
+    if (error.Fail ())
+    {
+        if (log)
+            log->Printf ("GDBRemoteCommunicationServerLLGS::%s failed: %s", __FUNCTION__, error.AsCString ());
+        return SendErrorResponse (55);
+    }
+
+    return SendOKResponse ();
+}
+
+GDBRemoteCommunication::PacketResult
+GDBRemoteCommunicationServerLLGS::Handle_jHSAStepBreakpoints (StringExtractorGDBRemote &packet)
+{
+    Log *log (GetLogIfAnyCategoriesSet (LIBLLDB_LOG_BREAKPOINTS));
+
+    // Ensure we have a debugged process.
+    if (!m_debugged_process_sp || (m_debugged_process_sp->GetID () == LLDB_INVALID_PROCESS_ID))
+        return SendErrorResponse (50);
+
+    // The rest of the packet is a JSON object, {"addrs":[addresses]}
+    packet.SetFilePos (strlen ("jHSAStepBreakpoints:"));
+    StructuredData::ObjectSP object_sp = StructuredData::ParseJSON (packet.Peek () ? packet.Peek () : "");
+    StructuredData::Dictionary *dict = object_sp ? object_sp->GetAsDictionary () : nullptr;
+    StructuredData::Array *addrs_array = nullptr;
+    if (!dict || !dict->GetValueForKeyAsArray ("addrs", addrs_array))
+        return SendIllFormedResponse (packet, "jHSAStepBreakpoints: malformed step breakpoints");
+
+    std::vector<lldb::addr_t> addrs (addrs_array->GetSize ());
+    for (size_t i = 0; i < addrs.size (); ++i)
+    {
+        if (!addrs_array->GetItemAtIndexAsInteger (i, addrs[i]))
+            return SendIllFormedResponse (packet, "jHSAStepBreakpoints: malformed address");
+    }
+
+    Error error = m_debugged_process_sp->SetHSAStepBreakpoints (addrs);
+    if (error.Fail ())
+    {
+        if (log)
+            log->Printf ("GDBRemoteCommunicationServerLLGS::%s failed: %s", __FUNCTION__, error.AsCString ());
+        return SendErrorResponse (56);
+    }
+
+    return SendOKResponse ();
+}
+
 GDBRemoteCommunication::PacketResult
 GDBRemoteCommunicationServerLLGS::Handle_qWatchpointSupportInfo (StringExtractorGDBRemote &packet)
 {
@@ -2936,7 +3421,7 @@ GDBRemoteCommunicationServerLLGS::GetThreadFromSuffix (StringExtractorGDBRemote
             return m_debugged_process_sp->GetThreadAtIndex (0);
         }
         else
-            return m_debugged_process_sp->GetThreadByID (current_tid);
+            return GetClientThreadByID (current_tid);
     }
 
     Log *log (GetLogIfAnyCategoriesSet(LIBLLDB_LOG_THREAD));
@@ -2962,8 +3447,19 @@ GDBRemoteCommunicationServerLLGS::GetThreadFromSuffix (StringExtractorGDBRemote
     packet.SetFilePos (packet.GetFilePos () + strlen("thread:"));
     const lldb::tid_t tid = packet.GetHexMaxU64(false, 0);
     if (tid != 0)
-        return m_debugged_process_sp->GetThreadByID (tid);
+        return GetClientThreadByID (tid);
+
+    return thread_sp;
+}
 
+NativeThreadProtocolSP
+GDBRemoteCommunicationServerLLGS::GetClientThreadByID (lldb::tid_t tid)
+{
+    // The waves of an HSA stop only get a thread once the client names
+    // them, the thread list itself only holds the ones it already knows
+    NativeThreadProtocolSP thread_sp = m_debugged_process_sp->GetThreadByID (tid);
+    if (!thread_sp && m_debugged_process_sp->MaterializeHSAWavefront (tid).Success ())
+        thread_sp = m_debugged_process_sp->GetThreadByID (tid);
     return thread_sp;
 }
 
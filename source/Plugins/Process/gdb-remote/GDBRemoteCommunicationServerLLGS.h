@@ -186,6 +186,9 @@ protected:
     PacketResult
     Handle_qsThreadInfo (StringExtractorGDBRemote &packet);
 
+    PacketResult
+    Handle_g (StringExtractorGDBRemote &packet);
+
     PacketResult
     Handle_p (StringExtractorGDBRemote &packet);
 
@@ -229,6 +232,30 @@ protected:
     PacketResult
     Handle_qXfer_auxv_read (StringExtractorGDBRemote &packet);
 
+    PacketResult
+    Handle_qXfer_hsa_binary_read (StringExtractorGDBRemote &packet);
+
+    PacketResult
+    Handle_jHSAWavefrontsDelta (StringExtractorGDBRemote &packet);
+
+    PacketResult
+    Handle_jHSARead (StringExtractorGDBRemote &packet);
+
+    PacketResult
+    Handle_jHSABreakpointCondition (StringExtractorGDBRemote &packet);
+
+    PacketResult
+    Handle_jHSABreakpointMode (StringExtractorGDBRemote &packet);
+
+    PacketResult
+    Handle_jHSABreakpointStats (StringExtractorGDBRemote &packet);
+
+    PacketResult
+    Handle_jHSADispatchFilter (StringExtractorGDBRemote &packet);
+
+    PacketResult
+    Handle_jHSAStepBreakpoints (StringExtractorGDBRemote &packet);
+
     PacketResult
     Handle_QSaveRegisterState (StringExtractorGDBRemote &packet);
 
@@ -281,6 +308,9 @@ private:
     NativeThreadProtocolSP
     GetThreadFromSuffix (StringExtractorGDBRemote &packet);
 
+    NativeThreadProtocolSP
+    GetClientThreadByID (lldb::tid_t tid);
+
     uint32_t
     GetNextSavedRegistersID ();
 
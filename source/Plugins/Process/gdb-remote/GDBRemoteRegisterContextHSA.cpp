@@ -11,6 +11,8 @@
 
 // C Includes
 // C++ Includes
+#include <cstring>
+
 // Other libraries and framework includes
 #include "lldb/Core/DataBufferHeap.h"
 #include "lldb/Core/DataExtractor.h"
@@ -28,6 +30,11 @@
 #include "ThreadGDBRemoteHSA.h"
 #include "Utility/ARM_DWARF_Registers.h"
 #include "Utility/ARM_ehframe_Registers.h"
+#include "Plugins/Process/HSA/UnwindHSA.h"
+
+#define DECLARE_REGISTER_INFOS_HSA_STRUCT
+#include "Plugins/Process/HSA/RegisterInfosHSA.h"
+#undef DECLARE_REGISTER_INFOS_HSA_STRUCT
 
 using namespace lldb;
 using namespace lldb_private;
@@ -47,26 +54,42 @@ GDBRemoteRegisterContextHSA::~GDBRemoteRegisterContextHSA()
 {
 }
 
+bool
+GDBRemoteRegisterContextHSA::ReadCallFrameRegisters (lldb::addr_t &fp, lldb::addr_t &mp)
+{
+    auto unwinder = static_cast<UnwindHSA*>(static_cast<ThreadGDBRemoteHSA&>(m_thread).GetUnwinder());
+    if (!unwinder)
+        return false;
+
+    const SymbolFileAMDHSA::CallFrame* frame = unwinder->GetCallFrame(m_concrete_frame_idx);
+    if (!frame)
+        return false;
+
+    fp = frame->m_fp;
+    mp = frame->m_mp;
+    return true;
+}
+
 bool
 GDBRemoteRegisterContextHSA::ReadRegister (const RegisterInfo *reg_info, RegisterValue &value) 
 {
     if (!reg_info) 
         return false;
 
-    if (reg_info->kinds[eRegisterKindGeneric] == LLDB_REGNUM_GENERIC_PC) {
+    // The stub does not know about call frames, fp and mp come from the
+    // debug info. Everything else is read from the wave snapshot with one
+    // g packet per stop.
+    const uint32_t reg = reg_info->kinds[eRegisterKindLLDB];
+    if (reg != gpr_fp_hsa && reg != gpr_mp_hsa)
         return GDBRemoteRegisterContext::ReadRegister(reg_info, value);
-    }
 
-    auto unwinder = static_cast<ThreadGDBRemoteHSA&>(m_thread).GetUnwinder();
-    if (!unwinder)
+    lldb::addr_t fp = 0;
+    lldb::addr_t mp = 0;
+    if (!ReadCallFrameRegisters(fp, mp))
         return false;
 
-    auto frame_sp = m_thread.GetFrameWithConcreteFrameIndex (m_concrete_frame_idx);
-    auto reg_ctx_sp = unwinder->CreateRegisterContextForFrame(frame_sp.get());
-    if (!reg_ctx_sp)
-        return false;
-
-    return reg_ctx_sp->ReadRegister(reg_info, value);
+    value.SetUInt64(reg == gpr_fp_hsa ? fp : mp);
+    return true;
 }
 
 bool
@@ -76,10 +99,21 @@ GDBRemoteRegisterContextHSA::ReadAllRegisterValues (lldb::DataBufferSP &data_sp)
     if (!success)
         return false;
 
+    lldb::addr_t fp = 0;
+    lldb::addr_t mp = 0;
+    if (!ReadCallFrameRegisters(fp, mp))
+        return true;
+
+    const RegisterInfo* fp_info = GetRegisterInfoAtIndex(gpr_fp_hsa);
+    const RegisterInfo* mp_info = GetRegisterInfoAtIndex(gpr_mp_hsa);
+    if (!fp_info || !mp_info ||
+        data_sp->GetByteSize() < fp_info->byte_offset + sizeof(fp) ||
+        data_sp->GetByteSize() < mp_info->byte_offset + sizeof(mp))
+        return true;
+
     auto bytes = data_sp->GetBytes();
-    auto fp = GetFP(0);
-    char* fp_p = reinterpret_cast<char*>(&fp);
-    std::copy(fp_p, fp_p+4, bytes+8);
+    ::memcpy(bytes + fp_info->byte_offset, &fp, sizeof(fp));
+    ::memcpy(bytes + mp_info->byte_offset, &mp, sizeof(mp));
 
     return true;
 }
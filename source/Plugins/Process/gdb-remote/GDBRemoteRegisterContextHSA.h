@@ -51,6 +51,10 @@ public:
     ReadAllRegisterValues (lldb::DataBufferSP &data_sp) override;
 
 private:
+    // The frame and memory pointers of this frame, from the thread's call stack
+    bool
+    ReadCallFrameRegisters (lldb::addr_t &fp, lldb::addr_t &mp);
+
     DISALLOW_COPY_AND_ASSIGN (GDBRemoteRegisterContextHSA);
 };
 
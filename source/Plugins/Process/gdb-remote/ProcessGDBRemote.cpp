@@ -24,7 +24,6 @@
 #include <algorithm>
 #include <map>
 #include <mutex>
-#include <fstream>
 
 #include "lldb/Breakpoint/Watchpoint.h"
 #include "lldb/Interpreter/Args.h"
@@ -38,10 +37,12 @@
 #include "lldb/Core/Section.h"
 #include "lldb/Core/State.h"
 #include "lldb/Core/StreamFile.h"
+#include "lldb/Core/StreamGDBRemote.h"
 #include "lldb/Core/StreamString.h"
 #include "lldb/Core/Timer.h"
 #include "lldb/Core/Value.h"
 #include "lldb/DataFormatters/FormatManager.h"
+#include "lldb/Host/File.h"
 #include "lldb/Host/FileSystem.h"
 #include "lldb/Host/HostThread.h"
 #include "lldb/Host/StringConvert.h"
@@ -66,6 +67,8 @@
 #include "lldb/Target/ThreadPlanCallFunction.h"
 #include "lldb/Target/SystemRuntime.h"
 #include "lldb/Utility/PseudoTerminal.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
 
 // Project includes
 #include "lldb/Host/Host.h"
@@ -79,6 +82,10 @@
 #include "ProcessGDBRemoteLog.h"
 #include "ThreadGDBRemote.h"
 #include "ThreadGDBRemoteHSA.h"
+#include "Plugins/LanguageRuntime/HSA/HSARuntime/HSARuntime.h"
+#include "Plugins/LanguageRuntime/HSA/HSARuntime/HsaBreakpointCondition.h"
+#include "Plugins/LanguageRuntime/HSA/HSARuntime/HsaBreakpointStats.h"
+#include "Plugins/LanguageRuntime/HSA/HSARuntime/HsaReadRequest.h"
 
 #define DECLARE_REGISTER_INFOS_HSA_STRUCT
 #include "Plugins/Process/HSA/RegisterInfosHSA.h"
@@ -303,7 +310,13 @@ ProcessGDBRemote::ProcessGDBRemote(lldb::TargetSP target_sp, Listener &listener)
     m_destroy_tried_resuming (false),
     m_command_sp (),
     m_breakpoint_pc_offset (0),
-    m_initial_tid (LLDB_INVALID_THREAD_ID)
+    m_initial_tid (LLDB_INVALID_THREAD_ID),
+    m_hsa_modules (),
+    m_hsa_wavefronts (),
+    m_hsa_wavefronts_version (0),
+    m_hsa_wavefronts_stop_id (UINT32_MAX),
+    m_hsa_module_sp (),
+    m_hsa_binary_hash (0)
 {
     m_async_broadcaster.SetEventName (eBroadcastBitAsyncThreadShouldExit,   "async thread should exit");
     m_async_broadcaster.SetEventName (eBroadcastBitAsyncContinue,           "async thread continue");
@@ -472,13 +485,13 @@ void
 ProcessGDBRemote::BuildDynamicRegisterInfo (bool force)
 {
     if (force || m_hsa_register_info.GetNumRegisters() == 0) {
-        ConstString pc ("pc");
-        ConstString fp ("fp");
-        ConstString mp ("mp");
         ConstString gpr ("gpr");
-        m_hsa_register_info.AddRegister(g_register_infos_hsa[0], pc, pc, gpr);
-        m_hsa_register_info.AddRegister(g_register_infos_hsa[1], fp, fp, gpr);
-        m_hsa_register_info.AddRegister(g_register_infos_hsa[2], mp, mp, gpr);
+        ConstString wave ("wave");
+        for (uint32_t reg = 0; reg < k_num_registers; ++reg) {
+            ConstString name (g_register_infos_hsa[reg].name);
+            m_hsa_register_info.AddRegister(g_register_infos_hsa[reg], name, name,
+                                            reg < k_num_gpr_registers_hsa ? gpr : wave);
+        }
         m_hsa_register_info.Finalize(GetTarget().GetArchitecture());
     }
 
@@ -1378,6 +1391,12 @@ ProcessGDBRemote::WillResume ()
     m_continue_S_tids.clear();
     m_jstopinfo_sp.reset();
     m_jthreadsinfo_sp.reset();
+
+    // Breakpoints changed since the last stop may need the agent to debug
+    // dispatches it would otherwise skip
+    HSARuntime *runtime = static_cast<HSARuntime *>(GetLanguageRuntime (eLanguageTypeObjC));
+    if (runtime)
+        runtime->ProcessBreakpointEvents ();
     return Error();
 }
 
@@ -2663,28 +2682,8 @@ ProcessGDBRemote::SetThreadStopInfo (StringExtractor& stop_packet)
                 }
             }
 
-            if (!description.empty()) {
-                auto file_name =  m_gdb_comm.GetHSABinaryFileName();
-                FileSpec fs (file_name,true);
-                Error err;
-
-                auto file_size = m_gdb_comm.GetFileSize(fs);
-                auto fd = m_gdb_comm.OpenFile(fs, O_RDONLY, 0, err);
-                std::vector<char> binary (file_size);
-                (void)m_gdb_comm.ReadFile(fd, 0, binary.data(), binary.size(), err);
-                m_gdb_comm.CloseFile(fd, err);
-
-                {
-                    std::ofstream bin_file (file_name);
-                    for (size_t i=0; i<binary.size(); ++i) bin_file << binary[i];
-                }
-
-                auto mod_sp = GetTarget().GetSharedModule(ModuleSpec(fs));
-                auto sec_sp = mod_sp->GetSectionList()->FindSectionByName(ConstString(".hsatext"));
-                GetTarget().SetSectionLoadAddress(sec_sp, 0);
-                Address addr;
-                GetTarget().ResolveLoadAddress(260, addr);
-            }
+            if (!description.empty())
+                LoadHSABinary ();
 
             ThreadSP thread_sp = SetThreadStopInfo (tid,
                                                     expedited_register_map,
@@ -3014,6 +3013,117 @@ ProcessGDBRemote::DoDestroy ()
     return error;
 }
 
+void
+ProcessGDBRemote::LoadHSABinary ()
+{
+    Log *log (ProcessGDBRemoteLog::GetLogIfAllCategoriesSet (GDBR_LOG_PROCESS));
+
+    uint64_t hash = 0;
+    uint64_t size = 0;
+    if (!m_gdb_comm.GetHSABinaryInfo (hash, size))
+    {
+        if (log)
+            log->Printf ("ProcessGDBRemote::%s no HSA code object available", __FUNCTION__);
+        return;
+    }
+
+    // An agent may dispatch without a code object, there is nothing to map
+    if (size == 0)
+    {
+        if (log)
+            log->Printf ("ProcessGDBRemote::%s HSA code object is empty", __FUNCTION__);
+        return;
+    }
+
+    // Every stop inside a kernel reports the code object, only transfer it
+    // when the GPU is running something we have not seen yet
+    if (m_hsa_module_sp && hash == m_hsa_binary_hash)
+        return;
+
+    // Applications dispatch the same few kernels over and over, so keep
+    // every code object we have loaded and switch back to it by hash
+    ModuleSP module_sp;
+    auto pos = m_hsa_modules.find (hash);
+    if (pos != m_hsa_modules.end ())
+    {
+        if (log)
+            log->Printf ("ProcessGDBRemote::%s reusing HSA code object %16.16" PRIx64, __FUNCTION__, hash);
+        module_sp = pos->second;
+    }
+    else
+    {
+        module_sp = CreateHSAModule (size);
+        if (!module_sp)
+            return;
+        m_hsa_modules[hash] = module_sp;
+    }
+
+    // All code objects are loaded at address 0, unload the previous one
+    // so addresses resolve to the kernel that is actually running
+    ConstString hsatext (".hsatext");
+    if (m_hsa_module_sp && m_hsa_module_sp->GetSectionList ())
+    {
+        SectionSP old_section_sp = m_hsa_module_sp->GetSectionList ()->FindSectionByName (hsatext);
+        if (old_section_sp)
+            GetTarget ().SetSectionUnloaded (old_section_sp);
+    }
+
+    SectionSP section_sp = module_sp->GetSectionList ()->FindSectionByName (hsatext);
+    if (section_sp)
+        GetTarget ().SetSectionLoadAddress (section_sp, 0);
+
+    m_hsa_module_sp = module_sp;
+    m_hsa_binary_hash = hash;
+
+    HSARuntime *runtime = static_cast<HSARuntime *>(GetLanguageRuntime (eLanguageTypeObjC));
+    if (runtime)
+        runtime->SetCurrentHSAModule (module_sp);
+}
+
+ModuleSP
+ProcessGDBRemote::CreateHSAModule (uint64_t size)
+{
+    Log *log (ProcessGDBRemoteLog::GetLogIfAllCategoriesSet (GDBR_LOG_PROCESS));
+
+    Error error;
+    DataBufferSP data_sp = m_gdb_comm.ReadHSABinary (size, error);
+    if (!data_sp)
+    {
+        if (log)
+            log->Printf ("ProcessGDBRemote::%s failed to read HSA code object: %s", __FUNCTION__, error.AsCString ());
+        return ModuleSP ();
+    }
+
+    // The object file plugins map modules from disk, so write the code
+    // object out locally in a single write and let the module map it
+    llvm::SmallString<PATH_MAX> output_file_path;
+    int temp_fd = -1;
+    if (llvm::sys::fs::createTemporaryFile ("hsa_binary.%%%%%%", "", temp_fd, output_file_path))
+    {
+        if (log)
+            log->Printf ("ProcessGDBRemote::%s failed to create HSA code object file", __FUNCTION__);
+        return ModuleSP ();
+    }
+
+    {
+        File file (temp_fd, true);
+        size_t bytes_written = data_sp->GetByteSize ();
+        error = file.Write (data_sp->GetBytes (), bytes_written);
+        if (error.Fail () || bytes_written != data_sp->GetByteSize ())
+        {
+            if (log)
+                log->Printf ("ProcessGDBRemote::%s failed to write HSA code object file", __FUNCTION__);
+            return ModuleSP ();
+        }
+    }
+
+    FileSpec file_spec (output_file_path.c_str (), false);
+    ModuleSP module_sp = GetTarget ().GetSharedModule (ModuleSpec (file_spec));
+    if (!module_sp || !module_sp->GetSectionList ())
+        return ModuleSP ();
+    return module_sp;
+}
+
 void
 ProcessGDBRemote::SetLastStopPacket (const StringExtractorGDBRemote &response)
 {
@@ -4305,6 +4415,273 @@ ProcessGDBRemote::GetLoadedDynamicLibrariesInfos (lldb::addr_t image_list_addres
     return object_sp;
 }
 
+Error
+ProcessGDBRemote::ReadHSA (std::vector<HsaReadRequest> &requests)
+{
+    if (requests.empty())
+        return Error();
+
+    StreamString request_json;
+    HsaReadRequestsToJSON (requests)->Write (request_json);
+
+    StreamGDBRemote packet;
+    packet.PutCString ("jHSARead:");
+    packet.PutEscapedBytes (request_json.GetData(), request_json.GetSize());
+
+    StringExtractorGDBRemote response;
+    if (m_gdb_comm.SendPacketAndWaitForResponse(packet.GetData(), packet.GetSize(), response, false) != GDBRemoteCommunication::PacketResult::Success)
+        return Error ("failed to send jHSARead packet");
+
+    if (response.GetResponseType() != StringExtractorGDBRemote::eResponse || response.Empty())
+        return Error ("the agent could not serve the HSA reads");
+
+    if (!HsaReadResultsFromJSON (StructuredData::ParseJSON (response.GetStringRef()), requests))
+        return Error ("malformed jHSARead response");
+
+    return Error();
+}
+
+Error
+ProcessGDBRemote::SetHSABreakpointCondition (const HsaBreakpointCondition &condition)
+{
+    StreamString condition_json;
+    HsaBreakpointConditionToJSON (condition)->Write (condition_json);
+
+    StreamGDBRemote packet;
+    packet.PutCString ("jHSABreakpointCondition:");
+    packet.PutEscapedBytes (condition_json.GetData(), condition_json.GetSize());
+
+    StringExtractorGDBRemote response;
+    if (m_gdb_comm.SendPacketAndWaitForResponse(packet.GetData(), packet.GetSize(), response, false) != GDBRemoteCommunication::PacketResult::Success)
+        return Error ("failed to send jHSABreakpointCondition packet");
+
+    if (!response.IsOKResponse())
+        return Error ("the agent did not take the breakpoint condition");
+
+    return Error();
+}
+
+Error
+ProcessGDBRemote::SetHSABreakpointMode (lldb::addr_t addr, uint32_t mode)
+{
+    StreamGDBRemote packet;
+    packet.Printf ("jHSABreakpointMode:{\"addr\":%" PRIu64 ",\"mode\":%u}", addr, mode);
+
+    StringExtractorGDBRemote response;
+    if (m_gdb_comm.SendPacketAndWaitForResponse(packet.GetData(), packet.GetSize(), response, false) != GDBRemoteCommunication::PacketResult::Success)
+        return Error ("failed to send jHSABreakpointMode packet");
+
+    if (!response.IsOKResponse())
+        return Error ("the agent did not take the breakpoint mode");
+
+    return Error();
+}
+
+Error
+ProcessGDBRemote::GetHSABreakpointStats (HsaBreakpointStatsTable &table, size_t max_work_groups)
+{
+    StreamGDBRemote packet;
+    packet.Printf ("jHSABreakpointStats:{\"max_work_groups\":%" PRIu64 "}", static_cast<uint64_t>(max_work_groups));
+
+    StringExtractorGDBRemote response;
+    if (m_gdb_comm.SendPacketAndWaitForResponse(packet.GetData(), packet.GetSize(), response, false) != GDBRemoteCommunication::PacketResult::Success)
+        return Error ("failed to send jHSABreakpointStats packet");
+
+    if (response.GetResponseType() != StringExtractorGDBRemote::eResponse || response.Empty())
+        return Error ("the agent has no breakpoint statistics");
+
+    if (!HsaBreakpointStatsFromJSON (StructuredData::ParseJSON (response.GetStringRef()), table))
+        return Error ("malformed jHSABreakpointStats response");
+
+    return Error();
+}
+
+Error
+ProcessGDBRemote::SetHSADispatchFilter (bool all_kernels, const std::vector<std::string> &kernel_names)
+{
+    JSONArray::SP kernels_sp = std::make_shared<JSONArray>();
+    for (const auto &kernel_name : kernel_names)
+        kernels_sp->AppendObject (std::make_shared<JSONString>(kernel_name));
+
+    JSONObject filter;
+    filter.SetObject ("all", std::make_shared<JSONNumber>(static_cast<uint64_t>(all_kernels)));
+    filter.SetObject ("kernels", kernels_sp);
+
+    StreamString filter_json;
+    filter.Write (filter_json);
+
+    StreamGDBRemote packet;
+    packet.PutCString ("jHSADispatchFilter:");
+    packet.PutEscapedBytes (filter_json.GetData(), filter_json.GetSize());
+
+    StringExtractorGDBRemote response;
+    if (m_gdb_comm.SendPacketAndWaitForResponse(packet.GetData(), packet.GetSize(), response, false) != GDBRemoteCommunication::PacketResult::Success)
+        return Error ("failed to send jHSADispatchFilter packet");
+
+    if (!response.IsOKResponse())
+        return Error ("the agent did not take the dispatch filter");
+
+    return Error();
+}
+
+Error
+ProcessGDBRemote::SetHSAStepBreakpoints (const std::vector<lldb::addr_t> &addrs)
+{
+    JSONArray::SP addrs_sp = std::make_shared<JSONArray>();
+    for (lldb::addr_t addr : addrs)
+        addrs_sp->AppendObject (std::make_shared<JSONNumber>(static_cast<uint64_t>(addr)));
+
+    JSONObject step;
+    step.SetObject ("addrs", addrs_sp);
+
+    StreamString step_json;
+    step.Write (step_json);
+
+    StreamGDBRemote packet;
+    packet.PutCString ("jHSAStepBreakpoints:");
+    packet.PutEscapedBytes (step_json.GetData(), step_json.GetSize());
+
+    StringExtractorGDBRemote response;
+    if (m_gdb_comm.SendPacketAndWaitForResponse(packet.GetData(), packet.GetSize(), response, false) != GDBRemoteCommunication::PacketResult::Success)
+        return Error ("failed to send jHSAStepBreakpoints packet");
+
+    if (!response.IsOKResponse())
+        return Error ("the agent did not take the step breakpoints");
+
+    return Error();
+}
+
+static bool
+ParseHSAWavefront (StructuredData::Dictionary *wave_dict, lldb::tid_t &tid, lldb::addr_t &pc,
+                   uint64_t &exec_mask, uint64_t &wave_address, uint64_t (&work_group)[3])
+{
+    if (!wave_dict || !wave_dict->GetValueForKeyAsInteger ("tid", tid))
+        return false;
+    wave_dict->GetValueForKeyAsInteger ("pc", pc);
+    wave_dict->GetValueForKeyAsInteger ("exec_mask", exec_mask);
+    wave_dict->GetValueForKeyAsInteger ("wave_address", wave_address);
+
+    StructuredData::Array *work_group_array = nullptr;
+    if (wave_dict->GetValueForKeyAsArray ("work_group", work_group_array))
+    {
+        for (size_t i = 0; i < 3; ++i)
+            work_group_array->GetItemAtIndexAsInteger (i, work_group[i]);
+    }
+    return true;
+}
+
+bool
+ProcessGDBRemote::UpdateHSAWavefronts ()
+{
+    const uint32_t stop_id = GetStopID ();
+    if (stop_id == m_hsa_wavefronts_stop_id)
+        return true;
+
+    StreamString packet;
+    packet.Printf ("jHSAWavefrontsDelta:%" PRIx32, m_hsa_wavefronts_version);
+
+    StringExtractorGDBRemote response;
+    StructuredData::ObjectSP object_sp;
+    if (m_gdb_comm.SendPacketAndWaitForResponse(packet.GetData(), packet.GetSize(), response, false) == GDBRemoteCommunication::PacketResult::Success &&
+        response.GetResponseType() == StringExtractorGDBRemote::eResponse && !response.Empty())
+    {
+        object_sp = StructuredData::ParseJSON (response.GetStringRef());
+    }
+
+    StructuredData::Dictionary *delta = object_sp ? object_sp->GetAsDictionary () : nullptr;
+    if (!delta)
+    {
+        // No wavefronts at this stop
+        m_hsa_wavefronts.clear ();
+        m_hsa_wavefronts_version = 0;
+        m_hsa_wavefronts_stop_id = stop_id;
+        return false;
+    }
+
+    StructuredData::ObjectSP full_sp = delta->GetValueForKey ("full");
+    if (!full_sp || full_sp->GetBooleanValue (true))
+        m_hsa_wavefronts.clear ();
+
+    auto find_wave = [this] (lldb::tid_t tid) {
+        return std::lower_bound (m_hsa_wavefronts.begin (), m_hsa_wavefronts.end (), tid,
+                                 [] (const HSAWavefront &wave, lldb::tid_t tid) { return wave.tid < tid; });
+    };
+
+    StructuredData::Array *retired = nullptr;
+    if (delta->GetValueForKeyAsArray ("retired", retired))
+    {
+        for (size_t i = 0; i < retired->GetSize (); ++i)
+        {
+            lldb::tid_t tid = LLDB_INVALID_THREAD_ID;
+            if (!retired->GetItemAtIndexAsInteger (i, tid))
+                continue;
+            auto pos = find_wave (tid);
+            if (pos != m_hsa_wavefronts.end () && pos->tid == tid)
+                m_hsa_wavefronts.erase (pos);
+        }
+    }
+
+    // Moved and added waves carry the whole row, insert or overwrite them
+    for (const char *key : { "moved", "added" })
+    {
+        StructuredData::Array *rows = nullptr;
+        if (!delta->GetValueForKeyAsArray (key, rows))
+            continue;
+        for (size_t i = 0; i < rows->GetSize (); ++i)
+        {
+            HSAWavefront wave = {};
+            if (!ParseHSAWavefront (rows->GetItemAtIndex (i)->GetAsDictionary (), wave.tid, wave.pc,
+                                    wave.exec_mask, wave.wave_address, wave.work_group))
+                continue;
+            auto pos = find_wave (wave.tid);
+            if (pos != m_hsa_wavefronts.end () && pos->tid == wave.tid)
+                *pos = wave;
+            else
+                m_hsa_wavefronts.insert (pos, wave);
+        }
+    }
+
+    delta->GetValueForKeyAsInteger ("version", m_hsa_wavefronts_version);
+    m_hsa_wavefronts_stop_id = stop_id;
+    return true;
+}
+
+StructuredData::ObjectSP
+ProcessGDBRemote::GetHSAWavefrontsInfo (uint64_t start, uint64_t count)
+{
+    if (!UpdateHSAWavefronts ())
+        return StructuredData::ObjectSP ();
+
+    StructuredData::Array *waves_array = new StructuredData::Array ();
+    StructuredData::ObjectSP waves_array_sp (waves_array);
+    const uint64_t end = std::min<uint64_t> (m_hsa_wavefronts.size (), start + count);
+    for (uint64_t idx = start; idx < end; ++idx)
+    {
+        const HSAWavefront &wave = m_hsa_wavefronts[idx];
+
+        StructuredData::Array *work_group = new StructuredData::Array ();
+        StructuredData::ObjectSP work_group_sp (work_group);
+        for (uint64_t id : wave.work_group)
+            work_group->AddItem (StructuredData::ObjectSP (new StructuredData::Integer (id)));
+
+        StructuredData::Dictionary *wave_dict = new StructuredData::Dictionary ();
+        StructuredData::ObjectSP wave_dict_sp (wave_dict);
+        wave_dict->AddIntegerItem ("tid", wave.tid);
+        wave_dict->AddIntegerItem ("pc", wave.pc);
+        wave_dict->AddIntegerItem ("exec_mask", wave.exec_mask);
+        wave_dict->AddIntegerItem ("wave_address", wave.wave_address);
+        wave_dict->AddItem ("work_group", work_group_sp);
+        waves_array->AddItem (wave_dict_sp);
+    }
+
+    StructuredData::Dictionary *info = new StructuredData::Dictionary ();
+    StructuredData::ObjectSP info_sp (info);
+    info->AddIntegerItem ("total", m_hsa_wavefronts.size ());
+    info->AddIntegerItem ("start", start);
+    info->AddItem ("wavefronts", waves_array_sp);
+    return info_sp;
+}
+
 // Establish the largest memory read/write payloads we should use.
 // If the remote stub has a max packet size, stay under that size.
 //
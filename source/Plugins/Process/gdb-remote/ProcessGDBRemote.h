@@ -260,6 +260,27 @@ public:
     StructuredData::ObjectSP
     GetLoadedDynamicLibrariesInfos (lldb::addr_t image_list_address, lldb::addr_t image_count) override;
 
+    StructuredData::ObjectSP
+    GetHSAWavefrontsInfo (uint64_t start, uint64_t count) override;
+
+    Error
+    ReadHSA (std::vector<HsaReadRequest> &requests) override;
+
+    Error
+    SetHSABreakpointCondition (const HsaBreakpointCondition &condition) override;
+
+    Error
+    SetHSABreakpointMode (lldb::addr_t addr, uint32_t mode) override;
+
+    Error
+    GetHSABreakpointStats (HsaBreakpointStatsTable &table, size_t max_work_groups) override;
+
+    Error
+    SetHSADispatchFilter (bool all_kernels, const std::vector<std::string> &kernel_names) override;
+
+    Error
+    SetHSAStepBreakpoints (const std::vector<lldb::addr_t> &addrs) override;
+
 protected:
     friend class ThreadGDBRemote;
     friend class ThreadGDBRemoteHSA;
@@ -308,6 +329,23 @@ protected:
     lldb::CommandObjectSP m_command_sp;
     int64_t m_breakpoint_pc_offset;
     lldb::tid_t m_initial_tid; // The initial thread ID, given by stub on attach
+    std::map<uint64_t, lldb::ModuleSP> m_hsa_modules; // HSA code objects seen so far, keyed by content hash
+
+    // A copy of the stub's HSA wavefront table, kept up to date from the
+    // deltas the stub sends so a step does not resend every wave
+    struct HSAWavefront
+    {
+        lldb::tid_t tid;
+        lldb::addr_t pc;
+        uint64_t exec_mask;
+        uint64_t wave_address;
+        uint64_t work_group[3];
+    };
+    std::vector<HSAWavefront> m_hsa_wavefronts; // Sorted by tid
+    uint32_t m_hsa_wavefronts_version;          // Stub table version m_hsa_wavefronts matches
+    uint32_t m_hsa_wavefronts_stop_id;          // Stop ID m_hsa_wavefronts was last updated at
+    lldb::ModuleSP m_hsa_module_sp; // The HSA code object currently on the GPU
+    uint64_t m_hsa_binary_hash;     // Content hash of m_hsa_module_sp as reported by the stub
 
     //----------------------------------------------------------------------
     // Accessors
@@ -373,6 +411,15 @@ protected:
     void
     SetLastStopPacket (const StringExtractorGDBRemote &response);
 
+    void
+    LoadHSABinary ();
+
+    lldb::ModuleSP
+    CreateHSAModule (uint64_t size);
+
+    bool
+    UpdateHSAWavefronts ();
+
     bool
     ParsePythonTargetDefinition(const FileSpec &target_definition_fspec);
 
@@ -32,8 +32,9 @@ ThreadGDBRemoteHSA::CreateRegisterContextForFrame (StackFrame *frame)
         if (process_sp)
         {
             ProcessGDBRemote *gdb_process = static_cast<ProcessGDBRemote *>(process_sp.get());
-            // read_all_registers_at_once will be true if 'p' packet is not supported.
-            bool read_all_registers_at_once = !gdb_process->GetGDBRemote().GetpPacketSupported (GetID());
+            // The stub serves every register of a wave from one row of the
+            // agent's wave snapshot, read them all with a single g packet.
+            bool read_all_registers_at_once = true;
 
             auto& reg_info = gdb_process->m_hsa_register_info;
             reg_ctx_sp.reset (new GDBRemoteRegisterContextHSA (*this, concrete_frame_idx, reg_info, read_all_registers_at_once));
@@ -9,6 +9,9 @@
 
 #include "SymbolFileAMDHSA.h"
 
+// C++ Includes
+#include <algorithm>
+
 // Other libraries and framework includes
 #include "lldb/Core/ArchSpec.h"
 #include "lldb/Core/PluginManager.h"
@@ -16,6 +19,9 @@
 #include "lldb/Host/File.h"
 #include "lldb/Symbol/ObjectFile.h"
 #include "lldb/Symbol/CompileUnit.h"
+#include "lldb/Symbol/LineTable.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Support/FileSystem.h"
 
@@ -55,20 +61,153 @@ SymbolFileAMDHSA::CreateInstance (ObjectFile* obj_file)
     return new SymbolFileAMDHSA(obj_file);
 }
 
-SymbolFileAMDHSA::SymbolFileAMDHSA(ObjectFile* ofile)
-    : SymbolFile (ofile),
-      m_dwarf_symbols (ofile)
+SymbolFileAMDHSA::DebugInfo::~DebugInfo()
+{
+    if (m_dbginfo)
+        hwdbginfo_release_debug_info(&m_dbginfo);
+}
+
+const std::vector<SymbolFileAMDHSA::DebugInfo::LineRow>&
+SymbolFileAMDHSA::DebugInfo::GetLineRows ()
+{
+    std::call_once(m_line_rows_once, [this] ()
+    {
+        size_t n_addrs = 0;
+        if (hwdbginfo_all_mapped_addrs(m_dbginfo, 0, nullptr, &n_addrs) != HWDBGINFO_E_SUCCESS)
+            return;
+
+        std::vector<HwDbgInfo_addr> addrs (n_addrs);
+        if (hwdbginfo_all_mapped_addrs(m_dbginfo, addrs.size(), addrs.data(), &n_addrs) != HWDBGINFO_E_SUCCESS)
+            return;
+        addrs.resize(std::min(n_addrs, addrs.size()));
+        std::sort(addrs.begin(), addrs.end());
+        addrs.erase(std::unique(addrs.begin(), addrs.end()), addrs.end());
+
+        std::map<std::string, uint32_t> file_indexes;
+        std::vector<char> file (1024);
+        m_line_rows.reserve(addrs.size());
+
+        for (HwDbgInfo_addr addr : addrs)
+        {
+            HwDbgInfo_code_location loc;
+            if (hwdbginfo_addr_to_line(m_dbginfo, addr, &loc) != HWDBGINFO_E_SUCCESS)
+                continue;
+
+            HwDbgInfo_linenum line;
+            size_t file_name_len;
+            HwDbgInfo_err err = hwdbginfo_code_location_details(loc, &line, file.size(), file.data(), &file_name_len);
+            hwdbginfo_release_code_locations(&loc, 1);
+            if (err != HWDBGINFO_E_SUCCESS)
+                continue;
+
+            auto inserted = file_indexes.insert(std::make_pair(std::string(file.data()), m_line_files.size()));
+            if (inserted.second)
+            {
+                // The kernel's own HSAIL is embedded in the code object, we
+                // wrote it out to m_source_file_spec
+                if (inserted.first->first == "/hsa::self().elf(\".source\"):text")
+                    m_line_files.push_back(m_source_file_spec);
+                else
+                    m_line_files.push_back(FileSpec(inserted.first->first.c_str(), true));
+            }
+
+            LineRow row;
+            row.m_addr = addr;
+            row.m_line = line;
+            row.m_file_idx = inserted.first->second;
+            m_line_rows.push_back(row);
+        }
+    });
+
+    return m_line_rows;
+}
+
+static std::vector<HwDbgInfo_addr>
+QueryStepAddresses (HwDbgInfo_debug dbginfo, HwDbgInfo_addr addr, bool step_out)
 {
-    DataExtractor de;
-    m_obj_file->GetData(0,m_obj_file->GetByteSize(),de);
-	
-    HwDbgInfo_err err;
+    size_t n_addrs = 0;
+    if (hwdbginfo_step_addresses(dbginfo, addr, step_out, 0, nullptr, &n_addrs) != HWDBGINFO_E_SUCCESS)
+        return {};
+
+    std::vector<HwDbgInfo_addr> addrs (n_addrs);
+    if (hwdbginfo_step_addresses(dbginfo, addr, step_out, addrs.size(), addrs.data(), &n_addrs) != HWDBGINFO_E_SUCCESS)
+        return {};
+    addrs.resize(std::min(n_addrs, addrs.size()));
+
+    // The agent sets one momentary breakpoint per address
+    std::sort(addrs.begin(), addrs.end());
+    addrs.erase(std::unique(addrs.begin(), addrs.end()), addrs.end());
+    return addrs;
+}
 
-    m_dbginfo = hwdbginfo_init_with_hsa_1_0_binary((void*)de.GetDataStart(), m_obj_file->GetByteSize(), &err);
+const std::vector<SymbolFileAMDHSA::LineStepAddressesSP>&
+SymbolFileAMDHSA::DebugInfo::GetLineStepTable ()
+{
+    std::call_once(m_step_table_once, [this] ()
+    {
+        const std::vector<LineRow>& rows = GetLineRows();
+        std::map<std::pair<uint32_t, uint32_t>, LineStepAddressesSP> lines;
+        m_step_table.reserve(rows.size());
+
+        for (const LineRow& row : rows)
+        {
+            auto inserted = lines.insert(std::make_pair(std::make_pair(row.m_file_idx, row.m_line), LineStepAddressesSP()));
+            if (inserted.second)
+            {
+                std::shared_ptr<LineStepAddresses> step_sp (new LineStepAddresses());
+                step_sp->m_step_over = QueryStepAddresses(m_dbginfo, row.m_addr, false);
+                step_sp->m_step_out = QueryStepAddresses(m_dbginfo, row.m_addr, true);
+                inserted.first->second = step_sp;
+            }
+            m_step_table.push_back(inserted.first->second);
+        }
+    });
+
+    return m_step_table;
+}
+
+const std::unordered_map<uint32_t, std::vector<HwDbgInfo_addr>>&
+SymbolFileAMDHSA::DebugInfo::GetLineAddresses ()
+{
+    std::call_once(m_line_addrs_once, [this] ()
+    {
+        // Rows are sorted by address, so are the addresses of each line
+        for (const LineRow& row : GetLineRows())
+            m_line_addrs[row.m_line].push_back(row.m_addr);
+    });
+
+    return m_line_addrs;
+}
+
+SymbolFileAMDHSA::DebugInfoSP
+SymbolFileAMDHSA::GetDebugInfo (const DataExtractor& data)
+{
+    // Entries are weak so the handle goes away with the last module using
+    // it, but stays shared while any module for that code object is alive
+    static std::mutex g_cache_mutex;
+    static std::map<DebugInfoKey, std::weak_ptr<DebugInfo>> g_cache;
+
+    llvm::StringRef bytes (reinterpret_cast<const char*>(data.GetDataStart()), data.GetByteSize());
+    const DebugInfoKey key (llvm::hash_value(bytes), bytes.size());
+
+    std::lock_guard<std::mutex> guard(g_cache_mutex);
+    auto pos = g_cache.find(key);
+    if (pos != g_cache.end())
+    {
+        DebugInfoSP debug_info_sp = pos->second.lock();
+        if (debug_info_sp && bytes == debug_info_sp->m_code_object)
+            return debug_info_sp;
+    }
+
+    DebugInfoSP debug_info_sp (new DebugInfo());
+    debug_info_sp->m_code_object = bytes.str();
+
+    HwDbgInfo_err err;
+    debug_info_sp->m_dbginfo = hwdbginfo_init_with_hsa_1_0_binary((void*)bytes.data(), bytes.size(), &err);
 
     const char* hsail;
     size_t hsail_len;
-    err = hwdbginfo_get_hsail_text(m_dbginfo, &hsail, &hsail_len);
+    err = hwdbginfo_get_hsail_text(debug_info_sp->m_dbginfo, &hsail, &hsail_len);
 
     llvm::SmallString<PATH_MAX> output_file_path{};
     int temp_fd;
@@ -77,7 +216,33 @@ SymbolFileAMDHSA::SymbolFileAMDHSA(ObjectFile* ofile)
     File tmp_file (temp_fd, true);
     tmp_file.Write(hsail, hsail_len);
 
-    tmp_file.GetFileSpec(m_source_file_spec);
+    tmp_file.GetFileSpec(debug_info_sp->m_source_file_spec);
+
+    // Drop the entries of code objects no module uses anymore, a process
+    // that loads many kernels would otherwise grow the cache forever. On a
+    // key collision the newer code object takes the entry.
+    for (auto it = g_cache.begin(); it != g_cache.end();)
+    {
+        if (it->second.expired())
+            it = g_cache.erase(it);
+        else
+            ++it;
+    }
+
+    g_cache[key] = debug_info_sp;
+    return debug_info_sp;
+}
+
+SymbolFileAMDHSA::SymbolFileAMDHSA(ObjectFile* ofile)
+    : SymbolFile (ofile),
+      m_dwarf_symbols (ofile)
+{
+    DataExtractor de;
+    m_obj_file->GetData(0,m_obj_file->GetByteSize(),de);
+
+    m_debug_info_sp = GetDebugInfo(de);
+    m_dbginfo = m_debug_info_sp->m_dbginfo;
+    m_source_file_spec = m_debug_info_sp->m_source_file_spec;
 }
 
 SymbolFileAMDHSA::~SymbolFileAMDHSA()
@@ -99,6 +264,55 @@ SymbolFileAMDHSA::CalculateAbilities ()
 void
 SymbolFileAMDHSA::InitializeObject()
 {
+    IndexKernelEntries();
+}
+
+void
+SymbolFileAMDHSA::IndexKernelEntries()
+{
+    m_kernel_name.Clear();
+    m_kernel_entries.clear();
+
+    auto symtab = m_obj_file->GetSymtab();
+    if (symtab) {
+        for (size_t i = 0; i < symtab->GetNumSymbols(); ++i) {
+            auto sym = symtab->SymbolAtIndex(i);
+            if (sym && sym->GetType() == eSymbolTypeResolver) {
+                m_kernel_name = sym->GetName();
+                break;
+            }
+        }
+    }
+
+    // The kernel starts at its lowest mapped address
+    const std::vector<DebugInfo::LineRow>& rows = m_debug_info_sp->GetLineRows();
+    if (rows.empty())
+        return;
+    const HwDbgInfo_addr entry_addr = rows.front().m_addr;
+
+    if (m_kernel_name)
+        m_kernel_entries[m_kernel_name.GetCString()] = entry_addr;
+
+    // The HSAIL function at the entry may be named differently from the
+    // kernel symbol
+    std::vector<HwDbgInfo_frame_context> frames (1);
+    size_t n_frames = 0;
+    if (hwdbginfo_addr_call_stack(m_dbginfo, entry_addr, frames.size(), frames.data(), &n_frames) != HWDBGINFO_E_SUCCESS ||
+        n_frames == 0)
+        return;
+
+    HwDbgInfo_addr pc, fp, mp;
+    HwDbgInfo_code_location loc;
+    std::vector<char> func_name (256);
+    size_t func_name_len;
+    if (hwdbginfo_frame_context_details(frames[0], &pc, &fp, &mp, &loc,
+                                        func_name.size(), func_name.data(), &func_name_len) == HWDBGINFO_E_SUCCESS) {
+        hwdbginfo_release_code_locations(&loc, 1);
+        func_name.back() = '\0';
+        if (func_name[0])
+            m_kernel_entries[ConstString(func_name.data()).GetCString()] = entry_addr;
+    }
+    hwdbginfo_release_frame_contexts(frames.data(), std::min(n_frames, frames.size()));
 }
 
 uint32_t
@@ -125,9 +339,46 @@ SymbolFileAMDHSA::ParseCompileUnitFunctions (const SymbolContext& sc)
     return m_dwarf_symbols.ParseCompileUnitFunctions(sc);
 }
 
+CompileUnit *
+SymbolFileAMDHSA::GetCompUnit ()
+{
+    if (!m_comp_unit_sp)
+        m_comp_unit_sp.reset(new CompileUnit(m_obj_file->GetModule(), nullptr, m_source_file_spec, 0, eLanguageTypeExtHsail, false));
+    return m_comp_unit_sp.get();
+}
+
 bool
 SymbolFileAMDHSA::ParseCompileUnitLineTable (const SymbolContext& sc)
 {
+    if (!sc.comp_unit || sc.comp_unit != m_comp_unit_sp.get())
+        return false;
+
+    const std::vector<DebugInfo::LineRow>& rows = m_debug_info_sp->GetLineRows();
+    std::unique_ptr<LineTable> line_table_ap (new LineTable(sc.comp_unit));
+
+    if (!rows.empty())
+    {
+        // The last mapped instruction runs to the end of the code
+        addr_t end_addr = rows.back().m_addr + 8;
+        SectionList* section_list = m_obj_file->GetSectionList();
+        SectionSP text_section = section_list ? section_list->FindSectionByName(ConstString(".hsatext")) : SectionSP();
+        if (text_section)
+            end_addr = std::max<addr_t>(end_addr, text_section->GetFileAddress() + text_section->GetByteSize());
+
+        // Support file 0 is the compile unit itself, see ParseCompileUnitSupportFiles
+        LineSequence* sequence = line_table_ap->CreateLineSequenceContainer();
+        for (const DebugInfo::LineRow& row : rows)
+        {
+            line_table_ap->AppendLineEntryToSequence(sequence, row.m_addr, row.m_line, 0, row.m_file_idx + 1,
+                                                     true, false, false, false, false);
+        }
+        line_table_ap->AppendLineEntryToSequence(sequence, end_addr, rows.back().m_line, 0, rows.back().m_file_idx + 1,
+                                                 true, false, false, false, true);
+        line_table_ap->InsertSequence(sequence);
+        delete sequence;
+    }
+
+    sc.comp_unit->SetLineTable(line_table_ap.release());
     return true;
 }
 
@@ -142,6 +393,12 @@ bool
 SymbolFileAMDHSA::ParseCompileUnitSupportFiles (const SymbolContext& sc,
                                                 FileSpecList& support_files)
 {
+    if (!sc.comp_unit || sc.comp_unit != m_comp_unit_sp.get())
+        return false;
+
+    support_files.Append(*sc.comp_unit);
+    for (const FileSpec& file_spec : m_debug_info_sp->m_line_files)
+        support_files.Append(file_spec);
     return true;
 }
 
@@ -217,56 +474,17 @@ SymbolFileAMDHSA::ResolveSymbolContext (const Address& so_addr,
     sc.module_sp = m_obj_file->GetModule();
     resolved |= eSymbolContextModule;
 
-    HwDbgInfo_addr addr;
-    auto err = hwdbginfo_nearest_mapped_addr(m_dbginfo, so_addr.GetFileAddress(), &addr);
-
-    if (err != HWDBGINFO_E_SUCCESS) {
-        return resolved;
-    }
-
-    HwDbgInfo_code_location loc;
-    err = hwdbginfo_addr_to_line(m_dbginfo, addr, &loc);
-
-    if (err != HWDBGINFO_E_SUCCESS) {
-        return resolved;
-    }
-
-    HwDbgInfo_linenum line;
-    std::vector<char> file (1024);
-    size_t file_name_len;
-    err = hwdbginfo_code_location_details(loc, &line, file.size(), file.data(), &file_name_len);
-    std::string file_name (file.data());
-
-    if (err != HWDBGINFO_E_SUCCESS) {
-        return resolved;
-    }
-
-    auto section_list = m_obj_file->GetSectionList();
-    
-    if (!section_list)
-        return resolved;
-
-    auto text_section = section_list->FindSectionByName(ConstString(".hsatext"));
-    if (!text_section)
-        return resolved;
-
-    if (err != HWDBGINFO_E_SUCCESS) {
-        return resolved;
-    }
+    sc.comp_unit = GetCompUnit();
+    resolved |= eSymbolContextCompUnit;
 
-    if (file_name == "/hsa::self().elf(\".source\"):text") {
-        sc.line_entry = LineEntry(text_section, 0, 8, m_source_file_spec, line, 0, true, false, false, false, false);      }
-    else {
-        FileSpec fs (file_name, true);
-        sc.line_entry = LineEntry(text_section, 0, 8, fs, line, 0, true, false, false, false, false);      
+    // The line table is built once per module, finding the line of an
+    // address is a binary search
+    if (resolve_scope & eSymbolContextLineEntry) {
+        LineTable* line_table = sc.comp_unit->GetLineTable();
+        if (line_table && line_table->FindLineEntryByAddress(so_addr, sc.line_entry))
+            resolved |= eSymbolContextLineEntry;
     }
 
-    resolved |= eSymbolContextLineEntry;
-
-    //TODO store this somewhere to avoid leaking
-    sc.comp_unit = new CompileUnit(sc.module_sp, nullptr, m_source_file_spec, 0, eLanguageTypeExtHsail, false);
-    resolved |= eSymbolContextCompUnit;
-
     return resolved;
 }
 
@@ -277,7 +495,9 @@ SymbolFileAMDHSA::ResolveSymbolContext (const FileSpec& file_spec,
                                         uint32_t resolve_scope,
                                         SymbolContextList& sc_list)
 {
-    return 0;
+    // Files other than the HSAIL source are support files of its compile
+    // unit, so always look at them
+    return GetCompUnit()->ResolveSymbolContext(file_spec, line, true, false, resolve_scope, sc_list);
 }
 
 uint32_t
@@ -357,55 +577,133 @@ SymbolFileAMDHSA::GetPluginVersion()
 }
 
 
-std::vector<HwDbgInfo_addr>
-SymbolFileAMDHSA::GetStepAddresses (HwDbgInfo_addr start_addr, bool step_out)
+SymbolFileAMDHSA::CallStackSP
+SymbolFileAMDHSA::GetCallStack (HwDbgInfo_addr pc)
 {
-    HwDbgInfo_addr addr;
-    auto err = hwdbginfo_nearest_mapped_addr(m_dbginfo, start_addr, &addr);
-
-    if (err != HWDBGINFO_E_SUCCESS) {
-        return {};
+    DebugInfo& debug_info = *m_debug_info_sp;
+    {
+        std::lock_guard<std::mutex> guard(debug_info.m_call_stacks_mutex);
+        auto pos = debug_info.m_call_stacks.find(pc);
+        if (pos != debug_info.m_call_stacks.end())
+            return pos->second;
     }
 
-    size_t n_addrs = 0;
-    err = hwdbginfo_step_addresses(m_dbginfo, addr, step_out, 0, nullptr, &n_addrs);
-
-    if (err != HWDBGINFO_E_SUCCESS) {
-        return {};
+    std::vector<HwDbgInfo_frame_context> contexts (16);
+    size_t n_frames = 0;
+    HwDbgInfo_err err = hwdbginfo_addr_call_stack(m_dbginfo, pc, contexts.size(), contexts.data(), &n_frames);
+    if (err == HWDBGINFO_E_SUCCESS && n_frames > contexts.size()) {
+        hwdbginfo_release_frame_contexts(contexts.data(), contexts.size());
+        contexts.resize(n_frames);
+        err = hwdbginfo_addr_call_stack(m_dbginfo, pc, contexts.size(), contexts.data(), &n_frames);
     }
 
-    std::vector<HwDbgInfo_addr> addrs (n_addrs);
-    err = hwdbginfo_step_addresses(m_dbginfo, addr, step_out, n_addrs, addrs.data(), &n_addrs);
+    std::shared_ptr<std::vector<CallFrame>> frames_sp (new std::vector<CallFrame>());
+    if (err == HWDBGINFO_E_SUCCESS) {
+        n_frames = std::min(n_frames, contexts.size());
+        frames_sp->reserve(n_frames);
+        for (size_t i=0; i < n_frames; ++i) {
+            CallFrame frame;
+            HwDbgInfo_code_location loc;
+            size_t func_name_len;
+            if (hwdbginfo_frame_context_details(contexts[i], &frame.m_pc, &frame.m_fp, &frame.m_mp, &loc,
+                                                0, nullptr, &func_name_len) != HWDBGINFO_E_SUCCESS)
+                break;
+            hwdbginfo_release_code_locations(&loc, 1);
+            frames_sp->push_back(frame);
+        }
+        hwdbginfo_release_frame_contexts(contexts.data(), n_frames);
+    }
 
-    if (err != HWDBGINFO_E_SUCCESS) {
-        return {};
+    std::lock_guard<std::mutex> guard(debug_info.m_call_stacks_mutex);
+    return debug_info.m_call_stacks.insert(std::make_pair(pc, CallStackSP(frames_sp))).first->second;
+}
+
+SymbolFileAMDHSA::LineStepAddressesSP
+SymbolFileAMDHSA::GetLineStepAddresses (HwDbgInfo_addr start_addr)
+{
+    const std::vector<DebugInfo::LineRow>& rows = m_debug_info_sp->GetLineRows();
+    const std::vector<LineStepAddressesSP>& step_table = m_debug_info_sp->GetLineStepTable();
+    if (rows.empty())
+        return LineStepAddressesSP();
+
+    // An address belongs to the line of the nearest mapped address at or
+    // before it
+    auto pos = std::upper_bound(rows.begin(), rows.end(), start_addr,
+                                [] (HwDbgInfo_addr addr, const DebugInfo::LineRow& row) { return addr < row.m_addr; });
+    if (pos == rows.begin())
+    {
+        HwDbgInfo_addr addr;
+        if (hwdbginfo_nearest_mapped_addr(m_dbginfo, start_addr, &addr) != HWDBGINFO_E_SUCCESS)
+            return LineStepAddressesSP();
+        pos = std::lower_bound(rows.begin(), rows.end(), addr,
+                               [] (const DebugInfo::LineRow& row, HwDbgInfo_addr addr) { return row.m_addr < addr; });
+        if (pos == rows.end() || pos->m_addr != addr)
+            return LineStepAddressesSP();
+        ++pos;
     }
 
-    return addrs;
+    return step_table[pos - rows.begin() - 1];
 }
 
 std::vector<HwDbgInfo_addr>
 SymbolFileAMDHSA::GetStepOverAddresses (HwDbgInfo_addr start_addr)
 {
-    return GetStepAddresses(start_addr, false);
+    LineStepAddressesSP step_sp = GetLineStepAddresses(start_addr);
+    return step_sp ? step_sp->m_step_over : std::vector<HwDbgInfo_addr>();
 }
 
 std::vector<HwDbgInfo_addr>
 SymbolFileAMDHSA::GetStepOutAddresses (HwDbgInfo_addr start_addr)
 {
-    return GetStepAddresses(start_addr, true);
+    LineStepAddressesSP step_sp = GetLineStepAddresses(start_addr);
+    return step_sp ? step_sp->m_step_out : std::vector<HwDbgInfo_addr>();
 }
 
 ConstString
 SymbolFileAMDHSA::GetKernelName() {
-    auto symtab = m_obj_file->GetSymtab();
+    return m_kernel_name;
+}
 
-    if (!symtab) return ConstString("");
+bool
+SymbolFileAMDHSA::FindKernelEntry (const ConstString &name, HwDbgInfo_addr &addr) const
+{
+    // ConstStrings with equal text share their pointer
+    auto pos = m_kernel_entries.find(name.GetCString());
+    if (pos == m_kernel_entries.end())
+        return false;
 
-    for (size_t i = 0; i < symtab->GetNumSymbols(); ++i) {
-        auto sym = symtab->SymbolAtIndex(i);
-        if (sym && sym->GetType() == eSymbolTypeResolver) {
-            return sym->GetName();
-        }
-    }
+    addr = pos->second;
+    return true;
+}
+
+std::vector<HwDbgInfo_addr>
+SymbolFileAMDHSA::FindLineAddresses (uint32_t line)
+{
+    const auto& line_addrs = m_debug_info_sp->GetLineAddresses();
+    auto pos = line_addrs.find(line);
+    if (pos != line_addrs.end())
+        return pos->second;
+
+    // Lines without code resolve to the nearest line with code
+    auto loc = hwdbginfo_make_code_location(nullptr, line);
+    if (loc == nullptr)
+        return {};
+
+    HwDbgInfo_code_location resolved_loc;
+    HwDbgInfo_err err = hwdbginfo_nearest_mapped_line(m_dbginfo, loc, &resolved_loc);
+    hwdbginfo_release_code_locations(&loc, 1);
+    if (err != HWDBGINFO_E_SUCCESS)
+        return {};
+
+    HwDbgInfo_linenum resolved_line;
+    size_t file_name_len;
+    err = hwdbginfo_code_location_details(resolved_loc, &resolved_line, 0, nullptr, &file_name_len);
+    hwdbginfo_release_code_locations(&resolved_loc, 1);
+    if (err != HWDBGINFO_E_SUCCESS)
+        return {};
+
+    pos = line_addrs.find(resolved_line);
+    if (pos == line_addrs.end())
+        return {};
+    return pos->second;
 }
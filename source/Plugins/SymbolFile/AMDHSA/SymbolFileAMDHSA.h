@@ -14,8 +14,11 @@
 // C++ Includes
 #include <list>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <set>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 // Other libraries and framework includes
@@ -190,6 +193,21 @@ public:
     uint32_t
     GetPluginVersion() override;
 
+    // Where a step over or a step out of one source line can stop
+    struct LineStepAddresses
+    {
+        std::vector<HwDbgInfo_addr> m_step_over;
+        std::vector<HwDbgInfo_addr> m_step_out;
+    };
+
+    typedef std::shared_ptr<const LineStepAddresses> LineStepAddressesSP;
+
+    // The step addresses of the line at start_addr, null if it maps to no
+    // line. They are computed for every line of the code object on first
+    // use, all addresses of a line share one set.
+    LineStepAddressesSP
+    GetLineStepAddresses (HwDbgInfo_addr start_addr);
+
     std::vector<HwDbgInfo_addr>
     GetStepOutAddresses (HwDbgInfo_addr start_addr);                      
 
@@ -199,11 +217,109 @@ public:
     lldb_private::ConstString
     GetKernelName();
 
-private:
+    // The entry address of the kernel called name, false if this code
+    // object does not hold it. The kernel is known by its symbol and by
+    // the name of the HSAIL function at its entry.
+    bool
+    FindKernelEntry (const lldb_private::ConstString &name, HwDbgInfo_addr &addr) const;
+
+    // The addresses of a source line, or of the nearest line with code if
+    // it has none. Sorted, empty if no line has code.
     std::vector<HwDbgInfo_addr>
-    GetStepAddresses (HwDbgInfo_addr start_addr, bool step_out);
+    FindLineAddresses (uint32_t line);
+
+    // One frame of the call stack at an address, innermost first
+    struct CallFrame
+    {
+        HwDbgInfo_addr m_pc;
+        HwDbgInfo_addr m_fp;
+        HwDbgInfo_addr m_mp;
+    };
+
+    typedef std::shared_ptr<const std::vector<CallFrame>> CallStackSP;
+
+    // The call stack at pc. Stacks only depend on the debug info, so they
+    // are computed once per address and shared by every wave stopped there.
+    CallStackSP
+    GetCallStack (HwDbgInfo_addr pc);
+
+private:
+    //------------------------------------------------------------------
+    // Debug info handle and extracted HSAIL source for one code object.
+    // Shared between every symbol file created for identical code
+    // objects, so repeated dispatches of a kernel only parse it once.
+    //------------------------------------------------------------------
+    struct DebugInfo
+    {
+        // One mapped address of the code object and the line it maps to
+        struct LineRow
+        {
+            HwDbgInfo_addr m_addr;
+            uint32_t m_line;
+            uint32_t m_file_idx; // Index into m_line_files
+        };
+
+        DebugInfo () : m_dbginfo (nullptr) {}
+        ~DebugInfo ();
+
+        // Query the address to line mapping of every mapped address once,
+        // on first use. Rows are sorted by address.
+        const std::vector<LineRow>&
+        GetLineRows ();
+
+        // Query the step addresses of every line once, on first use. One
+        // entry per line row, the rows of a line share theirs.
+        const std::vector<LineStepAddressesSP>&
+        GetLineStepTable ();
+
+        // The addresses of every line, from the line rows. Lines of all
+        // source files are merged, like breakpoints by line number do.
+        const std::unordered_map<uint32_t, std::vector<HwDbgInfo_addr>>&
+        GetLineAddresses ();
+
+        HwDbgInfo_debug m_dbginfo;
+        lldb_private::FileSpec m_source_file_spec;
+
+        // The code object the debug info was read from. Cache hits are
+        // compared against it, the key alone may collide.
+        std::string m_code_object;
+
+        std::once_flag m_line_rows_once;
+        std::vector<LineRow> m_line_rows;
+        std::vector<lldb_private::FileSpec> m_line_files;
+
+        std::once_flag m_step_table_once;
+        std::vector<LineStepAddressesSP> m_step_table;
+
+        std::once_flag m_line_addrs_once;
+        std::unordered_map<uint32_t, std::vector<HwDbgInfo_addr>> m_line_addrs;
+
+        std::mutex m_call_stacks_mutex;
+        std::unordered_map<HwDbgInfo_addr, CallStackSP> m_call_stacks;
+    };
+
+    typedef std::shared_ptr<DebugInfo> DebugInfoSP;
+    // Content hash and size of the code object
+    typedef std::pair<uint64_t, uint64_t> DebugInfoKey;
+
+    static DebugInfoSP
+    GetDebugInfo (const lldb_private::DataExtractor& data);
+
+    // The compile unit of the HSAIL source, its line table covers the
+    // whole code object
+    lldb_private::CompileUnit *
+    GetCompUnit ();
+
+    // Kernel names to the entry address, by ConstString pointer. Built
+    // when the module loads so resolving a kernel breakpoint is a lookup.
+    void
+    IndexKernelEntries ();
 
     SymbolFileDWARF m_dwarf_symbols;
+    lldb_private::ConstString m_kernel_name;
+    std::unordered_map<const char*, HwDbgInfo_addr> m_kernel_entries;
+    lldb::CompUnitSP m_comp_unit_sp;
+    DebugInfoSP m_debug_info_sp;
     HwDbgInfo_debug m_dbginfo;
     lldb_private::FileSpec m_source_file_spec;
 };
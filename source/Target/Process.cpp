@@ -6399,6 +6399,20 @@ Process::ModulesDidLoad (ModuleList &module_list)
     LoadOperatingSystemPlugin(false);
 }
 
+void
+Process::ModulesDidUnload (ModuleList &module_list)
+{
+    // Let any language runtimes we have already created forget
+    // about the modules that unloaded.
+    LanguageRuntimeCollection language_runtimes(m_language_runtimes);
+    for (const auto &pair: language_runtimes)
+    {
+        LanguageRuntimeSP language_runtime_sp = pair.second;
+        if (language_runtime_sp)
+            language_runtime_sp->ModulesDidUnload(module_list);
+    }
+}
+
 void
 Process::PrintWarning (uint64_t warning_type, const void *repeat_key, const char *fmt, ...)
 {
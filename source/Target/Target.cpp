@@ -1432,6 +1432,10 @@ Target::ModulesDidUnload (ModuleList &module_list, bool delete_locations)
         UnloadModuleSections (module_list);
         m_breakpoint_list.UpdateBreakpoints (module_list, false, delete_locations);
         m_internal_breakpoint_list.UpdateBreakpoints (module_list, false, delete_locations);
+        if (m_process_sp)
+        {
+            m_process_sp->ModulesDidUnload (module_list);
+        }
         BroadcastEvent (eBroadcastBitModulesUnloaded, new TargetEventData (this->shared_from_this(), module_list));
     }
 }
@@ -220,6 +220,7 @@ StringExtractorGDBRemote::GetServerPacketType () const
 
         case 'X':
             if (PACKET_STARTS_WITH ("qXfer:auxv:read::"))       return eServerPacketType_qXfer_auxv_read;
+            if (PACKET_STARTS_WITH ("qXfer:hsa-binary:read::")) return eServerPacketType_qXfer_hsa_binary_read;
             break;
         }
         break;
@@ -227,6 +228,13 @@ StringExtractorGDBRemote::GetServerPacketType () const
     case 'j':
         if (PACKET_MATCHES("jSignalsInfo"))                     return eServerPacketType_jSignalsInfo;
         if (PACKET_MATCHES("jThreadsInfo"))                     return eServerPacketType_jThreadsInfo;
+        if (PACKET_STARTS_WITH("jHSAWavefrontsDelta:"))         return eServerPacketType_jHSAWavefrontsDelta;
+        if (PACKET_STARTS_WITH("jHSARead:"))                    return eServerPacketType_jHSARead;
+        if (PACKET_STARTS_WITH("jHSABreakpointCondition:"))     return eServerPacketType_jHSABreakpointCondition;
+        if (PACKET_STARTS_WITH("jHSABreakpointMode:"))          return eServerPacketType_jHSABreakpointMode;
+        if (PACKET_STARTS_WITH("jHSABreakpointStats:"))         return eServerPacketType_jHSABreakpointStats;
+        if (PACKET_STARTS_WITH("jHSADispatchFilter:"))          return eServerPacketType_jHSADispatchFilter;
+        if (PACKET_STARTS_WITH("jHSAStepBreakpoints:"))         return eServerPacketType_jHSAStepBreakpoints;
 
 
     case 'v':
@@ -279,7 +287,7 @@ StringExtractorGDBRemote::GetServerPacketType () const
         break;
 
       case 'g':
-        if (packet_size == 1) return eServerPacketType_g;
+        if (packet_size == 1 || packet_cstr[1] == ';') return eServerPacketType_g;
         break;
 
       case 'G':
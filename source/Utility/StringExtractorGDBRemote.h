@@ -155,7 +155,15 @@ public:
         eServerPacketType__m,
         eServerPacketType_notify, // '%' notification
 
-        eServerPacketType_hsaBin
+        eServerPacketType_hsaBin,
+        eServerPacketType_qXfer_hsa_binary_read,
+        eServerPacketType_jHSAWavefrontsDelta,
+        eServerPacketType_jHSARead,
+        eServerPacketType_jHSABreakpointCondition,
+        eServerPacketType_jHSABreakpointMode,
+        eServerPacketType_jHSABreakpointStats,
+        eServerPacketType_jHSADispatchFilter,
+        eServerPacketType_jHSAStepBreakpoints
     };
     
     ServerPacketType
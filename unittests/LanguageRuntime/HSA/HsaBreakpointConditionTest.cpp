@@ -0,0 +1,173 @@
+//===-- HsaBreakpointConditionTest.cpp --------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#if defined(_MSC_VER) && (_HAS_EXCEPTIONS == 0)
+// Workaround for MSVC standard library bug, which fails to include <thread> when
+// exceptions are disabled.
+#include <eh.h>
+#endif
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "lldb/Core/StreamString.h"
+#include "Plugins/LanguageRuntime/HSA/HSARuntime/HsaBreakpointCondition.h"
+
+using namespace lldb_private;
+
+namespace
+{
+typedef std::vector<std::pair<uint32_t, uint64_t>> Program;
+
+Program
+ToProgram(const std::vector<HsailConditionOp> &ops)
+{
+    Program program;
+    for (const auto &op : ops)
+        program.push_back(std::make_pair(op.m_op, op.m_operand));
+    return program;
+}
+
+Program
+CompileOK(const char *text)
+{
+    std::vector<HsailConditionOp> ops;
+    std::string error;
+    EXPECT_TRUE(HsaBreakpointCondition::Compile(text, ops, error)) << text << ": " << error;
+    return ToProgram(ops);
+}
+
+std::string
+CompileError(const char *text)
+{
+    std::vector<HsailConditionOp> ops;
+    std::string error;
+    EXPECT_FALSE(HsaBreakpointCondition::Compile(text, ops, error)) << text;
+    return error;
+}
+}
+
+TEST(HsaBreakpointConditionTest, Empty)
+{
+    EXPECT_TRUE(CompileOK("").empty());
+    EXPECT_TRUE(CompileOK("   ").empty());
+}
+
+TEST(HsaBreakpointConditionTest, Compare)
+{
+    Program expected = {
+        { HSAIL_CONDITION_OP_GLOBAL_ID, 0 },
+        { HSAIL_CONDITION_OP_CONST, 1024 },
+        { HSAIL_CONDITION_OP_MOD, 0 },
+        { HSAIL_CONDITION_OP_CONST, 0 },
+        { HSAIL_CONDITION_OP_EQ, 0 },
+    };
+    EXPECT_EQ(expected, CompileOK("gid.x % 1024 == 0"));
+    EXPECT_EQ(expected, CompileOK("gid.x%0x400==0"));
+}
+
+TEST(HsaBreakpointConditionTest, Precedence)
+{
+    // && binds tighter than ||, ! tighter than both
+    Program expected = {
+        { HSAIL_CONDITION_OP_LANE, 0 },
+        { HSAIL_CONDITION_OP_CONST, 0 },
+        { HSAIL_CONDITION_OP_EQ, 0 },
+        { HSAIL_CONDITION_OP_HIT_COUNT, 0 },
+        { HSAIL_CONDITION_OP_CONST, 3 },
+        { HSAIL_CONDITION_OP_GT, 0 },
+        { HSAIL_CONDITION_OP_NOT, 0 },
+        { HSAIL_CONDITION_OP_ACTIVE_LANES, 0 },
+        { HSAIL_CONDITION_OP_CONST, 64 },
+        { HSAIL_CONDITION_OP_LT, 0 },
+        { HSAIL_CONDITION_OP_AND, 0 },
+        { HSAIL_CONDITION_OP_OR, 0 },
+    };
+    EXPECT_EQ(expected, CompileOK("lane == 0 || !(hits > 3) && active < 64"));
+}
+
+TEST(HsaBreakpointConditionTest, BitAnd)
+{
+    Program expected = {
+        { HSAIL_CONDITION_OP_EXEC_MASK, 0 },
+        { HSAIL_CONDITION_OP_CONST, 1 },
+        { HSAIL_CONDITION_OP_BIT_AND, 0 },
+        { HSAIL_CONDITION_OP_CONST, 0 },
+        { HSAIL_CONDITION_OP_NE, 0 },
+        { HSAIL_CONDITION_OP_LANE, 0 },
+        { HSAIL_CONDITION_OP_AND, 0 },
+    };
+    EXPECT_EQ(expected, CompileOK("exec & 1 != 0 && lane"));
+}
+
+TEST(HsaBreakpointConditionTest, Range)
+{
+    Program expected = {
+        { HSAIL_CONDITION_OP_WORKGROUP_ID, 1 },
+        { HSAIL_CONDITION_OP_CONST, 2 },
+        { HSAIL_CONDITION_OP_CONST, 5 },
+        { HSAIL_CONDITION_OP_IN_RANGE, 0 },
+    };
+    EXPECT_EQ(expected, CompileOK("wg.y in 2..5"));
+    EXPECT_EQ(expected, CompileOK("wg.y in 2 .. 5"));
+}
+
+TEST(HsaBreakpointConditionTest, Errors)
+{
+    EXPECT_EQ("unknown value 'foo'", CompileError("foo == 1"));
+    EXPECT_EQ("expected 'wi.x', '.y' or '.z'", CompileError("wi.w == 1"));
+    EXPECT_EQ("expected ')'", CompileError("(lane == 1"));
+    EXPECT_EQ("expected '..' in range", CompileError("lane in 1"));
+    EXPECT_EQ("unexpected end of condition", CompileError("lane =="));
+    EXPECT_EQ("unexpected ')'", CompileError("lane)"));
+}
+
+TEST(HsaBreakpointConditionTest, NumberOutOfRange)
+{
+    EXPECT_EQ("number out of range: 18446744073709551616", CompileError("lane == 18446744073709551616"));
+    EXPECT_EQ(Program({ { HSAIL_CONDITION_OP_CONST, UINT64_MAX } }), CompileOK("18446744073709551615"));
+}
+
+TEST(HsaBreakpointConditionTest, TooComplex)
+{
+    // Too many operations
+    std::string text = "lane == 0";
+    for (int i = 0; i < HSAIL_MAX_CONDITION_OPS / 4; ++i)
+        text += " || lane == 0";
+    EXPECT_EQ("condition is too complex for the agent", CompileError(text.c_str()));
+
+    // Too deep a stack
+    text = "1";
+    for (int i = 0; i < HSAIL_MAX_CONDITION_STACK; ++i)
+        text = "1 % (" + text + ")";
+    EXPECT_EQ("condition is too complex for the agent", CompileError(text.c_str()));
+}
+
+TEST(HsaBreakpointConditionTest, JSONRoundTrip)
+{
+    HsaBreakpointCondition condition;
+    condition.addr = 0x1234;
+    std::string error;
+    ASSERT_TRUE(HsaBreakpointCondition::Compile("gid.z in 1..0xffffffffffff && wi.x != 7", condition.ops, error));
+
+    StreamString json;
+    HsaBreakpointConditionToJSON(condition)->Write(json);
+
+    HsaBreakpointCondition parsed;
+    ASSERT_TRUE(HsaBreakpointConditionFromJSON(StructuredData::ParseJSON(json.GetString()), parsed));
+    EXPECT_EQ(condition.addr, parsed.addr);
+    EXPECT_EQ(ToProgram(condition.ops), ToProgram(parsed.ops));
+
+    EXPECT_FALSE(HsaBreakpointConditionFromJSON(StructuredData::ParseJSON("{\"addr\":1}"), parsed));
+    EXPECT_FALSE(HsaBreakpointConditionFromJSON(StructuredData::ParseJSON("{\"addr\":1,\"ops\":[[1]]}"), parsed));
+}
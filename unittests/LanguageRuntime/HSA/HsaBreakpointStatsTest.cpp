@@ -0,0 +1,281 @@
+//===-- HsaBreakpointStatsTest.cpp ------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#if defined(_MSC_VER) && (_HAS_EXCEPTIONS == 0)
+// Workaround for MSVC standard library bug, which fails to include <thread> when
+// exceptions are disabled.
+#include <eh.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "lldb/Core/StreamString.h"
+#include "lldb/Core/StructuredData.h"
+#include "Plugins/LanguageRuntime/HSA/HSARuntime/HsaBreakpointStats.h"
+
+using namespace lldb_private;
+
+namespace
+{
+// A statistics segment the way the agent lays it out
+class StatsSegment
+{
+public:
+    StatsSegment(uint32_t num_breakpoints, uint32_t num_work_groups) :
+        m_buffer(sizeof(HsailBreakpointStatsHeader) +
+                 num_breakpoints * sizeof(HsailBreakpointStats) +
+                 num_work_groups * sizeof(HsailWorkGroupHits), 0)
+    {
+        GetHeader().m_numBreakpoints = num_breakpoints;
+        GetHeader().m_numWorkGroups = num_work_groups;
+    }
+
+    HsailBreakpointStatsHeader &
+    GetHeader()
+    {
+        return *reinterpret_cast<HsailBreakpointStatsHeader *>(m_buffer.data());
+    }
+
+    HsailBreakpointStats &
+    GetBreakpoint(uint32_t idx)
+    {
+        return reinterpret_cast<HsailBreakpointStats *>(m_buffer.data() + sizeof(HsailBreakpointStatsHeader))[idx];
+    }
+
+    HsailWorkGroupHits &
+    GetWorkGroup(uint32_t idx)
+    {
+        return reinterpret_cast<HsailWorkGroupHits *>(&GetBreakpoint(GetHeader().m_numBreakpoints))[idx];
+    }
+
+    void
+    SetWorkGroup(uint32_t idx, uint32_t x, uint64_t wave_hits)
+    {
+        GetWorkGroup(idx).m_workGroup.x = x;
+        GetWorkGroup(idx).m_waveHits = wave_hits;
+        GetWorkGroup(idx).m_laneHits = wave_hits * HSAIL_WAVEFRONT_SIZE;
+    }
+
+    std::vector<uint8_t> m_buffer;
+};
+
+bool
+Parse(StatsSegment &segment, std::size_t max_work_groups, HsaBreakpointStatsTable &table)
+{
+    std::vector<uint8_t> copy;
+    return HsaBreakpointStatsTryCopy(segment.m_buffer.data(), segment.m_buffer.size(), copy) &&
+           HsaBreakpointStatsFromCopy(copy, max_work_groups, table);
+}
+}
+
+TEST(HsaBreakpointStatsTest, Parse)
+{
+    StatsSegment segment(1, 2);
+    segment.GetBreakpoint(0).m_pc = 0x100;
+    segment.GetBreakpoint(0).m_mode = HSAIL_BREAKPOINT_MODE_TRACE;
+    segment.GetBreakpoint(0).m_numWorkGroups = 2;
+    segment.GetBreakpoint(0).m_waveHits = 3;
+    segment.GetBreakpoint(0).m_laneHits[0] = 3;
+    segment.GetBreakpoint(0).m_laneHits[63] = 1;
+    segment.SetWorkGroup(0, 7, 1);
+    segment.SetWorkGroup(1, 9, 2);
+
+    HsaBreakpointStatsTable table;
+    ASSERT_TRUE(Parse(segment, 16, table));
+    EXPECT_FALSE(table.truncated);
+    ASSERT_EQ(1u, table.breakpoints.size());
+
+    const HsaBreakpointStats &stats = table.breakpoints[0];
+    EXPECT_EQ(0x100u, stats.addr);
+    EXPECT_EQ(uint32_t(HSAIL_BREAKPOINT_MODE_TRACE), stats.mode);
+    EXPECT_EQ(3u, stats.wave_hits);
+    EXPECT_EQ(size_t(HSAIL_WAVEFRONT_SIZE), stats.lane_hits.size());
+    EXPECT_EQ(4u, stats.GetLaneHits());
+    EXPECT_EQ(2u, stats.num_work_groups);
+
+    // The hottest work-group comes first
+    ASSERT_EQ(2u, stats.work_groups.size());
+    EXPECT_EQ(9u, stats.work_groups[0].m_workGroup.x);
+    EXPECT_EQ(7u, stats.work_groups[1].m_workGroup.x);
+}
+
+TEST(HsaBreakpointStatsTest, Truncated)
+{
+    StatsSegment segment(0, 0);
+    segment.GetHeader().m_isTruncated = 1;
+
+    HsaBreakpointStatsTable table;
+    ASSERT_TRUE(Parse(segment, 16, table));
+    EXPECT_TRUE(table.truncated);
+    EXPECT_TRUE(table.breakpoints.empty());
+}
+
+TEST(HsaBreakpointStatsTest, SpareWorkGroupSlots)
+{
+    // Each breakpoint owns four slots, the first uses one and the second two
+    StatsSegment segment(2, 8);
+    segment.GetBreakpoint(0).m_numWorkGroups = 1;
+    segment.GetBreakpoint(0).m_firstWorkGroup = 0;
+    segment.GetBreakpoint(1).m_numWorkGroups = 2;
+    segment.GetBreakpoint(1).m_firstWorkGroup = 4;
+    segment.SetWorkGroup(0, 1, 5);
+    segment.SetWorkGroup(4, 2, 1);
+    segment.SetWorkGroup(5, 3, 4);
+
+    HsaBreakpointStatsTable table;
+    ASSERT_TRUE(Parse(segment, 16, table));
+    ASSERT_EQ(2u, table.breakpoints.size());
+
+    ASSERT_EQ(1u, table.breakpoints[0].work_groups.size());
+    EXPECT_EQ(1u, table.breakpoints[0].work_groups[0].m_workGroup.x);
+
+    ASSERT_EQ(2u, table.breakpoints[1].work_groups.size());
+    EXPECT_EQ(3u, table.breakpoints[1].work_groups[0].m_workGroup.x);
+    EXPECT_EQ(2u, table.breakpoints[1].work_groups[1].m_workGroup.x);
+
+    // Only the hottest work-groups are kept, the count says how many hit
+    ASSERT_TRUE(Parse(segment, 1, table));
+    ASSERT_EQ(1u, table.breakpoints[1].work_groups.size());
+    EXPECT_EQ(3u, table.breakpoints[1].work_groups[0].m_workGroup.x);
+    EXPECT_EQ(2u, table.breakpoints[1].num_work_groups);
+
+    // Work-groups past the last slot are malformed
+    segment.GetBreakpoint(1).m_firstWorkGroup = 7;
+    EXPECT_FALSE(Parse(segment, 16, table));
+}
+
+TEST(HsaBreakpointStatsTest, OddSequence)
+{
+    StatsSegment segment(1, 1);
+    segment.GetBreakpoint(0).m_numWorkGroups = 1;
+
+    std::vector<uint8_t> copy;
+    segment.GetHeader().m_sequence = 3;
+    EXPECT_FALSE(HsaBreakpointStatsTryCopy(segment.m_buffer.data(), segment.m_buffer.size(), copy));
+
+    segment.GetHeader().m_sequence = 4;
+    EXPECT_TRUE(HsaBreakpointStatsTryCopy(segment.m_buffer.data(), segment.m_buffer.size(), copy));
+    EXPECT_EQ(segment.m_buffer, copy);
+}
+
+TEST(HsaBreakpointStatsTest, DoesNotFit)
+{
+    StatsSegment segment(1, 4);
+
+    std::vector<uint8_t> copy;
+    EXPECT_FALSE(HsaBreakpointStatsTryCopy(segment.m_buffer.data(), segment.m_buffer.size() - 1, copy));
+    EXPECT_FALSE(HsaBreakpointStatsTryCopy(segment.m_buffer.data(), sizeof(HsailBreakpointStatsHeader) - 1, copy));
+    EXPECT_FALSE(HsaBreakpointStatsTryCopy(nullptr, 0, copy));
+
+    HsaBreakpointStatsTable table;
+    copy.assign(segment.m_buffer.begin(), segment.m_buffer.end() - 1);
+    EXPECT_FALSE(HsaBreakpointStatsFromCopy(copy, 16, table));
+}
+
+TEST(HsaBreakpointStatsTest, ChangedSequence)
+{
+    // A writer rewrites the statistics the way the agent does, every lane
+    // count equal to the wave count. A copy taken while it wrote has to be
+    // refused, so every accepted copy is consistent.
+    StatsSegment segment(1, 1);
+    segment.GetBreakpoint(0).m_numWorkGroups = 1;
+    HsailBreakpointStatsHeader &header = segment.GetHeader();
+    HsailBreakpointStats &stats = segment.GetBreakpoint(0);
+
+    std::atomic<bool> done(false);
+    std::thread writer([&]() {
+        for (uint64_t hits = 1; !done.load(); ++hits)
+        {
+            __atomic_store_n(&header.m_sequence, header.m_sequence + 1, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_RELEASE);
+            stats.m_waveHits = hits;
+            for (uint32_t lane = 0; lane < HSAIL_WAVEFRONT_SIZE; ++lane)
+                __atomic_store_n(&stats.m_laneHits[lane], hits, __ATOMIC_RELAXED);
+            __atomic_store_n(&header.m_sequence, header.m_sequence + 1, __ATOMIC_RELEASE);
+
+            // The agent writes after breakpoint events, not all the time
+            std::this_thread::yield();
+        }
+    });
+
+    // The writer is joined before anything is checked
+    int accepted = 0;
+    int torn = 0;
+    std::vector<uint8_t> copy;
+    HsaBreakpointStatsTable table;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (accepted < 10000 && std::chrono::steady_clock::now() < deadline)
+    {
+        if (!HsaBreakpointStatsTryCopy(segment.m_buffer.data(), segment.m_buffer.size(), copy))
+            continue;
+
+        ++accepted;
+        if (!HsaBreakpointStatsFromCopy(copy, 16, table) || table.breakpoints.size() != 1)
+        {
+            ++torn;
+            continue;
+        }
+        for (uint64_t lane_hits : table.breakpoints[0].lane_hits)
+        {
+            if (lane_hits != table.breakpoints[0].wave_hits)
+            {
+                ++torn;
+                break;
+            }
+        }
+    }
+
+    done = true;
+    writer.join();
+    EXPECT_GT(accepted, 0);
+    EXPECT_EQ(0, torn);
+}
+
+TEST(HsaBreakpointStatsTest, JSONRoundTrip)
+{
+    HsaBreakpointStatsTable table;
+    table.truncated = true;
+    table.breakpoints.resize(1);
+    table.breakpoints[0].addr = 0x200;
+    table.breakpoints[0].wave_hits = 2;
+    table.breakpoints[0].lane_hits.assign(HSAIL_WAVEFRONT_SIZE, 1);
+    table.breakpoints[0].num_work_groups = 5;
+    HsailWorkGroupHits work_group;
+    std::memset(&work_group, 0, sizeof(work_group));
+    work_group.m_workGroup.z = 3;
+    work_group.m_waveHits = 2;
+    table.breakpoints[0].work_groups.push_back(work_group);
+
+    StreamString stream;
+    HsaBreakpointStatsToJSON(table)->Write(stream);
+
+    HsaBreakpointStatsTable parsed;
+    ASSERT_TRUE(HsaBreakpointStatsFromJSON(StructuredData::ParseJSON(stream.GetString()), parsed));
+    EXPECT_TRUE(parsed.truncated);
+    ASSERT_EQ(1u, parsed.breakpoints.size());
+    EXPECT_EQ(0x200u, parsed.breakpoints[0].addr);
+    EXPECT_EQ(uint64_t(HSAIL_WAVEFRONT_SIZE), parsed.breakpoints[0].GetLaneHits());
+    EXPECT_EQ(5u, parsed.breakpoints[0].num_work_groups);
+    ASSERT_EQ(1u, parsed.breakpoints[0].work_groups.size());
+    EXPECT_EQ(3u, parsed.breakpoints[0].work_groups[0].m_workGroup.z);
+    EXPECT_EQ(2u, parsed.breakpoints[0].work_groups[0].m_waveHits);
+
+    // More lanes than a wave has are refused
+    StreamString too_many_lanes;
+    table.breakpoints[0].lane_hits.push_back(1);
+    HsaBreakpointStatsToJSON(table)->Write(too_many_lanes);
+    EXPECT_FALSE(HsaBreakpointStatsFromJSON(StructuredData::ParseJSON(too_many_lanes.GetString()), parsed));
+}
@@ -0,0 +1,215 @@
+//===-- HsaReadRequestTest.cpp ----------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#if defined(_MSC_VER) && (_HAS_EXCEPTIONS == 0)
+// Workaround for MSVC standard library bug, which fails to include <thread> when
+// exceptions are disabled.
+#include <eh.h>
+#endif
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "lldb/Core/StreamString.h"
+#include "lldb/Core/StructuredData.h"
+#include "Plugins/LanguageRuntime/HSA/HSARuntime/HsaReadRequest.h"
+
+using namespace lldb_private;
+
+namespace
+{
+const HsailWaveDim3 g_origin = { 0, 0, 0 };
+
+HsailWaveDim3
+Dim3(uint32_t x, uint32_t y, uint32_t z)
+{
+    HsailWaveDim3 dim = { x, y, z };
+    return dim;
+}
+
+StructuredData::ObjectSP
+ToStructuredData(const JSONArray::SP &array_sp)
+{
+    StreamString stream;
+    array_sp->Write(stream);
+    return StructuredData::ParseJSON(stream.GetString());
+}
+
+// Parse one request the way the stub parses a jHSARead packet
+bool
+ParseRequest(const std::string &json, HsaReadRequests &requests)
+{
+    return HsaReadRequestsFromJSON(StructuredData::ParseJSON("[" + json + "]"), requests);
+}
+}
+
+TEST(HsaReadRequestTest, BoxLanes)
+{
+    HsaReadRequest read = HsaReadRequest::Memory(1, Dim3(4, 2, 0), 1, 0x10, 4);
+    EXPECT_EQ(1u, read.GetLaneCount());
+
+    read.work_item_count = Dim3(3, 2, 2);
+    ASSERT_EQ(12u, read.GetLaneCount());
+
+    // Lanes are ordered x fastest
+    HsailWaveDim3 work_item = read.GetWorkItem(0);
+    EXPECT_EQ(4u, work_item.x);
+    EXPECT_EQ(2u, work_item.y);
+    EXPECT_EQ(0u, work_item.z);
+
+    work_item = read.GetWorkItem(11);
+    EXPECT_EQ(6u, work_item.x);
+    EXPECT_EQ(3u, work_item.y);
+    EXPECT_EQ(1u, work_item.z);
+
+    HsaReadRequest lane_read = read.GetLane(4);
+    EXPECT_EQ(1u, lane_read.GetLaneCount());
+    EXPECT_EQ(5u, lane_read.request.m_workItem.x);
+    EXPECT_EQ(3u, lane_read.request.m_workItem.y);
+    EXPECT_EQ(0x10u, lane_read.request.m_address);
+}
+
+TEST(HsaReadRequestTest, EmptyBox)
+{
+    HsaReadRequests requests;
+    EXPECT_FALSE(ParseRequest("{\"tid\":1,\"kind\":2,\"work_item\":[0,0,0],\"size\":4,"
+                              "\"count\":[0,1,1],\"region\":1,\"address\":0}", requests));
+    EXPECT_FALSE(ParseRequest("{\"tid\":1,\"kind\":2,\"work_item\":[0,0,0],\"size\":4,"
+                              "\"count\":[4,4,0],\"region\":1,\"address\":0}", requests));
+    EXPECT_FALSE(ParseRequest("{\"tid\":1,\"kind\":2,\"work_item\":[0,0,0],\"size\":4,"
+                              "\"count\":[4,4],\"region\":1,\"address\":0}", requests));
+}
+
+TEST(HsaReadRequestTest, BoxClippedToWorkGroup)
+{
+    HsaReadRequest read = HsaReadRequest::Memory(1, Dim3(6, 0, 0), 1, 0, 4);
+    read.work_item_count = Dim3(4, 2, 1);
+    const HsailWaveDim3 group_size = Dim3(8, 1, 1);
+
+    std::vector<uint64_t> inside;
+    for (uint64_t lane = 0; lane < read.GetLaneCount(); ++lane)
+    {
+        if (read.IsLaneInWorkGroup(lane, group_size))
+            inside.push_back(lane);
+    }
+    EXPECT_EQ(std::vector<uint64_t>({ 0, 1 }), inside);
+
+    // An unknown size does not clip
+    for (uint64_t lane = 0; lane < read.GetLaneCount(); ++lane)
+        EXPECT_TRUE(read.IsLaneInWorkGroup(lane, g_origin));
+
+    // A box starting past the end of the work-group has no lanes in it
+    read.request.m_workItem = Dim3(8, 0, 0);
+    for (uint64_t lane = 0; lane < read.GetLaneCount(); ++lane)
+        EXPECT_FALSE(read.IsLaneInWorkGroup(lane, group_size));
+
+    // Nor does one that wraps a 32-bit work-item ID
+    read.request.m_workItem = Dim3(UINT32_MAX, 0, 0);
+    read.work_item_count = Dim3(2, 1, 1);
+    EXPECT_TRUE(read.IsLaneInWorkGroup(0, g_origin));
+    EXPECT_FALSE(read.IsLaneInWorkGroup(1, g_origin));
+}
+
+TEST(HsaReadRequestTest, BadRegionOrKind)
+{
+    HsaReadRequests requests;
+    EXPECT_TRUE(ParseRequest("{\"tid\":1,\"kind\":2,\"work_item\":[0,0,0],\"size\":4,"
+                             "\"region\":2,\"address\":0}", requests));
+    EXPECT_FALSE(ParseRequest("{\"tid\":1,\"kind\":2,\"work_item\":[0,0,0],\"size\":4,"
+                              "\"region\":3,\"address\":0}", requests));
+    EXPECT_FALSE(ParseRequest("{\"tid\":1,\"kind\":2,\"work_item\":[0,0,0],\"size\":4,"
+                              "\"address\":0}", requests));
+    EXPECT_FALSE(ParseRequest("{\"tid\":1,\"kind\":0,\"work_item\":[0,0,0],\"size\":4,"
+                              "\"region\":1,\"address\":0}", requests));
+    EXPECT_FALSE(ParseRequest("{\"tid\":1,\"kind\":7,\"work_item\":[0,0,0],\"size\":4,"
+                              "\"region\":1,\"address\":0}", requests));
+    // A variable needs all nine location fields
+    EXPECT_FALSE(ParseRequest("{\"tid\":1,\"kind\":1,\"work_item\":[0,0,0],\"size\":4,"
+                              "\"location\":[1,2,3]}", requests));
+    EXPECT_FALSE(HsaReadRequestsFromJSON(StructuredData::ObjectSP(), requests));
+}
+
+TEST(HsaReadRequestTest, GlobalMemory)
+{
+    EXPECT_TRUE(HsaReadRequest::Memory(1, g_origin, 0, 0x1000, 8).IsGlobalMemory());
+    EXPECT_FALSE(HsaReadRequest::Memory(1, g_origin, 1, 0x1000, 8).IsGlobalMemory());
+
+    HsailVariableLocation location = HsailVariableLocation();
+    EXPECT_FALSE(HsaReadRequest::Variable(1, g_origin, location, 8).IsGlobalMemory());
+}
+
+TEST(HsaReadRequestTest, RequestsRoundTrip)
+{
+    HsailVariableLocation location = HsailVariableLocation();
+    location.m_regType = -1;
+    location.m_regNum = 3;
+    location.m_constAdd = -8;
+
+    HsaReadRequests requests;
+    requests.push_back(HsaReadRequest::Variable(2, Dim3(1, 2, 3), location, 4));
+    requests.push_back(HsaReadRequest::Memory(3, Dim3(0, 0, 0), 1, 0x40, 8));
+    requests.back().work_item_count = Dim3(16, 2, 1);
+
+    HsaReadRequests parsed;
+    ASSERT_TRUE(HsaReadRequestsFromJSON(ToStructuredData(HsaReadRequestsToJSON(requests)), parsed));
+    ASSERT_EQ(2u, parsed.size());
+
+    EXPECT_EQ(2u, parsed[0].tid);
+    EXPECT_EQ(uint32_t(HSAIL_READ_KIND_VARIABLE), parsed[0].request.m_kind);
+    EXPECT_EQ(3u, parsed[0].request.m_workItem.z);
+    EXPECT_EQ(1u, parsed[0].GetLaneCount());
+    EXPECT_EQ(-1, parsed[0].request.m_location.m_regType);
+    EXPECT_EQ(3u, parsed[0].request.m_location.m_regNum);
+    EXPECT_EQ(-8, parsed[0].request.m_location.m_constAdd);
+
+    EXPECT_EQ(uint32_t(HSAIL_READ_KIND_MEMORY), parsed[1].request.m_kind);
+    EXPECT_EQ(1u, parsed[1].request.m_memoryRegion);
+    EXPECT_EQ(0x40u, parsed[1].request.m_address);
+    EXPECT_EQ(32u, parsed[1].GetLaneCount());
+}
+
+TEST(HsaReadRequestTest, LaneResults)
+{
+    HsaReadRequest read = HsaReadRequest::Memory(1, g_origin, 1, 0, 2);
+    read.work_item_count = Dim3(3, 1, 1);
+    read.BeginLanes();
+    EXPECT_EQ(6u, read.data.size());
+    EXPECT_FALSE(read.Succeeded());
+
+    HsaReadRequest failed = read.GetLane(0);
+    failed.request.m_status = HSAIL_READ_STATUS_UNSUPPORTED;
+    read.SetLaneResult(0, failed);
+    EXPECT_EQ(uint32_t(HSAIL_READ_STATUS_UNSUPPORTED), read.request.m_status);
+
+    HsaReadRequest lane = read.GetLane(2);
+    lane.request.m_status = HSAIL_READ_STATUS_SUCCESS;
+    lane.data = { 0xab, 0xcd };
+    read.SetLaneResult(2, lane);
+
+    // Any lane succeeding makes the request succeed
+    EXPECT_TRUE(read.Succeeded());
+    EXPECT_EQ(std::vector<uint8_t>({ 0, 0, 0, 0, 0xab, 0xcd }), read.data);
+    EXPECT_EQ(std::vector<uint64_t>({ 0 }), read.failed_lanes);
+
+    HsaReadRequests requests(1, read);
+    HsaReadRequests results(1, read);
+    results[0].data.clear();
+    results[0].failed_lanes.clear();
+    ASSERT_TRUE(HsaReadResultsFromJSON(ToStructuredData(HsaReadResultsToJSON(requests)), results));
+    EXPECT_TRUE(results[0].Succeeded());
+    EXPECT_EQ(read.data, results[0].data);
+    EXPECT_EQ(read.failed_lanes, results[0].failed_lanes);
+
+    // The results have to match the requests one to one
+    results.push_back(read);
+    EXPECT_FALSE(HsaReadResultsFromJSON(ToStructuredData(HsaReadResultsToJSON(requests)), results));
+}
@@ -0,0 +1,175 @@
+//===-- HsaWavefrontTableTest.cpp -------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#if defined(_MSC_VER) && (_HAS_EXCEPTIONS == 0)
+// Workaround for MSVC standard library bug, which fails to include <thread> when
+// exceptions are disabled.
+#include <eh.h>
+#endif
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "Plugins/LanguageRuntime/HSA/HSARuntime/HsaWavefrontTable.h"
+
+using namespace lldb_private;
+
+namespace
+{
+typedef std::vector<std::size_t> Rows;
+
+struct Wave
+{
+    uint32_t group_x;
+    HsailProgramCounter pc;
+    HsailWaveAddress address;
+    uint64_t exec_mask;
+};
+
+const HsailWaveDim3 g_group_size = { 16, 1, 1 };
+
+// A wave buffer the way the agent writes it, one record per wave without
+// work-item IDs
+std::vector<uint8_t>
+MakeWaveBuffer(const std::vector<Wave> &waves)
+{
+    const uint32_t record_size = GetHsailWaveRecordSize(0);
+
+    HsailWaveBufferHeader header;
+    ::memset(&header, 0, sizeof(header));
+    header.m_version = HSAIL_WAVE_BUFFER_VERSION;
+    header.m_headerSize = sizeof(header);
+    header.m_numWaves = waves.size();
+    header.m_bytesUsed = sizeof(header) + waves.size() * record_size;
+    header.m_capacity = header.m_bytesUsed;
+
+    std::vector<uint8_t> buffer(header.m_bytesUsed, 0);
+    ::memcpy(buffer.data(), &header, sizeof(header));
+
+    for (std::size_t i = 0; i < waves.size(); ++i)
+    {
+        HsailWaveRecord record;
+        ::memset(&record, 0, sizeof(record));
+        record.m_recordSize = record_size;
+        record.workGroupId.x = waves[i].group_x;
+        record.execMask = waves[i].exec_mask;
+        record.pc = waves[i].pc;
+        record.waveAddress = waves[i].address;
+        ::memcpy(buffer.data() + sizeof(header) + i * record_size, &record, sizeof(record));
+    }
+    return buffer;
+}
+
+HsaWavefrontTable
+MakeTable(const std::vector<Wave> &waves)
+{
+    std::vector<uint8_t> buffer = MakeWaveBuffer(waves);
+    return HsaWavefrontTable(buffer.data(), buffer.size(), g_group_size);
+}
+}
+
+TEST(HsaWavefrontTableTest, SortedByGlobalID)
+{
+    HsaWavefrontTable table = MakeTable({ { 3, 0x30, 1, ~0ull }, { 1, 0x10, 2, ~0ull }, { 2, 0x20, 3, 0xf } });
+
+    ASSERT_EQ(3u, table.GetSize());
+    EXPECT_EQ(1u, table.GetGlobalID(0));
+    EXPECT_EQ(2u, table.GetGlobalID(1));
+    EXPECT_EQ(3u, table.GetGlobalID(2));
+    EXPECT_EQ(0x20u, table.GetPC(1));
+    EXPECT_EQ(0xfu, table.GetExecMask(1));
+    EXPECT_EQ(3u, table.GetWaveAddress(1));
+
+    EXPECT_EQ(2u, table.FindGlobalID(3));
+    EXPECT_EQ(HsaWavefrontTable::npos, table.FindGlobalID(4));
+}
+
+TEST(HsaWavefrontTableTest, DuplicateGlobalIDKeepsFirst)
+{
+    HsaWavefrontTable table = MakeTable({ { 5, 0x50, 1, ~0ull }, { 5, 0x58, 2, ~0ull } });
+
+    ASSERT_EQ(1u, table.GetSize());
+    EXPECT_EQ(0x50u, table.GetPC(0));
+    EXPECT_EQ(1u, table.GetWaveAddress(0));
+}
+
+TEST(HsaWavefrontTableTest, TruncatedBuffer)
+{
+    std::vector<uint8_t> buffer = MakeWaveBuffer({ { 1, 0x10, 1, ~0ull }, { 2, 0x20, 2, ~0ull } });
+
+    // The second record does not fit
+    HsaWavefrontTable table(buffer.data(), buffer.size() - 1, g_group_size);
+    ASSERT_EQ(1u, table.GetSize());
+    EXPECT_EQ(1u, table.GetGlobalID(0));
+
+    EXPECT_TRUE(HsaWavefrontTable(buffer.data(), sizeof(HsailWaveBufferHeader) - 1, g_group_size).IsEmpty());
+    EXPECT_TRUE(HsaWavefrontTable(nullptr, 0, g_group_size).IsEmpty());
+}
+
+TEST(HsaWavefrontDeltaTest, EmptyPrevious)
+{
+    HsaWavefrontTable to = MakeTable({ { 1, 0x10, 1, ~0ull }, { 2, 0x20, 2, ~0ull } });
+    HsaWavefrontDelta delta = HsaWavefrontDelta::Compute(HsaWavefrontTable(), to);
+
+    EXPECT_EQ(Rows({ 0, 1 }), delta.added);
+    EXPECT_TRUE(delta.moved.empty());
+    EXPECT_TRUE(delta.retired.empty());
+
+    delta = HsaWavefrontDelta::Compute(to, HsaWavefrontTable());
+    EXPECT_TRUE(delta.added.empty());
+    EXPECT_EQ(Rows({ 0, 1 }), delta.retired);
+}
+
+TEST(HsaWavefrontDeltaTest, Unchanged)
+{
+    HsaWavefrontTable from = MakeTable({ { 1, 0x10, 1, ~0ull }, { 2, 0x20, 2, ~0ull } });
+    HsaWavefrontTable to = MakeTable({ { 2, 0x20, 2, ~0ull }, { 1, 0x10, 1, ~0ull } });
+
+    EXPECT_TRUE(HsaWavefrontDelta::Compute(from, to).IsEmpty());
+    EXPECT_TRUE(HsaWavefrontDelta::Compute(HsaWavefrontTable(), HsaWavefrontTable()).IsEmpty());
+}
+
+TEST(HsaWavefrontDeltaTest, AddedRetiredMoved)
+{
+    HsaWavefrontTable from = MakeTable({ { 1, 0x10, 1, ~0ull }, { 2, 0x20, 2, ~0ull }, { 3, 0x30, 3, ~0ull } });
+    // Wave 1 is gone, wave 2 changed its exec mask, wave 3 is unchanged and wave 4 is new
+    HsaWavefrontTable to = MakeTable({ { 2, 0x20, 2, 0xff }, { 3, 0x30, 3, ~0ull }, { 4, 0x40, 4, ~0ull } });
+
+    HsaWavefrontDelta delta = HsaWavefrontDelta::Compute(from, to);
+    EXPECT_FALSE(delta.IsEmpty());
+    EXPECT_EQ(Rows({ 2 }), delta.added);
+    EXPECT_EQ(Rows({ 0 }), delta.moved);
+    EXPECT_EQ(Rows({ 0 }), delta.retired);
+}
+
+TEST(HsaWavefrontDeltaTest, SameWaveAtNewPC)
+{
+    HsaWavefrontTable from = MakeTable({ { 1, 0x10, 1, ~0ull }, { 2, 0x20, 2, ~0ull } });
+    HsaWavefrontTable to = MakeTable({ { 1, 0x18, 1, ~0ull }, { 2, 0x20, 2, ~0ull } });
+
+    HsaWavefrontDelta delta = HsaWavefrontDelta::Compute(from, to);
+    EXPECT_TRUE(delta.added.empty());
+    EXPECT_EQ(Rows({ 0 }), delta.moved);
+    EXPECT_TRUE(delta.retired.empty());
+}
+
+TEST(HsaWavefrontDeltaTest, SlotReusedByAnotherWave)
+{
+    // Slot 1 ran wave 1 and now runs wave 5, wave 2 moved to slot 3
+    HsaWavefrontTable from = MakeTable({ { 1, 0x10, 1, ~0ull }, { 2, 0x20, 2, ~0ull } });
+    HsaWavefrontTable to = MakeTable({ { 2, 0x20, 3, ~0ull }, { 5, 0x10, 1, ~0ull } });
+
+    HsaWavefrontDelta delta = HsaWavefrontDelta::Compute(from, to);
+    EXPECT_EQ(Rows({ 0, 1 }), delta.added);
+    EXPECT_TRUE(delta.moved.empty());
+    EXPECT_EQ(Rows({ 0, 1 }), delta.retired);
+}